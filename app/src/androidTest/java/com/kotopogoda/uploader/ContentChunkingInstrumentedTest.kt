@@ -0,0 +1,89 @@
+package com.kotopogoda.uploader
+
+import android.content.Context
+import android.os.ParcelFileDescriptor
+import androidx.test.core.app.ApplicationProvider
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import com.kotopogoda.uploader.core.data.util.NativeHashing
+import java.io.File
+import java.security.MessageDigest
+import kotlin.random.Random
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+
+@RunWith(AndroidJUnit4::class)
+class ContentChunkingInstrumentedTest {
+
+    private lateinit var context: Context
+
+    @Before
+    fun setUp() {
+        context = ApplicationProvider.getApplicationContext()
+        assertTrue(NativeHashing.isAvailable(), "Native hashing library must be loadable on device")
+    }
+
+    @Test
+    fun chunksCoverFileAndDigestsMatch() {
+        val content = Random(32).nextBytes(9 * 1024 * 1024 + 123)
+        val params = NativeHashing.ChunkingParams()
+        val result = chunk(content, params)
+
+        assertEquals(content.size.toLong(), result.chunks.sumOf { it.length })
+        result.chunks.dropLast(1).forEach { chunk ->
+            assertTrue(chunk.length >= params.minSize, "Chunk shorter than minSize: $chunk")
+        }
+        result.chunks.forEach { chunk ->
+            assertTrue(chunk.length <= params.maxSize, "Chunk longer than maxSize: $chunk")
+            val slice = content.copyOfRange(chunk.offset.toInt(), (chunk.offset + chunk.length).toInt())
+            assertEquals(sha256(slice).toHex(), chunk.sha256)
+        }
+        assertEquals(sha256(content).toHex(), result.contentSha256)
+        val root = MessageDigest.getInstance("SHA-256").apply {
+            result.chunks.forEach { chunk -> update(chunk.sha256.hexToBytes()) }
+        }.digest()
+        assertEquals(root.toHex(), result.rootSha256)
+    }
+
+    @Test
+    fun insertionNearStartKeepsLaterChunks() {
+        val content = Random(33).nextBytes(8 * 1024 * 1024)
+        val edited = content.copyOfRange(0, 1024 * 1024) + ByteArray(100) { it.toByte() } +
+            content.copyOfRange(1024 * 1024, content.size)
+
+        val original = chunk(content, NativeHashing.ChunkingParams()).chunks.map { it.sha256 }.toSet()
+        val changed = chunk(edited, NativeHashing.ChunkingParams()).chunks.map { it.sha256 }
+
+        val reused = changed.count { it in original }
+        assertTrue(reused >= changed.size - 2, "Only $reused of ${changed.size} chunks reused after insertion")
+    }
+
+    @Test
+    fun emptyFileHasNoChunks() {
+        val result = chunk(ByteArray(0), NativeHashing.ChunkingParams())
+
+        assertTrue(result.chunks.isEmpty())
+        assertEquals(sha256(ByteArray(0)).toHex(), result.rootSha256)
+        assertEquals(sha256(ByteArray(0)).toHex(), result.contentSha256)
+    }
+
+    private fun chunk(content: ByteArray, params: NativeHashing.ChunkingParams): NativeHashing.ChunkedDigest {
+        val file = File.createTempFile("content-chunks", ".bin", context.cacheDir).apply {
+            writeBytes(content)
+            deleteOnExit()
+        }
+        return ParcelFileDescriptor.open(file, ParcelFileDescriptor.MODE_READ_ONLY).use { pfd ->
+            NativeHashing.chunk(pfd.fd, params)
+        }
+    }
+
+    private fun sha256(bytes: ByteArray): ByteArray = MessageDigest.getInstance("SHA-256").digest(bytes)
+
+    private fun ByteArray.toHex(): String = joinToString(separator = "") { byte -> "%02x".format(byte) }
+
+    private fun String.hexToBytes(): ByteArray = ByteArray(length / 2) { index ->
+        substring(index * 2, index * 2 + 2).toInt(16).toByte()
+    }
+}
@@ -0,0 +1,163 @@
+package com.kotopogoda.uploader
+
+import android.content.Context
+import android.net.Uri
+import android.os.ParcelFileDescriptor
+import android.os.SystemClock
+import android.util.Log
+import androidx.test.core.app.ApplicationProvider
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import com.kotopogoda.uploader.core.data.util.Hashing
+import com.kotopogoda.uploader.core.data.util.NativeHashing
+import java.io.File
+import java.security.MessageDigest
+import javax.crypto.Mac
+import javax.crypto.spec.SecretKeySpec
+import java.util.concurrent.CancellationException
+import kotlin.random.Random
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertTrue
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+
+@RunWith(AndroidJUnit4::class)
+class NativeHashingInstrumentedTest {
+
+    private lateinit var context: Context
+
+    @Before
+    fun setUp() {
+        context = ApplicationProvider.getApplicationContext()
+        assertTrue(NativeHashing.isAvailable(), "Native hashing library must be loadable on device")
+    }
+
+    @Test
+    fun nativeDigestMatchesStreamDigestForBlockBoundaries() {
+        val sizes = listOf(0, 1, 55, 56, 63, 64, 65, 1024 * 1024 + 3, 5 * 1024 * 1024 + 17)
+        val random = Random(29)
+        sizes.forEach { size ->
+            val file = createTempFile(random.nextBytes(size))
+            val expected = Hashing.sha256 { file.inputStream() }
+            val actual = ParcelFileDescriptor.open(file, ParcelFileDescriptor.MODE_READ_ONLY).use { pfd ->
+                NativeHashing.sha256(pfd.fd)
+            }
+            assertEquals(expected, actual, "Digest mismatch for size=$size")
+        }
+    }
+
+    @Test
+    fun contentResolverPathReportsProgressAndMatchesStreamDigest() {
+        val file = createTempFile(Random(7).nextBytes(9 * 1024 * 1024))
+        var lastHashed = -1L
+        var reportedTotal = -1L
+        val digest = Hashing.sha256(context.contentResolver, Uri.fromFile(file)) { hashed, total ->
+            assertTrue(hashed >= lastHashed, "Progress must be monotonic")
+            lastHashed = hashed
+            reportedTotal = total
+            true
+        }
+
+        assertEquals(Hashing.sha256 { file.inputStream() }, digest)
+        assertEquals(file.length(), lastHashed)
+        assertEquals(file.length(), reportedTotal)
+    }
+
+    @Test
+    fun listenerCanCancelHashing() {
+        val file = createTempFile(Random(11).nextBytes(12 * 1024 * 1024))
+        ParcelFileDescriptor.open(file, ParcelFileDescriptor.MODE_READ_ONLY).use { pfd ->
+            assertFailsWith<CancellationException> {
+                NativeHashing.sha256(pfd.fd) { hashed, _ -> hashed == 0L }
+            }
+        }
+    }
+
+    @Test
+    fun batchDigestsMatchSingleStreamForMixedSizes() {
+        val random = Random(30)
+        val sizes = listOf(0, 1, 63, 64, 65, 262_143, 262_144, 262_145, 1_000_000, 3 * 1024 * 1024 + 5, 777, 64 * 1000)
+        val files = sizes.map { size -> createTempFile(random.nextBytes(size)) }
+        val expected = files.map { file -> Hashing.sha256 { file.inputStream() } }
+
+        val descriptors = files.map { file -> ParcelFileDescriptor.open(file, ParcelFileDescriptor.MODE_READ_ONLY) }
+        val actual = try {
+            val fds = IntArray(descriptors.size + 1) { index -> descriptors.getOrNull(index)?.fd ?: -1 }
+            NativeHashing.sha256Batch(fds)
+        } finally {
+            descriptors.forEach { it.close() }
+        }
+
+        assertEquals(expected, actual.dropLast(1))
+        assertEquals(null, actual.last(), "Invalid descriptor must yield null digest")
+        assertEquals(expected, Hashing.sha256Batch(context.contentResolver, files.map(Uri::fromFile)))
+    }
+
+    @Test
+    fun batchThroughputComparedWithSingleStream() {
+        val random = Random(31)
+        val files = List(BENCHMARK_FILES) { createTempFile(random.nextBytes(BENCHMARK_FILE_SIZE)) }
+        val descriptors = files.map { file -> ParcelFileDescriptor.open(file, ParcelFileDescriptor.MODE_READ_ONLY) }
+        try {
+            val fds = IntArray(descriptors.size) { index -> descriptors[index].fd }
+            // Прогрев: страничный кэш и выбор бэкенда не должны попадать в замер.
+            NativeHashing.sha256Batch(fds)
+
+            val singleStart = SystemClock.elapsedRealtimeNanos()
+            val single = fds.map { fd -> NativeHashing.sha256(fd) }
+            val singleNanos = SystemClock.elapsedRealtimeNanos() - singleStart
+
+            val batchStart = SystemClock.elapsedRealtimeNanos()
+            val batch = NativeHashing.sha256Batch(fds)
+            val batchNanos = SystemClock.elapsedRealtimeNanos() - batchStart
+
+            assertEquals(single, batch)
+            val totalMb = BENCHMARK_FILES * BENCHMARK_FILE_SIZE / (1024.0 * 1024.0)
+            Log.i(
+                TAG,
+                "sha256 single=%.1f MB/s batch=%.1f MB/s files=%d".format(
+                    totalMb * 1e9 / singleNanos,
+                    totalMb * 1e9 / batchNanos,
+                    BENCHMARK_FILES,
+                ),
+            )
+        } finally {
+            descriptors.forEach { it.close() }
+        }
+    }
+
+    @Test
+    fun bodyDigestsMatchJvmPrimitivesInOnePass() {
+        val body = Random(32).nextBytes(2 * 1024 * 1024 + 11)
+        val file = createTempFile(body)
+        val framePrefix = "--boundary\r\nContent-Disposition: form-data; name=\"file\"\r\n\r\n".toByteArray()
+        val frameSuffix = "\r\n--boundary--\r\n".toByteArray()
+        val key = "device-secret".toByteArray()
+        val canonicalPrefix = "POST\n/v1/uploads\n-\n".toByteArray()
+
+        val digests = ParcelFileDescriptor.open(file, ParcelFileDescriptor.MODE_READ_ONLY).use { pfd ->
+            NativeHashing.digestBody(pfd.fd, framePrefix, frameSuffix, key, canonicalPrefix)
+        }
+
+        val sha256 = MessageDigest.getInstance("SHA-256")
+        assertEquals(sha256.digest(body).toHex(), digests.contentSha256)
+        assertEquals(sha256.digest(framePrefix + body + frameSuffix).toHex(), digests.framedSha256)
+        val mac = Mac.getInstance("HmacSHA256").apply { init(SecretKeySpec(key, "HmacSHA256")) }
+        assertEquals(mac.doFinal(canonicalPrefix + body).toHex(), digests.hmacSha256)
+    }
+
+    private fun ByteArray.toHex(): String = joinToString(separator = "") { byte -> "%02x".format(byte) }
+
+    private fun createTempFile(content: ByteArray): File =
+        File.createTempFile("native-hashing", ".bin", context.cacheDir).apply {
+            writeBytes(content)
+            deleteOnExit()
+        }
+
+    private companion object {
+        const val TAG = "NativeHashingTest"
+        const val BENCHMARK_FILES = 24
+        const val BENCHMARK_FILE_SIZE = 4 * 1024 * 1024
+    }
+}
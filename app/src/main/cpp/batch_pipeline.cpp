@@ -0,0 +1,259 @@
+#include "batch_pipeline.h"
+#include "trace.h"
+#include <android/log.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#define LOG_TAG "BatchPipeline"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace kotopogoda {
+
+namespace {
+
+constexpr size_t kChannelCapacity = 1;
+
+int64_t elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+}
+
+}
+
+// Ограниченная очередь кадров между стадиями.
+struct BatchPipeline::Channel {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<BatchFrame> frames;
+    bool closed = false;
+
+    // Ждёт свободного места: производитель не начинает следующий кадр, пока
+    // потребитель не забрал предыдущий.
+    void awaitCapacity() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return frames.size() < kChannelCapacity; });
+    }
+
+    void push(BatchFrame frame) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return frames.size() < kChannelCapacity; });
+            frames.push_back(std::move(frame));
+        }
+        changed.notify_all();
+    }
+
+    bool pop(BatchFrame& frame) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return closed || !frames.empty(); });
+            if (frames.empty()) {
+                return false;
+            }
+            frame = std::move(frames.front());
+            frames.pop_front();
+        }
+        changed.notify_all();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        changed.notify_all();
+    }
+};
+
+BatchPipeline::BatchPipeline(size_t itemCount, BatchStages stages)
+    : itemCount_(itemCount),
+      stages_(std::move(stages)),
+      itemCancelFlags_(new std::atomic<bool>[itemCount > 0 ? itemCount : 1]),
+      results_(itemCount),
+      decoded_(std::make_unique<Channel>()),
+      inferred_(std::make_unique<Channel>()) {
+    for (size_t i = 0; i < itemCount_; ++i) {
+        itemCancelFlags_[i].store(false);
+    }
+}
+
+BatchPipeline::~BatchPipeline() = default;
+
+bool BatchPipeline::cancelItem(size_t index) {
+    if (index >= itemCount_) {
+        return false;
+    }
+    itemCancelFlags_[index].store(true);
+    return true;
+}
+
+void BatchPipeline::cancelAll() {
+    for (size_t i = 0; i < itemCount_; ++i) {
+        itemCancelFlags_[i].store(true);
+    }
+}
+
+bool BatchPipeline::isCancelled(size_t index) const {
+    return itemCancelFlags_[index].load();
+}
+
+void BatchPipeline::propagateJobCancel() {
+    if (jobCancelFlag_ == nullptr || !jobCancelFlag_->load()) {
+        return;
+    }
+    cancelAll();
+}
+
+void BatchPipeline::finishItem(size_t index, BatchItemState state, BatchStage stage) {
+    BatchItemResult& result = results_[index];
+    result.state = state;
+    result.stoppedAt = state == BatchItemState::SUCCEEDED ? BatchStage::NONE : stage;
+    result.telemetry.cancelled = state == BatchItemState::CANCELLED;
+    if (stages_.onItemFinished) {
+        stages_.onItemFinished(index, result);
+    }
+}
+
+bool BatchPipeline::run(std::atomic<bool>& jobCancelFlag) {
+    jobCancelFlag_ = &jobCancelFlag;
+    const auto start = std::chrono::steady_clock::now();
+    LOGI("Пакет: старт, элементов=%zu", itemCount_);
+
+    std::thread decoder(&BatchPipeline::decodeLoop, this);
+    std::thread encoder(&BatchPipeline::encodeLoop, this);
+    inferLoop();
+    decoder.join();
+    encoder.join();
+
+    size_t succeeded = 0;
+    size_t failed = 0;
+    size_t cancelled = 0;
+    for (const BatchItemResult& result : results_) {
+        switch (result.state) {
+            case BatchItemState::SUCCEEDED: ++succeeded; break;
+            case BatchItemState::FAILED: ++failed; break;
+            case BatchItemState::CANCELLED: ++cancelled; break;
+            case BatchItemState::PENDING: break;
+        }
+    }
+    LOGI("Пакет: завершён за %lldмс, успешно=%zu ошибок=%zu отменено=%zu",
+         static_cast<long long>(elapsedMs(start)), succeeded, failed, cancelled);
+    return failed == 0;
+}
+
+void BatchPipeline::decodeLoop() {
+    if (stages_.onStageThreadStart) {
+        stages_.onStageThreadStart();
+    }
+    for (size_t index = 0; index < itemCount_; ++index) {
+        decoded_->awaitCapacity();
+        propagateJobCancel();
+        if (isCancelled(index)) {
+            finishItem(index, BatchItemState::CANCELLED, BatchStage::DECODE);
+            continue;
+        }
+        BatchFrame frame;
+        frame.index = index;
+        const auto start = std::chrono::steady_clock::now();
+        bool ok;
+        {
+            TraceScope trace("batch_decode", static_cast<int>(index));
+            ok = stages_.decode && stages_.decode(frame);
+        }
+        results_[index].decodeMs = elapsedMs(start);
+        if (!ok || frame.image.empty()) {
+            LOGW("Пакет: элемент %zu не декодирован", index);
+            finishItem(index, BatchItemState::FAILED, BatchStage::DECODE);
+            continue;
+        }
+        if (frame.width <= 0 || frame.height <= 0) {
+            frame.width = frame.image.w;
+            frame.height = frame.image.h;
+        }
+        results_[index].width = frame.width;
+        results_[index].height = frame.height;
+        decoded_->push(std::move(frame));
+    }
+    decoded_->close();
+    if (stages_.onStageThreadStop) {
+        stages_.onStageThreadStop();
+    }
+}
+
+void BatchPipeline::inferLoop() {
+    BatchFrame frame;
+    while (decoded_->pop(frame)) {
+        const size_t index = frame.index;
+        propagateJobCancel();
+        if (isCancelled(index)) {
+            finishItem(index, BatchItemState::CANCELLED, BatchStage::INFER);
+            continue;
+        }
+        BatchItemResult& result = results_[index];
+        RunContext context(itemCancelFlags_[index], result.telemetry);
+        context.setSustained(true);
+        ncnn::Mat output;
+        const auto start = std::chrono::steady_clock::now();
+        bool ok;
+        {
+            TraceScope trace("batch_infer", static_cast<int>(index));
+            ok = stages_.infer && stages_.infer(frame, output, context);
+        }
+        result.inferMs = elapsedMs(start);
+        if (isCancelled(index)) {
+            finishItem(index, BatchItemState::CANCELLED, BatchStage::INFER);
+            continue;
+        }
+        if (!ok) {
+            LOGW("Пакет: вывод элемента %zu завершился ошибкой", index);
+            finishItem(index, BatchItemState::FAILED, BatchStage::INFER);
+            continue;
+        }
+        // Вход больше не нужен: освобождаем его до передачи кадра кодировщику.
+        frame.image = output;
+        inferred_->push(std::move(frame));
+        frame = BatchFrame();
+    }
+    inferred_->close();
+}
+
+void BatchPipeline::encodeLoop() {
+    if (stages_.onStageThreadStart) {
+        stages_.onStageThreadStart();
+    }
+    BatchFrame frame;
+    while (inferred_->pop(frame)) {
+        const size_t index = frame.index;
+        propagateJobCancel();
+        if (isCancelled(index)) {
+            finishItem(index, BatchItemState::CANCELLED, BatchStage::ENCODE);
+            frame = BatchFrame();
+            continue;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        bool ok;
+        {
+            TraceScope trace("batch_encode", static_cast<int>(index));
+            ok = stages_.encode && stages_.encode(frame);
+        }
+        results_[index].encodeMs = elapsedMs(start);
+        if (ok) {
+            results_[index].telemetry.imageStats = frame.imageStats;
+        } else {
+            LOGW("Пакет: элемент %zu не закодирован", index);
+        }
+        finishItem(index, ok ? BatchItemState::SUCCEEDED : BatchItemState::FAILED, BatchStage::ENCODE);
+        frame = BatchFrame();
+    }
+    if (stages_.onStageThreadStop) {
+        stages_.onStageThreadStop();
+    }
+}
+
+}
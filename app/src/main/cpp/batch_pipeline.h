@@ -0,0 +1,126 @@
+#ifndef BATCH_PIPELINE_H
+#define BATCH_PIPELINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <ncnn/mat.h>
+#include "ncnn_engine.h"
+
+namespace kotopogoda {
+
+// Коды совпадают с NativeEnhanceController.BatchItemState.
+enum class BatchItemState {
+    PENDING = 0,
+    SUCCEEDED = 1,
+    FAILED = 2,
+    CANCELLED = 3,
+};
+
+// Коды совпадают с NativeEnhanceController.BatchStage.
+enum class BatchStage {
+    NONE = -1,
+    DECODE = 0,
+    INFER = 1,
+    ENCODE = 2,
+};
+
+struct BatchItemResult {
+    BatchItemState state = BatchItemState::PENDING;
+    // Стадия, на которой элемент завершился неуспешно или был отменён.
+    BatchStage stoppedAt = BatchStage::NONE;
+    int64_t decodeMs = 0;
+    int64_t inferMs = 0;
+    int64_t encodeMs = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+    TelemetryData telemetry;
+};
+
+// Кадр, который переходит между стадиями. image — планарный float RGB;
+// codecState — непрозрачное состояние декодера, которое нужно кодировщику
+// (например, Bitmap источника, куда записывается результат). width и height —
+// размер результата: декодер и вывод могут работать на уменьшенном image, тогда
+// кодировщик увеличивает его до этого размера. 0 — размер image после
+// декодирования. imageStats кодировщик заполняет попутно с записью результата;
+// после успешного кодирования она попадает в телеметрию элемента.
+struct BatchFrame {
+    size_t index = 0;
+    ncnn::Mat image;
+    std::shared_ptr<void> codecState;
+    int width = 0;
+    int height = 0;
+    ImageStats imageStats;
+};
+
+struct BatchStages {
+    // Заполняет frame.image (и при необходимости frame.codecState).
+    std::function<bool(BatchFrame& frame)> decode;
+    std::function<bool(const BatchFrame& frame, ncnn::Mat& output, RunContext& context)> infer;
+    // Получает frame с результатом вывода в frame.image.
+    std::function<bool(BatchFrame& frame)> encode;
+    // Вызываются в потоках декодирования и кодирования (например, для AttachCurrentThread).
+    std::function<void()> onStageThreadStart;
+    std::function<void()> onStageThreadStop;
+    // Вызывается один раз на элемент из потока, который его завершил.
+    std::function<void(size_t index, const BatchItemResult& result)> onItemFinished;
+};
+
+// Пакетная обработка в три стадии: декодирование, вывод и кодирование идут в
+// своих потоках и перекрываются — пока выводится элемент N, декодируется N+1 и
+// кодируется N-1. Между стадиями очереди ёмкостью в один кадр, поэтому в памяти
+// одновременно не больше пяти изображений независимо от размера пакета. У
+// каждого элемента свой флаг отмены. Отмена задачи целиком — cancelAll (её
+// вызывает EnhanceJob::onCancel): текущий вывод прерывается сразу, а не после
+// элемента; флаг задачи, переданный в run, дополнительно проверяется на
+// границах стадий.
+class BatchPipeline {
+public:
+    BatchPipeline(size_t itemCount, BatchStages stages);
+    ~BatchPipeline();
+
+    BatchPipeline(const BatchPipeline&) = delete;
+    BatchPipeline& operator=(const BatchPipeline&) = delete;
+
+    // Блокирует до завершения всех элементов. Вывод выполняется в вызывающем
+    // потоке. true — ни один элемент не завершился ошибкой.
+    bool run(std::atomic<bool>& jobCancelFlag);
+
+    // Отменяет элемент: ещё не начатый пропускается, текущий вывод прерывается
+    // между тайлами. false — индекс вне диапазона.
+    bool cancelItem(size_t index);
+
+    // Отменяет все элементы: как cancelItem для каждого, включая текущий вывод
+    // и паузу устойчивого режима перед ним.
+    void cancelAll();
+
+    size_t itemCount() const { return itemCount_; }
+    // Читать после возврата из run.
+    const std::vector<BatchItemResult>& results() const { return results_; }
+
+private:
+    bool isCancelled(size_t index) const;
+    void propagateJobCancel();
+    void finishItem(size_t index, BatchItemState state, BatchStage stage);
+
+    void decodeLoop();
+    void inferLoop();
+    void encodeLoop();
+
+    struct Channel;
+
+    const size_t itemCount_;
+    BatchStages stages_;
+    std::unique_ptr<std::atomic<bool>[]> itemCancelFlags_;
+    std::vector<BatchItemResult> results_;
+    std::atomic<bool>* jobCancelFlag_ = nullptr;
+    std::unique_ptr<Channel> decoded_;
+    std::unique_ptr<Channel> inferred_;
+};
+
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include "body_digest.h"
+#include "sha256_verifier.h"
+#include <memory>
+
+namespace kotopogoda {
+
+FdStreamResult computeBodyDigests(
+    int fd,
+    const BodyDigestSpec& spec,
+    BodyDigests& digests,
+    const FdProgressCallback& progress
+) {
+    Sha256 content;
+    Sha256 framed;
+    std::unique_ptr<HmacSha256> mac;
+
+    if (spec.framed) {
+        framed.update(spec.framePrefix.data(), spec.framePrefix.size());
+    }
+    if (spec.signedBody) {
+        mac.reset(new HmacSha256(spec.hmacKey.data(), spec.hmacKey.size()));
+        mac->update(spec.hmacPrefix.data(), spec.hmacPrefix.size());
+    }
+
+    const bool framedEnabled = spec.framed;
+    HmacSha256* macPtr = mac.get();
+    const FdStreamResult result = streamFd(
+        fd,
+        [&](const uint8_t* data, size_t size) {
+            // Порция читается с диска один раз и ещё горячая в кэше CPU для остальных дайджестов.
+            content.update(data, size);
+            if (framedEnabled) {
+                framed.update(data, size);
+            }
+            if (macPtr != nullptr) {
+                macPtr->update(data, size);
+            }
+        },
+        progress
+    );
+    if (result != FdStreamResult::OK) {
+        return result;
+    }
+
+    digests.bodyBytes = content.totalBytes();
+    digests.contentSha256 = content.finalHex();
+    if (spec.framed) {
+        framed.update(spec.frameSuffix.data(), spec.frameSuffix.size());
+        digests.framedSha256 = framed.finalHex();
+    } else {
+        digests.framedSha256.clear();
+    }
+    if (macPtr != nullptr) {
+        digests.hmacSha256 = macPtr->finalHex();
+    } else {
+        digests.hmacSha256.clear();
+    }
+    return FdStreamResult::OK;
+}
+
+}
@@ -0,0 +1,42 @@
+#ifndef BODY_DIGEST_H
+#define BODY_DIGEST_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "fd_stream.h"
+
+namespace kotopogoda {
+
+// Какие дайджесты считать за один проход по телу запроса.
+struct BodyDigestSpec {
+    // SHA-256(framePrefix || body || frameSuffix), например multipart-обёртка файла.
+    bool framed = false;
+    std::vector<uint8_t> framePrefix;
+    std::vector<uint8_t> frameSuffix;
+
+    // HMAC-SHA256(hmacKey, hmacPrefix || body) с каноническим префиксом вызывающей стороны.
+    bool signedBody = false;
+    std::vector<uint8_t> hmacKey;
+    std::vector<uint8_t> hmacPrefix;
+};
+
+struct BodyDigests {
+    std::string contentSha256;
+    std::string framedSha256;
+    std::string hmacSha256;
+    uint64_t bodyBytes = 0;
+};
+
+// Один проход streamFd по fd: SHA-256 содержимого всегда, framed SHA-256 и
+// HMAC — по spec. При ошибке или отмене digests не заполняются.
+FdStreamResult computeBodyDigests(
+    int fd,
+    const BodyDigestSpec& spec,
+    BodyDigests& digests,
+    const FdProgressCallback& progress = FdProgressCallback()
+);
+
+}
+
+#endif
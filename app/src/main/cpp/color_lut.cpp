@@ -0,0 +1,312 @@
+#include "color_lut.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <thread>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define KOTOPOGODA_COLOR_LUT_NEON 1
+#endif
+
+namespace kotopogoda {
+
+namespace {
+
+// Ранний выход EnhanceEngine.applyVibranceAndSaturation.
+constexpr float kIdentityEpsilon = 1e-3f;
+
+// Разброс каналов, до которого пиксель считается точно: ближе к серой оси
+// LUT расходится с Kotlin больше допуска таблицы из-за разрыва vibrance.
+constexpr int kNeutralSpread65 = 32;
+constexpr int kNeutralSpread33 = 48;
+
+// Полоса на поток не короче: короткие полосы не окупают запуск потока.
+constexpr int kMinBandRows = 64;
+
+inline float clamp01(float value) {
+    return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+inline uint32_t toChannel(float value) {
+    const int level = static_cast<int>(std::floor(value * 255.0f + 0.5f));
+    return static_cast<uint32_t>(std::min(255, std::max(0, level)));
+}
+
+// S в HSV после vibrance и saturation до ограничения сверху: там, где она
+// переходит через 1, у стадии излом.
+float gainedSaturation(float r, float g, float b, float vibranceGain, float saturationGain) {
+    const float maxValue = std::max(r, std::max(g, b));
+    const float minValue = std::min(r, std::min(g, b));
+    const float saturation = maxValue == 0.0f ? 0.0f : (maxValue - minValue) / maxValue;
+    return clamp01(saturation + (1.0f - saturation) * vibranceGain) * saturationGain;
+}
+
+// rgbToHsv -> vibrance/saturation -> hsvToRgb из EnhanceEngine, во float и в
+// том же порядке операций.
+void vibranceSaturation(float r, float g, float b, float vibranceGain, float saturationGain, float out[3]) {
+    const float maxValue = std::max(r, std::max(g, b));
+    const float minValue = std::min(r, std::min(g, b));
+    const float delta = maxValue - minValue;
+    float hue;
+    if (delta == 0.0f) {
+        hue = 0.0f;
+    } else if (maxValue == r) {
+        hue = std::fmod((g - b) / delta, 6.0f);
+    } else if (maxValue == g) {
+        hue = ((b - r) / delta) + 2.0f;
+    } else {
+        hue = ((r - g) / delta) + 4.0f;
+    }
+    hue *= 60.0f;
+    if (hue < 0.0f) {
+        hue += 360.0f;
+    }
+    const float saturation = maxValue == 0.0f ? 0.0f : delta / maxValue;
+    const float value = maxValue;
+
+    const float vibrance = clamp01(saturation + (1.0f - saturation) * vibranceGain);
+    const float s = clamp01(vibrance * saturationGain);
+    if (s == 0.0f) {
+        out[0] = value;
+        out[1] = value;
+        out[2] = value;
+        return;
+    }
+    const float sector = std::fmod(hue / 60.0f, 6.0f);
+    const int i = static_cast<int>(sector);
+    const float f = sector - static_cast<float>(i);
+    const float p = value * (1.0f - s);
+    const float q = value * (1.0f - s * f);
+    const float t = value * (1.0f - s * (1.0f - f));
+    switch (i) {
+        case 0: out[0] = value; out[1] = t; out[2] = p; break;
+        case 1: out[0] = q; out[1] = value; out[2] = p; break;
+        case 2: out[0] = p; out[1] = value; out[2] = t; break;
+        case 3: out[0] = p; out[1] = q; out[2] = value; break;
+        case 4: out[0] = t; out[1] = p; out[2] = value; break;
+        default: out[0] = value; out[1] = p; out[2] = q; break;
+    }
+}
+
+std::mutex gLutCacheMutex;
+std::shared_ptr<const ColorLut> gLutCache;
+
+}
+
+ColorLut::ColorLut(float vibranceGain, float saturationGain, int size)
+    : size_(size == kSize33 ? kSize33 : kSize65),
+      vibranceGain_(vibranceGain),
+      saturationGain_(saturationGain),
+      neutralSpread_(size_ == kSize33 ? kNeutralSpread33 : kNeutralSpread65),
+      nodes_(static_cast<size_t>(size_) * size_ * size_ * 4),
+      exactCells_(static_cast<size_t>(size_ - 1) * (size_ - 1) * (size_ - 1)) {
+    const float last = static_cast<float>(size_ - 1);
+    std::vector<float> gained(static_cast<size_t>(size_) * size_ * size_);
+    float* node = nodes_.data();
+    for (int b = 0; b < size_; ++b) {
+        for (int g = 0; g < size_; ++g) {
+            for (int r = 0; r < size_; ++r) {
+                const float fr = static_cast<float>(r) / last;
+                const float fg = static_cast<float>(g) / last;
+                const float fb = static_cast<float>(b) / last;
+                vibranceSaturation(fr, fg, fb, vibranceGain, saturationGain, node);
+                node[3] = 0.0f;
+                node += 4;
+                gained[(static_cast<size_t>(b) * size_ + g) * size_ + r] =
+                    gainedSaturation(fr, fg, fb, vibranceGain, saturationGain);
+            }
+        }
+    }
+
+    // S = 1 - min / max внутри ячейки принимает крайние значения в углах, а
+    // gainedSaturation от S монотонна: излом проходит через ячейку, только если
+    // углы лежат по разные стороны от 1.
+    const int cells = size_ - 1;
+    for (int b = 0; b < cells; ++b) {
+        for (int g = 0; g < cells; ++g) {
+            for (int r = 0; r < cells; ++r) {
+                float low = 2.0f;
+                float high = 0.0f;
+                for (int corner = 0; corner < 8; ++corner) {
+                    const size_t index = (static_cast<size_t>(b + ((corner >> 2) & 1)) * size_ +
+                                          (g + ((corner >> 1) & 1))) * size_ + (r + (corner & 1));
+                    low = std::min(low, gained[index]);
+                    high = std::max(high, gained[index]);
+                }
+                exactCells_[(static_cast<size_t>(b) * cells + g) * cells + r] = low < 1.0f && high > 1.0f ? 1 : 0;
+            }
+        }
+    }
+}
+
+void ColorLut::applyExact(uint32_t px, uint32_t* dst) const {
+    float rgb[3];
+    vibranceSaturation(
+        static_cast<float>((px >> 16) & 0xFF) / 255.0f,
+        static_cast<float>((px >> 8) & 0xFF) / 255.0f,
+        static_cast<float>(px & 0xFF) / 255.0f,
+        vibranceGain_,
+        saturationGain_,
+        rgb
+    );
+    *dst = (px & 0xFF000000u) | (toChannel(rgb[0]) << 16) | (toChannel(rgb[1]) << 8) | toChannel(rgb[2]);
+}
+
+void ColorLut::applyRow(const uint32_t* src, uint32_t* dst, int count) const {
+    const float scale = static_cast<float>(size_ - 1) / 255.0f;
+    const int maxCell = size_ - 2;
+    const size_t cells = static_cast<size_t>(size_ - 1);
+    const size_t strideG = static_cast<size_t>(size_) * 4;
+    const size_t strideB = strideG * size_;
+    const float* nodes = nodes_.data();
+
+    for (int x = 0; x < count; ++x) {
+        const uint32_t px = src[x];
+        const uint32_t alpha = px & 0xFF000000u;
+        const int r8 = static_cast<int>((px >> 16) & 0xFF);
+        const int g8 = static_cast<int>((px >> 8) & 0xFF);
+        const int b8 = static_cast<int>(px & 0xFF);
+        const int spread = std::max(r8, std::max(g8, b8)) - std::min(r8, std::min(g8, b8));
+        if (spread <= neutralSpread_) {
+            applyExact(px, dst + x);
+            continue;
+        }
+
+        const float fr = static_cast<float>(r8) * scale;
+        const float fg = static_cast<float>(g8) * scale;
+        const float fb = static_cast<float>(b8) * scale;
+        const int ir = std::min(static_cast<int>(fr), maxCell);
+        const int ig = std::min(static_cast<int>(fg), maxCell);
+        const int ib = std::min(static_cast<int>(fb), maxCell);
+        if (exactCells_[(static_cast<size_t>(ib) * cells + ig) * cells + ir] != 0) {
+            applyExact(px, dst + x);
+            continue;
+        }
+        const float dr = fr - static_cast<float>(ir);
+        const float dg = fg - static_cast<float>(ig);
+        const float db = fb - static_cast<float>(ib);
+
+        // Тетраэдр выбирается по порядку дробных частей: c000 -> cA -> cB -> c111
+        // идут вдоль рёбер куба по убыванию dr, dg, db.
+        const size_t stepR = 4;
+        const size_t stepG = strideG;
+        const size_t stepB = strideB;
+        size_t stepA;
+        size_t stepAB;
+        float w1;
+        float w2;
+        float w3;
+        if (dr > dg) {
+            if (dg > db) {
+                stepA = stepR; stepAB = stepR + stepG; w1 = dr; w2 = dg; w3 = db;
+            } else if (dr > db) {
+                stepA = stepR; stepAB = stepR + stepB; w1 = dr; w2 = db; w3 = dg;
+            } else {
+                stepA = stepB; stepAB = stepB + stepR; w1 = db; w2 = dr; w3 = dg;
+            }
+        } else {
+            if (db > dg) {
+                stepA = stepB; stepAB = stepB + stepG; w1 = db; w2 = dg; w3 = dr;
+            } else if (db > dr) {
+                stepA = stepG; stepAB = stepG + stepB; w1 = dg; w2 = db; w3 = dr;
+            } else {
+                stepA = stepG; stepAB = stepG + stepR; w1 = dg; w2 = dr; w3 = db;
+            }
+        }
+        const float* c000 = nodes + static_cast<size_t>(ib) * strideB + static_cast<size_t>(ig) * strideG +
+            static_cast<size_t>(ir) * 4;
+        const float* cA = c000 + stepA;
+        const float* cB = c000 + stepAB;
+        const float* c111 = c000 + stepR + stepG + stepB;
+
+#if defined(KOTOPOGODA_COLOR_LUT_NEON)
+        const float32x4_t v000 = vld1q_f32(c000);
+        const float32x4_t vA = vld1q_f32(cA);
+        const float32x4_t vB = vld1q_f32(cB);
+        const float32x4_t v111 = vld1q_f32(c111);
+        float32x4_t v = vmlaq_n_f32(v000, vsubq_f32(vA, v000), w1);
+        v = vmlaq_n_f32(v, vsubq_f32(vB, vA), w2);
+        v = vmlaq_n_f32(v, vsubq_f32(v111, vB), w3);
+        const uint32x4_t q = vcvtq_u32_f32(vaddq_f32(vmulq_n_f32(v, 255.0f), vdupq_n_f32(0.5f)));
+        dst[x] = alpha | (vgetq_lane_u32(q, 0) << 16) | (vgetq_lane_u32(q, 1) << 8) | vgetq_lane_u32(q, 2);
+#else
+        uint32_t channels[3];
+        for (int c = 0; c < 3; ++c) {
+            const float v = c000[c] + (cA[c] - c000[c]) * w1 + (cB[c] - cA[c]) * w2 + (c111[c] - cB[c]) * w3;
+            channels[c] = toChannel(v);
+        }
+        dst[x] = alpha | (channels[0] << 16) | (channels[1] << 8) | channels[2];
+#endif
+    }
+}
+
+void ColorLut::applyRgbRow(uint8_t* rgb, int count) const {
+    // Короткими порциями через applyRow: буфер на стеке, без аллокаций на строку.
+    constexpr int kChunk = 256;
+    uint32_t argb[kChunk];
+    for (int start = 0; start < count; start += kChunk) {
+        const int n = std::min(kChunk, count - start);
+        uint8_t* chunk = rgb + static_cast<size_t>(start) * 3;
+        for (int i = 0; i < n; ++i) {
+            const uint8_t* p = chunk + i * 3;
+            argb[i] = 0xFF000000u | (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | p[2];
+        }
+        applyRow(argb, argb, n);
+        for (int i = 0; i < n; ++i) {
+            uint8_t* p = chunk + i * 3;
+            p[0] = static_cast<uint8_t>(argb[i] >> 16);
+            p[1] = static_cast<uint8_t>(argb[i] >> 8);
+            p[2] = static_cast<uint8_t>(argb[i]);
+        }
+    }
+}
+
+bool isIdentityColorProfile(float vibranceGain, float saturationGain) {
+    return std::fabs(vibranceGain) <= kIdentityEpsilon && std::fabs(saturationGain - 1.0f) <= kIdentityEpsilon;
+}
+
+std::shared_ptr<const ColorLut> vibranceSaturationLut(float vibranceGain, float saturationGain, int size) {
+    const int lutSize = size == ColorLut::kSize33 ? ColorLut::kSize33 : ColorLut::kSize65;
+    {
+        std::lock_guard<std::mutex> lock(gLutCacheMutex);
+        if (gLutCache && gLutCache->size() == lutSize && gLutCache->vibranceGain() == vibranceGain &&
+            gLutCache->saturationGain() == saturationGain) {
+            return gLutCache;
+        }
+    }
+    // Сборка вне блокировки: 65^3 узлов — несколько миллисекунд.
+    TRACE_SCOPE("ColorLut::build");
+    auto lut = std::make_shared<const ColorLut>(vibranceGain, saturationGain, lutSize);
+    std::lock_guard<std::mutex> lock(gLutCacheMutex);
+    gLutCache = lut;
+    return lut;
+}
+
+bool applyColorLut(const ColorLut& lut, const uint32_t* src, uint32_t* dst, int width, int height, int threads) {
+    if (src == nullptr || dst == nullptr || width <= 0 || height <= 0) {
+        return false;
+    }
+    TRACE_SCOPE("applyColorLut");
+    const int bands = std::max(1, std::min(threads, height / kMinBandRows));
+    auto runBand = [&lut, src, dst, width, height, bands](int band) {
+        const int y0 = static_cast<int>(static_cast<int64_t>(height) * band / bands);
+        const int y1 = static_cast<int>(static_cast<int64_t>(height) * (band + 1) / bands);
+        const size_t offset = static_cast<size_t>(y0) * width;
+        lut.applyRow(src + offset, dst + offset, (y1 - y0) * width);
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<size_t>(bands - 1));
+    for (int band = 1; band < bands; ++band) {
+        workers.emplace_back(runBand, band);
+    }
+    runBand(0);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return true;
+}
+
+}
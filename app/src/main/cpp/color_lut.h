@@ -0,0 +1,73 @@
+#ifndef COLOR_LUT_H
+#define COLOR_LUT_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace kotopogoda {
+
+// Цветовая стадия профиля EnhanceEngine (applyVibranceAndSaturation: S в HSV
+// поднимается vibrance и умножается на saturation, H и V сохраняются),
+// запечённая в 3D LUT size^3 по RGB. Применяется тетраэдрической
+// интерполяцией за один проход вместо пересчёта HSV на каждый пиксель.
+//
+// У почти серых пикселей оттенок не определён, и vibrance в Kotlin
+// разрывна на нейтральной оси (серый получает H = 0 и S = vibranceGain),
+// поэтому пиксели с разбросом каналов не больше neutralSpread() считаются
+// точно, как в Kotlin. Так же считаются ячейки, через которые проходит излом
+// ограничения S <= 1: интерполяция его не повторяет. Остальные отличаются от
+// Kotlin не больше чем на 1 LSB для 65^3 и на 2 LSB для 33^3 (зато таблица
+// 33^3 в восемь раз меньше).
+class ColorLut {
+public:
+    static constexpr int kSize33 = 33;
+    static constexpr int kSize65 = 65;
+
+    // size — kSize33 или kSize65 (иначе kSize65).
+    ColorLut(float vibranceGain, float saturationGain, int size);
+
+    ColorLut(const ColorLut&) = delete;
+    ColorLut& operator=(const ColorLut&) = delete;
+
+    int size() const { return size_; }
+    float vibranceGain() const { return vibranceGain_; }
+    float saturationGain() const { return saturationGain_; }
+    // Наибольший разброс каналов (max - min, 8 бит), который считается точно.
+    int neutralSpread() const { return neutralSpread_; }
+
+    // ARGB (0xAARRGGBB) -> ARGB, альфа как есть; src и dst могут совпадать.
+    void applyRow(const uint32_t* src, uint32_t* dst, int count) const;
+    // То же на месте для 8-битной RGB-строки (по 3 байта на пиксель), которую
+    // matToBitmap и JpegBandEncoder собирают при квантовании.
+    void applyRgbRow(uint8_t* rgb, int count) const;
+
+private:
+    // Пиксель по формуле Kotlin, без таблицы.
+    void applyExact(uint32_t px, uint32_t* dst) const;
+
+    int size_;
+    float vibranceGain_;
+    float saturationGain_;
+    int neutralSpread_;
+    // Узлы по 4 float (R, G, B и пустой лейн), r меняется быстрее всего.
+    std::vector<float> nodes_;
+    // 1 — ячейку пересекает излом S = 1, пиксели в ней считаются точно.
+    std::vector<uint8_t> exactCells_;
+};
+
+// true — цветовая стадия при этих коэффициентах ничего не меняет (как ранний
+// выход applyVibranceAndSaturation).
+bool isIdentityColorProfile(float vibranceGain, float saturationGain);
+
+// LUT для коэффициентов профиля. Последняя собранная таблица кешируется:
+// подряд идущие кадры с тем же профилем не пересобирают её.
+std::shared_ptr<const ColorLut> vibranceSaturationLut(float vibranceGain, float saturationGain, int size);
+
+// Применяет lut к кадру ARGB width x height полосами строк в threads потоках.
+// false — неверные размеры.
+bool applyColorLut(const ColorLut& lut, const uint32_t* src, uint32_t* dst, int width, int height, int threads);
+
+}
+
+#endif
@@ -0,0 +1,160 @@
+#include "content_chunker.h"
+#include <algorithm>
+#include <cstring>
+
+namespace kotopogoda {
+
+namespace {
+
+// Таблица Gear: 256 псевдослучайных 64-битных слов из splitmix64 с фиксированным
+// зерном. Таблица часть формата (kFormatVersion) — её нельзя менять.
+struct GearTable {
+    uint64_t values[256];
+
+    GearTable() {
+        uint64_t seed = 0x6b6f746f706f6764ULL;
+        for (uint64_t& value : values) {
+            seed += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            value = z ^ (z >> 31);
+        }
+    }
+};
+
+const GearTable& gearTable() {
+    static const GearTable table;
+    return table;
+}
+
+int log2Rounded(uint32_t value) {
+    int bits = 0;
+    while ((1u << (bits + 1)) <= value) {
+        ++bits;
+    }
+    // Ближайшая степень двойки.
+    if (bits < 31 && value - (1u << bits) > (1u << (bits + 1)) - value) {
+        ++bits;
+    }
+    return bits;
+}
+
+// В Gear-хеше старшие биты зависят от последних 64 байт, поэтому маска
+// берётся из старших бит.
+uint64_t topBitsMask(int bits) {
+    bits = std::max(1, std::min(bits, 63));
+    return ~0ULL << (64 - bits);
+}
+
+}
+
+ContentDefinedChunker::ContentDefinedChunker(const CdcParams& params)
+    : params_(params),
+      maskStrict_(0),
+      maskLoose_(0),
+      hash_(0),
+      current_(0),
+      offset_(0),
+      finished_(false) {
+    if (!isValid(params_)) {
+        params_ = CdcParams();
+    }
+    // Уровень нормализации 2 (FastCDC): ±2 бита от log2(avgSize).
+    const int bits = log2Rounded(params_.avgSize);
+    maskStrict_ = topBitsMask(bits + 2);
+    maskLoose_ = topBitsMask(bits - 2);
+}
+
+bool ContentDefinedChunker::isValid(const CdcParams& params) {
+    return params.minSize >= 64 &&
+           params.minSize < params.avgSize &&
+           params.avgSize < params.maxSize &&
+           params.maxSize <= (1u << 30);
+}
+
+void ContentDefinedChunker::update(const uint8_t* data, size_t size) {
+    if (finished_ || size == 0) {
+        return;
+    }
+    contentHasher_.update(data, size);
+
+    const uint64_t* gear = gearTable().values;
+    size_t pos = 0;
+    while (pos < size) {
+        size_t i = pos;
+        bool boundary = false;
+
+        // Первые minSize байт чанка не могут быть границей — не хешируем их.
+        if (current_ < params_.minSize) {
+            const size_t skip = std::min<size_t>(params_.minSize - current_, size - i);
+            i += skip;
+            current_ += static_cast<uint32_t>(skip);
+        }
+
+        while (i < size) {
+            hash_ = (hash_ << 1) + gear[data[i]];
+            ++i;
+            ++current_;
+            const uint64_t mask = current_ < params_.avgSize ? maskStrict_ : maskLoose_;
+            if ((hash_ & mask) == 0 || current_ >= params_.maxSize) {
+                boundary = true;
+                break;
+            }
+        }
+
+        chunkHasher_.update(data + pos, i - pos);
+        pos = i;
+        if (boundary) {
+            emitChunk();
+        }
+    }
+}
+
+void ContentDefinedChunker::finish() {
+    if (finished_) {
+        return;
+    }
+    if (current_ > 0) {
+        emitChunk();
+    }
+    finished_ = true;
+
+    Sha256 root;
+    for (const CdcChunk& chunk : chunks_) {
+        root.update(chunk.digest, sizeof(chunk.digest));
+    }
+    rootDigestHex_ = root.finalHex();
+    contentSha256Hex_ = contentHasher_.finalHex();
+}
+
+void ContentDefinedChunker::emitChunk() {
+    CdcChunk chunk;
+    chunk.offset = offset_;
+    chunk.length = current_;
+    chunkHasher_.final(chunk.digest);
+    chunks_.push_back(chunk);
+
+    offset_ += current_;
+    current_ = 0;
+    hash_ = 0;
+    chunkHasher_.reset();
+}
+
+FdStreamResult ContentDefinedChunker::chunkFd(
+    int fd,
+    ContentDefinedChunker& chunker,
+    const FdProgressCallback& progress
+) {
+    const FdStreamResult result = streamFd(
+        fd,
+        [&chunker](const uint8_t* data, size_t size) { chunker.update(data, size); },
+        progress
+    );
+    if (result == FdStreamResult::OK) {
+        chunker.finish();
+    }
+    return result;
+}
+
+}
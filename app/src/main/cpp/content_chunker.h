@@ -0,0 +1,78 @@
+#ifndef CONTENT_CHUNKER_H
+#define CONTENT_CHUNKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "fd_stream.h"
+#include "sha256_verifier.h"
+
+namespace kotopogoda {
+
+// Границы чанков FastCDC: до avgSize действует строгая маска (реже режем),
+// после — мягкая (чаще режем), что стягивает распределение длин к avgSize.
+struct CdcParams {
+    uint32_t minSize = 128 * 1024;
+    uint32_t avgSize = 512 * 1024;
+    uint32_t maxSize = 2 * 1024 * 1024;
+};
+
+struct CdcChunk {
+    uint64_t offset = 0;
+    uint32_t length = 0;
+    uint8_t digest[Sha256::kDigestSize] = {};
+};
+
+// Разбиение потока на чанки по содержимому (Gear rolling hash, FastCDC) с
+// SHA-256 каждого чанка и всего содержимого за один проход. Границы зависят
+// только от байтов, а не от того, какими порциями вызывается update().
+//
+// Корневой дайджест — SHA-256 от конкатенации дайджестов чанков по порядку;
+// для пустого входа чанков нет и корень равен SHA-256 пустой строки.
+// Таблица Gear и маски фиксированы: их изменение меняет границы, поэтому
+// формат версионируется kFormatVersion.
+class ContentDefinedChunker {
+public:
+    static constexpr int kFormatVersion = 1;
+
+    explicit ContentDefinedChunker(const CdcParams& params = CdcParams());
+
+    void update(const uint8_t* data, size_t size);
+    void finish();
+
+    const std::vector<CdcChunk>& chunks() const { return chunks_; }
+    const std::string& rootDigestHex() const { return rootDigestHex_; }
+    const std::string& contentSha256Hex() const { return contentSha256Hex_; }
+    uint64_t totalBytes() const { return offset_ + current_; }
+
+    static bool isValid(const CdcParams& params);
+
+    // Читает fd через streamFd и заполняет чанкер; при ошибке или отмене
+    // результат чанкера не финализируется.
+    static FdStreamResult chunkFd(
+        int fd,
+        ContentDefinedChunker& chunker,
+        const FdProgressCallback& progress = FdProgressCallback()
+    );
+
+private:
+    void emitChunk();
+
+    CdcParams params_;
+    uint64_t maskStrict_;
+    uint64_t maskLoose_;
+    uint64_t hash_;
+    uint32_t current_;
+    uint64_t offset_;
+    bool finished_;
+    Sha256 chunkHasher_;
+    Sha256 contentHasher_;
+    std::vector<CdcChunk> chunks_;
+    std::string rootDigestHex_;
+    std::string contentSha256Hex_;
+};
+
+}
+
+#endif
@@ -0,0 +1,210 @@
+#include "cpu_accounting.h"
+#include "ncnn_engine.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <dirent.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LOG_TAG "CpuAccounting"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+namespace kotopogoda {
+
+namespace {
+
+struct TaskSample {
+    int64_t ticks = 0;
+    int processor = -1;
+};
+
+int64_t threadCpuNanos() {
+    timespec ts{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+int64_t timevalMicros(const timeval& tv) {
+    return static_cast<int64_t>(tv.tv_sec) * 1000000LL + tv.tv_usec;
+}
+
+// /proc/self/task/<tid>/stat: после ")" идут поля с третьего (state); utime и
+// stime — 14-е и 15-е, processor — 39-е.
+bool readTaskSample(const char* path, TaskSample& sample) {
+    FILE* file = std::fopen(path, "re");
+    if (file == nullptr) {
+        return false;
+    }
+    char line[1024];
+    const bool read = std::fgets(line, sizeof(line), file) != nullptr;
+    std::fclose(file);
+    char* closing = read ? std::strrchr(line, ')') : nullptr;
+    if (closing == nullptr) {
+        return false;
+    }
+    int64_t utime = 0;
+    int64_t stime = 0;
+    char* save = nullptr;
+    int field = 3;
+    for (char* token = strtok_r(closing + 1, " ", &save);
+         token != nullptr && field <= 39;
+         token = strtok_r(nullptr, " ", &save), ++field) {
+        if (field == 14) {
+            utime = std::strtoll(token, nullptr, 10);
+        } else if (field == 15) {
+            stime = std::strtoll(token, nullptr, 10);
+        } else if (field == 39) {
+            sample.processor = std::atoi(token);
+        }
+    }
+    sample.ticks = utime + stime;
+    return sample.processor >= 0;
+}
+
+template <typename Visitor>
+void forEachTask(Visitor visit) {
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return;
+    }
+    char path[64];
+    while (const dirent* entry = readdir(dir)) {
+        const int tid = std::atoi(entry->d_name);
+        if (tid <= 0) {
+            continue;
+        }
+        std::snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+        TaskSample sample;
+        if (readTaskSample(path, sample)) {
+            visit(tid, sample);
+        }
+    }
+    closedir(dir);
+}
+
+std::vector<CoreClass> readCoreClasses() {
+    const long cpuCount = std::max(1L, sysconf(_SC_NPROCESSORS_CONF));
+    std::vector<long> maxFreq(static_cast<size_t>(cpuCount), 0);
+    for (long cpu = 0; cpu < cpuCount; ++cpu) {
+        char path[96];
+        std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%ld/cpufreq/cpuinfo_max_freq", cpu);
+        if (FILE* file = std::fopen(path, "re")) {
+            if (std::fscanf(file, "%ld", &maxFreq[cpu]) != 1) {
+                maxFreq[cpu] = 0;
+            }
+            std::fclose(file);
+        }
+    }
+    long lowest = 0;
+    long highest = 0;
+    for (long freq : maxFreq) {
+        if (freq > 0) {
+            lowest = lowest == 0 ? freq : std::min(lowest, freq);
+            highest = std::max(highest, freq);
+        }
+    }
+    std::vector<CoreClass> classes(maxFreq.size(), CoreClass::BIG);
+    if (lowest == highest) {
+        return classes;
+    }
+    for (size_t cpu = 0; cpu < maxFreq.size(); ++cpu) {
+        if (maxFreq[cpu] == lowest) {
+            classes[cpu] = CoreClass::LITTLE;
+        } else if (maxFreq[cpu] != highest) {
+            classes[cpu] = CoreClass::MID;
+        }
+    }
+    return classes;
+}
+
+}
+
+CoreClass coreClassOf(int cpu) {
+    static std::vector<CoreClass> classes;
+    static std::once_flag once;
+    std::call_once(once, [] { classes = readCoreClasses(); });
+    return cpu >= 0 && static_cast<size_t>(cpu) < classes.size() ? classes[cpu] : CoreClass::BIG;
+}
+
+CpuAccounting::CpuAccounting(TelemetryData& telemetry, bool coreClasses)
+    : telemetry_(telemetry), coreClasses_(coreClasses) {
+    threadStartNanos_ = threadCpuNanos();
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        processStartMicros_ = timevalMicros(usage.ru_utime) + timevalMicros(usage.ru_stime);
+        voluntaryStart_ = usage.ru_nvcsw;
+        involuntaryStart_ = usage.ru_nivcsw;
+    }
+    if (coreClasses_) {
+        forEachTask([this](int tid, const TaskSample& sample) { taskTicksStart_[tid] = sample.ticks; });
+    }
+}
+
+void CpuAccounting::notePixels(int64_t pixels) {
+    int64_t current = pixels_.load(std::memory_order_relaxed);
+    while (pixels > current && !pixels_.compare_exchange_weak(current, pixels, std::memory_order_relaxed)) {
+    }
+}
+
+void CpuAccounting::finish() {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+
+    TelemetryData::CpuTelemetry& cpu = telemetry_.cpu;
+    cpu.threadCpuMicros = (threadCpuNanos() - threadStartNanos_) / 1000;
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        cpu.processCpuMicros = timevalMicros(usage.ru_utime) + timevalMicros(usage.ru_stime) - processStartMicros_;
+        cpu.voluntarySwitches = usage.ru_nvcsw - voluntaryStart_;
+        cpu.involuntarySwitches = usage.ru_nivcsw - involuntaryStart_;
+    }
+
+    if (coreClasses_) {
+        int64_t classTicks[kCoreClassCount] = {};
+        int64_t totalTicks = 0;
+        forEachTask([&](int tid, const TaskSample& sample) {
+            const auto start = taskTicksStart_.find(tid);
+            const int64_t delta = sample.ticks - (start != taskTicksStart_.end() ? start->second : 0);
+            if (delta <= 0) {
+                return;
+            }
+            classTicks[static_cast<int>(coreClassOf(sample.processor))] += delta;
+            totalTicks += delta;
+            if (sample.processor < 64) {
+                cpu.cpuMask |= uint64_t{1} << sample.processor;
+            }
+        });
+        for (int coreClass = 0; coreClass < kCoreClassCount; ++coreClass) {
+            cpu.coreClassMicros[coreClass] =
+                totalTicks > 0 ? cpu.processCpuMicros * classTicks[coreClass] / totalTicks : 0;
+        }
+    }
+
+    cpu.pixels = pixels_.load(std::memory_order_relaxed);
+    cpu.cpuMsPerMegapixel = cpu.pixels > 0
+        ? static_cast<float>((cpu.processCpuMicros / 1000.0) / (cpu.pixels / 1000000.0))
+        : 0.0f;
+
+    LOGI("CPU: process_ms=%lld thread_ms=%lld cpu_ms_per_mp=%.1f csw=%lld/%lld little_ms=%lld mid_ms=%lld big_ms=%lld cpus=0x%llx",
+         static_cast<long long>(cpu.processCpuMicros / 1000),
+         static_cast<long long>(cpu.threadCpuMicros / 1000),
+         cpu.cpuMsPerMegapixel,
+         static_cast<long long>(cpu.voluntarySwitches),
+         static_cast<long long>(cpu.involuntarySwitches),
+         static_cast<long long>(cpu.coreClassMicros[static_cast<int>(CoreClass::LITTLE)] / 1000),
+         static_cast<long long>(cpu.coreClassMicros[static_cast<int>(CoreClass::MID)] / 1000),
+         static_cast<long long>(cpu.coreClassMicros[static_cast<int>(CoreClass::BIG)] / 1000),
+         static_cast<unsigned long long>(cpu.cpuMask));
+}
+
+}
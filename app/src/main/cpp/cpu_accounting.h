@@ -0,0 +1,80 @@
+#ifndef CPU_ACCOUNTING_H
+#define CPU_ACCOUNTING_H
+
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+
+namespace kotopogoda {
+
+struct TelemetryData;
+
+// Классы ядер по cpuinfo_max_freq из cpufreq: ядра с наименьшей частотой —
+// LITTLE, с наибольшей — BIG, остальные — MID. Однородный процессор (и
+// система без cpufreq) целиком считается BIG. Порядок совпадает с массивом по
+// классам в telemetry_layout и с NativeTelemetryBuffer.kt.
+enum class CoreClass {
+    LITTLE = 0,
+    MID = 1,
+    BIG = 2,
+};
+
+constexpr int kCoreClassCount = 3;
+
+inline const char* coreClassName(CoreClass coreClass) {
+    switch (coreClass) {
+        case CoreClass::LITTLE:
+            return "little";
+        case CoreClass::MID:
+            return "mid";
+        case CoreClass::BIG:
+            return "big";
+    }
+    return "unknown";
+}
+
+// Класс ядра cpu; топология читается из sysfs один раз на процесс.
+CoreClass coreClassOf(int cpu);
+
+// Учёт CPU одного запуска: время потока запуска (CLOCK_THREAD_CPUTIME_ID),
+// время процесса и переключения контекста (getrusage RUSAGE_SELF) между
+// созданием и finish. Время процесса включает рабочие потоки ncnn, но и всё,
+// что процесс делал параллельно (другие запуски, UI), поэтому это верхняя
+// оценка. Распределение по классам ядер — по приросту utime+stime потоков из
+// /proc/self/task и ядру, на котором каждый поток был замечен последним; точность
+// тиков — 10 мс, поэтому для коротких запусков оно может остаться нулевым.
+// Обход /proc/self/task читает stat каждого потока процесса дважды за запуск,
+// поэтому делается только при coreClasses (режим профилирования); без него
+// coreClassMicros и cpuMask остаются нулевыми.
+// Создаётся и завершается в потоке запуска.
+class CpuAccounting {
+public:
+    CpuAccounting(TelemetryData& telemetry, bool coreClasses);
+
+    CpuAccounting(const CpuAccounting&) = delete;
+    CpuAccounting& operator=(const CpuAccounting&) = delete;
+
+    // Пикселей на входе запуска (до уменьшения под сеть); берётся максимум,
+    // если запуск обрабатывает несколько уровней.
+    void notePixels(int64_t pixels);
+
+    // Сводит замеры в telemetry.cpu и пишет строку CPU в лог; повторный вызов
+    // ничего не делает.
+    void finish();
+
+private:
+    TelemetryData& telemetry_;
+    int64_t threadStartNanos_ = 0;
+    int64_t processStartMicros_ = 0;
+    long voluntaryStart_ = 0;
+    long involuntaryStart_ = 0;
+    bool coreClasses_;
+    // utime + stime потоков процесса на старте, в тиках.
+    std::unordered_map<int, int64_t> taskTicksStart_;
+    std::atomic<int64_t> pixels_{0};
+    bool finished_ = false;
+};
+
+}
+
+#endif
@@ -0,0 +1,357 @@
+#include "edge_unsharp.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define KOTOPOGODA_UNSHARP_NEON 1
+#endif
+
+namespace kotopogoda {
+
+namespace {
+
+// Пороги и пределы EnhanceEngine.applyEdgeAwareUnsharp.
+constexpr float kMinAmount = 1e-3f;
+constexpr float kMinRadius = 0.1f;
+constexpr float kRadiusFloor = 0.5f;
+constexpr float kRadiusCeil = 12.0f;
+constexpr float kAmountCeil = 1.5f;
+constexpr float kThresholdEpsilon = 1e-5f;
+
+constexpr float kLumaR = 0.2126f;
+constexpr float kLumaG = 0.7152f;
+constexpr float kLumaB = 0.0722f;
+
+// Полоса на поток не короче: разгон кольца стоит 2 * radius строк
+// горизонтального прохода, на коротких полосах он съедает выигрыш.
+constexpr int kMinBandRows = 64;
+
+struct UnsharpJob {
+    const uint32_t* src;
+    uint32_t* dst;
+    int width;
+    int height;
+    int radius;
+    const float* kernel;
+    int kernelSize;
+    float limit;
+    float threshold;
+    float maskDenominator;
+};
+
+inline float clamp01(float value) {
+    return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+inline uint32_t toChannel(float value) {
+    const int level = static_cast<int>(std::floor(value * 255.0f + 0.5f));
+    return static_cast<uint32_t>(std::min(255, std::max(0, level)));
+}
+
+// ARGB-строка в три плоскости [0, 1], деление на 255 — как Color.red(c) / 255f.
+void unpackRow(const uint32_t* row, int width, float* r, float* g, float* b) {
+    int x = 0;
+#if defined(KOTOPOGODA_UNSHARP_NEON)
+    const uint32x4_t mask = vdupq_n_u32(0xFF);
+    const float32x4_t scale = vdupq_n_f32(255.0f);
+    for (; x + 4 <= width; x += 4) {
+        const uint32x4_t px = vld1q_u32(row + x);
+        vst1q_f32(r + x, vdivq_f32(vcvtq_f32_u32(vandq_u32(vshrq_n_u32(px, 16), mask)), scale));
+        vst1q_f32(g + x, vdivq_f32(vcvtq_f32_u32(vandq_u32(vshrq_n_u32(px, 8), mask)), scale));
+        vst1q_f32(b + x, vdivq_f32(vcvtq_f32_u32(vandq_u32(px, mask)), scale));
+    }
+#endif
+    for (; x < width; ++x) {
+        const uint32_t px = row[x];
+        r[x] = static_cast<float>((px >> 16) & 0xFF) / 255.0f;
+        g[x] = static_cast<float>((px >> 8) & 0xFF) / 255.0f;
+        b[x] = static_cast<float>(px & 0xFF) / 255.0f;
+    }
+}
+
+// Свёртка строки с ядром; padded уже дополнена radius краевыми пикселями с
+// каждой стороны. Порядок сложения — как в Kotlin, от первого отвода.
+void convolveRow(const float* padded, float* out, int width, const float* kernel, int size) {
+    int x = 0;
+#if defined(KOTOPOGODA_UNSHARP_NEON)
+    for (; x + 8 <= width; x += 8) {
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        for (int k = 0; k < size; ++k) {
+            const float32x4_t weight = vdupq_n_f32(kernel[k]);
+            acc0 = vaddq_f32(acc0, vmulq_f32(vld1q_f32(padded + x + k), weight));
+            acc1 = vaddq_f32(acc1, vmulq_f32(vld1q_f32(padded + x + k + 4), weight));
+        }
+        vst1q_f32(out + x, acc0);
+        vst1q_f32(out + x + 4, acc1);
+    }
+#endif
+    for (; x < width; ++x) {
+        float acc = 0.0f;
+        for (int k = 0; k < size; ++k) {
+            acc += padded[x + k] * kernel[k];
+        }
+        out[x] = acc;
+    }
+}
+
+// Вертикальная свёртка: rows[k] — строка y + k - radius (с повтором краёв).
+void convolveColumns(const float* const* rows, float* out, int width, const float* kernel, int size) {
+    int x = 0;
+#if defined(KOTOPOGODA_UNSHARP_NEON)
+    for (; x + 8 <= width; x += 8) {
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        for (int k = 0; k < size; ++k) {
+            const float32x4_t weight = vdupq_n_f32(kernel[k]);
+            acc0 = vaddq_f32(acc0, vmulq_f32(vld1q_f32(rows[k] + x), weight));
+            acc1 = vaddq_f32(acc1, vmulq_f32(vld1q_f32(rows[k] + x + 4), weight));
+        }
+        vst1q_f32(out + x, acc0);
+        vst1q_f32(out + x + 4, acc1);
+    }
+#endif
+    for (; x < width; ++x) {
+        float acc = 0.0f;
+        for (int k = 0; k < size; ++k) {
+            acc += rows[k][x] * kernel[k];
+        }
+        out[x] = acc;
+    }
+}
+
+// Маска по яркости, усиление и упаковка строки результата.
+void sharpenRow(
+    const UnsharpJob& job,
+    const uint32_t* srcRow,
+    const float* const original[3],
+    const float* const blurred[3],
+    uint32_t* dstRow
+) {
+    const int width = job.width;
+    int x = 0;
+#if defined(KOTOPOGODA_UNSHARP_NEON)
+    const float32x4_t lumaR = vdupq_n_f32(kLumaR);
+    const float32x4_t lumaG = vdupq_n_f32(kLumaG);
+    const float32x4_t lumaB = vdupq_n_f32(kLumaB);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t threshold = vdupq_n_f32(job.threshold);
+    const float32x4_t denominator = vdupq_n_f32(job.maskDenominator);
+    const float32x4_t limit = vdupq_n_f32(job.limit);
+    const float32x4_t scale = vdupq_n_f32(255.0f);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const uint32x4_t alphaMask = vdupq_n_u32(0xFF000000u);
+    for (; x + 4 <= width; x += 4) {
+        const float32x4_t oR = vld1q_f32(original[0] + x);
+        const float32x4_t oG = vld1q_f32(original[1] + x);
+        const float32x4_t oB = vld1q_f32(original[2] + x);
+        const float32x4_t bR = vld1q_f32(blurred[0] + x);
+        const float32x4_t bG = vld1q_f32(blurred[1] + x);
+        const float32x4_t bB = vld1q_f32(blurred[2] + x);
+        const float32x4_t lumaO = vaddq_f32(vaddq_f32(vmulq_f32(lumaR, oR), vmulq_f32(lumaG, oG)), vmulq_f32(lumaB, oB));
+        const float32x4_t lumaBlur = vaddq_f32(vaddq_f32(vmulq_f32(lumaR, bR), vmulq_f32(lumaG, bG)), vmulq_f32(lumaB, bB));
+        const float32x4_t diff = vabdq_f32(lumaO, lumaBlur);
+        float32x4_t mask = vdivq_f32(vsubq_f32(diff, threshold), denominator);
+        mask = vminq_f32(vmaxq_f32(mask, zero), one);
+        mask = vbslq_f32(vcleq_f32(diff, threshold), zero, mask);
+        const float32x4_t gain = vmulq_f32(limit, mask);
+
+        const float32x4_t nR = vminq_f32(vmaxq_f32(vaddq_f32(oR, vmulq_f32(vsubq_f32(oR, bR), gain)), zero), one);
+        const float32x4_t nG = vminq_f32(vmaxq_f32(vaddq_f32(oG, vmulq_f32(vsubq_f32(oG, bG), gain)), zero), one);
+        const float32x4_t nB = vminq_f32(vmaxq_f32(vaddq_f32(oB, vmulq_f32(vsubq_f32(oB, bB), gain)), zero), one);
+        // Значения неотрицательны, поэтому усечение после +0.5 — это floor.
+        const uint32x4_t qR = vcvtq_u32_f32(vaddq_f32(vmulq_f32(nR, scale), half));
+        const uint32x4_t qG = vcvtq_u32_f32(vaddq_f32(vmulq_f32(nG, scale), half));
+        const uint32x4_t qB = vcvtq_u32_f32(vaddq_f32(vmulq_f32(nB, scale), half));
+        uint32x4_t packed = vandq_u32(vld1q_u32(srcRow + x), alphaMask);
+        packed = vorrq_u32(packed, vshlq_n_u32(qR, 16));
+        packed = vorrq_u32(packed, vshlq_n_u32(qG, 8));
+        packed = vorrq_u32(packed, qB);
+        vst1q_u32(dstRow + x, packed);
+    }
+#endif
+    for (; x < width; ++x) {
+        const float oR = original[0][x];
+        const float oG = original[1][x];
+        const float oB = original[2][x];
+        const float bR = blurred[0][x];
+        const float bG = blurred[1][x];
+        const float bB = blurred[2][x];
+        const float diff = std::fabs(
+            (kLumaR * oR + kLumaG * oG + kLumaB * oB) - (kLumaR * bR + kLumaG * bG + kLumaB * bB)
+        );
+        const float mask = diff <= job.threshold
+            ? 0.0f
+            : clamp01((diff - job.threshold) / job.maskDenominator);
+        const float gain = job.limit * mask;
+        const uint32_t r = toChannel(clamp01(oR + (oR - bR) * gain));
+        const uint32_t g = toChannel(clamp01(oG + (oG - bG) * gain));
+        const uint32_t b = toChannel(clamp01(oB + (oB - bB) * gain));
+        dstRow[x] = (srcRow[x] & 0xFF000000u) | (r << 16) | (g << 8) | b;
+    }
+}
+
+// Полоса строк [y0, y1) одного потока. Кольцо держит 2 * radius + 1 строк,
+// размытых по горизонтали: строка sy лежит в слоте sy % ringRows, а окно
+// y - radius..y + radius с повтором краёв не длиннее кольца.
+class BandWorker {
+public:
+    explicit BandWorker(const UnsharpJob& job)
+        : job_(job),
+          paddedWidth_(job.width + 2 * job.radius),
+          ringRows_(job.kernelSize),
+          padded_(static_cast<size_t>(paddedWidth_) * 3),
+          ring_(static_cast<size_t>(ringRows_) * 3 * job.width),
+          original_(static_cast<size_t>(job.width) * 3),
+          blurred_(static_cast<size_t>(job.width) * 3),
+          rows_(static_cast<size_t>(job.kernelSize)) {}
+
+    void run(int y0, int y1) {
+        const int width = job_.width;
+        const int radius = job_.radius;
+        int loaded = std::max(0, y0 - radius);
+        float* original[3];
+        float* blurred[3];
+        for (int c = 0; c < 3; ++c) {
+            original[c] = original_.data() + static_cast<size_t>(c) * width;
+            blurred[c] = blurred_.data() + static_cast<size_t>(c) * width;
+        }
+
+        for (int y = y0; y < y1; ++y) {
+            const int last = std::min(job_.height - 1, y + radius);
+            for (; loaded <= last; ++loaded) {
+                loadRow(loaded);
+            }
+            for (int c = 0; c < 3; ++c) {
+                for (int k = 0; k < job_.kernelSize; ++k) {
+                    const int sy = std::min(job_.height - 1, std::max(0, y + k - radius));
+                    rows_[k] = slot(sy) + static_cast<size_t>(c) * width;
+                }
+                convolveColumns(rows_.data(), blurred[c], width, job_.kernel, job_.kernelSize);
+            }
+
+            const uint32_t* srcRow = job_.src + static_cast<size_t>(y) * width;
+            unpackRow(srcRow, width, original[0], original[1], original[2]);
+            sharpenRow(job_, srcRow, original, blurred, job_.dst + static_cast<size_t>(y) * width);
+        }
+    }
+
+private:
+    float* slot(int sy) {
+        return ring_.data() + static_cast<size_t>(sy % ringRows_) * 3 * job_.width;
+    }
+
+    void loadRow(int sy) {
+        const int width = job_.width;
+        const int radius = job_.radius;
+        float* planes[3];
+        for (int c = 0; c < 3; ++c) {
+            planes[c] = padded_.data() + static_cast<size_t>(c) * paddedWidth_;
+        }
+        unpackRow(job_.src + static_cast<size_t>(sy) * width, width,
+                  planes[0] + radius, planes[1] + radius, planes[2] + radius);
+        float* out = slot(sy);
+        for (int c = 0; c < 3; ++c) {
+            float* plane = planes[c];
+            std::fill(plane, plane + radius, plane[radius]);
+            std::fill(plane + radius + width, plane + paddedWidth_, plane[radius + width - 1]);
+            convolveRow(plane, out + static_cast<size_t>(c) * width, width, job_.kernel, job_.kernelSize);
+        }
+    }
+
+    const UnsharpJob& job_;
+    const int paddedWidth_;
+    const int ringRows_;
+    std::vector<float> padded_;
+    std::vector<float> ring_;
+    std::vector<float> original_;
+    std::vector<float> blurred_;
+    std::vector<const float*> rows_;
+};
+
+}
+
+std::vector<float> gaussianKernel(int radius) {
+    const int size = radius * 2 + 1;
+    const float sigma = std::max(static_cast<float>(radius) / 2.0f, 1.0f);
+    std::vector<float> kernel(static_cast<size_t>(size));
+    float sum = 0.0f;
+    for (int i = 0; i < size; ++i) {
+        const float x = static_cast<float>(i - radius);
+        // kotlin.math.exp(Float) считает в double.
+        const float value = static_cast<float>(std::exp(static_cast<double>(-(x * x) / (2.0f * sigma * sigma))));
+        kernel[i] = value;
+        sum += value;
+    }
+    if (sum > 0.0f) {
+        for (float& value : kernel) {
+            value /= sum;
+        }
+    }
+    return kernel;
+}
+
+bool applyEdgeAwareUnsharp(
+    const uint32_t* src,
+    uint32_t* dst,
+    int width,
+    int height,
+    float amount,
+    float radius,
+    float threshold,
+    int threads
+) {
+    if (src == nullptr || dst == nullptr || width <= 0 || height <= 0) {
+        return false;
+    }
+    const size_t total = static_cast<size_t>(width) * height;
+    if (amount <= kMinAmount || radius <= kMinRadius) {
+        std::memcpy(dst, src, total * sizeof(uint32_t));
+        return true;
+    }
+
+    TRACE_SCOPE("applyEdgeAwareUnsharp");
+    const float clampedRadius = std::min(kRadiusCeil, std::max(kRadiusFloor, radius));
+    const int rad = std::max(1, static_cast<int>(std::floor(clampedRadius + 0.5f)));
+    const std::vector<float> kernel = gaussianKernel(rad);
+    const float thr = std::min(1.0f, std::max(0.0f, threshold));
+
+    UnsharpJob job{};
+    job.src = src;
+    job.dst = dst;
+    job.width = width;
+    job.height = height;
+    job.radius = rad;
+    job.kernel = kernel.data();
+    job.kernelSize = static_cast<int>(kernel.size());
+    job.limit = std::min(kAmountCeil, std::max(0.0f, amount));
+    job.threshold = thr;
+    job.maskDenominator = 1.0f - thr + kThresholdEpsilon;
+
+    const int bands = std::max(1, std::min(threads, height / kMinBandRows));
+    auto bandStart = [height, bands](int band) {
+        return static_cast<int>(static_cast<int64_t>(height) * band / bands);
+    };
+    auto runBand = [&job, &bandStart](int band) {
+        BandWorker worker(job);
+        worker.run(bandStart(band), bandStart(band + 1));
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<size_t>(bands - 1));
+    for (int band = 1; band < bands; ++band) {
+        workers.emplace_back(runBand, band);
+    }
+    runBand(0);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,38 @@
+#ifndef EDGE_UNSHARP_H
+#define EDGE_UNSHARP_H
+
+#include <cstdint>
+#include <vector>
+
+namespace kotopogoda {
+
+// Нормированное гауссово ядро 2 * radius + 1 с sigma = max(radius / 2, 1),
+// как EnhanceEngine.gaussianKernel (float, те же операции и порядок).
+std::vector<float> gaussianKernel(int radius);
+
+// Нерезкое маскирование с порогом по яркости — нативная версия
+// EnhanceEngine.applyEdgeAwareUnsharp: раздельное гауссово размытие с повтором
+// краевых пикселей, маска по разнице яркости Rec. 709 исходника и размытия,
+// усиление amount * mask. Параметры ограничиваются так же, как в Kotlin, а
+// результат совпадает с ним в пределах 1 LSB.
+//
+// Пиксели — Android ARGB (0xAARRGGBB), строки подряд по width; альфа
+// переносится как есть. src и dst не должны перекрываться. Полосы строк
+// делятся между threads потоками; каждый держит кольцо из 2 * radius + 1
+// размытых по горизонтали строк, а не промежуточные плоскости кадра.
+// При amount или radius ниже порога Kotlin dst — копия src.
+// false — неверные размеры.
+bool applyEdgeAwareUnsharp(
+    const uint32_t* src,
+    uint32_t* dst,
+    int width,
+    int height,
+    float amount,
+    float radius,
+    float threshold,
+    int threads
+);
+
+}
+
+#endif
@@ -0,0 +1,297 @@
+#include "enhance_job_queue.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+
+#define LOG_TAG "EnhanceJobQueue"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+namespace kotopogoda {
+
+bool isTerminal(EnhanceJobState state) {
+    return state == EnhanceJobState::SUCCEEDED ||
+           state == EnhanceJobState::FAILED ||
+           state == EnhanceJobState::CANCELLED ||
+           state == EnhanceJobState::SUPERSEDED;
+}
+
+EnhanceJobQueue::EnhanceJobQueue(EnhanceJobQueueHooks hooks, size_t workerCount)
+    : hooks_(std::move(hooks)) {
+    workerCount = std::max<size_t>(1, workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers_.emplace_back(&EnhanceJobQueue::run, this);
+    }
+}
+
+EnhanceJobQueue::~EnhanceJobQueue() {
+    shutdown();
+}
+
+int64_t EnhanceJobQueue::submit(EnhanceJob job) {
+    std::vector<Entry> dropped;
+    int64_t jobId = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            dropped.emplace_back();
+            dropped.back().job = std::move(job);
+        } else {
+            if (job.kind == EnhanceJobKind::PREVIEW && !job.photoKey.empty()) {
+                supersedeLocked(job.photoKey, dropped);
+            }
+            Entry entry;
+            entry.id = nextJobId_++;
+            entry.job = std::move(job);
+            entry.cancelFlag = std::make_shared<std::atomic<bool>>(false);
+            jobId = entry.id;
+            pending_.push_back(std::move(entry));
+        }
+    }
+    // Ресурсы снятых задач освобождаются вне блокировки: release может обращаться к JNI.
+    for (Entry& entry : dropped) {
+        if (entry.id != 0 && entry.job.onFinished) {
+            entry.job.onFinished(entry.id, EnhanceJobState::SUPERSEDED);
+        }
+        if (entry.job.release) {
+            entry.job.release();
+        }
+    }
+    if (jobId != 0) {
+        workAvailable_.notify_one();
+        jobFinished_.notify_all();
+    }
+    return jobId;
+}
+
+void EnhanceJobQueue::supersedeLocked(const std::string& photoKey, std::vector<Entry>& dropped) {
+    auto isSuperseded = [&photoKey](const Entry& entry) {
+        return entry.job.kind == EnhanceJobKind::PREVIEW && entry.job.photoKey == photoKey;
+    };
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        if (!isSuperseded(*it)) {
+            ++it;
+            continue;
+        }
+        EnhanceJobResult result;
+        result.state = EnhanceJobState::SUPERSEDED;
+        result.telemetry.cancelled = true;
+        finishLocked(it->id, result);
+        LOGI("Превью job=%lld вытеснено новым запросом", static_cast<long long>(it->id));
+        dropped.push_back(std::move(*it));
+        it = pending_.erase(it);
+    }
+    for (Entry* running : running_) {
+        if (!isSuperseded(*running)) {
+            continue;
+        }
+        running->superseded = true;
+        running->cancelFlag->store(true);
+        if (running->job.onCancel) {
+            running->job.onCancel();
+        }
+        LOGI("Текущее превью job=%lld отменено новым запросом", static_cast<long long>(running->id));
+    }
+}
+
+EnhanceJobQueue::Entry* EnhanceJobQueue::findRunningLocked(int64_t jobId) {
+    for (Entry* running : running_) {
+        if (running->id == jobId) {
+            return running;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<EnhanceJobQueue::Entry>::iterator EnhanceJobQueue::nextRunnableLocked() {
+    auto best = pending_.end();
+    for (auto it = pending_.begin(); it != pending_.end(); ++it) {
+        const bool kindBusy = std::any_of(running_.begin(), running_.end(), [&it](const Entry* running) {
+            return running->job.kind == it->job.kind;
+        });
+        if (kindBusy) {
+            continue;
+        }
+        if (best == pending_.end() ||
+            it->job.priority > best->job.priority ||
+            (it->job.priority == best->job.priority && it->id < best->id)) {
+            best = it;
+        }
+    }
+    return best;
+}
+
+EnhanceJobState EnhanceJobQueue::poll(int64_t jobId, EnhanceJobResult* result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return takeLocked(jobId, result);
+}
+
+EnhanceJobState EnhanceJobQueue::await(int64_t jobId, int64_t timeoutMs, EnhanceJobResult* result) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto ready = [this, jobId] {
+        return stopping_ || finished_.count(jobId) > 0;
+    };
+    if (timeoutMs < 0) {
+        jobFinished_.wait(lock, ready);
+    } else {
+        jobFinished_.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready);
+    }
+    return takeLocked(jobId, result);
+}
+
+EnhanceJobState EnhanceJobQueue::takeLocked(int64_t jobId, EnhanceJobResult* result) {
+    auto finished = finished_.find(jobId);
+    if (finished != finished_.end()) {
+        const EnhanceJobState state = finished->second.state;
+        if (result != nullptr) {
+            *result = std::move(finished->second);
+        }
+        finished_.erase(finished);
+        finishedOrder_.erase(std::remove(finishedOrder_.begin(), finishedOrder_.end(), jobId), finishedOrder_.end());
+        return state;
+    }
+    if (findRunningLocked(jobId) != nullptr) {
+        return EnhanceJobState::RUNNING;
+    }
+    for (const Entry& entry : pending_) {
+        if (entry.id == jobId) {
+            return EnhanceJobState::QUEUED;
+        }
+    }
+    return EnhanceJobState::UNKNOWN;
+}
+
+bool EnhanceJobQueue::cancel(int64_t jobId) {
+    Entry dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (Entry* running = findRunningLocked(jobId)) {
+            running->cancelFlag->store(true);
+            if (running->job.onCancel) {
+                running->job.onCancel();
+            }
+            return true;
+        }
+        auto it = std::find_if(pending_.begin(), pending_.end(), [jobId](const Entry& entry) {
+            return entry.id == jobId;
+        });
+        if (it == pending_.end()) {
+            return false;
+        }
+        EnhanceJobResult result;
+        result.state = EnhanceJobState::CANCELLED;
+        result.telemetry.cancelled = true;
+        finishLocked(jobId, result);
+        dropped = std::move(*it);
+        pending_.erase(it);
+    }
+    jobFinished_.notify_all();
+    if (dropped.job.onFinished) {
+        dropped.job.onFinished(jobId, EnhanceJobState::CANCELLED);
+    }
+    if (dropped.job.release) {
+        dropped.job.release();
+    }
+    return true;
+}
+
+void EnhanceJobQueue::cancelAll() {
+    std::vector<int64_t> ids;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Entry& entry : pending_) {
+            ids.push_back(entry.id);
+        }
+        for (const Entry* running : running_) {
+            ids.push_back(running->id);
+        }
+    }
+    for (int64_t id : ids) {
+        cancel(id);
+    }
+}
+
+void EnhanceJobQueue::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    // После stopping_ новые задачи не принимаются; оставшиеся снимаются с отменой.
+    cancelAll();
+    workAvailable_.notify_all();
+    jobFinished_.notify_all();
+    for (std::thread& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void EnhanceJobQueue::finishLocked(int64_t jobId, EnhanceJobResult result) {
+    finished_[jobId] = std::move(result);
+    finishedOrder_.push_back(jobId);
+    while (finishedOrder_.size() > kMaxRetainedResults) {
+        finished_.erase(finishedOrder_.front());
+        finishedOrder_.pop_front();
+    }
+}
+
+void EnhanceJobQueue::run() {
+    if (hooks_.onThreadStart) {
+        hooks_.onThreadStart();
+    }
+    while (true) {
+        Entry current;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto next = pending_.end();
+            workAvailable_.wait(lock, [this, &next] {
+                next = nextRunnableLocked();
+                return stopping_ || next != pending_.end();
+            });
+            if (next == pending_.end()) {
+                break;
+            }
+            current = std::move(*next);
+            pending_.erase(next);
+            running_.push_back(&current);
+        }
+
+        EnhanceJobResult result;
+        const bool success = current.job.run
+            ? current.job.run(*current.cancelFlag, result.telemetry)
+            : false;
+        const bool cancelled = current.cancelFlag->load();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_.erase(std::remove(running_.begin(), running_.end(), &current), running_.end());
+            if (current.superseded) {
+                result.state = EnhanceJobState::SUPERSEDED;
+            } else if (cancelled) {
+                result.state = EnhanceJobState::CANCELLED;
+            } else {
+                result.state = success ? EnhanceJobState::SUCCEEDED : EnhanceJobState::FAILED;
+            }
+            result.telemetry.cancelled = result.telemetry.cancelled || cancelled;
+            finishLocked(current.id, result);
+        }
+        jobFinished_.notify_all();
+        // Освободился вид задачи: ожидающая задача того же вида может достаться другому потоку.
+        workAvailable_.notify_all();
+
+        if (current.job.onFinished) {
+            current.job.onFinished(current.id, result.state);
+        }
+        if (current.job.release) {
+            current.job.release();
+        }
+    }
+    if (hooks_.onThreadStop) {
+        hooks_.onThreadStop();
+    }
+}
+
+}
@@ -0,0 +1,130 @@
+#ifndef ENHANCE_JOB_QUEUE_H
+#define ENHANCE_JOB_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ncnn_engine.h"
+
+namespace kotopogoda {
+
+enum class EnhanceJobKind {
+    PREVIEW = 0,
+    FULL = 1,
+};
+
+// Коды совпадают с NativeEnhanceController.JobState.
+enum class EnhanceJobState {
+    UNKNOWN = -1,
+    QUEUED = 0,
+    RUNNING = 1,
+    SUCCEEDED = 2,
+    FAILED = 3,
+    CANCELLED = 4,
+    SUPERSEDED = 5,
+};
+
+bool isTerminal(EnhanceJobState state);
+
+// Задача очереди. run выполняется в потоке очереди и получает собственный флаг
+// отмены задачи; release освобождает ресурсы задачи (глобальные ссылки JNI) и
+// вызывается ровно один раз, после onFinished — когда задача выполнена или
+// снята из очереди.
+struct EnhanceJob {
+    EnhanceJobKind kind = EnhanceJobKind::PREVIEW;
+    int priority = 0;
+    // Ключ фото: новое превью с тем же ключом вытесняет ожидающие и текущее превью.
+    std::string photoKey;
+    std::function<bool(std::atomic<bool>& cancelFlag, TelemetryData& telemetry)> run;
+    // Вызывается, когда выставляется флаг отмены уже запущенной задачи (cancel,
+    // cancelAll, вытеснение, shutdown): для задач, у которых внутри свои флаги
+    // отмены. Вызывается под блокировкой очереди, поэтому должна только
+    // выставлять флаги и не обращаться к очереди.
+    std::function<void()> onCancel;
+    std::function<void()> release;
+    // Вызывается после сохранения результата: в потоке очереди либо в потоке,
+    // который отменил или вытеснил задачу до запуска.
+    std::function<void(int64_t jobId, EnhanceJobState state)> onFinished;
+};
+
+struct EnhanceJobResult {
+    EnhanceJobState state = EnhanceJobState::UNKNOWN;
+    TelemetryData telemetry;
+};
+
+struct EnhanceJobQueueHooks {
+    std::function<void()> onThreadStart;
+    std::function<void()> onThreadStop;
+};
+
+// Асинхронная очередь задач одного движка. Свободный рабочий поток берёт задачу
+// с наибольшим приоритетом (при равенстве — более раннюю) среди тех, чей вид
+// сейчас не выполняется: одновременно идёт не больше одной задачи каждого вида,
+// так что превью не ждёт окончания полной обработки. У каждой задачи свой
+// флаг отмены, поэтому cancel(jobId) не задевает соседние задачи. Результат
+// хранится до первого poll/await, вернувшего конечное состояние (не более
+// kMaxRetainedResults последних).
+class EnhanceJobQueue {
+public:
+    static constexpr size_t kMaxRetainedResults = 64;
+
+    explicit EnhanceJobQueue(
+        EnhanceJobQueueHooks hooks = EnhanceJobQueueHooks(),
+        size_t workerCount = 1
+    );
+    ~EnhanceJobQueue();
+
+    EnhanceJobQueue(const EnhanceJobQueue&) = delete;
+    EnhanceJobQueue& operator=(const EnhanceJobQueue&) = delete;
+
+    int64_t submit(EnhanceJob job);
+
+    // Неблокирующий опрос. Конечное состояние забирает результат из очереди.
+    EnhanceJobState poll(int64_t jobId, EnhanceJobResult* result);
+    // Ждёт конечного состояния не дольше timeoutMs (< 0 — без ограничения).
+    EnhanceJobState await(int64_t jobId, int64_t timeoutMs, EnhanceJobResult* result);
+
+    bool cancel(int64_t jobId);
+    void cancelAll();
+    void shutdown();
+
+private:
+    struct Entry {
+        int64_t id = 0;
+        EnhanceJob job;
+        std::shared_ptr<std::atomic<bool>> cancelFlag;
+        bool superseded = false;
+    };
+
+    void run();
+    std::vector<Entry>::iterator nextRunnableLocked();
+    Entry* findRunningLocked(int64_t jobId);
+    void finishLocked(int64_t jobId, EnhanceJobResult result);
+    void supersedeLocked(const std::string& photoKey, std::vector<Entry>& dropped);
+    EnhanceJobState takeLocked(int64_t jobId, EnhanceJobResult* result);
+
+    EnhanceJobQueueHooks hooks_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable jobFinished_;
+    std::vector<Entry> pending_;
+    std::vector<Entry*> running_;
+    std::map<int64_t, EnhanceJobResult> finished_;
+    std::deque<int64_t> finishedOrder_;
+    int64_t nextJobId_ = 1;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+}
+
+#endif
@@ -0,0 +1,95 @@
+#include "fd_stream.h"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace kotopogoda {
+
+namespace {
+constexpr size_t kReadChunkSize = 1 << 20;
+// Между проверками отмены/прогресса обрабатываем не больше 4 МиБ mmap-окна.
+constexpr size_t kMappedSliceSize = 4 << 20;
+
+// -1 — mmap не удался, можно читать обычным путём.
+int streamMapped(int fd, uint64_t totalBytes, const FdChunkSink& sink, const FdProgressCallback& progress) {
+    const size_t fileSize = static_cast<size_t>(totalBytes);
+    void* mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        return -1;
+    }
+    madvise(mapped, fileSize, MADV_SEQUENTIAL);
+    const uint8_t* bytes = static_cast<const uint8_t*>(mapped);
+    FdStreamResult result = FdStreamResult::OK;
+    size_t offset = 0;
+    while (offset < fileSize) {
+        const size_t slice = std::min(kMappedSliceSize, fileSize - offset);
+        sink(bytes + offset, slice);
+        offset += slice;
+        if (progress && !progress(offset, totalBytes)) {
+            result = FdStreamResult::CANCELLED;
+            break;
+        }
+    }
+    munmap(mapped, fileSize);
+    return static_cast<int>(result);
+}
+}
+
+FdStreamResult streamFd(int fd, const FdChunkSink& sink, const FdProgressCallback& progress, FdReadMode mode) {
+    if (fd < 0) {
+        return FdStreamResult::IO_ERROR;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return FdStreamResult::IO_ERROR;
+    }
+
+    const bool regularFile = S_ISREG(st.st_mode);
+    const uint64_t totalBytes = regularFile ? static_cast<uint64_t>(st.st_size) : 0;
+
+    if (progress && !progress(0, totalBytes)) {
+        return FdStreamResult::CANCELLED;
+    }
+
+    if (mode == FdReadMode::MAP && regularFile && totalBytes > 0) {
+        const int mapped = streamMapped(fd, totalBytes, sink, progress);
+        if (mapped >= 0) {
+            return static_cast<FdStreamResult>(mapped);
+        }
+    }
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // Обычный файл читается с начала через pread: позиция fd не важна и не
+    // меняется. Если файл меняется во время чтения, хешируется то, что успели
+    // прочитать, без падения процесса.
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[kReadChunkSize]);
+    uint64_t processed = 0;
+    while (true) {
+        const ssize_t bytesRead = regularFile
+            ? pread(fd, buffer.get(), kReadChunkSize, static_cast<off_t>(processed))
+            : read(fd, buffer.get(), kReadChunkSize);
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return FdStreamResult::IO_ERROR;
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+        sink(buffer.get(), static_cast<size_t>(bytesRead));
+        processed += static_cast<uint64_t>(bytesRead);
+        if (progress && !progress(processed, totalBytes)) {
+            return FdStreamResult::CANCELLED;
+        }
+    }
+    return FdStreamResult::OK;
+}
+
+}
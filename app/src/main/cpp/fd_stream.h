@@ -0,0 +1,46 @@
+#ifndef FD_STREAM_H
+#define FD_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace kotopogoda {
+
+enum class FdStreamResult {
+    OK = 0,
+    IO_ERROR = 1,
+    CANCELLED = 2,
+};
+
+// Как читать обычный файл. READ — pread блоками, подходит для любого
+// источника. MAP — mmap всего файла: только для файлов приложения, которые не
+// меняются во время чтения (модели). Если файл укоротят, пока он отображён,
+// обращение к хвосту отображения даёт SIGBUS, поэтому пользовательский
+// контент (fd из ContentResolver) читается только через READ.
+enum class FdReadMode {
+    READ = 0,
+    MAP = 1,
+};
+
+// Получатель очередной порции данных файла.
+using FdChunkSink = std::function<void(const uint8_t* data, size_t size)>;
+
+// Вызывается между порциями; false прерывает чтение (отмена).
+// totalBytes равен 0, если размер источника заранее неизвестен (pipe).
+using FdProgressCallback = std::function<bool(uint64_t processedBytes, uint64_t totalBytes)>;
+
+// Последовательно отдаёт содержимое fd в sink. Обычные файлы читаются с начала
+// файла через pread блоками по 1 МиБ с POSIX_FADV_SEQUENTIAL (или через mmap с
+// MADV_SEQUENTIAL в режиме MAP), остальные источники — read с текущей позиции.
+// Дескриптор не закрывается.
+FdStreamResult streamFd(
+    int fd,
+    const FdChunkSink& sink,
+    const FdProgressCallback& progress = FdProgressCallback(),
+    FdReadMode mode = FdReadMode::READ
+);
+
+}
+
+#endif
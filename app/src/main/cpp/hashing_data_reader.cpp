@@ -0,0 +1,126 @@
+#include "hashing_data_reader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace kotopogoda {
+
+namespace {
+constexpr size_t kBufferSize = 1 << 20;
+constexpr size_t kMaxParamBytes = 16 << 20;
+
+ssize_t readRetrying(int fd, void* buf, size_t size) {
+    while (true) {
+        const ssize_t bytesRead = ::read(fd, buf, size);
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        }
+        return bytesRead;
+    }
+}
+}
+
+HashingDataReader::HashingDataReader(const std::string& filePath)
+    : fd_(open(filePath.c_str(), O_RDONLY | O_CLOEXEC)),
+      buffer_(new unsigned char[kBufferSize]),
+      bufferPos_(0),
+      bufferSize_(0),
+      eof_(false),
+      ioError_(false) {
+    if (fd_ >= 0) {
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+}
+
+HashingDataReader::~HashingDataReader() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool HashingDataReader::refill() const {
+    if (fd_ < 0 || eof_ || ioError_) {
+        return false;
+    }
+    const ssize_t bytesRead = readRetrying(fd_, buffer_.get(), kBufferSize);
+    if (bytesRead < 0) {
+        ioError_ = true;
+        return false;
+    }
+    if (bytesRead == 0) {
+        eof_ = true;
+        return false;
+    }
+    sha_.update(buffer_.get(), static_cast<size_t>(bytesRead));
+    bufferPos_ = 0;
+    bufferSize_ = static_cast<size_t>(bytesRead);
+    return true;
+}
+
+size_t HashingDataReader::read(void* buf, size_t size) const {
+    unsigned char* out = static_cast<unsigned char*>(buf);
+    size_t copied = 0;
+    while (copied < size) {
+        if (bufferPos_ == bufferSize_ && !refill()) {
+            break;
+        }
+        const size_t take = std::min(size - copied, bufferSize_ - bufferPos_);
+        std::memcpy(out + copied, buffer_.get() + bufferPos_, take);
+        bufferPos_ += take;
+        copied += take;
+    }
+    return copied;
+}
+
+std::string HashingDataReader::finishHex() {
+    bufferPos_ = bufferSize_;
+    while (refill()) {
+        bufferPos_ = bufferSize_;
+    }
+    if (fd_ < 0 || ioError_) {
+        return "";
+    }
+    return sha_.finalHex();
+}
+
+bool HashingDataReader::readAll(const std::string& filePath, std::string& content, std::string& digestHex) {
+    content.clear();
+    digestHex.clear();
+
+    const int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) > kMaxParamBytes) {
+        close(fd);
+        return false;
+    }
+    content.resize(static_cast<size_t>(st.st_size));
+
+    size_t offset = 0;
+    while (offset < content.size()) {
+        const ssize_t bytesRead = readRetrying(fd, &content[offset], content.size() - offset);
+        if (bytesRead <= 0) {
+            break;
+        }
+        offset += static_cast<size_t>(bytesRead);
+    }
+    close(fd);
+
+    if (offset != content.size()) {
+        content.clear();
+        return false;
+    }
+
+    Sha256 sha;
+    sha.update(content.data(), content.size());
+    digestHex = sha.finalHex();
+    return true;
+}
+
+}
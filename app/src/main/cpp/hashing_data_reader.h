@@ -0,0 +1,45 @@
+#ifndef HASHING_DATA_READER_H
+#define HASHING_DATA_READER_H
+
+#include "sha256_verifier.h"
+#include <ncnn/datareader.h>
+#include <memory>
+#include <string>
+
+namespace kotopogoda {
+
+// DataReader для ncnn::Net::load_model, который читает файл один раз и
+// одновременно подаёт каждый прочитанный байт в SHA-256. Сеть можно
+// принимать только после сверки finalHex() с ожидаемой суммой.
+class HashingDataReader : public ncnn::DataReader {
+public:
+    explicit HashingDataReader(const std::string& filePath);
+    ~HashingDataReader() override;
+
+    bool isOpen() const { return fd_ >= 0; }
+    bool hasIoError() const { return ioError_; }
+
+    size_t read(void* buf, size_t size) const override;
+
+    // Дочитывает остаток файла в хеш (ncnn может не потребить хвост)
+    // и возвращает hex-дайджест; пустая строка при ошибке ввода-вывода.
+    std::string finishHex();
+
+    // Читает небольшой файл (.param) целиком в память с одновременным хешированием.
+    static bool readAll(const std::string& filePath, std::string& content, std::string& digestHex);
+
+private:
+    bool refill() const;
+
+    int fd_;
+    mutable Sha256 sha_;
+    mutable std::unique_ptr<unsigned char[]> buffer_;
+    mutable size_t bufferPos_;
+    mutable size_t bufferSize_;
+    mutable bool eof_;
+    mutable bool ioError_;
+};
+
+}
+
+#endif
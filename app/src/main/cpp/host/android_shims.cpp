@@ -0,0 +1,65 @@
+#include "host_bitmap.h"
+#include <android/log.h>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+int thresholdFromEnv() {
+    const char* level = std::getenv("KOTOPOGODA_LOG_LEVEL");
+    if (level == nullptr || level[0] == '\0') {
+        return ANDROID_LOG_WARN;
+    }
+    switch (level[0]) {
+        case 'v': return ANDROID_LOG_VERBOSE;
+        case 'd': return ANDROID_LOG_DEBUG;
+        case 'i': return ANDROID_LOG_INFO;
+        case 'w': return ANDROID_LOG_WARN;
+        case 'e': return ANDROID_LOG_ERROR;
+        default: return ANDROID_LOG_WARN;
+    }
+}
+
+kotopogoda::HostBitmap* fromObject(jobject bitmap) {
+    return reinterpret_cast<kotopogoda::HostBitmap*>(bitmap);
+}
+
+}
+
+int __android_log_print(int prio, const char* tag, const char* fmt, ...) {
+    static const int threshold = thresholdFromEnv();
+    if (prio < threshold) {
+        return 0;
+    }
+    va_list args;
+    va_start(args, fmt);
+    std::fprintf(stderr, "[%s] ", tag);
+    const int written = std::vfprintf(stderr, fmt, args);
+    std::fputc('\n', stderr);
+    va_end(args);
+    return written;
+}
+
+int AndroidBitmap_getInfo(JNIEnv* env, jobject bitmap, AndroidBitmapInfo* info) {
+    (void)env;
+    if (bitmap == nullptr || info == nullptr) {
+        return ANDROID_BITMAP_RESULT_BAD_PARAMETER;
+    }
+    *info = fromObject(bitmap)->info;
+    return ANDROID_BITMAP_RESULT_SUCCESS;
+}
+
+int AndroidBitmap_lockPixels(JNIEnv* env, jobject bitmap, void** pixels) {
+    (void)env;
+    if (bitmap == nullptr || pixels == nullptr) {
+        return ANDROID_BITMAP_RESULT_BAD_PARAMETER;
+    }
+    *pixels = fromObject(bitmap)->pixels.data();
+    return ANDROID_BITMAP_RESULT_SUCCESS;
+}
+
+int AndroidBitmap_unlockPixels(JNIEnv* env, jobject bitmap) {
+    (void)env;
+    return bitmap == nullptr ? ANDROID_BITMAP_RESULT_BAD_PARAMETER : ANDROID_BITMAP_RESULT_SUCCESS;
+}
@@ -0,0 +1,69 @@
+#include "batch_pipeline.h"
+#include "enhance_job_queue.h"
+#include <gtest/gtest.h>
+#include <ncnn/mat.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+// Отмена пакетной задачи через очередь должна прерывать текущий вывод, а не
+// ждать его окончания на границе стадий.
+
+namespace {
+
+using namespace kotopogoda;
+
+TEST(BatchPipelineCancel, JobCancelInterruptsCurrentItem) {
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool inferStarted = false;
+
+    BatchStages stages;
+    stages.decode = [](BatchFrame& frame) {
+        frame.image.create(8, 8, 3);
+        return true;
+    };
+    // Долгий вывод, который, как processTiled, смотрит только на флаг контекста.
+    stages.infer = [&](const BatchFrame& frame, ncnn::Mat& output, RunContext& context) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            inferStarted = true;
+        }
+        changed.notify_all();
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!context.isCancelled() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        output = frame.image;
+        return !context.isCancelled();
+    };
+    stages.encode = [](BatchFrame&) { return true; };
+    auto pipeline = std::make_shared<BatchPipeline>(3, stages);
+
+    EnhanceJobQueue queue;
+    EnhanceJob job;
+    job.kind = EnhanceJobKind::FULL;
+    job.run = [pipeline](std::atomic<bool>& cancelFlag, TelemetryData&) { return pipeline->run(cancelFlag); };
+    job.onCancel = [pipeline]() { pipeline->cancelAll(); };
+    const int64_t jobId = queue.submit(std::move(job));
+    ASSERT_NE(jobId, 0);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(changed.wait_for(lock, std::chrono::seconds(5), [&] { return inferStarted; }));
+    }
+    const auto cancelledAt = std::chrono::steady_clock::now();
+    ASSERT_TRUE(queue.cancel(jobId));
+    const EnhanceJobState state = queue.await(jobId, 5000, nullptr);
+    const auto elapsed = std::chrono::steady_clock::now() - cancelledAt;
+
+    EXPECT_EQ(state, EnhanceJobState::CANCELLED);
+    EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 1000);
+    for (const BatchItemResult& result : pipeline->results()) {
+        EXPECT_EQ(result.state, BatchItemState::CANCELLED);
+    }
+    queue.shutdown();
+}
+
+}
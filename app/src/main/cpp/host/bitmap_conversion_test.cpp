@@ -0,0 +1,128 @@
+#include "host_bitmap.h"
+#include "ncnn_engine.h"
+#include <gtest/gtest.h>
+#include <ncnn/mat.h>
+#include <cstring>
+#include <vector>
+
+// bitmapToMat/matToBitmap: раскладка RGBA_8888 (красный — первый байт
+// пикселя в памяти), шаг строки info.stride и цветовая LUT при записи.
+
+namespace {
+
+using namespace kotopogoda;
+
+TEST(BitmapConversion, ReadsRgbaByteOrder) {
+    HostBitmap bitmap(2, 1);
+    bitmap.at(0, 0) = packRgba(200, 100, 50);
+    bitmap.at(1, 0) = packRgba(0, 0, 255);
+
+    ncnn::Mat mat;
+    bitmapToMat(nullptr, bitmap.object(), mat);
+
+    ASSERT_EQ(mat.c, 3);
+    EXPECT_FLOAT_EQ(mat.channel(0)[0], 200 / 255.0f);
+    EXPECT_FLOAT_EQ(mat.channel(1)[0], 100 / 255.0f);
+    EXPECT_FLOAT_EQ(mat.channel(2)[0], 50 / 255.0f);
+    EXPECT_FLOAT_EQ(mat.channel(0)[1], 0.0f);
+    EXPECT_FLOAT_EQ(mat.channel(2)[1], 1.0f);
+}
+
+TEST(BitmapConversion, WritesRgbaByteOrder) {
+    ncnn::Mat mat(1, 1, 3);
+    mat.channel(0)[0] = 1.0f;
+    mat.channel(1)[0] = 0.0f;
+    mat.channel(2)[0] = 0.0f;
+    HostBitmap bitmap(1, 1);
+
+    matToBitmap(nullptr, mat, bitmap.object());
+
+    uint8_t bytes[4];
+    std::memcpy(bytes, bitmap.pixels.data(), sizeof(bytes));
+    EXPECT_EQ(bytes[0], 0xFF);
+    EXPECT_EQ(bytes[1], 0x00);
+    EXPECT_EQ(bytes[2], 0x00);
+    EXPECT_EQ(bytes[3], 0xFF);
+}
+
+TEST(BitmapConversion, RoundTripHonoursStride) {
+    const int width = 5;
+    const int height = 3;
+    HostBitmap source(width, height, 8);
+    for (uint32_t& pixel : source.pixels) {
+        pixel = 0xDEADBEEFu;
+    }
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            source.at(x, y) = packRgba(
+                static_cast<uint8_t>(10 * x),
+                static_cast<uint8_t>(20 * y),
+                static_cast<uint8_t>(250 - 10 * x - 20 * y)
+            );
+        }
+    }
+
+    ncnn::Mat mat;
+    bitmapToMat(nullptr, source.object(), mat);
+    HostBitmap target(width, height, 8);
+    for (uint32_t& pixel : target.pixels) {
+        pixel = 0xDEADBEEFu;
+    }
+    matToBitmap(nullptr, mat, target.object());
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            EXPECT_EQ(target.at(x, y), source.at(x, y)) << "x=" << x << " y=" << y;
+        }
+    }
+}
+
+TEST(BitmapConversion, AppliesColorLutBeforeStats) {
+    const int width = 37;
+    const int height = 11;
+    ncnn::Mat mat(width, height, 3);
+    uint32_t seed = 4242;
+    for (int c = 0; c < 3; ++c) {
+        float* data = mat.channel(c);
+        for (int i = 0; i < width * height; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            data[i] = static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+        }
+    }
+    const ColorLut lut(0.5f, 1.25f, ColorLut::kSize65);
+
+    HostBitmap plain(width, height);
+    matToBitmap(nullptr, mat, plain.object());
+    HostBitmap graded(width, height);
+    ImageStats stats;
+    matToBitmap(nullptr, mat, graded.object(), &stats, &lut);
+
+    // Тот же результат, что у отдельного прохода LUT по готовому кадру.
+    ImageStatsAccumulator accumulator(width, height);
+    std::vector<uint8_t> rgbRow(static_cast<size_t>(width) * 3);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const uint32_t rgba = plain.at(x, y);
+            const uint32_t argb = 0xFF000000u | ((rgba & 0xFFu) << 16) | (rgba & 0xFF00u) | ((rgba >> 16) & 0xFFu);
+            uint32_t expected = 0;
+            lut.applyRow(&argb, &expected, 1);
+            const uint8_t r = static_cast<uint8_t>(expected >> 16);
+            const uint8_t g = static_cast<uint8_t>(expected >> 8);
+            const uint8_t b = static_cast<uint8_t>(expected);
+            EXPECT_EQ(graded.at(x, y), packRgba(r, g, b)) << "x=" << x << " y=" << y;
+            rgbRow[x * 3] = r;
+            rgbRow[x * 3 + 1] = g;
+            rgbRow[x * 3 + 2] = b;
+        }
+        accumulator.addRow(rgbRow.data());
+    }
+    // Статистика описывает записанный (уже окрашенный) результат.
+    ImageStats expectedStats;
+    ASSERT_TRUE(accumulator.finish(expectedStats));
+    ASSERT_TRUE(stats.valid);
+    EXPECT_FLOAT_EQ(stats.lumaMean, expectedStats.lumaMean);
+    EXPECT_FLOAT_EQ(stats.sharpness, expectedStats.sharpness);
+    EXPECT_FLOAT_EQ(stats.noise, expectedStats.noise);
+}
+
+}
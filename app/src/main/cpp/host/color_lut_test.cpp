@@ -0,0 +1,195 @@
+#include "color_lut.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// applyColorLut против дословного переноса
+// EnhanceEngine.applyVibranceAndSaturation (rgbToHsv, hsvToRgb, composeColor)
+// на сетке цветов и коэффициентов: 65^3 — в пределах 1 LSB, 33^3 — 2 LSB,
+// альфа без изменений. Тот же Kotlin-код на устройстве сверяет
+// NativeColorLutEquivalenceTest.
+
+namespace {
+
+using namespace kotopogoda;
+
+float clamp01(float value) {
+    return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+// roundToInt(): Math.round(Float) — floor(x + 0.5).
+uint32_t toChannel(float value) {
+    const int level = static_cast<int>(std::floor(value * 255.0f + 0.5f));
+    return static_cast<uint32_t>(std::min(255, std::max(0, level)));
+}
+
+uint32_t kotlinVibranceSaturation(uint32_t color, float vibranceGain, float saturationGain) {
+    const float r = static_cast<float>((color >> 16) & 0xFF) / 255.0f;
+    const float g = static_cast<float>((color >> 8) & 0xFF) / 255.0f;
+    const float b = static_cast<float>(color & 0xFF) / 255.0f;
+
+    // rgbToHsv
+    const float maxValue = std::max(r, std::max(g, b));
+    const float minValue = std::min(r, std::min(g, b));
+    const float delta = maxValue - minValue;
+    float hue;
+    if (delta == 0.0f) {
+        hue = 0.0f;
+    } else if (maxValue == r) {
+        hue = std::fmod((g - b) / delta, 6.0f);
+    } else if (maxValue == g) {
+        hue = ((b - r) / delta) + 2.0f;
+    } else {
+        hue = ((r - g) / delta) + 4.0f;
+    }
+    hue *= 60.0f;
+    const float hsvSaturation = maxValue == 0.0f ? 0.0f : delta / maxValue;
+    const float v = maxValue;
+    const float h = hue < 0.0f ? hue + 360.0f : hue;
+
+    const float vibrance = clamp01(hsvSaturation + (1.0f - hsvSaturation) * vibranceGain);
+    const float s = clamp01(vibrance * saturationGain);
+
+    // hsvToRgb
+    float out[3];
+    if (s == 0.0f) {
+        out[0] = v;
+        out[1] = v;
+        out[2] = v;
+    } else {
+        const float sector = std::fmod(h / 60.0f, 6.0f);
+        const int i = static_cast<int>(sector);
+        const float f = sector - static_cast<float>(i);
+        const float p = v * (1.0f - s);
+        const float q = v * (1.0f - s * f);
+        const float t = v * (1.0f - s * (1.0f - f));
+        switch (i) {
+            case 0: out[0] = v; out[1] = t; out[2] = p; break;
+            case 1: out[0] = q; out[1] = v; out[2] = p; break;
+            case 2: out[0] = p; out[1] = v; out[2] = t; break;
+            case 3: out[0] = p; out[1] = q; out[2] = v; break;
+            case 4: out[0] = t; out[1] = p; out[2] = v; break;
+            default: out[0] = v; out[1] = p; out[2] = q; break;
+        }
+    }
+    return (color & 0xFF000000u) | (toChannel(out[0]) << 16) | (toChannel(out[1]) << 8) | toChannel(out[2]);
+}
+
+// Все цвета сетки с шагом 5 по каждому каналу (0, 5, ..., 255) и разной альфой.
+std::vector<uint32_t> colorGrid() {
+    std::vector<uint32_t> colors;
+    for (uint32_t r = 0; r <= 255; r += 5) {
+        for (uint32_t g = 0; g <= 255; g += 5) {
+            for (uint32_t b = 0; b <= 255; b += 5) {
+                const uint32_t alpha = static_cast<uint32_t>(colors.size() * 29) & 0xFF;
+                colors.push_back((alpha << 24) | (r << 16) | (g << 8) | b);
+            }
+        }
+    }
+    return colors;
+}
+
+struct ColorProfile {
+    float vibranceGain;
+    float saturationGain;
+};
+
+class ColorLutEquivalence : public ::testing::TestWithParam<int> {};
+
+TEST_P(ColorLutEquivalence, MatchesKotlinOnColorGrid) {
+    const int lutSize = GetParam();
+    const int tolerance = lutSize == ColorLut::kSize33 ? 2 : 1;
+    // Сетка по диапазонам ProfileCalculator: vibrance 0..1.12, saturation 0.86..1.48.
+    std::vector<ColorProfile> profiles;
+    for (float vibranceGain : {0.0f, 0.05f, 0.3f, 0.6f, 0.9f, 1.12f}) {
+        for (float saturationGain : {0.86f, 1.0f, 1.15f, 1.3f, 1.48f}) {
+            profiles.push_back({vibranceGain, saturationGain});
+        }
+    }
+    const std::vector<uint32_t> src = colorGrid();
+    // 52^3 цвета — кадр 52^2 x 52, чтобы полос было несколько.
+    const int width = 52 * 52;
+    const int height = 52;
+    ASSERT_EQ(src.size(), static_cast<size_t>(width) * height);
+
+    for (const ColorProfile& profile : profiles) {
+        SCOPED_TRACE(::testing::Message() << "vibrance=" << profile.vibranceGain
+                                          << " saturation=" << profile.saturationGain);
+        const ColorLut lut(profile.vibranceGain, profile.saturationGain, lutSize);
+        std::vector<uint32_t> actual(src.size());
+        ASSERT_TRUE(applyColorLut(lut, src.data(), actual.data(), width, height, 4));
+
+        int maxDifference = 0;
+        int alphaMismatches = 0;
+        uint32_t worstColor = 0;
+        for (size_t i = 0; i < src.size(); ++i) {
+            const uint32_t expected = kotlinVibranceSaturation(src[i], profile.vibranceGain, profile.saturationGain);
+            if ((actual[i] >> 24) != (expected >> 24)) {
+                ++alphaMismatches;
+            }
+            for (int shift = 0; shift < 24; shift += 8) {
+                const int difference = std::abs(
+                    static_cast<int>((actual[i] >> shift) & 0xFF) - static_cast<int>((expected >> shift) & 0xFF)
+                );
+                if (difference > maxDifference) {
+                    maxDifference = difference;
+                    worstColor = src[i] & 0xFFFFFFu;
+                }
+            }
+        }
+        EXPECT_EQ(alphaMismatches, 0);
+        EXPECT_LE(maxDifference, tolerance) << "худший цвет #" << std::hex << worstColor;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(LutSizes, ColorLutEquivalence,
+                         ::testing::Values(ColorLut::kSize33, ColorLut::kSize65),
+                         [](const ::testing::TestParamInfo<int>& param) {
+                             return "Size" + std::to_string(param.param);
+                         });
+
+TEST(ColorLut, NeutralPixelsAreExact) {
+    // Серая ось: в Kotlin серый получает H = 0 и S = vibranceGain, LUT здесь
+    // не интерполирует, а считает формулу.
+    const ColorLut lut(0.35f, 1.2f, ColorLut::kSize65);
+    std::vector<uint32_t> src;
+    for (uint32_t level = 0; level <= 255; ++level) {
+        src.push_back(0xFF000000u | (level << 16) | (level << 8) | level);
+    }
+    std::vector<uint32_t> actual(src.size());
+    lut.applyRow(src.data(), actual.data(), static_cast<int>(src.size()));
+    for (size_t i = 0; i < src.size(); ++i) {
+        EXPECT_EQ(actual[i], kotlinVibranceSaturation(src[i], 0.35f, 1.2f)) << "уровень " << i;
+    }
+}
+
+TEST(ColorLut, RgbRowMatchesArgbRow) {
+    // matToBitmap и JpegBandEncoder применяют LUT к 8-битной RGB-строке; длина
+    // больше одного внутреннего блока, чтобы проверить и его границу.
+    const ColorLut lut(0.6f, 1.3f, ColorLut::kSize65);
+    const int count = 700;
+    std::vector<uint32_t> argb(count);
+    std::vector<uint8_t> rgb(static_cast<size_t>(count) * 3);
+    uint32_t seed = 777;
+    for (int i = 0; i < count; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        argb[i] = 0xFF000000u | (seed >> 8);
+        rgb[i * 3] = static_cast<uint8_t>(argb[i] >> 16);
+        rgb[i * 3 + 1] = static_cast<uint8_t>(argb[i] >> 8);
+        rgb[i * 3 + 2] = static_cast<uint8_t>(argb[i]);
+    }
+    std::vector<uint32_t> expected(count);
+    lut.applyRow(argb.data(), expected.data(), count);
+    lut.applyRgbRow(rgb.data(), count);
+    for (int i = 0; i < count; ++i) {
+        const uint32_t actual = 0xFF000000u | (static_cast<uint32_t>(rgb[i * 3]) << 16) |
+                                (static_cast<uint32_t>(rgb[i * 3 + 1]) << 8) | rgb[i * 3 + 2];
+        EXPECT_EQ(actual, expected[i]) << "пиксель " << i;
+    }
+}
+
+}
@@ -0,0 +1,54 @@
+#include "cpu_accounting.h"
+#include "ncnn_engine.h"
+#include <gtest/gtest.h>
+#include <chrono>
+
+// Распределение по классам ядер обходит /proc/self/task и включается только
+// в режиме профилирования; остальной учёт CPU пишется всегда.
+
+namespace {
+
+using namespace kotopogoda;
+
+// Крутит поток не меньше duration, чтобы набралось несколько тиков планировщика.
+void burnCpu(std::chrono::milliseconds duration) {
+    const auto end = std::chrono::steady_clock::now() + duration;
+    volatile uint64_t sink = 0;
+    while (std::chrono::steady_clock::now() < end) {
+        for (int i = 0; i < 10000; ++i) {
+            sink = sink + static_cast<uint64_t>(i);
+        }
+    }
+}
+
+TEST(CpuAccounting, CoreClassesOnlyWhenRequested) {
+    TelemetryData telemetry;
+    {
+        CpuAccounting accounting(telemetry, false);
+        burnCpu(std::chrono::milliseconds(60));
+        accounting.finish();
+    }
+    EXPECT_GT(telemetry.cpu.threadCpuMicros, 0);
+    EXPECT_GT(telemetry.cpu.processCpuMicros, 0);
+    EXPECT_EQ(telemetry.cpu.cpuMask, 0u);
+    for (int64_t micros : telemetry.cpu.coreClassMicros) {
+        EXPECT_EQ(micros, 0);
+    }
+}
+
+TEST(CpuAccounting, CoreClassesWithProfiling) {
+    TelemetryData telemetry;
+    {
+        CpuAccounting accounting(telemetry, true);
+        burnCpu(std::chrono::milliseconds(60));
+        accounting.finish();
+    }
+    EXPECT_NE(telemetry.cpu.cpuMask, 0u);
+    int64_t total = 0;
+    for (int64_t micros : telemetry.cpu.coreClassMicros) {
+        total += micros;
+    }
+    EXPECT_GT(total, 0);
+}
+
+}
@@ -0,0 +1,212 @@
+#include "edge_unsharp.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// applyEdgeAwareUnsharp против дословного переноса
+// EnhanceEngine.applyEdgeAwareUnsharp (gaussianBlur, gaussianKernel,
+// composeColor) на случайных кадрах: результат в пределах 1 LSB на канал,
+// альфа без изменений. Тот же Kotlin-код на устройстве сверяет
+// NativeSharpenerEquivalenceTest.
+
+namespace {
+
+using namespace kotopogoda;
+
+float clamp01(float value) {
+    return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+float luminance(float r, float g, float b) {
+    return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+}
+
+// roundToInt(): Math.round(Float) — floor(x + 0.5).
+int roundToInt(float value) {
+    return static_cast<int>(std::floor(value + 0.5f));
+}
+
+uint32_t composeColor(uint32_t alpha, float r, float g, float b) {
+    const uint32_t rr = static_cast<uint32_t>(std::min(255, std::max(0, roundToInt(r * 255.0f))));
+    const uint32_t gg = static_cast<uint32_t>(std::min(255, std::max(0, roundToInt(g * 255.0f))));
+    const uint32_t bb = static_cast<uint32_t>(std::min(255, std::max(0, roundToInt(b * 255.0f))));
+    return (alpha << 24) | (rr << 16) | (gg << 8) | bb;
+}
+
+std::vector<float> kotlinKernel(int radius) {
+    const int size = radius * 2 + 1;
+    const float sigma = std::max(radius / 2.0f, 1.0f);
+    std::vector<float> kernel(size);
+    float sum = 0.0f;
+    for (int i = 0; i < size; ++i) {
+        const float x = static_cast<float>(i - radius);
+        const float value = static_cast<float>(std::exp(static_cast<double>(-(x * x) / (2.0f * sigma * sigma))));
+        kernel[i] = value;
+        sum += value;
+    }
+    if (sum > 0.0f) {
+        for (float& value : kernel) {
+            value /= sum;
+        }
+    }
+    return kernel;
+}
+
+void kotlinBlur(const std::vector<float>& src, std::vector<float>& out, int width, int height, int radius) {
+    const std::vector<float> kernel = kotlinKernel(radius);
+    const int size = static_cast<int>(kernel.size());
+    std::vector<float> temp(src.size());
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            float acc = 0.0f;
+            for (int k = 0; k < size; ++k) {
+                const int offsetX = std::min(width - 1, std::max(0, x + k - radius));
+                acc += src[y * width + offsetX] * kernel[k];
+            }
+            temp[y * width + x] = acc;
+        }
+    }
+    out.assign(src.size(), 0.0f);
+    for (int x = 0; x < width; ++x) {
+        for (int y = 0; y < height; ++y) {
+            float acc = 0.0f;
+            for (int k = 0; k < size; ++k) {
+                const int offsetY = std::min(height - 1, std::max(0, y + k - radius));
+                acc += temp[offsetY * width + x] * kernel[k];
+            }
+            out[y * width + x] = acc;
+        }
+    }
+}
+
+std::vector<uint32_t> kotlinUnsharp(
+    const std::vector<uint32_t>& pixels,
+    int width,
+    int height,
+    float amount,
+    float radius,
+    float threshold
+) {
+    if (amount <= 1e-3f || radius <= 0.1f) {
+        return pixels;
+    }
+    const size_t total = pixels.size();
+    std::vector<float> srcR(total);
+    std::vector<float> srcG(total);
+    std::vector<float> srcB(total);
+    for (size_t i = 0; i < total; ++i) {
+        srcR[i] = static_cast<float>((pixels[i] >> 16) & 0xFF) / 255.0f;
+        srcG[i] = static_cast<float>((pixels[i] >> 8) & 0xFF) / 255.0f;
+        srcB[i] = static_cast<float>(pixels[i] & 0xFF) / 255.0f;
+    }
+    const int rad = std::max(1, roundToInt(std::min(12.0f, std::max(0.5f, radius))));
+    std::vector<float> blurR;
+    std::vector<float> blurG;
+    std::vector<float> blurB;
+    kotlinBlur(srcR, blurR, width, height, rad);
+    kotlinBlur(srcG, blurG, width, height, rad);
+    kotlinBlur(srcB, blurB, width, height, rad);
+
+    const float limit = std::min(1.5f, std::max(0.0f, amount));
+    const float thr = std::min(1.0f, std::max(0.0f, threshold));
+    std::vector<uint32_t> sharpened(total);
+    for (size_t i = 0; i < total; ++i) {
+        const float diffLum = std::fabs(
+            luminance(srcR[i], srcG[i], srcB[i]) - luminance(blurR[i], blurG[i], blurB[i])
+        );
+        const float mask = diffLum <= thr ? 0.0f : clamp01((diffLum - thr) / (1.0f - thr + 1e-5f));
+        const float gain = limit * mask;
+        sharpened[i] = composeColor(
+            pixels[i] >> 24,
+            clamp01(srcR[i] + (srcR[i] - blurR[i]) * gain),
+            clamp01(srcG[i] + (srcG[i] - blurG[i]) * gain),
+            clamp01(srcB[i] + (srcB[i] - blurB[i]) * gain)
+        );
+    }
+    return sharpened;
+}
+
+// Шум поверх плавного градиента: есть и резкие края, и пиксели ниже порога.
+std::vector<uint32_t> randomImage(int width, int height, uint32_t seed) {
+    std::vector<uint32_t> pixels(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            const int noise = static_cast<int>((seed >> 24) & 0x3F) - 32;
+            const int base = (x * 255 / width + y * 255 / height) / 2;
+            const uint32_t r = static_cast<uint32_t>(std::min(255, std::max(0, base + noise)));
+            const uint32_t g = static_cast<uint32_t>(std::min(255, std::max(0, 255 - base + noise / 2)));
+            const uint32_t b = (seed >> 8) & 0xFF;
+            const uint32_t a = (seed >> 16) & 0xFF;
+            pixels[static_cast<size_t>(y) * width + x] = (a << 24) | (r << 16) | (g << 8) | b;
+        }
+    }
+    return pixels;
+}
+
+struct UnsharpCase {
+    float amount;
+    float radius;
+    float threshold;
+};
+
+TEST(EdgeAwareUnsharp, MatchesKotlinWithinOneLsb) {
+    // Радиусы: округление вниз/вверх, ограничение снизу и сверху; amount и
+    // threshold — в пределах и за пределами ограничений Kotlin.
+    const UnsharpCase cases[] = {
+        {0.6f, 0.6f, 0.0f},
+        {1.0f, 1.0f, 0.02f},
+        {1.2f, 2.4f, 0.05f},
+        {0.8f, 2.5f, 0.0f},
+        {1.5f, 5.0f, 0.1f},
+        {3.0f, 12.0f, 0.01f},
+        {0.4f, 30.0f, 1.5f},
+        {0.5f, 7.3f, -0.2f},
+    };
+    const int sizes[][2] = {{67, 41}, {130, 200}, {5, 3}};
+    int caseIndex = 0;
+    for (const auto& size : sizes) {
+        const int width = size[0];
+        const int height = size[1];
+        for (const UnsharpCase& params : cases) {
+            SCOPED_TRACE(::testing::Message() << width << "x" << height << " amount=" << params.amount
+                                              << " radius=" << params.radius << " threshold=" << params.threshold);
+            const std::vector<uint32_t> src = randomImage(width, height, 977u + caseIndex++);
+            const std::vector<uint32_t> expected =
+                kotlinUnsharp(src, width, height, params.amount, params.radius, params.threshold);
+            std::vector<uint32_t> actual(src.size());
+            ASSERT_TRUE(applyEdgeAwareUnsharp(
+                src.data(), actual.data(), width, height, params.amount, params.radius, params.threshold, 4
+            ));
+
+            int maxDifference = 0;
+            int alphaMismatches = 0;
+            for (size_t i = 0; i < src.size(); ++i) {
+                if ((actual[i] >> 24) != (expected[i] >> 24)) {
+                    ++alphaMismatches;
+                }
+                for (int shift = 0; shift < 24; shift += 8) {
+                    const int a = static_cast<int>((actual[i] >> shift) & 0xFF);
+                    const int e = static_cast<int>((expected[i] >> shift) & 0xFF);
+                    maxDifference = std::max(maxDifference, std::abs(a - e));
+                }
+            }
+            EXPECT_EQ(alphaMismatches, 0);
+            EXPECT_LE(maxDifference, 1);
+        }
+    }
+}
+
+TEST(EdgeAwareUnsharp, BelowThresholdCopiesSource) {
+    const std::vector<uint32_t> src = randomImage(31, 17, 5u);
+    std::vector<uint32_t> dst(src.size());
+    ASSERT_TRUE(applyEdgeAwareUnsharp(src.data(), dst.data(), 31, 17, 1e-3f, 2.0f, 0.0f, 2));
+    EXPECT_EQ(dst, src);
+    ASSERT_TRUE(applyEdgeAwareUnsharp(src.data(), dst.data(), 31, 17, 1.0f, 0.1f, 0.0f, 2));
+    EXPECT_EQ(dst, src);
+}
+
+}
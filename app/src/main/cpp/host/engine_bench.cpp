@@ -0,0 +1,340 @@
+#include "host_bitmap.h"
+#include "color_lut.h"
+#include "edge_unsharp.h"
+#include "hann_window.h"
+#include "ncnn_engine.h"
+#include "sha256_verifier.h"
+#include "tile_processor.h"
+#include "zerodce_backend.h"
+#include <benchmark/benchmark.h>
+#include <ncnn/cpu.h>
+#include <ncnn/mat.h>
+#include <ncnn/net.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Бенчмарки ядра движка на хосте. Входы синтетические и детерминированные,
+// размеры — типичные кадры камер 2, 12 и 48 Мп. Отчёт для сравнения между
+// коммитами: цель bench_report (JSON) и tools/compare_native_bench.py.
+
+namespace {
+
+using namespace kotopogoda;
+
+struct FrameSize {
+    int width;
+    int height;
+};
+
+FrameSize frameSize(int64_t megapixels) {
+    switch (megapixels) {
+        case 2:
+            return {1632, 1224};
+        case 12:
+            return {4000, 3000};
+        case 48:
+            return {8000, 6000};
+    }
+    return {1024, 1024};
+}
+
+// Плавный градиент с шумом: похож на фото достаточно, чтобы ни одна ветка
+// (клампинг, смешивание) не вырождалась.
+void fillSynthetic(ncnn::Mat& mat, int width, int height) {
+    mat.create(width, height, 3, 4u, nullptr);
+    uint32_t seed = 0x9E3779B9u;
+    for (int c = 0; c < 3; ++c) {
+        float* channel = mat.channel(c);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                seed = seed * 1664525u + 1013904223u;
+                const float noise = static_cast<float>(seed >> 24) / 255.0f - 0.5f;
+                const float base = (static_cast<float>(x) / width + static_cast<float>(y) / height) * 0.5f;
+                channel[static_cast<size_t>(y) * width + x] =
+                    std::max(0.0f, std::min(1.0f, base * (0.6f + 0.2f * c) + noise * 0.1f));
+            }
+        }
+    }
+}
+
+void fillSynthetic(HostBitmap& bitmap) {
+    uint32_t seed = 0x2545F491u;
+    for (uint32_t& pixel : bitmap.pixels) {
+        seed = seed * 1664525u + 1013904223u;
+        pixel = 0xFF000000u | (seed >> 8);
+    }
+}
+
+void setFrameCounters(benchmark::State& state, int width, int height) {
+    const int64_t pixels = static_cast<int64_t>(width) * height;
+    state.SetItemsProcessed(state.iterations() * pixels);
+    state.counters["megapixels"] = static_cast<double>(pixels) / 1e6;
+}
+
+std::string modelsDir() {
+    const char* override = std::getenv("KOTOPOGODA_MODELS_DIR");
+    return override != nullptr ? override : KOTOPOGODA_BENCH_MODELS_DIR;
+}
+
+// Сеть Zero-DCE++ с теми же опциями, что в NcnnEngine::loadModels. nullptr —
+// моделей нет (bin скачивается отдельно, см. scripts/prepare_models.sh).
+const ncnn::Net* zeroDceNet() {
+    static std::unique_ptr<ncnn::Net> net = [] {
+        auto loaded = std::make_unique<ncnn::Net>();
+        loaded->opt.use_vulkan_compute = false;
+        loaded->opt.use_fp16_packed = false;
+        loaded->opt.use_fp16_storage = true;
+        loaded->opt.use_fp16_arithmetic = false;
+        loaded->opt.num_threads = std::max(1, std::min(4, ncnn::get_big_cpu_count()));
+        const std::string dir = modelsDir();
+        if (loaded->load_param((dir + "/zerodcepp_fp16.param").c_str()) != 0 ||
+            loaded->load_model((dir + "/zerodcepp_fp16.bin").c_str()) != 0) {
+            loaded.reset();
+        }
+        return loaded;
+    }();
+    return net.get();
+}
+
+std::string sourceRevision() {
+    const std::string command = std::string("git -C ") + KOTOPOGODA_BENCH_SOURCE_DIR +
+        " describe --always --dirty 2>/dev/null";
+    FILE* pipe = popen(command.c_str(), "r");
+    if (pipe == nullptr) {
+        return "unknown";
+    }
+    char line[128] = {};
+    const bool read = std::fgets(line, sizeof(line), pipe) != nullptr;
+    pclose(pipe);
+    std::string revision = read ? line : "unknown";
+    revision.erase(revision.find_last_not_of("\r\n") + 1);
+    return revision.empty() ? "unknown" : revision;
+}
+
+void BM_BitmapToMat(benchmark::State& state) {
+    const FrameSize size = frameSize(state.range(0));
+    HostBitmap bitmap(size.width, size.height);
+    fillSynthetic(bitmap);
+    for (auto _ : state) {
+        ncnn::Mat mat;
+        bitmapToMat(nullptr, bitmap.object(), mat);
+        benchmark::DoNotOptimize(mat.data);
+    }
+    setFrameCounters(state, size.width, size.height);
+}
+BENCHMARK(BM_BitmapToMat)->Arg(2)->Arg(12)->Arg(48)->Unit(benchmark::kMillisecond);
+
+void BM_MatToBitmap(benchmark::State& state) {
+    const FrameSize size = frameSize(state.range(0));
+    ncnn::Mat mat;
+    fillSynthetic(mat, size.width, size.height);
+    HostBitmap bitmap(size.width, size.height);
+    for (auto _ : state) {
+        matToBitmap(nullptr, mat, bitmap.object());
+        benchmark::DoNotOptimize(bitmap.pixels.data());
+    }
+    setFrameCounters(state, size.width, size.height);
+}
+BENCHMARK(BM_MatToBitmap)->Arg(2)->Arg(12)->Arg(48)->Unit(benchmark::kMillisecond);
+
+// Нерезкое маскирование результата: Мп и радиус (типичный профиль — 2..3,
+// предел — 12); потоки — как у JNI.
+void BM_EdgeAwareUnsharp(benchmark::State& state) {
+    const FrameSize size = frameSize(state.range(0));
+    HostBitmap source(size.width, size.height);
+    fillSynthetic(source);
+    std::vector<uint32_t> output(source.pixels.size());
+    const int threads = std::max(1, std::min(4, ncnn::get_big_cpu_count()));
+    for (auto _ : state) {
+        applyEdgeAwareUnsharp(
+            source.pixels.data(),
+            output.data(),
+            size.width,
+            size.height,
+            1.0f,
+            static_cast<float>(state.range(1)),
+            0.02f,
+            threads
+        );
+        benchmark::DoNotOptimize(output.data());
+    }
+    setFrameCounters(state, size.width, size.height);
+}
+BENCHMARK(BM_EdgeAwareUnsharp)
+    ->Args({2, 3})
+    ->Args({12, 3})
+    ->Args({12, 12})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Цветовая стадия профиля через 3D LUT: Мп и сторона таблицы. Сборка
+// таблицы вне замера — она кешируется между кадрами.
+void BM_ColorLut(benchmark::State& state) {
+    const FrameSize size = frameSize(state.range(0));
+    HostBitmap source(size.width, size.height);
+    fillSynthetic(source);
+    std::vector<uint32_t> output(source.pixels.size());
+    const auto lut = vibranceSaturationLut(0.4f, 1.2f, static_cast<int>(state.range(1)));
+    const int threads = std::max(1, std::min(4, ncnn::get_big_cpu_count()));
+    for (auto _ : state) {
+        applyColorLut(*lut, source.pixels.data(), output.data(), size.width, size.height, threads);
+        benchmark::DoNotOptimize(output.data());
+    }
+    setFrameCounters(state, size.width, size.height);
+}
+BENCHMARK(BM_ColorLut)
+    ->Args({12, ColorLut::kSize33})
+    ->Args({12, ColorLut::kSize65})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Вырезка тайлов и сшивание окном Ханна без сети: processFunc возвращает
+// вход, поэтому время — это extractTile, blendTile и сетка тайлов.
+void BM_TileExtractBlend(benchmark::State& state) {
+    const FrameSize size = frameSize(state.range(0));
+    ncnn::Mat input;
+    fillSynthetic(input, size.width, size.height);
+    TileConfig config;
+    config.tileSize = static_cast<int>(state.range(1));
+    config.overlap = 64;
+    std::atomic<bool> cancelFlag{false};
+    TileProcessor processor(config, cancelFlag);
+    auto passThrough = [](const ncnn::Mat& tileIn, ncnn::Mat& tileOut, ncnn::Net*, int*) {
+        tileOut = tileIn;
+        return true;
+    };
+    TileProcessStats stats;
+    for (auto _ : state) {
+        ncnn::Mat output;
+        if (!processor.processTiled(input, output, nullptr, passThrough, nullptr, &stats)) {
+            state.SkipWithError("processTiled вернул false");
+            break;
+        }
+        benchmark::DoNotOptimize(output.data);
+    }
+    setFrameCounters(state, size.width, size.height);
+    state.counters["tiles"] = stats.tileCount;
+}
+BENCHMARK(BM_TileExtractBlend)
+    ->Args({2, 384})
+    ->Args({12, 384})
+    ->Args({12, 512})
+    ->Unit(benchmark::kMillisecond);
+
+void BM_HannWindow2D(benchmark::State& state) {
+    const int tileSize = static_cast<int>(state.range(0));
+    std::vector<float> window;
+    for (auto _ : state) {
+        HannWindow::create2D(tileSize, tileSize, 64, window);
+        benchmark::DoNotOptimize(window.data());
+    }
+    state.SetItemsProcessed(state.iterations() * tileSize * tileSize);
+}
+BENCHMARK(BM_HannWindow2D)->Arg(256)->Arg(384)->Arg(512)->Unit(benchmark::kMicrosecond);
+
+void BM_Sha256(benchmark::State& state) {
+    const auto backend = static_cast<Sha256Backend>(state.range(0));
+    if (!Sha256::isBackendSupported(backend)) {
+        state.SkipWithError("бэкенд не поддерживается процессором");
+        return;
+    }
+    state.SetLabel(Sha256::backendName(backend));
+    std::vector<uint8_t> data(16u << 20);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 131u + (i >> 11));
+    }
+    for (auto _ : state) {
+        Sha256 sha(backend);
+        sha.update(data.data(), data.size());
+        uint8_t digest[Sha256::kDigestSize];
+        sha.final(digest);
+        benchmark::DoNotOptimize(digest);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(data.size()));
+}
+BENCHMARK(BM_Sha256)
+    ->Arg(static_cast<int>(Sha256Backend::SCALAR))
+    ->Arg(static_cast<int>(Sha256Backend::ARMV8_CE))
+    ->Arg(static_cast<int>(Sha256Backend::X86_SHANI))
+    ->Unit(benchmark::kMillisecond);
+
+// Полный путь Sha256Verifier: чтение файла и хеш лучшим бэкендом.
+void BM_Sha256VerifierFile(benchmark::State& state) {
+    char path[] = "/tmp/kotopogoda_bench_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+        state.SkipWithError("не удалось создать временный файл");
+        return;
+    }
+    std::vector<uint8_t> chunk(1u << 20);
+    for (size_t i = 0; i < chunk.size(); ++i) {
+        chunk[i] = static_cast<uint8_t>(i * 7u);
+    }
+    const int64_t megabytes = state.range(0);
+    bool written = true;
+    for (int64_t i = 0; i < megabytes && written; ++i) {
+        written = write(fd, chunk.data(), chunk.size()) == static_cast<ssize_t>(chunk.size());
+    }
+    close(fd);
+    if (!written) {
+        unlink(path);
+        state.SkipWithError("не удалось записать временный файл");
+        return;
+    }
+    for (auto _ : state) {
+        const std::string digest = Sha256Verifier::computeSha256(path);
+        benchmark::DoNotOptimize(digest.data());
+    }
+    unlink(path);
+    state.SetBytesProcessed(state.iterations() * megabytes * static_cast<int64_t>(chunk.size()));
+}
+BENCHMARK(BM_Sha256VerifierFile)->Arg(64)->Unit(benchmark::kMillisecond);
+
+// ZeroDceBackend::process целиком: уменьшение до kZeroDceMaxSide, сеть,
+// смешивание и увеличение обратно, как в runFull. RunContext — на итерацию.
+void BM_ZeroDceProcess(benchmark::State& state) {
+    const ncnn::Net* net = zeroDceNet();
+    if (net == nullptr) {
+        state.SkipWithError("модель Zero-DCE++ не найдена (KOTOPOGODA_MODELS_DIR)");
+        return;
+    }
+    const FrameSize size = frameSize(state.range(0));
+    ncnn::Mat input;
+    fillSynthetic(input, size.width, size.height);
+    for (auto _ : state) {
+        std::atomic<bool> cancelFlag{false};
+        TelemetryData telemetry;
+        RunContext context(cancelFlag, telemetry);
+        ZeroDceBackend backend(net, context);
+        ncnn::Mat output;
+        if (!backend.process(input, output, 0.8f, telemetry)) {
+            state.SkipWithError("ZeroDceBackend::process вернул false");
+            break;
+        }
+        benchmark::DoNotOptimize(output.data);
+    }
+    setFrameCounters(state, size.width, size.height);
+}
+BENCHMARK(BM_ZeroDceProcess)->Arg(2)->Arg(12)->Arg(48)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+}
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::AddCustomContext("source_revision", sourceRevision());
+    benchmark::AddCustomContext("sha256_backend", kotopogoda::Sha256::backendName(kotopogoda::Sha256::bestBackend()));
+    benchmark::AddCustomContext("models_dir", modelsDir());
+    benchmark::AddCustomContext("ncnn_threads", std::to_string(std::max(1, std::min(4, ncnn::get_big_cpu_count()))));
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
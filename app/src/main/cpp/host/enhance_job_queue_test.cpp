@@ -0,0 +1,352 @@
+#include "enhance_job_queue.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// EnhanceJobQueue напрямую: вытеснение превью по photoKey (ожидающего и
+// запущенного), отмена одной задачи без влияния на соседние, не больше одной
+// задачи каждого вида одновременно, приоритет и таймауты await.
+
+namespace {
+
+using namespace kotopogoda;
+
+constexpr auto kWait = std::chrono::seconds(5);
+
+// Задача, которая ждёт release() или отмены. Считает вызовы колбэков,
+// чтобы проверить, что onFinished и release вызываются ровно один раз.
+struct ControlledJob {
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool started = false;
+    bool released = false;
+    int onCancelCalls = 0;
+    int onFinishedCalls = 0;
+    int releaseCalls = 0;
+    EnhanceJobState finishedState = EnhanceJobState::UNKNOWN;
+    std::atomic<bool>* cancelFlag = nullptr;
+
+    bool waitStarted() {
+        std::unique_lock<std::mutex> lock(mutex);
+        return changed.wait_for(lock, kWait, [this] { return started; });
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            released = true;
+        }
+        changed.notify_all();
+    }
+
+    bool wasStarted() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return started;
+    }
+
+    bool cancelRequested() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return cancelFlag != nullptr && cancelFlag->load();
+    }
+};
+
+EnhanceJob makeJob(
+    const std::shared_ptr<ControlledJob>& control,
+    EnhanceJobKind kind,
+    const std::string& photoKey = std::string(),
+    int priority = 0,
+    std::function<void()> onRun = std::function<void()>()
+) {
+    EnhanceJob job;
+    job.kind = kind;
+    job.priority = priority;
+    job.photoKey = photoKey;
+    job.run = [control, onRun](std::atomic<bool>& cancelFlag, TelemetryData&) {
+        {
+            std::lock_guard<std::mutex> lock(control->mutex);
+            control->started = true;
+            control->cancelFlag = &cancelFlag;
+        }
+        control->changed.notify_all();
+        if (onRun) {
+            onRun();
+        }
+        std::unique_lock<std::mutex> lock(control->mutex);
+        control->changed.wait_for(lock, kWait, [&] { return control->released || cancelFlag.load(); });
+        return !cancelFlag.load();
+    };
+    job.onCancel = [control] {
+        std::lock_guard<std::mutex> lock(control->mutex);
+        ++control->onCancelCalls;
+        // Только будим run: флаг уже выставлен очередью.
+        control->changed.notify_all();
+    };
+    job.onFinished = [control](int64_t, EnhanceJobState state) {
+        std::lock_guard<std::mutex> lock(control->mutex);
+        ++control->onFinishedCalls;
+        control->finishedState = state;
+    };
+    job.release = [control] {
+        {
+            std::lock_guard<std::mutex> lock(control->mutex);
+            ++control->releaseCalls;
+        }
+        control->changed.notify_all();
+    };
+    return job;
+}
+
+// Поток очереди вызывает onFinished и release после публикации результата,
+// поэтому await может вернуться раньше колбэков: ждём release.
+void expectFinishedOnce(ControlledJob& control, EnhanceJobState state) {
+    std::unique_lock<std::mutex> lock(control.mutex);
+    ASSERT_TRUE(control.changed.wait_for(lock, kWait, [&] { return control.releaseCalls > 0; }));
+    EXPECT_EQ(control.onFinishedCalls, 1);
+    EXPECT_EQ(control.releaseCalls, 1);
+    EXPECT_EQ(control.finishedState, state);
+}
+
+TEST(EnhanceJobQueue, PendingPreviewIsSupersededBySamePhoto) {
+    EnhanceJobQueue queue;
+    // Полная обработка занимает единственный поток: превью остаются в очереди.
+    auto blocker = std::make_shared<ControlledJob>();
+    const int64_t blockerId = queue.submit(makeJob(blocker, EnhanceJobKind::FULL, "photo"));
+    ASSERT_TRUE(blocker->waitStarted());
+
+    auto first = std::make_shared<ControlledJob>();
+    auto second = std::make_shared<ControlledJob>();
+    auto other = std::make_shared<ControlledJob>();
+    const int64_t firstId = queue.submit(makeJob(first, EnhanceJobKind::PREVIEW, "photo"));
+    const int64_t otherId = queue.submit(makeJob(other, EnhanceJobKind::PREVIEW, "other"));
+    EXPECT_EQ(queue.poll(firstId, nullptr), EnhanceJobState::QUEUED);
+
+    const int64_t secondId = queue.submit(makeJob(second, EnhanceJobKind::PREVIEW, "photo"));
+    // Вытеснение синхронно с submit: результат уже готов, задача не запускалась.
+    EnhanceJobResult result;
+    EXPECT_EQ(queue.poll(firstId, &result), EnhanceJobState::SUPERSEDED);
+    EXPECT_TRUE(result.telemetry.cancelled);
+    expectFinishedOnce(*first, EnhanceJobState::SUPERSEDED);
+    EXPECT_FALSE(first->wasStarted());
+    // Превью другого фото и полная обработка того же фото не затронуты.
+    EXPECT_EQ(queue.poll(otherId, nullptr), EnhanceJobState::QUEUED);
+    EXPECT_EQ(queue.poll(blockerId, nullptr), EnhanceJobState::RUNNING);
+    EXPECT_FALSE(blocker->cancelRequested());
+
+    blocker->release();
+    second->release();
+    other->release();
+    EXPECT_EQ(queue.await(blockerId, -1, nullptr), EnhanceJobState::SUCCEEDED);
+    EXPECT_EQ(queue.await(secondId, -1, nullptr), EnhanceJobState::SUCCEEDED);
+    EXPECT_EQ(queue.await(otherId, -1, nullptr), EnhanceJobState::SUCCEEDED);
+    expectFinishedOnce(*second, EnhanceJobState::SUCCEEDED);
+    expectFinishedOnce(*other, EnhanceJobState::SUCCEEDED);
+}
+
+TEST(EnhanceJobQueue, RunningPreviewIsSupersededBySamePhoto) {
+    EnhanceJobQueue queue;
+    auto first = std::make_shared<ControlledJob>();
+    const int64_t firstId = queue.submit(makeJob(first, EnhanceJobKind::PREVIEW, "photo"));
+    ASSERT_TRUE(first->waitStarted());
+
+    // Превью другого фото текущее превью не отменяет.
+    auto other = std::make_shared<ControlledJob>();
+    const int64_t otherId = queue.submit(makeJob(other, EnhanceJobKind::PREVIEW, "other"));
+    EXPECT_FALSE(first->cancelRequested());
+
+    auto second = std::make_shared<ControlledJob>();
+    const int64_t secondId = queue.submit(makeJob(second, EnhanceJobKind::PREVIEW, "photo"));
+    EXPECT_EQ(queue.await(firstId, -1, nullptr), EnhanceJobState::SUPERSEDED);
+    expectFinishedOnce(*first, EnhanceJobState::SUPERSEDED);
+    {
+        std::lock_guard<std::mutex> lock(first->mutex);
+        EXPECT_EQ(first->onCancelCalls, 1);
+    }
+
+    second->release();
+    other->release();
+    EXPECT_EQ(queue.await(secondId, -1, nullptr), EnhanceJobState::SUCCEEDED);
+    EXPECT_EQ(queue.await(otherId, -1, nullptr), EnhanceJobState::SUCCEEDED);
+}
+
+TEST(EnhanceJobQueue, CancelRunningJobDoesNotAffectOthers) {
+    // Два потока: полная обработка и превью идут одновременно.
+    EnhanceJobQueue queue(EnhanceJobQueueHooks(), 2);
+    auto full = std::make_shared<ControlledJob>();
+    auto preview = std::make_shared<ControlledJob>();
+    auto queued = std::make_shared<ControlledJob>();
+    const int64_t fullId = queue.submit(makeJob(full, EnhanceJobKind::FULL, "photo"));
+    const int64_t previewId = queue.submit(makeJob(preview, EnhanceJobKind::PREVIEW, "photo"));
+    ASSERT_TRUE(full->waitStarted());
+    ASSERT_TRUE(preview->waitStarted());
+    const int64_t queuedId = queue.submit(makeJob(queued, EnhanceJobKind::FULL, "next"));
+
+    ASSERT_TRUE(queue.cancel(fullId));
+    EXPECT_EQ(queue.await(fullId, -1, nullptr), EnhanceJobState::CANCELLED);
+    expectFinishedOnce(*full, EnhanceJobState::CANCELLED);
+
+    // Соседние задачи — и запущенная, и ожидающая — флага отмены не получили.
+    EXPECT_FALSE(preview->cancelRequested());
+    ASSERT_TRUE(queued->waitStarted());
+    EXPECT_FALSE(queued->cancelRequested());
+    {
+        std::lock_guard<std::mutex> lock(preview->mutex);
+        EXPECT_EQ(preview->onCancelCalls, 0);
+    }
+    preview->release();
+    queued->release();
+    EXPECT_EQ(queue.await(previewId, -1, nullptr), EnhanceJobState::SUCCEEDED);
+    EXPECT_EQ(queue.await(queuedId, -1, nullptr), EnhanceJobState::SUCCEEDED);
+
+    // Отмена завершённой задачи ни на что не влияет.
+    EXPECT_FALSE(queue.cancel(fullId));
+}
+
+TEST(EnhanceJobQueue, CancelPendingJobDoesNotAffectOthers) {
+    EnhanceJobQueue queue;
+    auto blocker = std::make_shared<ControlledJob>();
+    const int64_t blockerId = queue.submit(makeJob(blocker, EnhanceJobKind::FULL));
+    ASSERT_TRUE(blocker->waitStarted());
+
+    auto a = std::make_shared<ControlledJob>();
+    auto b = std::make_shared<ControlledJob>();
+    const int64_t aId = queue.submit(makeJob(a, EnhanceJobKind::FULL));
+    const int64_t bId = queue.submit(makeJob(b, EnhanceJobKind::FULL));
+
+    ASSERT_TRUE(queue.cancel(aId));
+    EXPECT_EQ(queue.poll(aId, nullptr), EnhanceJobState::CANCELLED);
+    expectFinishedOnce(*a, EnhanceJobState::CANCELLED);
+    EXPECT_FALSE(a->wasStarted());
+    EXPECT_EQ(queue.poll(bId, nullptr), EnhanceJobState::QUEUED);
+    EXPECT_FALSE(blocker->cancelRequested());
+
+    blocker->release();
+    ASSERT_TRUE(b->waitStarted());
+    EXPECT_FALSE(b->cancelRequested());
+    b->release();
+    EXPECT_EQ(queue.await(blockerId, -1, nullptr), EnhanceJobState::SUCCEEDED);
+    EXPECT_EQ(queue.await(bId, -1, nullptr), EnhanceJobState::SUCCEEDED);
+}
+
+TEST(EnhanceJobQueue, AtMostOneJobPerKind) {
+    // Потоков больше, чем видов задач: ограничение держит очередь, а не число потоков.
+    EnhanceJobQueue queue(EnhanceJobQueueHooks(), 4);
+    std::mutex mutex;
+    int running[2] = {0, 0};
+    int maxRunning[2] = {0, 0};
+    auto track = [&](EnhanceJobKind kind) {
+        return [&, kind] {
+            std::lock_guard<std::mutex> lock(mutex);
+            const int index = static_cast<int>(kind);
+            maxRunning[index] = std::max(maxRunning[index], ++running[index]);
+        };
+    };
+
+    std::vector<std::shared_ptr<ControlledJob>> controls;
+    std::vector<EnhanceJobKind> kinds;
+    std::vector<int64_t> ids;
+    for (int i = 0; i < 3; ++i) {
+        for (EnhanceJobKind kind : {EnhanceJobKind::FULL, EnhanceJobKind::PREVIEW}) {
+            kinds.push_back(kind);
+            controls.push_back(std::make_shared<ControlledJob>());
+            ids.push_back(queue.submit(makeJob(controls.back(), kind, "photo" + std::to_string(i), 0, track(kind))));
+        }
+    }
+    // Первые FULL и PREVIEW стартуют вместе, остальные ждут своего вида.
+    ASSERT_TRUE(controls[0]->waitStarted());
+    ASSERT_TRUE(controls[1]->waitStarted());
+    for (size_t i = 2; i < controls.size(); ++i) {
+        EXPECT_FALSE(controls[i]->wasStarted()) << "задача " << i;
+    }
+
+    for (size_t i = 0; i < controls.size(); ++i) {
+        ASSERT_TRUE(controls[i]->waitStarted()) << "задача " << i;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --running[static_cast<int>(kinds[i])];
+        }
+        controls[i]->release();
+        EXPECT_EQ(queue.await(ids[i], -1, nullptr), EnhanceJobState::SUCCEEDED);
+    }
+    EXPECT_EQ(maxRunning[static_cast<int>(EnhanceJobKind::FULL)], 1);
+    EXPECT_EQ(maxRunning[static_cast<int>(EnhanceJobKind::PREVIEW)], 1);
+}
+
+TEST(EnhanceJobQueue, HigherPriorityRunsFirst) {
+    EnhanceJobQueue queue;
+    auto blocker = std::make_shared<ControlledJob>();
+    queue.submit(makeJob(blocker, EnhanceJobKind::FULL));
+    ASSERT_TRUE(blocker->waitStarted());
+
+    std::mutex mutex;
+    std::vector<int> order;
+    auto low = std::make_shared<ControlledJob>();
+    auto high = std::make_shared<ControlledJob>();
+    low->release();
+    high->release();
+    const int64_t lowId = queue.submit(makeJob(low, EnhanceJobKind::FULL, "", 0, [&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(0);
+    }));
+    const int64_t highId = queue.submit(makeJob(high, EnhanceJobKind::FULL, "", 5, [&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(5);
+    }));
+    blocker->release();
+    EXPECT_EQ(queue.await(lowId, -1, nullptr), EnhanceJobState::SUCCEEDED);
+    EXPECT_EQ(queue.await(highId, -1, nullptr), EnhanceJobState::SUCCEEDED);
+    EXPECT_EQ(order, (std::vector<int>{5, 0}));
+}
+
+TEST(EnhanceJobQueue, AwaitTimesOutAndResultIsTakenOnce) {
+    EnhanceJobQueue queue;
+    auto job = std::make_shared<ControlledJob>();
+    const int64_t jobId = queue.submit(makeJob(job, EnhanceJobKind::FULL));
+    ASSERT_TRUE(job->waitStarted());
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(queue.await(jobId, 50, nullptr), EnhanceJobState::RUNNING);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::milliseconds(50));
+    EXPECT_LT(elapsed, std::chrono::seconds(2));
+
+    // Неизвестная задача: таймаут, UNKNOWN.
+    EXPECT_EQ(queue.await(jobId + 100, 20, nullptr), EnhanceJobState::UNKNOWN);
+
+    job->release();
+    EnhanceJobResult result;
+    EXPECT_EQ(queue.await(jobId, -1, &result), EnhanceJobState::SUCCEEDED);
+    EXPECT_EQ(result.state, EnhanceJobState::SUCCEEDED);
+    // Конечное состояние отдаётся один раз.
+    EXPECT_EQ(queue.poll(jobId, nullptr), EnhanceJobState::UNKNOWN);
+    EXPECT_EQ(queue.await(jobId, 0, nullptr), EnhanceJobState::UNKNOWN);
+}
+
+TEST(EnhanceJobQueue, ShutdownCancelsEverythingAndRejectsNewJobs) {
+    auto running = std::make_shared<ControlledJob>();
+    auto pending = std::make_shared<ControlledJob>();
+    auto late = std::make_shared<ControlledJob>();
+    {
+        EnhanceJobQueue queue;
+        queue.submit(makeJob(running, EnhanceJobKind::FULL));
+        ASSERT_TRUE(running->waitStarted());
+        queue.submit(makeJob(pending, EnhanceJobKind::FULL));
+        queue.shutdown();
+        EXPECT_EQ(queue.submit(makeJob(late, EnhanceJobKind::FULL)), 0);
+    }
+    expectFinishedOnce(*running, EnhanceJobState::CANCELLED);
+    expectFinishedOnce(*pending, EnhanceJobState::CANCELLED);
+    EXPECT_FALSE(pending->wasStarted());
+    // Отклонённая задача освобождается, но не получает onFinished.
+    std::lock_guard<std::mutex> lock(late->mutex);
+    EXPECT_EQ(late->onFinishedCalls, 0);
+    EXPECT_EQ(late->releaseCalls, 1);
+}
+
+}
@@ -0,0 +1,113 @@
+#include "fd_stream.h"
+#include "sha256_verifier.h"
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// streamFd на пользовательском контенте: файл может измениться во время
+// чтения, и это не должно ронять процесс.
+
+namespace {
+
+using namespace kotopogoda;
+
+class FdStreamTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = ::testing::TempDir() + "fd_stream_test.bin";
+        content_.resize((3u << 20) + 12345u);
+        uint32_t seed = 0x12345678u;
+        for (uint8_t& byte : content_) {
+            seed = seed * 1664525u + 1013904223u;
+            byte = static_cast<uint8_t>(seed >> 24);
+        }
+        const int fd = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(::write(fd, content_.data(), content_.size()), static_cast<ssize_t>(content_.size()));
+        ::close(fd);
+    }
+
+    void TearDown() override { ::unlink(path_.c_str()); }
+
+    std::string path_;
+    std::vector<uint8_t> content_;
+};
+
+TEST_F(FdStreamTest, ReadsWholeFileFromStartRegardlessOfPosition) {
+    const int fd = ::open(path_.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(::lseek(fd, 1000, SEEK_SET), 1000);
+    std::vector<uint8_t> read;
+    uint64_t lastTotal = 0;
+    const FdStreamResult result = streamFd(
+        fd,
+        [&read](const uint8_t* data, size_t size) { read.insert(read.end(), data, data + size); },
+        [&lastTotal](uint64_t, uint64_t total) {
+            lastTotal = total;
+            return true;
+        }
+    );
+    ::close(fd);
+    EXPECT_EQ(result, FdStreamResult::OK);
+    EXPECT_EQ(lastTotal, content_.size());
+    EXPECT_EQ(read, content_);
+}
+
+TEST_F(FdStreamTest, MapModeMatchesReadMode) {
+    std::string digests[2];
+    const FdReadMode modes[2] = {FdReadMode::READ, FdReadMode::MAP};
+    for (int i = 0; i < 2; ++i) {
+        const int fd = ::open(path_.c_str(), O_RDONLY);
+        ASSERT_GE(fd, 0);
+        Sha256 hasher;
+        EXPECT_EQ(
+            streamFd(fd, [&hasher](const uint8_t* data, size_t size) { hasher.update(data, size); }, {}, modes[i]),
+            FdStreamResult::OK
+        );
+        ::close(fd);
+        digests[i] = hasher.finalHex();
+    }
+    EXPECT_EQ(digests[0], digests[1]);
+}
+
+// Другой процесс укорачивает файл после первой порции. Отображённый файл
+// получил бы SIGBUS на хвосте; чтение просто заканчивается раньше.
+TEST_F(FdStreamTest, SurvivesTruncationDuringRead) {
+    const int fd = ::open(path_.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    uint64_t received = 0;
+    bool truncated = false;
+    const std::string path = path_;
+    const FdStreamResult result = streamFd(
+        fd,
+        [&](const uint8_t*, size_t size) {
+            received += size;
+            if (!truncated) {
+                truncated = ::truncate(path.c_str(), 4096) == 0;
+            }
+        }
+    );
+    ::close(fd);
+    EXPECT_TRUE(truncated);
+    EXPECT_EQ(result, FdStreamResult::OK);
+    EXPECT_LT(received, content_.size());
+}
+
+TEST(FdStream, ReadsPipe) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    const std::string payload = "kotopogoda";
+    ASSERT_EQ(::write(fds[1], payload.data(), payload.size()), static_cast<ssize_t>(payload.size()));
+    ::close(fds[1]);
+    std::string read;
+    EXPECT_EQ(
+        streamFd(fds[0], [&read](const uint8_t* data, size_t size) { read.append(reinterpret_cast<const char*>(data), size); }),
+        FdStreamResult::OK
+    );
+    ::close(fds[0]);
+    EXPECT_EQ(read, payload);
+}
+
+}
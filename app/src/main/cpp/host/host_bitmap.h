@@ -0,0 +1,42 @@
+#ifndef HOST_BITMAP_H
+#define HOST_BITMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <jni.h>
+#include <android/bitmap.h>
+
+namespace kotopogoda {
+
+// Bitmap ARGB_8888 для хостовой сборки: то, что на устройстве передаётся
+// в движок как jobject android.graphics.Bitmap. Пиксель — байты R, G, B, A
+// (в uint32 красный — младший байт). strideWords — шаг строки в пикселях;
+// 0 — строки без выравнивания.
+struct HostBitmap {
+    AndroidBitmapInfo info{};
+    std::vector<uint32_t> pixels;
+
+    HostBitmap(int width, int height, int strideWords = 0)
+        : pixels(static_cast<size_t>(strideWords > width ? strideWords : width) * height) {
+        info.width = static_cast<uint32_t>(width);
+        info.height = static_cast<uint32_t>(height);
+        info.stride = static_cast<uint32_t>(strideWords > width ? strideWords : width) * 4;
+        info.format = ANDROID_BITMAP_FORMAT_RGBA_8888;
+    }
+
+    uint32_t& at(int x, int y) { return pixels[static_cast<size_t>(y) * (info.stride / 4) + x]; }
+    uint32_t at(int x, int y) const { return pixels[static_cast<size_t>(y) * (info.stride / 4) + x]; }
+
+    jobject object() { return reinterpret_cast<jobject>(this); }
+};
+
+// Пиксель HostBitmap из каналов (порядок байт RGBA_8888).
+inline uint32_t packRgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 0xFF) {
+    return static_cast<uint32_t>(r) | (static_cast<uint32_t>(g) << 8) |
+        (static_cast<uint32_t>(b) << 16) | (static_cast<uint32_t>(a) << 24);
+}
+
+}
+
+#endif
@@ -0,0 +1,186 @@
+#include "host_bitmap.h"
+#include "image_stats.h"
+#include "ncnn_engine.h"
+#include <gtest/gtest.h>
+#include <ncnn/mat.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// ImageStats из matToBitmap против EnhanceEngine.MetricsCalculator на том же
+// Bitmap. Каналы на кадре несимметричны: красные и синие области дают разную
+// яркость и разную долю тёмных пикселей, так что перепутанные каналы заметны.
+
+namespace {
+
+using namespace kotopogoda;
+
+struct Metrics {
+    double lMean;
+    double pDark;
+    double bSharpness;
+    double nNoise;
+};
+
+double laplacianAt(const std::vector<double>& luma, int width, int height, int x, int y) {
+    const int centerIndex = y * width + x;
+    const double center = luma[centerIndex];
+    double sum = -4.0 * center;
+    const double left = x > 0 ? luma[centerIndex - 1] : center;
+    const double right = x < width - 1 ? luma[centerIndex + 1] : center;
+    const double up = y > 0 ? luma[centerIndex - width] : center;
+    const double down = y < height - 1 ? luma[centerIndex + width] : center;
+    sum += left + right + up + down;
+    return sum;
+}
+
+double gaussianBlurAt(const std::vector<double>& luma, int width, int height, int x, int y) {
+    static const double kKernel[3][3] = {{1.0, 2.0, 1.0}, {2.0, 4.0, 2.0}, {1.0, 2.0, 1.0}};
+    double acc = 0.0;
+    double weightAcc = 0.0;
+    for (int ky = -1; ky <= 1; ++ky) {
+        const int cy = std::min(std::max(y + ky, 0), height - 1);
+        for (int kx = -1; kx <= 1; ++kx) {
+            const int cx = std::min(std::max(x + kx, 0), width - 1);
+            const double weight = kKernel[ky + 1][kx + 1];
+            acc += luma[cy * width + cx] * weight;
+            weightAcc += weight;
+        }
+    }
+    return weightAcc == 0.0 ? 0.0 : acc / weightAcc;
+}
+
+// MetricsCalculator.calculate, перенесённый построчно. Пиксели читаются так,
+// как их отдаёт Bitmap.getPixels: Color.red — первый байт RGBA_8888.
+Metrics kotlinMetrics(const HostBitmap& bitmap) {
+    const int width = static_cast<int>(bitmap.info.width);
+    const int height = static_cast<int>(bitmap.info.height);
+    const int total = width * height;
+    std::vector<double> luminances(total);
+    double luminanceSum = 0.0;
+    int darkCount = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const uint32_t pixel = bitmap.at(x, y);
+            const double r = (pixel & 0xFF) / 255.0;
+            const double g = ((pixel >> 8) & 0xFF) / 255.0;
+            const double b = ((pixel >> 16) & 0xFF) / 255.0;
+            const double luma = 0.2126 * r + 0.7152 * g + 0.0722 * b;
+            luminances[y * width + x] = luma;
+            luminanceSum += luma;
+            if (luma < 0.22) {
+                darkCount++;
+            }
+        }
+    }
+
+    double laplacianSum = 0.0;
+    double laplacianSqSum = 0.0;
+    double noiseSqSum = 0.0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const double laplacian = laplacianAt(luminances, width, height, x, y);
+            laplacianSum += laplacian;
+            laplacianSqSum += laplacian * laplacian;
+            const double blurred = gaussianBlurAt(luminances, width, height, x, y);
+            const double diff = luminances[y * width + x] - blurred;
+            noiseSqSum += diff * diff;
+        }
+    }
+
+    const double norm = total;
+    const double lMean = luminanceSum / norm;
+    const double pDark = darkCount / norm;
+    const double laplacianMean = laplacianSum / norm;
+    const double laplacianEnergy = laplacianSqSum / norm;
+    const double laplacianVariance = laplacianEnergy - laplacianMean * laplacianMean;
+    const double bSharpness = laplacianEnergy <= 1e-12
+        ? 0.0
+        : std::min(1.0, std::max(0.0, laplacianVariance / laplacianEnergy));
+    const double noiseStd = std::sqrt(noiseSqSum / norm);
+    const double noiseRelative = noiseStd / std::max(lMean, 1e-3);
+    double nNoise;
+    if (noiseRelative <= 0.04) {
+        nNoise = 0.0;
+    } else if (noiseRelative >= 0.32) {
+        nNoise = 1.0;
+    } else {
+        nNoise = (noiseRelative - 0.04) / (0.32 - 0.04);
+    }
+    return {lMean, pDark, bSharpness, nNoise};
+}
+
+// Левая половина — насыщенный красный, правая — насыщенный синий, с шумом и
+// градиентом по y. Ширина нечётная: хвост строки идёт скалярным путём.
+void fillAsymmetric(HostBitmap& bitmap) {
+    const int width = static_cast<int>(bitmap.info.width);
+    const int height = static_cast<int>(bitmap.info.height);
+    uint32_t seed = 0x2545F491u;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            const int noise = static_cast<int>(seed >> 27) - 16;
+            const int strong = std::min(255, std::max(0, 200 + noise + 50 * y / height));
+            const int green = std::min(255, std::max(0, 40 + noise));
+            if (x < width / 2) {
+                bitmap.at(x, y) = packRgba(static_cast<uint8_t>(strong), static_cast<uint8_t>(green), 0);
+            } else {
+                bitmap.at(x, y) = packRgba(0, static_cast<uint8_t>(green), static_cast<uint8_t>(strong));
+            }
+        }
+    }
+}
+
+TEST(ImageStats, MatToBitmapMatchesMetricsCalculator) {
+    const int width = 61;
+    const int height = 37;
+    HostBitmap source(width, height);
+    fillAsymmetric(source);
+
+    // Как runFull с тождественной сетью: Bitmap -> Mat -> Bitmap со статистикой.
+    ncnn::Mat mat;
+    bitmapToMat(nullptr, source.object(), mat);
+    HostBitmap result(width, height);
+    ImageStats stats;
+    matToBitmap(nullptr, mat, result.object(), &stats);
+    ASSERT_EQ(result.pixels, source.pixels);
+
+    const Metrics expected = kotlinMetrics(result);
+    ASSERT_TRUE(stats.valid);
+    EXPECT_EQ(stats.pixels, static_cast<int64_t>(width) * height);
+    EXPECT_NEAR(stats.lumaMean, expected.lMean, 1e-5);
+    EXPECT_NEAR(stats.darkShare, expected.pDark, 1e-6);
+    EXPECT_NEAR(stats.sharpness, expected.bSharpness, 1e-4);
+    EXPECT_NEAR(stats.noise, expected.nNoise, 1e-4);
+    // Кадр подобран так, что синяя половина тёмная, а красная — нет.
+    EXPECT_GT(expected.pDark, 0.3);
+    EXPECT_LT(expected.pDark, 0.7);
+}
+
+// Цвета, у которых целочисленная яркость ровно на пороге тёмного пикселя:
+// решает округление double-яркости в Kotlin.
+TEST(ImageStats, DarkThresholdFollowsKotlinRounding) {
+    int boundary = 0;
+    for (int r = 0; r < 256; ++r) {
+        for (int g = 0; g < 256; ++g) {
+            for (int b = 0; b < 256; ++b) {
+                if (2126 * r + 7152 * g + 722 * b != 561000) {
+                    continue;
+                }
+                ++boundary;
+                HostBitmap pixel(1, 1);
+                pixel.at(0, 0) = packRgba(static_cast<uint8_t>(r), static_cast<uint8_t>(g), static_cast<uint8_t>(b));
+                const uint8_t rgb[3] = {static_cast<uint8_t>(r), static_cast<uint8_t>(g), static_cast<uint8_t>(b)};
+                ImageStatsAccumulator accumulator(1, 1);
+                accumulator.addRow(rgb);
+                ImageStats stats;
+                ASSERT_TRUE(accumulator.finish(stats));
+                EXPECT_EQ(stats.darkShare, static_cast<float>(kotlinMetrics(pixel).pDark))
+                    << "r=" << r << " g=" << g << " b=" << b;
+            }
+        }
+    }
+    EXPECT_GT(boundary, 0);
+}
+
+}
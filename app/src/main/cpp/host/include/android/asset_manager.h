@@ -0,0 +1,8 @@
+#ifndef ANDROID_ASSET_MANAGER_H
+#define ANDROID_ASSET_MANAGER_H
+
+// Хостовый шим: ядро движка только передаёт AAssetManager дальше (модели
+// читаются из modelsDir), поэтому тип непрозрачен, а на хосте передаётся nullptr.
+struct AAssetManager;
+
+#endif
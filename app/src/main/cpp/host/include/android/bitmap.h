@@ -0,0 +1,31 @@
+#ifndef ANDROID_BITMAP_H
+#define ANDROID_BITMAP_H
+
+#include <cstdint>
+#include <jni.h>
+
+// Хостовый шим: jobject — это HostBitmap (host_bitmap.h), пиксели всегда
+// ARGB_8888 в памяти самого HostBitmap, блокировка ничего не делает.
+enum AndroidBitmapFormat {
+    ANDROID_BITMAP_FORMAT_NONE = 0,
+    ANDROID_BITMAP_FORMAT_RGBA_8888 = 1,
+};
+
+enum {
+    ANDROID_BITMAP_RESULT_SUCCESS = 0,
+    ANDROID_BITMAP_RESULT_BAD_PARAMETER = -1,
+};
+
+struct AndroidBitmapInfo {
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    int32_t format;
+    uint32_t flags;
+};
+
+int AndroidBitmap_getInfo(JNIEnv* env, jobject bitmap, AndroidBitmapInfo* info);
+int AndroidBitmap_lockPixels(JNIEnv* env, jobject bitmap, void** pixels);
+int AndroidBitmap_unlockPixels(JNIEnv* env, jobject bitmap);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef ANDROID_LOG_H
+#define ANDROID_LOG_H
+
+// Хостовый шим: __android_log_print пишет в stderr строку "[TAG] сообщение".
+// Порог задаёт переменная окружения KOTOPOGODA_LOG_LEVEL (v, d, i, w, e);
+// по умолчанию w, чтобы информационные логи движка не смешивались с выводом
+// бенчмарков.
+enum android_LogPriority {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT,
+};
+
+int __android_log_print(int prio, const char* tag, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+#endif
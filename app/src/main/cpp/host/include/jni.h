@@ -0,0 +1,23 @@
+#ifndef JNI_H
+#define JNI_H
+
+#include <cstdint>
+
+// Хостовый шим jni.h: только типы из сигнатур ядра движка (ncnn_engine.h).
+// JNI-слой (native_*_jni.cpp, jni_cache) на хосте не собирается, поэтому
+// JNIEnv здесь непрозрачен, а jobject указывает на HostBitmap (host_bitmap.h).
+typedef int32_t jint;
+typedef int64_t jlong;
+typedef uint8_t jboolean;
+typedef float jfloat;
+
+class _jobject {};
+typedef _jobject* jobject;
+
+struct _JNIEnv;
+typedef _JNIEnv JNIEnv;
+
+#define JNI_FALSE 0
+#define JNI_TRUE 1
+
+#endif
@@ -0,0 +1,205 @@
+#include "jpeg_decoder.h"
+#include "test_jpeg.h"
+#include <gtest/gtest.h>
+#include <ncnn/mat.h>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// decodeJpegPlanar против декодирования как в BitmapFactory, выбор масштаба
+// на границах, статистика входа computeJpegImageStats и отказ на CMYK/YCCK
+// (вызывающий должен откатиться на Bitmap).
+
+namespace {
+
+using namespace kotopogoda;
+
+TEST(JpegScaleDenom, KeepsLongSideAtLeastMaxSide) {
+    // Результат DCT-масштабирования — ceil(side / denom).
+    EXPECT_EQ(chooseJpegScaleDenom(4096, 3072, 2048), 2);
+    EXPECT_EQ(chooseJpegScaleDenom(4095, 3072, 2048), 2);
+    EXPECT_EQ(chooseJpegScaleDenom(4094, 3072, 2048), 1);
+    EXPECT_EQ(chooseJpegScaleDenom(8192, 6144, 2048), 4);
+    EXPECT_EQ(chooseJpegScaleDenom(8189, 6144, 2048), 4);
+    EXPECT_EQ(chooseJpegScaleDenom(8188, 6144, 2048), 2);
+    EXPECT_EQ(chooseJpegScaleDenom(16384, 100, 2048), 8);
+    EXPECT_EQ(chooseJpegScaleDenom(100000, 100, 2048), 8);
+}
+
+TEST(JpegScaleDenom, UsesLongestSide) {
+    EXPECT_EQ(chooseJpegScaleDenom(3072, 4096, 2048), 2);
+    EXPECT_EQ(chooseJpegScaleDenom(3072, 4094, 2048), 1);
+}
+
+TEST(JpegScaleDenom, DegenerateInputsDoNotScale) {
+    EXPECT_EQ(chooseJpegScaleDenom(4000, 3000, 0), 1);
+    EXPECT_EQ(chooseJpegScaleDenom(4000, 3000, -1), 1);
+    EXPECT_EQ(chooseJpegScaleDenom(0, 0, 2048), 1);
+    EXPECT_EQ(chooseJpegScaleDenom(100, 80, 2048), 1);
+    EXPECT_EQ(chooseJpegScaleDenom(2048, 2048, 2048), 1);
+    EXPECT_EQ(chooseJpegScaleDenom(1, 1, 1), 8);
+}
+
+TEST(JpegDecoder, FullSizeMatchesBitmapDecode) {
+    // Нечётные размеры: неполные MCU по обеим осям и последняя неполная полоса.
+    const int width = 101;
+    const int height = 77;
+    test::TempFile jpeg("decoder_full.jpg");
+    ASSERT_TRUE(test::writeTestJpeg(jpeg.path(), test::asymmetricRgb(width, height), width, height, 3, 90));
+
+    ncnn::Mat planar;
+    ASSERT_TRUE(decodeJpegPlanar(jpeg.path().c_str(), 1, planar));
+    ASSERT_EQ(planar.w, width);
+    ASSERT_EQ(planar.h, height);
+    ASSERT_EQ(planar.c, 3);
+
+    std::unique_ptr<HostBitmap> reference = test::decodeTestJpeg(jpeg.path());
+    ASSERT_NE(reference, nullptr);
+    int mismatches = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const uint32_t pixel = reference->at(x, y);
+            for (int c = 0; c < 3; ++c) {
+                // Сравнение по 8-битному уровню: таблица декодера собрана с
+                // -ffast-math, и i / 255 в ней может отличаться в последнем бите.
+                const int expected = static_cast<int>((pixel >> (8 * c)) & 0xFF);
+                const int actual = static_cast<int>(std::lround(planar.channel(c).row(y)[x] * 255.0f));
+                if (actual != expected && ++mismatches <= 5) {
+                    ADD_FAILURE() << "(" << x << ", " << y << ") канал " << c << ": "
+                                  << actual << " вместо " << expected;
+                }
+            }
+        }
+    }
+    EXPECT_EQ(mismatches, 0);
+}
+
+TEST(JpegDecoder, ScaledSizeMatchesHeaderInfo) {
+    const int width = 203;
+    const int height = 131;
+    test::TempFile jpeg("decoder_scaled.jpg");
+    ASSERT_TRUE(test::writeTestJpeg(jpeg.path(), test::asymmetricRgb(width, height), width, height, 3, 90));
+
+    for (int denom : {1, 2, 4, 8}) {
+        SCOPED_TRACE(denom);
+        ncnn::Mat planar;
+        ASSERT_TRUE(decodeJpegPlanar(jpeg.path().c_str(), denom, planar));
+        EXPECT_EQ(planar.w, (width + denom - 1) / denom);
+        EXPECT_EQ(planar.h, (height + denom - 1) / denom);
+        EXPECT_EQ(planar.c, 3);
+    }
+
+    JpegImageInfo info;
+    ASSERT_TRUE(readJpegInfo(jpeg.path().c_str(), 50, info));
+    EXPECT_EQ(info.width, width);
+    EXPECT_EQ(info.height, height);
+    EXPECT_EQ(info.scaleDenom, 4);
+    EXPECT_EQ(info.scaledWidth, 51);
+    EXPECT_EQ(info.scaledHeight, 33);
+}
+
+TEST(JpegDecoder, ImageStatsMatchDecodedPixels) {
+    const int width = 203;
+    const int height = 131;
+    test::TempFile jpeg("decoder_stats.jpg");
+    ASSERT_TRUE(test::writeTestJpeg(jpeg.path(), test::asymmetricRgb(width, height), width, height, 3, 90));
+
+    // Без масштаба статистика совпадает с накоплением по декодированным пикселям.
+    std::unique_ptr<HostBitmap> reference = test::decodeTestJpeg(jpeg.path());
+    ASSERT_NE(reference, nullptr);
+    ImageStatsAccumulator accumulator(width, height);
+    std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const uint32_t pixel = reference->at(x, y);
+            for (int c = 0; c < 3; ++c) {
+                row[static_cast<size_t>(x) * 3 + c] = static_cast<uint8_t>((pixel >> (8 * c)) & 0xFF);
+            }
+        }
+        accumulator.addRow(row.data());
+    }
+    ImageStats expected;
+    ASSERT_TRUE(accumulator.finish(expected));
+
+    JpegImageInfo info;
+    ImageStats stats;
+    ASSERT_TRUE(computeJpegImageStats(jpeg.path().c_str(), 0, info, stats));
+    EXPECT_EQ(info.scaleDenom, 1);
+    EXPECT_EQ(stats.pixels, static_cast<int64_t>(width) * height);
+    EXPECT_FLOAT_EQ(stats.lumaMean, expected.lumaMean);
+    EXPECT_FLOAT_EQ(stats.darkShare, expected.darkShare);
+    EXPECT_FLOAT_EQ(stats.sharpness, expected.sharpness);
+    EXPECT_FLOAT_EQ(stats.noise, expected.noise);
+
+    // С масштабом размеры — как у readJpegInfo, статистика — по уменьшенному кадру.
+    JpegImageInfo header;
+    ASSERT_TRUE(readJpegInfo(jpeg.path().c_str(), 50, header));
+    ASSERT_TRUE(computeJpegImageStats(jpeg.path().c_str(), 50, info, stats));
+    EXPECT_EQ(info.width, width);
+    EXPECT_EQ(info.height, height);
+    EXPECT_EQ(info.scaleDenom, header.scaleDenom);
+    EXPECT_EQ(info.scaledWidth, header.scaledWidth);
+    EXPECT_EQ(info.scaledHeight, header.scaledHeight);
+    EXPECT_EQ(stats.pixels, static_cast<int64_t>(header.scaledWidth) * header.scaledHeight);
+    EXPECT_NEAR(stats.lumaMean, expected.lumaMean, 0.02f);
+
+    std::atomic<bool> cancelFlag{true};
+    EXPECT_FALSE(computeJpegImageStats(jpeg.path().c_str(), 0, info, stats, &cancelFlag));
+    EXPECT_FALSE(computeJpegImageStats("/nonexistent/kotopogoda.jpg", 0, info, stats));
+}
+
+TEST(JpegDecoder, RejectsUnsupportedScale) {
+    test::TempFile jpeg("decoder_bad_scale.jpg");
+    ASSERT_TRUE(test::writeTestJpeg(jpeg.path(), test::asymmetricRgb(16, 16), 16, 16, 3, 90));
+    ncnn::Mat planar(4, 4, 3);
+    EXPECT_FALSE(decodeJpegPlanar(jpeg.path().c_str(), 3, planar));
+    EXPECT_TRUE(planar.empty());
+}
+
+class JpegDecoderCmyk : public ::testing::TestWithParam<bool> {};
+
+TEST_P(JpegDecoderCmyk, IsRejected) {
+    const bool ycck = GetParam();
+    const int width = 24;
+    const int height = 16;
+    std::vector<uint8_t> cmyk(static_cast<size_t>(width) * height * 4);
+    for (size_t i = 0; i < cmyk.size(); ++i) {
+        cmyk[i] = static_cast<uint8_t>(i * 37);
+    }
+    test::TempFile jpeg(ycck ? "decoder_ycck.jpg" : "decoder_cmyk.jpg");
+    ASSERT_TRUE(test::writeTestJpeg(jpeg.path(), cmyk, width, height, 4, 90, ycck));
+
+    // Непустой вход: при отказе результат должен быть освобождён.
+    ncnn::Mat planar(4, 4, 3);
+    EXPECT_FALSE(decodeJpegPlanar(jpeg.path().c_str(), 1, planar));
+    EXPECT_TRUE(planar.empty());
+
+    JpegImageInfo info;
+    EXPECT_FALSE(readJpegInfo(jpeg.path().c_str(), 0, info));
+    ImageStats stats;
+    EXPECT_FALSE(computeJpegImageStats(jpeg.path().c_str(), 0, info, stats));
+}
+
+INSTANTIATE_TEST_SUITE_P(ColorSpaces, JpegDecoderCmyk, ::testing::Values(false, true),
+                         [](const ::testing::TestParamInfo<bool>& param) {
+                             return param.param ? "Ycck" : "Cmyk";
+                         });
+
+TEST(JpegDecoder, CancelledBeforeFirstStrip) {
+    test::TempFile jpeg("decoder_cancel.jpg");
+    ASSERT_TRUE(test::writeTestJpeg(jpeg.path(), test::asymmetricRgb(64, 64), 64, 64, 3, 90));
+    std::atomic<bool> cancelFlag{true};
+    ncnn::Mat planar;
+    EXPECT_FALSE(decodeJpegPlanar(jpeg.path().c_str(), 1, planar, &cancelFlag));
+    EXPECT_TRUE(planar.empty());
+}
+
+TEST(JpegDecoder, MissingFileFails) {
+    ncnn::Mat planar(4, 4, 3);
+    EXPECT_FALSE(decodeJpegPlanar("/nonexistent/kotopogoda.jpg", 1, planar));
+    EXPECT_TRUE(planar.empty());
+}
+
+}
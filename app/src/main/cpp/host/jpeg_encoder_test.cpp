@@ -0,0 +1,233 @@
+#include "jpeg_decoder.h"
+#include "jpeg_encoder.h"
+#include "row_band_sink.h"
+#include "test_jpeg.h"
+#include <gtest/gtest.h>
+#include <ncnn/mat.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <unistd.h>
+#include <vector>
+
+// Запись результата полосами: writeResizedBands должен давать то же, что
+// полный ncnn::resize_bilinear, а JPEG из writeJpegFile — переносить APP1
+// Exif источника сразу за SOI, а цветовую LUT применять к строкам до записи.
+
+namespace {
+
+using namespace kotopogoda;
+
+// Собирает полосы обратно в кадр и проверяет порядок строк.
+class CollectingSink : public RowBandSink {
+public:
+    bool begin(int width, int height) override {
+        image.create(width, height, 3);
+        return !image.empty();
+    }
+
+    bool writeRows(const ncnn::Mat& band, int firstRow) override {
+        if (firstRow != nextRow || band.w != image.w || band.c != 3) {
+            return false;
+        }
+        for (int c = 0; c < 3; ++c) {
+            for (int row = 0; row < band.h; ++row) {
+                std::memcpy(image.channel(c).row(firstRow + row), band.channel(c).row(row), sizeof(float) * band.w);
+            }
+        }
+        nextRow += band.h;
+        return true;
+    }
+
+    bool finish() override {
+        finished = nextRow == image.h;
+        return finished;
+    }
+
+    ncnn::Mat image;
+    int nextRow = 0;
+    bool finished = false;
+};
+
+ncnn::Mat noisyImage(int width, int height) {
+    ncnn::Mat image(width, height, 3);
+    uint32_t seed = 12345;
+    for (int c = 0; c < 3; ++c) {
+        float* data = image.channel(c);
+        for (int i = 0; i < width * height; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            data[i] = static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+        }
+    }
+    return image;
+}
+
+std::vector<uint8_t> exifPayload(size_t size) {
+    static const uint8_t kHeader[] = {'E', 'x', 'i', 'f', 0, 0, 'M', 'M', 0, 42, 0, 0, 0, 8};
+    std::vector<uint8_t> payload(kHeader, kHeader + sizeof(kHeader));
+    for (size_t i = payload.size(); i < size; ++i) {
+        payload.push_back(static_cast<uint8_t>(i * 7));
+    }
+    return payload;
+}
+
+bool encodeWhole(const std::string& path, const ncnn::Mat& image, int quality) {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok;
+    {
+        JpegBandEncoder encoder(fd, quality);
+        ok = encoder.begin(image.w, image.h) && encoder.writeRows(image, 0) && encoder.finish();
+    }
+    return ::close(fd) == 0 && ok;
+}
+
+TEST(ResizedBands, MatchFullResizeBilinear) {
+    const ncnn::Mat source = noisyImage(37, 23);
+    const int width = 150;
+    const int height = 101;
+    ncnn::Mat expected;
+    ncnn::resize_bilinear(source, expected, width, height);
+    ASSERT_FALSE(expected.empty());
+
+    // Высоты полос, которые не делят высоту, и одна полоса на весь кадр.
+    for (int bandRows : {1, 7, kRowBandHeight, 1000}) {
+        SCOPED_TRACE(bandRows);
+        CollectingSink sink;
+        ASSERT_TRUE(writeResizedBands(source, width, height, sink, nullptr, bandRows));
+        ASSERT_TRUE(sink.finished);
+        float maxError = 0.0f;
+        for (int c = 0; c < 3; ++c) {
+            for (int y = 0; y < height; ++y) {
+                const float* actual = sink.image.channel(c).row(y);
+                const float* reference = expected.channel(c).row(y);
+                for (int x = 0; x < width; ++x) {
+                    maxError = std::max(maxError, std::fabs(actual[x] - reference[x]));
+                }
+            }
+        }
+        EXPECT_LE(maxError, 1e-5f);
+    }
+}
+
+TEST(ResizedBands, SameSizeIsCopy) {
+    const ncnn::Mat source = noisyImage(40, 33);
+    CollectingSink sink;
+    ASSERT_TRUE(writeResizedBands(source, 40, 33, sink));
+    for (int c = 0; c < 3; ++c) {
+        EXPECT_EQ(std::memcmp(sink.image.channel(c), source.channel(c), sizeof(float) * 40 * 33), 0);
+    }
+}
+
+TEST(JpegEncoder, BandedFileMatchesFullResizeEncode) {
+    const ncnn::Mat source = noisyImage(45, 30);
+    const int width = 133;
+    const int height = 90;
+    test::TempFile banded("encoder_banded.jpg");
+    ASSERT_TRUE(writeJpegFile(banded.path().c_str(), source, width, height, 92, {}));
+
+    ncnn::Mat resized;
+    ncnn::resize_bilinear(source, resized, width, height);
+    test::TempFile whole("encoder_whole.jpg");
+    ASSERT_TRUE(encodeWhole(whole.path(), resized, 92));
+
+    std::unique_ptr<HostBitmap> fromBands = test::decodeTestJpeg(banded.path());
+    std::unique_ptr<HostBitmap> fromWhole = test::decodeTestJpeg(whole.path());
+    ASSERT_NE(fromBands, nullptr);
+    ASSERT_NE(fromWhole, nullptr);
+    ASSERT_EQ(fromBands->info.width, static_cast<uint32_t>(width));
+    ASSERT_EQ(fromBands->info.height, static_cast<uint32_t>(height));
+
+    // Разница в последнем бите float может сдвинуть квантование на уровень.
+    int maxDifference = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            for (int shift = 0; shift < 24; shift += 8) {
+                const int a = static_cast<int>((fromBands->at(x, y) >> shift) & 0xFF);
+                const int b = static_cast<int>((fromWhole->at(x, y) >> shift) & 0xFF);
+                maxDifference = std::max(maxDifference, std::abs(a - b));
+            }
+        }
+    }
+    EXPECT_LE(maxDifference, 1);
+}
+
+TEST(JpegEncoder, ColorLutGradesWrittenRows) {
+    const ncnn::Mat source = noisyImage(40, 24);
+    const ColorLut lut(0.4f, 1.35f, ColorLut::kSize65);
+    test::TempFile plain("encoder_lut_plain.jpg");
+    test::TempFile graded("encoder_lut_graded.jpg");
+    ImageStats plainStats;
+    ImageStats gradedStats;
+    ASSERT_TRUE(writeJpegFile(plain.path().c_str(), source, 40, 24, 95, {}, nullptr, &plainStats));
+    ASSERT_TRUE(writeJpegFile(graded.path().c_str(), source, 40, 24, 95, {}, nullptr, &gradedStats, &lut));
+
+    // Статистика кодировщика — по строкам после LUT, как у отдельного прохода.
+    ImageStatsAccumulator accumulator(source.w, source.h);
+    std::vector<uint8_t> rgbRow(static_cast<size_t>(source.w) * 3);
+    for (int y = 0; y < source.h; ++y) {
+        for (int x = 0; x < source.w; ++x) {
+            for (int c = 0; c < 3; ++c) {
+                const float value = std::max(0.0f, std::min(1.0f, source.channel(c).row(y)[x]));
+                rgbRow[x * 3 + c] = static_cast<uint8_t>(value * 255.0f);
+            }
+        }
+        lut.applyRgbRow(rgbRow.data(), source.w);
+        accumulator.addRow(rgbRow.data());
+    }
+    ImageStats expectedStats;
+    ASSERT_TRUE(accumulator.finish(expectedStats));
+    EXPECT_FLOAT_EQ(gradedStats.lumaMean, expectedStats.lumaMean);
+    EXPECT_FLOAT_EQ(gradedStats.sharpness, expectedStats.sharpness);
+    EXPECT_FLOAT_EQ(gradedStats.noise, expectedStats.noise);
+    EXPECT_NE(gradedStats.lumaMean, plainStats.lumaMean);
+}
+
+TEST(JpegEncoder, ExifApp1FollowsSoi) {
+    const std::vector<uint8_t> app1 = exifPayload(300);
+    test::TempFile jpeg("encoder_exif.jpg");
+    ASSERT_TRUE(writeJpegFile(jpeg.path().c_str(), noisyImage(16, 16), 32, 24, 90, app1));
+
+    const std::vector<uint8_t> bytes = test::readTestFile(jpeg.path());
+    ASSERT_GT(bytes.size(), app1.size() + 6);
+    EXPECT_EQ(bytes[0], 0xFF);
+    EXPECT_EQ(bytes[1], 0xD8);
+    EXPECT_EQ(bytes[2], 0xFF);
+    EXPECT_EQ(bytes[3], 0xE1);
+    EXPECT_EQ((bytes[4] << 8) | bytes[5], static_cast<int>(app1.size() + 2));
+    EXPECT_TRUE(std::equal(app1.begin(), app1.end(), bytes.begin() + 6));
+
+    std::vector<uint8_t> readBack;
+    ASSERT_TRUE(readJpegExif(jpeg.path().c_str(), readBack));
+    EXPECT_EQ(readBack, app1);
+    EXPECT_NE(test::decodeTestJpeg(jpeg.path()), nullptr);
+}
+
+TEST(JpegEncoder, OversizedExifFallsBackToJfif) {
+    test::TempFile jpeg("encoder_big_exif.jpg");
+    ASSERT_TRUE(writeJpegFile(jpeg.path().c_str(), noisyImage(16, 16), 32, 24, 90, exifPayload(70000)));
+
+    const std::vector<uint8_t> bytes = test::readTestFile(jpeg.path());
+    ASSERT_GT(bytes.size(), 4u);
+    EXPECT_EQ(bytes[2], 0xFF);
+    EXPECT_EQ(bytes[3], 0xE0);
+    std::vector<uint8_t> readBack;
+    ASSERT_TRUE(readJpegExif(jpeg.path().c_str(), readBack));
+    EXPECT_TRUE(readBack.empty());
+}
+
+TEST(JpegEncoder, CancelRemovesFile) {
+    test::TempFile jpeg("encoder_cancel.jpg");
+    std::atomic<bool> cancelFlag{true};
+    EXPECT_FALSE(writeJpegFile(jpeg.path().c_str(), noisyImage(16, 16), 64, 64, 90, {}, &cancelFlag));
+    EXPECT_NE(::access(jpeg.path().c_str(), F_OK), 0);
+}
+
+}
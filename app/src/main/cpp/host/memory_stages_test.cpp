@@ -0,0 +1,84 @@
+#include "host_bitmap.h"
+#include "ncnn_engine.h"
+#include "sha256_verifier.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <string>
+
+// Увеличение результата Zero-DCE++ до размера входа учитывается отдельной
+// стадией upscale: полноразмерный выход не попадает в пик смешивания и
+// учитывается, пока жив.
+
+namespace {
+
+using namespace kotopogoda;
+
+std::string modelsDir() {
+    const char* override = std::getenv("KOTOPOGODA_MODELS_DIR");
+    return override != nullptr ? override : KOTOPOGODA_TEST_MODELS_DIR;
+}
+
+class MemoryStages : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const std::string dir = modelsDir();
+        NcnnEngine::ModelChecksums checksums;
+        checksums.param = Sha256Verifier::computeSha256(dir + "/zerodcepp_fp16.param");
+        checksums.bin = Sha256Verifier::computeSha256(dir + "/zerodcepp_fp16.bin");
+        if (checksums.param.empty() || checksums.bin.empty()) {
+            GTEST_SKIP() << "модель Zero-DCE++ не найдена (KOTOPOGODA_MODELS_DIR)";
+        }
+        ASSERT_TRUE(engine_.initialize(nullptr, dir, checksums, {}, PreviewProfile::BALANCED, true));
+    }
+
+    // Полная обработка кадра width x height; телеметрия памяти — в telemetry.
+    void runFull(int width, int height, TelemetryData& telemetry) {
+        HostBitmap source(width, height);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                source.at(x, y) = packRgba(
+                    static_cast<uint8_t>(x * 255 / width),
+                    static_cast<uint8_t>(y * 255 / height),
+                    static_cast<uint8_t>((x + y) & 0xFF)
+                );
+            }
+        }
+        HostBitmap output(width, height);
+        std::atomic<bool> cancelFlag{false};
+        RunContext context(cancelFlag, telemetry);
+        ASSERT_TRUE(engine_.runFull(nullptr, source.object(), 0.8f, output.object(), context));
+    }
+
+    NcnnEngine engine_;
+};
+
+long stagePeakKb(const TelemetryData& telemetry, PipelineStage stage) {
+    return telemetry.memory.stagePeakKb[static_cast<int>(stage)];
+}
+
+TEST_F(MemoryStages, UpscaleHasOwnStage) {
+    // Длинная сторона больше kZeroDceMaxSide: сеть видит уменьшенный кадр.
+    const int width = kZeroDceMaxSide + 200;
+    const int height = 1000;
+    TelemetryData telemetry;
+    runFull(width, height, telemetry);
+
+    // На увеличении живы вход и полноразмерный выход (CHW float).
+    const long fullKb = static_cast<long>(width) * height * 3 * sizeof(float) / 1024;
+    EXPECT_GE(stagePeakKb(telemetry, PipelineStage::UPSCALE), 2 * fullKb);
+    // Смешивание идёт на уменьшенном кадре: полноразмерного выхода в нём ещё нет.
+    EXPECT_LT(stagePeakKb(telemetry, PipelineStage::BLEND), stagePeakKb(telemetry, PipelineStage::UPSCALE));
+    // Выход учтён и на convert_out, пока результат пишется в Bitmap.
+    EXPECT_GE(stagePeakKb(telemetry, PipelineStage::CONVERT_OUT), 2 * fullKb);
+}
+
+TEST_F(MemoryStages, NoUpscaleWithoutDownscale) {
+    TelemetryData telemetry;
+    runFull(320, 200, telemetry);
+
+    EXPECT_GT(stagePeakKb(telemetry, PipelineStage::BLEND), 0);
+    EXPECT_EQ(stagePeakKb(telemetry, PipelineStage::UPSCALE), 0);
+}
+
+}
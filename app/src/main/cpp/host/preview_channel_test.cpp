@@ -0,0 +1,72 @@
+#include "host_bitmap.h"
+#include "ncnn_engine.h"
+#include "jpeg_decoder.h"
+#include "sha256_verifier.h"
+#include "test_jpeg.h"
+#include <gtest/gtest.h>
+#include <ncnn/mat.h>
+#include <atomic>
+#include <cstdlib>
+#include <string>
+
+// Превью из нативного JPEG-декодера (runPreview с ncnn::Mat) и из Bitmap,
+// декодированного как BitmapFactory (runPreview с Bitmap), должно совпадать
+// попиксельно: оба пути подают сети один и тот же RGB.
+
+namespace {
+
+using namespace kotopogoda;
+
+std::string modelsDir() {
+    const char* override = std::getenv("KOTOPOGODA_MODELS_DIR");
+    return override != nullptr ? override : KOTOPOGODA_TEST_MODELS_DIR;
+}
+
+TEST(PreviewChannelOrder, JpegPathMatchesBitmapPath) {
+    const std::string dir = modelsDir();
+    NcnnEngine::ModelChecksums checksums;
+    checksums.param = Sha256Verifier::computeSha256(dir + "/zerodcepp_fp16.param");
+    checksums.bin = Sha256Verifier::computeSha256(dir + "/zerodcepp_fp16.bin");
+    if (checksums.param.empty() || checksums.bin.empty()) {
+        GTEST_SKIP() << "модель Zero-DCE++ не найдена (KOTOPOGODA_MODELS_DIR)";
+    }
+    NcnnEngine engine;
+    ASSERT_TRUE(engine.initialize(nullptr, dir, checksums, {}, PreviewProfile::BALANCED, true));
+
+    const int width = 96;
+    const int height = 64;
+    test::TempFile jpeg("preview_channel.jpg");
+    ASSERT_TRUE(test::writeTestJpeg(jpeg.path(), test::asymmetricRgb(width, height), width, height, 3, 95));
+
+    ncnn::Mat planar;
+    ASSERT_TRUE(decodeJpegPlanar(jpeg.path().c_str(), 1, planar));
+    HostBitmap fromJpeg(width, height);
+    {
+        std::atomic<bool> cancelFlag{false};
+        TelemetryData telemetry;
+        RunContext context(cancelFlag, telemetry);
+        ASSERT_TRUE(engine.runPreview(nullptr, planar, 0.8f, fromJpeg.object(), context));
+    }
+
+    std::unique_ptr<HostBitmap> fromBitmap = test::decodeTestJpeg(jpeg.path());
+    ASSERT_NE(fromBitmap, nullptr);
+    {
+        std::atomic<bool> cancelFlag{false};
+        TelemetryData telemetry;
+        RunContext context(cancelFlag, telemetry);
+        ASSERT_TRUE(engine.runPreview(nullptr, fromBitmap->object(), 0.8f, context));
+    }
+
+    int mismatches = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (fromJpeg.at(x, y) != fromBitmap->at(x, y)) {
+                ++mismatches;
+            }
+        }
+    }
+    EXPECT_EQ(mismatches, 0);
+    engine.release();
+}
+
+}
@@ -0,0 +1,299 @@
+#include "progress_channel.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Кольцо ProgressRing под несколькими производителями и потребителями и
+// ProgressDispatcher: свёртка переполнения, ограничение частоты доставки
+// и доставка последнего события в stop().
+
+namespace {
+
+using namespace kotopogoda;
+
+constexpr const char* kStageA = "stage_a";
+constexpr const char* kStageB = "stage_b";
+constexpr const char* kStageC = "stage_c";
+
+TEST(ProgressRing, CapacityRoundsUpToPowerOfTwo) {
+    EXPECT_EQ(ProgressRing(1).capacity(), 2u);
+    EXPECT_EQ(ProgressRing(5).capacity(), 8u);
+    EXPECT_EQ(ProgressRing(64).capacity(), 64u);
+
+    ProgressRing ring(4);
+    ProgressEvent event;
+    for (int i = 0; i < 4; ++i) {
+        event.current = i;
+        EXPECT_TRUE(ring.tryPush(event));
+    }
+    EXPECT_FALSE(ring.tryPush(event));
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(ring.tryPop(event));
+        EXPECT_EQ(event.current, i);
+    }
+    EXPECT_FALSE(ring.tryPop(event));
+}
+
+TEST(ProgressRing, MultiProducerMultiConsumerKeepsEveryEventOnce) {
+    constexpr int kProducers = 4;
+    constexpr int kConsumers = 3;
+    constexpr int kEventsPerProducer = 50000;
+    // Маленькое кольцо: производители постоянно упираются в заполненность.
+    ProgressRing ring(64);
+
+    std::atomic<bool> start{false};
+    std::atomic<int> producersDone{0};
+    std::vector<std::thread> threads;
+    for (int producer = 0; producer < kProducers; ++producer) {
+        threads.emplace_back([&, producer] {
+            while (!start.load()) {
+            }
+            ProgressEvent event;
+            event.total = producer;
+            for (int i = 0; i < kEventsPerProducer; ++i) {
+                event.current = i;
+                while (!ring.tryPush(event)) {
+                    std::this_thread::yield();
+                }
+            }
+            producersDone.fetch_add(1);
+        });
+    }
+
+    std::vector<std::vector<ProgressEvent>> popped(kConsumers);
+    for (int consumer = 0; consumer < kConsumers; ++consumer) {
+        threads.emplace_back([&, consumer] {
+            while (!start.load()) {
+            }
+            ProgressEvent event;
+            while (true) {
+                if (ring.tryPop(event)) {
+                    popped[consumer].push_back(event);
+                } else if (producersDone.load() == kProducers) {
+                    // Повторная попытка после завершения производителей забирает хвост.
+                    if (!ring.tryPop(event)) {
+                        break;
+                    }
+                    popped[consumer].push_back(event);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    start.store(true);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<std::vector<int>> seen(kProducers, std::vector<int>(kEventsPerProducer, 0));
+    size_t total = 0;
+    for (const std::vector<ProgressEvent>& events : popped) {
+        // Внутри одного потребителя события одного производителя идут по порядку.
+        std::vector<int> lastSeen(kProducers, -1);
+        for (const ProgressEvent& event : events) {
+            ASSERT_GE(event.total, 0);
+            ASSERT_LT(event.total, kProducers);
+            ASSERT_GE(event.current, 0);
+            ASSERT_LT(event.current, kEventsPerProducer);
+            EXPECT_GT(event.current, lastSeen[event.total]);
+            lastSeen[event.total] = event.current;
+            ++seen[event.total][event.current];
+        }
+        total += events.size();
+    }
+    EXPECT_EQ(total, static_cast<size_t>(kProducers) * kEventsPerProducer);
+    int lost = 0;
+    int duplicated = 0;
+    for (const std::vector<int>& counts : seen) {
+        for (int count : counts) {
+            lost += count == 0 ? 1 : 0;
+            duplicated += count > 1 ? 1 : 0;
+        }
+    }
+    EXPECT_EQ(lost, 0);
+    EXPECT_EQ(duplicated, 0);
+}
+
+// Собирает доставленные события; поток диспетчера можно задержать на старте,
+// чтобы кольцо гарантированно переполнилось.
+class RecordingSink {
+public:
+    ProgressSink sink(bool holdStart = false) {
+        ProgressSink result;
+        result.onThreadStart = [this, holdStart] {
+            if (holdStart) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                released_.wait(lock, [this] { return release_; });
+            }
+        };
+        result.deliver = [this](const ProgressEvent& event) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            deliveries_.push_back({event.stage, event.current, event.total, std::chrono::steady_clock::now()});
+        };
+        result.onThreadStop = [this] {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        };
+        return result;
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            release_ = true;
+        }
+        released_.notify_all();
+    }
+
+    struct Delivery {
+        std::string stage;
+        int current;
+        int total;
+        std::chrono::steady_clock::time_point at;
+    };
+
+    std::vector<Delivery> deliveries() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return deliveries_;
+    }
+
+    bool stopped() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stopped_;
+    }
+
+    // Последнее доставленное значение current по стадиям.
+    std::map<std::string, int> latest() {
+        std::map<std::string, int> result;
+        for (const Delivery& delivery : deliveries()) {
+            result[delivery.stage] = delivery.current;
+        }
+        return result;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable released_;
+    bool release_ = false;
+    bool stopped_ = false;
+    std::vector<Delivery> deliveries_;
+};
+
+TEST(ProgressDispatcher, OverflowFoldsToLatestPerStage) {
+    RecordingSink recorder;
+    ProgressDispatcher dispatcher(recorder.sink(true), 1000, 4);
+
+    // Диспетчер стоит: четыре события уходят в кольцо, остальные — в слоты стадий.
+    const char* stages[] = {kStageA, kStageB, kStageC};
+    constexpr int kPerStage = 200;
+    for (int i = 1; i <= kPerStage; ++i) {
+        for (const char* stage : stages) {
+            dispatcher.publish(stage, i, kPerStage);
+        }
+    }
+    EXPECT_EQ(dispatcher.publishedEvents(), 3u * kPerStage);
+    EXPECT_EQ(dispatcher.overflowedEvents(), 3u * kPerStage - 4u);
+    EXPECT_EQ(dispatcher.droppedEvents(), 0u);
+
+    recorder.release();
+    dispatcher.stop();
+
+    const std::map<std::string, int> latest = recorder.latest();
+    ASSERT_EQ(latest.size(), 3u);
+    for (const char* stage : stages) {
+        EXPECT_EQ(latest.at(stage), kPerStage) << stage;
+    }
+    // Свёрнутые события не доставляются по одному: на стадию — одна доставка.
+    EXPECT_EQ(recorder.deliveries().size(), 3u);
+    EXPECT_EQ(dispatcher.deliveredEvents(), 3u);
+}
+
+TEST(ProgressDispatcher, DeliveryRateStaysWithinLimit) {
+    constexpr int kMaxRateHz = 20;
+    RecordingSink recorder;
+    ProgressDispatcher dispatcher(recorder.sink(), kMaxRateHz);
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = start + std::chrono::milliseconds(600);
+    int published = 0;
+    while (std::chrono::steady_clock::now() < end) {
+        dispatcher.publish(kStageA, ++published, 0);
+        dispatcher.publish(kStageB, published, 0);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    dispatcher.stop();
+    const double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const char* stage : {kStageA, kStageB}) {
+        std::vector<std::chrono::steady_clock::time_point> times;
+        int last = 0;
+        for (const RecordingSink::Delivery& delivery : recorder.deliveries()) {
+            if (delivery.stage == stage) {
+                times.push_back(delivery.at);
+                last = delivery.current;
+            }
+        }
+        // Не больше одной доставки за интервал плюс финальная в stop().
+        EXPECT_LE(static_cast<double>(times.size()), elapsedSec * kMaxRateHz + 2) << stage;
+        EXPECT_GE(times.size(), 2u) << stage;
+        EXPECT_EQ(last, published) << stage;
+    }
+    EXPECT_LT(dispatcher.deliveredEvents(), dispatcher.publishedEvents() / 10);
+}
+
+TEST(ProgressDispatcher, StopFlushesFinalEvent) {
+    RecordingSink recorder;
+    // 1 Гц: до stop() диспетчер не просыпается сам.
+    ProgressDispatcher dispatcher(recorder.sink(), 1);
+    for (int i = 1; i <= 10; ++i) {
+        dispatcher.publish(kStageA, i, 10);
+    }
+    dispatcher.publish(kStageB, 3, 7);
+    dispatcher.stop();
+
+    EXPECT_TRUE(recorder.stopped());
+    const std::map<std::string, int> latest = recorder.latest();
+    EXPECT_EQ(latest.at(kStageA), 10);
+    EXPECT_EQ(latest.at(kStageB), 3);
+    EXPECT_EQ(recorder.deliveries().size(), 2u);
+
+    // Повторный stop() ничего не доставляет.
+    const size_t delivered = recorder.deliveries().size();
+    dispatcher.stop();
+    EXPECT_EQ(recorder.deliveries().size(), delivered);
+}
+
+TEST(ProgressDispatcher, ConcurrentPublishersDeliverLatestOnStop) {
+    RecordingSink recorder;
+    ProgressDispatcher dispatcher(recorder.sink(), 60, 16);
+    const char* stages[] = {kStageA, kStageB, kStageC};
+    std::vector<std::thread> producers;
+    constexpr int kSteps = 20000;
+    for (const char* stage : stages) {
+        producers.emplace_back([&dispatcher, stage] {
+            for (int i = 1; i <= kSteps; ++i) {
+                dispatcher.publish(stage, i, kSteps);
+            }
+        });
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    dispatcher.stop();
+
+    EXPECT_EQ(dispatcher.publishedEvents(), 3u * kSteps);
+    EXPECT_EQ(dispatcher.droppedEvents(), 0u);
+    const std::map<std::string, int> latest = recorder.latest();
+    for (const char* stage : stages) {
+        EXPECT_EQ(latest.at(stage), kSteps) << stage;
+    }
+}
+
+}
@@ -0,0 +1,197 @@
+#include "sha256_batch.h"
+#include "sha256_verifier.h"
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Известные ответы FIPS 180-4 для каждого бэкенда сжатия, сверка
+// ускоренных бэкендов со scalar на границах дополнения, порционный update()
+// и лейны Sha256Batch против одиночного хеша. Бэкенды, которых нет на
+// процессоре сборки, пропускаются.
+
+namespace {
+
+using namespace kotopogoda;
+
+std::vector<uint8_t> pseudoRandomBytes(size_t size, uint32_t seed) {
+    std::vector<uint8_t> bytes(size);
+    for (uint8_t& byte : bytes) {
+        seed = seed * 1664525u + 1013904223u;
+        byte = static_cast<uint8_t>(seed >> 24);
+    }
+    return bytes;
+}
+
+std::string digestHex(Sha256Backend backend, const void* data, size_t size) {
+    Sha256 hasher(backend);
+    hasher.update(data, size);
+    return hasher.finalHex();
+}
+
+std::string backendParamName(const ::testing::TestParamInfo<Sha256Backend>& param) {
+    return Sha256::backendName(param.param);
+}
+
+class Sha256Backends : public ::testing::TestWithParam<Sha256Backend> {
+protected:
+    void SetUp() override {
+        if (!Sha256::isBackendSupported(GetParam())) {
+            GTEST_SKIP() << "бэкенд " << Sha256::backendName(GetParam()) << " не поддерживается";
+        }
+    }
+};
+
+TEST_P(Sha256Backends, Fips180KnownAnswers) {
+    struct KnownAnswer {
+        const char* message;
+        const char* digest;
+    };
+    const KnownAnswer answers[] = {
+        {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+        {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+        {
+            "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+            "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"
+        },
+        {
+            "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmno"
+            "ijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+            "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"
+        },
+    };
+    for (const KnownAnswer& answer : answers) {
+        EXPECT_EQ(digestHex(GetParam(), answer.message, std::strlen(answer.message)), answer.digest)
+            << "сообщение \"" << answer.message << "\"";
+    }
+
+    // Миллион символов 'a'.
+    const std::vector<uint8_t> million(1000000, 'a');
+    EXPECT_EQ(
+        digestHex(GetParam(), million.data(), million.size()),
+        "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"
+    );
+    EXPECT_TRUE(Sha256Verifier::selfTest(GetParam()));
+}
+
+TEST_P(Sha256Backends, MatchesScalarAtPaddingBoundaries) {
+    // 55 — последняя длина с дополнением в одном блоке, 56..63 — дополнение
+    // во второй блок, 64/65 — ровно блок и блок с байтом; то же через блок.
+    const size_t lengths[] = {0, 1, 55, 56, 57, 63, 64, 65, 119, 120, 127, 128, 129, 1000, 4096 + 55};
+    const std::vector<uint8_t> data = pseudoRandomBytes(4096 + 64, 0xC0FFEEu);
+    for (size_t length : lengths) {
+        EXPECT_EQ(
+            digestHex(GetParam(), data.data(), length),
+            digestHex(Sha256Backend::SCALAR, data.data(), length)
+        ) << "длина " << length;
+    }
+}
+
+TEST_P(Sha256Backends, SplitUpdatesMatchSingleUpdate) {
+    const std::vector<uint8_t> data = pseudoRandomBytes(3 * 64 + 17, 0xBADC0DEu);
+    const std::string expected = digestHex(GetParam(), data.data(), data.size());
+    // Порции меньше, равные и больше блока, со сдвигом относительно границ блоков.
+    const size_t chunks[] = {1, 3, 55, 56, 63, 64, 65, 100};
+    for (size_t chunk : chunks) {
+        Sha256 hasher(GetParam());
+        for (size_t offset = 0; offset < data.size(); offset += chunk) {
+            hasher.update(data.data() + offset, std::min(chunk, data.size() - offset));
+        }
+        EXPECT_EQ(hasher.totalBytes(), data.size());
+        EXPECT_EQ(hasher.finalHex(), expected) << "порции по " << chunk;
+    }
+    // Пустые update() между порциями ничего не меняют.
+    Sha256 hasher(GetParam());
+    hasher.update(data.data(), 10);
+    hasher.update(data.data() + 10, 0);
+    hasher.update(data.data() + 10, data.size() - 10);
+    EXPECT_EQ(hasher.finalHex(), expected);
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, Sha256Backends,
+                         ::testing::Values(Sha256Backend::SCALAR, Sha256Backend::ARMV8_CE, Sha256Backend::X86_SHANI),
+                         backendParamName);
+
+TEST(HmacSha256, Rfc4231TestCase2) {
+    const char key[] = "Jefe";
+    const char message[] = "what do ya want for nothing?";
+    HmacSha256 mac(reinterpret_cast<const uint8_t*>(key), std::strlen(key));
+    mac.update(message, std::strlen(message));
+    EXPECT_EQ(mac.finalHex(), "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+}
+
+std::string kernelParamName(const ::testing::TestParamInfo<Sha256LaneKernel>& param) {
+    return Sha256Batch::kernelName(param.param);
+}
+
+class Sha256BatchLanes : public ::testing::TestWithParam<Sha256LaneKernel> {
+protected:
+    void SetUp() override {
+        if (!Sha256Batch::isKernelSupported(GetParam())) {
+            GTEST_SKIP() << "ядро " << Sha256Batch::kernelName(GetParam()) << " не поддерживается";
+        }
+    }
+
+    void TearDown() override {
+        for (int fd : fds_) {
+            ::close(fd);
+        }
+        for (const std::string& path : paths_) {
+            ::unlink(path.c_str());
+        }
+    }
+
+    int writeFile(const std::vector<uint8_t>& content) {
+        const std::string path = ::testing::TempDir() + "sha256_batch_" + std::to_string(paths_.size()) + ".bin";
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        EXPECT_GE(fd, 0);
+        if (!content.empty()) {
+            EXPECT_EQ(::write(fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+        }
+        paths_.push_back(path);
+        fds_.push_back(fd);
+        return fd;
+    }
+
+    std::vector<std::string> paths_;
+    std::vector<int> fds_;
+};
+
+TEST_P(Sha256BatchLanes, LanesMatchSingleStreamDigests) {
+    EXPECT_TRUE(Sha256Batch::selfTest(GetParam()));
+
+    // Файлов больше, чем лейнов, и разной длины: лейны освобождаются
+    // в разное время и подхватывают следующие файлы.
+    const size_t lengths[] = {
+        0, 1, 55, 56, 63, 64, 65, 128, 1000, 4096 + 55, (1u << 20) + 3, 200000, 17, 64 * 1024, 9
+    };
+    std::vector<std::string> expected;
+    uint32_t seed = 1;
+    for (size_t length : lengths) {
+        const std::vector<uint8_t> content = pseudoRandomBytes(length, seed++);
+        writeFile(content);
+        expected.push_back(digestHex(Sha256Backend::SCALAR, content.data(), content.size()));
+    }
+
+    const Sha256Batch batch(GetParam());
+    ASSERT_EQ(batch.kernel(), GetParam());
+    std::vector<std::string> digests;
+    std::vector<FdStreamResult> results;
+    ASSERT_EQ(batch.hashFds(fds_, digests, results), FdStreamResult::OK);
+    ASSERT_EQ(digests.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(results[i], FdStreamResult::OK) << "файл " << i;
+        EXPECT_EQ(digests[i], expected[i]) << "файл " << i << ", длина " << lengths[i];
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Kernels, Sha256BatchLanes,
+                         ::testing::Values(Sha256LaneKernel::SEQUENTIAL, Sha256LaneKernel::NEON_X4,
+                                           Sha256LaneKernel::AVX2_X8),
+                         kernelParamName);
+
+}
@@ -0,0 +1,79 @@
+#include "host_bitmap.h"
+#include "ncnn_engine.h"
+#include "sha256_verifier.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <string>
+
+// Устойчивый режим применяется только к запускам, контекст которых включил
+// его (элементы пакета); одиночная полная обработка идёт без бюджета и пауз.
+
+namespace {
+
+using namespace kotopogoda;
+
+std::string modelsDir() {
+    const char* override = std::getenv("KOTOPOGODA_MODELS_DIR");
+    return override != nullptr ? override : KOTOPOGODA_TEST_MODELS_DIR;
+}
+
+class SustainedMode : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const std::string dir = modelsDir();
+        NcnnEngine::ModelChecksums checksums;
+        checksums.param = Sha256Verifier::computeSha256(dir + "/zerodcepp_fp16.param");
+        checksums.bin = Sha256Verifier::computeSha256(dir + "/zerodcepp_fp16.bin");
+        if (checksums.param.empty() || checksums.bin.empty()) {
+            GTEST_SKIP() << "модель Zero-DCE++ не найдена (KOTOPOGODA_MODELS_DIR)";
+        }
+        ASSERT_TRUE(engine_.initialize(nullptr, dir, checksums, {}, PreviewProfile::BALANCED, true));
+        setSustainedModeEnabled(true);
+    }
+
+    void TearDown() override {
+        setSustainedModeEnabled(true);
+    }
+
+    TelemetryData runFull(bool sustained) {
+        constexpr int kWidth = 160;
+        constexpr int kHeight = 120;
+        HostBitmap source(kWidth, kHeight);
+        for (int y = 0; y < kHeight; ++y) {
+            for (int x = 0; x < kWidth; ++x) {
+                source.at(x, y) = packRgba(static_cast<uint8_t>(x), static_cast<uint8_t>(y), 96);
+            }
+        }
+        HostBitmap output(kWidth, kHeight);
+        TelemetryData telemetry;
+        std::atomic<bool> cancelFlag{false};
+        {
+            RunContext context(cancelFlag, telemetry);
+            context.setSustained(sustained);
+            EXPECT_TRUE(engine_.runFull(nullptr, source.object(), 0.8f, output.object(), context));
+        }
+        return telemetry;
+    }
+
+    NcnnEngine engine_;
+};
+
+TEST_F(SustainedMode, SingleRunIsNotThrottled) {
+    const TelemetryData telemetry = runFull(false);
+    EXPECT_FALSE(telemetry.sustained.enabled);
+}
+
+TEST_F(SustainedMode, OptedInRunAppliesBudget) {
+    const TelemetryData telemetry = runFull(true);
+    EXPECT_TRUE(telemetry.sustained.enabled);
+    EXPECT_GT(telemetry.sustained.report.applied.threads, 0);
+}
+
+TEST_F(SustainedMode, GlobalSwitchOverridesOptIn) {
+    setSustainedModeEnabled(false);
+    const TelemetryData telemetry = runFull(true);
+    EXPECT_FALSE(telemetry.sustained.enabled);
+}
+
+}
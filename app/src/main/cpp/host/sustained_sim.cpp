@@ -0,0 +1,300 @@
+#include "sustained_performance.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Симуляция SustainedPerformanceController на синтетической тепловой модели:
+// время контроллера подменяется часами симуляции, задержки тайлов считаются
+// из модели нагрева, поэтому прогон на сотни кадров занимает миллисекунды и
+// повторяется бит в бит. Очередь прогоняется дважды — с фиксированным бюджетом
+// (все потоки, без пауз) и под контроллером — с простоем посередине, после
+// которого контроллер должен вернуться на верхний уровень. --check превращает
+// прогон в проверку: код возврата 1, если контроллер не отступил под
+// троттлингом, не вернулся после остывания, потратил на мегапиксель больше
+// энергии, чем фиксированный бюджет, или заметно уступил ему в пропускной
+// способности на хвосте очереди.
+
+namespace {
+
+using namespace kotopogoda;
+
+struct Options {
+    int images = 300;
+    double megapixels = 4.0;
+    int threads = 4;
+    // Пропускная способность холодного устройства на всех потоках, Мп/с.
+    double coldMpps = 2.0;
+    // Простой посередине очереди, с.
+    double idleGapSeconds = 120.0;
+    // Показатель масштабирования по потокам: throughput ~ threads^scaling.
+    double threadScaling = 0.8;
+    bool check = false;
+    bool verbose = false;
+};
+
+// Нагрев первого порядка: dT/dt = power * kHeat - T / kTau, где мощность
+// пропорциональна числу потоков и частоте. Выше kThrottleAt частота линейно
+// падает до kMinFrequency к kThrottleAt + kThrottleSpan; на всех потоках
+// равновесие — задержка кадра примерно в 2,4 раза выше холодной.
+constexpr double kHeat = 0.5;
+constexpr double kTau = 40.0;
+constexpr double kThrottleAt = 25.0;
+constexpr double kThrottleSpan = 10.0;
+constexpr double kMinFrequency = 0.35;
+constexpr double kStepSeconds = 0.01;
+constexpr double kNoise = 0.05;
+// --check: доля пропускной способности фиксированного бюджета, которую
+// контроллер должен сохранить на хвосте очереди.
+constexpr double kMinTailShare = 0.9;
+
+struct Thermal {
+    double temperature = 0.0;
+    double peak = 0.0;
+    double energy = 0.0;
+    double temperatureSeconds = 0.0;
+    double seconds = 0.0;
+
+    double frequency() const {
+        const double excess = (temperature - kThrottleAt) / kThrottleSpan;
+        return std::max(kMinFrequency, std::min(1.0, 1.0 - excess * (1.0 - kMinFrequency)));
+    }
+
+    void advance(double seconds, double power) {
+        const double decay = std::exp(-seconds / kTau);
+        const double target = power * kHeat * kTau;
+        temperature = target + (temperature - target) * decay;
+        peak = std::max(peak, temperature);
+        energy += power * seconds;
+        temperatureSeconds += temperature * seconds;
+        this->seconds += seconds;
+    }
+};
+
+struct Totals {
+    double wallSeconds = 0.0;
+    double computeSeconds = 0.0;
+    double tailMpps = 0.0;
+    double peakTemperature = 0.0;
+    double meanTemperature = 0.0;
+    double energyPerMegapixel = 0.0;
+    int throttles = 0;
+    int recovers = 0;
+    int levelAfterGap = -1;
+    int levelAtEnd = 0;
+    int minLevelAfterGap = -1;
+};
+
+// Детерминированный шум ±kNoise.
+class Noise {
+public:
+    double next() {
+        state_ = state_ * 6364136223846793005ULL + 1442695040888963407ULL;
+        const double unit = static_cast<double>(state_ >> 11) / static_cast<double>(1ULL << 53);
+        return 1.0 + (unit * 2.0 - 1.0) * kNoise;
+    }
+
+private:
+    uint64_t state_ = 0x5eed;
+};
+
+// Кадр на threads потоках: время считается шагами, потому что частота
+// меняется вместе с температурой.
+double computeFrame(Thermal& thermal, const Options& options, int threads, double noise) {
+    const double share = std::pow(static_cast<double>(threads) / options.threads, options.threadScaling);
+    double remaining = options.megapixels;
+    double seconds = 0.0;
+    while (remaining > 0.0) {
+        const double frequency = thermal.frequency();
+        const double rate = options.coldMpps * share * frequency / noise;
+        const double step = std::min(kStepSeconds, remaining / rate);
+        thermal.advance(step, threads * frequency);
+        remaining -= rate * step;
+        seconds += step;
+    }
+    return seconds;
+}
+
+Totals simulate(const Options& options, bool controlled) {
+    int64_t nowMicros = 0;
+    SustainedConfig config;
+    config.maxThreads = options.threads;
+    SustainedPerformanceController controller(config, [&nowMicros]() { return nowMicros; });
+
+    Thermal thermal;
+    Noise noise;
+    Totals totals;
+    const int gapAt = options.images / 2;
+    const int tailFrom = options.images * 3 / 4;
+    double tailStart = 0.0;
+    auto toMicros = [](double seconds) { return static_cast<int64_t>(std::llround(seconds * 1e6)); };
+
+    for (int image = 0; image < options.images; ++image) {
+        if (image == gapAt && options.idleGapSeconds > 0.0) {
+            thermal.advance(options.idleGapSeconds, 0.0);
+            nowMicros += toMicros(options.idleGapSeconds);
+            totals.levelAfterGap = controller.level();
+            totals.minLevelAfterGap = totals.levelAfterGap;
+        }
+        if (image == tailFrom) {
+            tailStart = nowMicros / 1e6;
+        }
+
+        SustainedBudget budget;
+        budget.threads = options.threads;
+        if (controlled) {
+            budget = controller.budget();
+            if (budget.pauseMicros > 0) {
+                thermal.advance(budget.pauseMicros / 1e6, 0.0);
+                nowMicros += budget.pauseMicros;
+            }
+        }
+        const double seconds = computeFrame(thermal, options, budget.threads, noise.next());
+        nowMicros += toMicros(seconds);
+        totals.computeSeconds += seconds;
+
+        if (controlled) {
+            SustainedReport report;
+            const SustainedDecision decision = controller.recordTile(
+                budget,
+                static_cast<int64_t>(options.megapixels * 1e6),
+                toMicros(seconds),
+                &report
+            );
+            if (decision == SustainedDecision::THROTTLE) {
+                ++totals.throttles;
+            } else if (decision == SustainedDecision::RECOVER) {
+                ++totals.recovers;
+            }
+            if (image >= gapAt && totals.minLevelAfterGap >= 0) {
+                totals.minLevelAfterGap = std::min(totals.minLevelAfterGap, report.nextLevel);
+            }
+            if (options.verbose && decision != SustainedDecision::HOLD) {
+                std::printf("  t=%7.1fс кадр %3d: %s -> уровень %d (окно %.2f / эталон %.2f Мп/с, T=%.1f)\n",
+                            nowMicros / 1e6,
+                            image,
+                            decision == SustainedDecision::THROTTLE ? "throttle" : "recover",
+                            report.nextLevel,
+                            report.windowMpps,
+                            report.baselineMpps,
+                            thermal.temperature);
+            }
+        }
+    }
+
+    totals.wallSeconds = nowMicros / 1e6;
+    const double tailSeconds = totals.wallSeconds - tailStart;
+    totals.tailMpps = tailSeconds > 0.0 ? (options.images - tailFrom) * options.megapixels / tailSeconds : 0.0;
+    totals.peakTemperature = thermal.peak;
+    totals.meanTemperature = thermal.seconds > 0.0 ? thermal.temperatureSeconds / thermal.seconds : 0.0;
+    totals.energyPerMegapixel = thermal.energy / (options.images * options.megapixels);
+    totals.levelAtEnd = controller.level();
+    return totals;
+}
+
+void printTotals(const char* name, const Totals& totals) {
+    std::printf("%-10s time_s=%7.1f compute_s=%7.1f tail_mpps=%.2f peak_t=%.1f mean_t=%.1f energy_per_mp=%.3f\n",
+                name,
+                totals.wallSeconds,
+                totals.computeSeconds,
+                totals.tailMpps,
+                totals.peakTemperature,
+                totals.meanTemperature,
+                totals.energyPerMegapixel);
+}
+
+void usage() {
+    std::fprintf(stderr,
+        "Использование: kotopogoda_sustained_sim [--images=N] [--megapixels=MP] [--threads=N]\n"
+        "    [--cold-mpps=MPPS] [--idle-gap=SECONDS] [--thread-scaling=EXP] [--verbose=1] [--check=1]\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* eq = std::strchr(arg, '=');
+        if (std::strncmp(arg, "--", 2) != 0 || eq == nullptr) {
+            return false;
+        }
+        const std::string key(arg + 2, eq);
+        const char* value = eq + 1;
+        if (key == "images") {
+            options.images = std::atoi(value);
+        } else if (key == "megapixels") {
+            options.megapixels = std::atof(value);
+        } else if (key == "threads") {
+            options.threads = std::atoi(value);
+        } else if (key == "cold-mpps") {
+            options.coldMpps = std::atof(value);
+        } else if (key == "idle-gap") {
+            options.idleGapSeconds = std::atof(value);
+        } else if (key == "thread-scaling") {
+            options.threadScaling = std::atof(value);
+        } else if (key == "verbose") {
+            options.verbose = std::atoi(value) != 0;
+        } else if (key == "check") {
+            options.check = std::atoi(value) != 0;
+        } else {
+            return false;
+        }
+    }
+    return options.images > 1 && options.megapixels > 0.0 && options.threads > 0 && options.coldMpps > 0.0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    const Totals fixed = simulate(options, false);
+    if (options.verbose) {
+        std::printf("Решения контроллера:\n");
+    }
+    const Totals controlled = simulate(options, true);
+
+    std::printf("Очередь из %d кадров по %.1f Мп, простой %.0f с после кадра %d "
+                "(tail — последняя четверть, T — над окружающей средой):\n",
+                options.images, options.megapixels, options.idleGapSeconds, options.images / 2);
+    printTotals("fixed", fixed);
+    printTotals("sustained", controlled);
+    std::printf("Контроллер: отступлений %d, подъёмов %d, уровень в конце %d\n",
+                controlled.throttles,
+                controlled.recovers,
+                controlled.levelAtEnd);
+    if (controlled.levelAfterGap >= 0) {
+        std::printf("После простоя: уровень %d, наименьший до конца очереди %d\n",
+                    controlled.levelAfterGap,
+                    controlled.minLevelAfterGap);
+    }
+
+    if (!options.check) {
+        return 0;
+    }
+    bool ok = true;
+    if (fixed.peakTemperature > kThrottleAt && controlled.throttles == 0) {
+        std::fprintf(stderr, "FAIL: модель троттлит, а контроллер ни разу не отступил\n");
+        ok = false;
+    }
+    if (options.idleGapSeconds > 0.0 && controlled.levelAfterGap > 0 && controlled.minLevelAfterGap != 0) {
+        std::fprintf(stderr, "FAIL: после простоя контроллер не вернулся на уровень 0\n");
+        ok = false;
+    }
+    if (controlled.energyPerMegapixel > fixed.energyPerMegapixel) {
+        std::fprintf(stderr, "FAIL: под контроллером на мегапиксель ушло больше энергии\n");
+        ok = false;
+    }
+    if (controlled.tailMpps < fixed.tailMpps * kMinTailShare) {
+        std::fprintf(stderr, "FAIL: пропускная способность под контроллером ниже %.0f%% фиксированной\n",
+                     kMinTailShare * 100.0);
+        ok = false;
+    }
+    std::printf("%s\n", ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+#include "test_jpeg.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+#include <jpeglib.h>
+
+namespace kotopogoda {
+namespace test {
+
+TempFile::TempFile(const std::string& name) : path_(::testing::TempDir() + name) {}
+
+TempFile::~TempFile() {
+    ::unlink(path_.c_str());
+}
+
+bool writeTestJpeg(
+    const std::string& path,
+    const std::vector<uint8_t>& pixels,
+    int width,
+    int height,
+    int components,
+    int quality,
+    bool ycck,
+    const std::vector<uint8_t>& app1
+) {
+    if (static_cast<size_t>(width) * height * components != pixels.size()) {
+        return false;
+    }
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    jpeg_stdio_dest(&cinfo, file);
+    cinfo.image_width = static_cast<JDIMENSION>(width);
+    cinfo.image_height = static_cast<JDIMENSION>(height);
+    cinfo.input_components = components;
+    cinfo.in_color_space = components == 4 ? JCS_CMYK : JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    if (components == 4) {
+        jpeg_set_colorspace(&cinfo, ycck ? JCS_YCCK : JCS_CMYK);
+    }
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    cinfo.write_JFIF_header = app1.empty() ? cinfo.write_JFIF_header : FALSE;
+    jpeg_start_compress(&cinfo, TRUE);
+    if (!app1.empty()) {
+        jpeg_write_marker(&cinfo, JPEG_APP0 + 1, app1.data(), static_cast<unsigned int>(app1.size()));
+    }
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = const_cast<uint8_t*>(pixels.data()) +
+            static_cast<size_t>(cinfo.next_scanline) * width * components;
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    return std::fclose(file) == 0;
+}
+
+std::unique_ptr<HostBitmap> decodeTestJpeg(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return nullptr;
+    }
+    jpeg_decompress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, file);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+    auto bitmap = std::make_unique<HostBitmap>(
+        static_cast<int>(cinfo.output_width),
+        static_cast<int>(cinfo.output_height)
+    );
+    std::vector<uint8_t> row(static_cast<size_t>(cinfo.output_width) * 3);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        const int y = static_cast<int>(cinfo.output_scanline);
+        JSAMPROW scanline = row.data();
+        jpeg_read_scanlines(&cinfo, &scanline, 1);
+        for (int x = 0; x < static_cast<int>(cinfo.output_width); ++x) {
+            bitmap->at(x, y) = packRgba(row[x * 3], row[x * 3 + 1], row[x * 3 + 2]);
+        }
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    std::fclose(file);
+    return bitmap;
+}
+
+std::vector<uint8_t> readTestFile(const std::string& path) {
+    std::ifstream stream(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+std::vector<uint8_t> asymmetricRgb(int width, int height) {
+    std::vector<uint8_t> rgb(static_cast<size_t>(width) * height * 3);
+    uint32_t seed = 0x9E3779B9u;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            uint8_t* pixel = rgb.data() + (static_cast<size_t>(y) * width + x) * 3;
+            pixel[0] = static_cast<uint8_t>(40 + 200 * x / width);
+            pixel[1] = static_cast<uint8_t>((60 * (x + y) / (width + height)) + (seed >> 28));
+            pixel[2] = static_cast<uint8_t>(230 - 190 * y / height);
+        }
+    }
+    return rgb;
+}
+
+}
+}
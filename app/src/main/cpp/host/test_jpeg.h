@@ -0,0 +1,54 @@
+#ifndef TEST_JPEG_H
+#define TEST_JPEG_H
+
+#include "host_bitmap.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace kotopogoda {
+namespace test {
+
+// Путь во временном каталоге GoogleTest; файл удаляется в деструкторе.
+class TempFile {
+public:
+    explicit TempFile(const std::string& name);
+    ~TempFile();
+
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+// Пишет JPEG системной libjpeg из чередующихся 8-битных каналов: 3 — RGB,
+// 4 — CMYK (в файле YCCK, если ycck). app1 — полезная нагрузка APP1.
+bool writeTestJpeg(
+    const std::string& path,
+    const std::vector<uint8_t>& pixels,
+    int width,
+    int height,
+    int components,
+    int quality,
+    bool ycck = false,
+    const std::vector<uint8_t>& app1 = {}
+);
+
+// Декодирует JPEG в RGBA_8888 так же, как BitmapFactory: полный размер, RGB,
+// альфа 0xFF. nullptr — файл не декодируется.
+std::unique_ptr<HostBitmap> decodeTestJpeg(const std::string& path);
+
+std::vector<uint8_t> readTestFile(const std::string& path);
+
+// Детерминированный кадр с разными градиентами по каналам (R по x, B по y, G
+// по диагонали с шумом): перестановка каналов на нём всегда заметна.
+std::vector<uint8_t> asymmetricRgb(int width, int height);
+
+}
+}
+
+#endif
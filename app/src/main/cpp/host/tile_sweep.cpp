@@ -0,0 +1,485 @@
+#include "jpeg_decoder.h"
+#include "memory_tracker.h"
+#include "ncnn_engine.h"
+#include "tile_processor.h"
+#include "trace.h"
+#include <ncnn/cpu.h>
+#include <ncnn/mat.h>
+#include <ncnn/net.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Перебор конфигураций TileProcessor на папке JPEG: для каждой комбинации
+// tileSize x overlap x useReflectPadding x enableHannWindow сеть запускается
+// тайлами и сравнивается с запуском на кадре целиком. Печатает PSNR и
+// максимальное отклонение от эталона, швы (seamMaxDelta/seamMeanDelta), время
+// и пик памяти, затем Парето-оптимальные конфигурации по качеству, времени и
+// памяти.
+
+namespace {
+
+using namespace kotopogoda;
+
+struct Options {
+    std::string imagesDir;
+    std::string modelsDir;
+    std::string param = "zerodcepp_fp16.param";
+    std::string bin = "zerodcepp_fp16.bin";
+    std::string inputBlob = "input";
+    std::string outputBlob = "output";
+    std::string jsonPath;
+    std::string tracePath;
+    int maxSide = kZeroDceMaxSide;
+    int threads = 0;
+    std::vector<int> tileSizes = {256, 384, 512};
+    std::vector<int> overlaps = {16, 32, 64};
+    std::vector<int> reflect = {0, 1};
+    std::vector<int> hann = {0, 1};
+};
+
+struct Image {
+    std::string name;
+    ncnn::Mat input;
+    ncnn::Mat reference;
+    double referenceMs = 0.0;
+};
+
+struct SweepRow {
+    TileConfig config;
+    int tiles = 0;
+    double psnrMeanDb = 0.0;
+    double psnrMinDb = 0.0;
+    float maxAbsDiff = 0.0f;
+    float seamMaxDelta = 0.0f;
+    float seamMeanDelta = 0.0f;
+    double timeMs = 0.0;
+    long ncnnPeakKb = 0;
+    // -1 — ядро не даёт сбросить VmHWM (/proc/self/clear_refs), пик не измерен.
+    long rssPeakKb = -1;
+    bool failed = false;
+    bool pareto = false;
+};
+
+// PSNR бесконечен для совпадающих кадров; для сравнения и вывода он
+// ограничивается этим значением.
+constexpr double kPsnrCapDb = 99.0;
+
+void usage() {
+    std::fprintf(stderr,
+        "Использование: kotopogoda_tile_sweep --images=DIR [--models=DIR] [--param=FILE] [--bin=FILE]\n"
+        "    [--input-blob=NAME] [--output-blob=NAME] [--max-side=N] [--threads=N]\n"
+        "    [--tile-sizes=256,384,512] [--overlaps=16,32,64] [--reflect=0,1] [--hann=0,1]\n"
+        "    [--json=PATH] [--trace=PATH]\n");
+}
+
+bool parseList(const char* text, std::vector<int>& values) {
+    values.clear();
+    const char* cursor = text;
+    while (*cursor != '\0') {
+        char* end = nullptr;
+        const long value = std::strtol(cursor, &end, 10);
+        if (end == cursor || value < 0) {
+            return false;
+        }
+        values.push_back(static_cast<int>(value));
+        cursor = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0') {
+            return false;
+        }
+    }
+    return !values.empty();
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* eq = std::strchr(arg, '=');
+        if (std::strncmp(arg, "--", 2) != 0 || eq == nullptr) {
+            return false;
+        }
+        const std::string key(arg + 2, eq);
+        const char* value = eq + 1;
+        bool ok = true;
+        if (key == "images") {
+            options.imagesDir = value;
+        } else if (key == "models") {
+            options.modelsDir = value;
+        } else if (key == "param") {
+            options.param = value;
+        } else if (key == "bin") {
+            options.bin = value;
+        } else if (key == "input-blob") {
+            options.inputBlob = value;
+        } else if (key == "output-blob") {
+            options.outputBlob = value;
+        } else if (key == "json") {
+            options.jsonPath = value;
+        } else if (key == "trace") {
+            options.tracePath = value;
+        } else if (key == "max-side") {
+            options.maxSide = std::atoi(value);
+        } else if (key == "threads") {
+            options.threads = std::atoi(value);
+        } else if (key == "tile-sizes") {
+            ok = parseList(value, options.tileSizes);
+        } else if (key == "overlaps") {
+            ok = parseList(value, options.overlaps);
+        } else if (key == "reflect") {
+            ok = parseList(value, options.reflect);
+        } else if (key == "hann") {
+            ok = parseList(value, options.hann);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::fprintf(stderr, "Неверный аргумент: %s\n", arg);
+            return false;
+        }
+    }
+    return !options.imagesDir.empty();
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Сбрасывает VmHWM процесса до текущего RSS (Linux 4.0+). false — сброс
+// недоступен, и пик RSS конфигурации не измеряется.
+bool resetPeakRss() {
+    FILE* file = std::fopen("/proc/self/clear_refs", "we");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool ok = std::fputs("5", file) >= 0;
+    return std::fclose(file) == 0 && ok;
+}
+
+// Прогон сети на одном кадре или тайле с аллокаторами контекста.
+bool runNet(
+    const ncnn::Net& net,
+    const Options& options,
+    RunContext& context,
+    const ncnn::Mat& input,
+    ncnn::Mat& output,
+    int* errorCode
+) {
+    ncnn::Extractor ex = net.create_extractor();
+    ex.set_blob_allocator(context.blobAllocator());
+    ex.set_workspace_allocator(context.workspaceAllocator());
+    int ret = ex.input(options.inputBlob.c_str(), input);
+    if (ret == 0) {
+        ret = ex.extract(options.outputBlob.c_str(), output);
+    }
+    if (errorCode != nullptr) {
+        *errorCode = ret;
+    }
+    return ret == 0 && output.w == input.w && output.h == input.h && output.c == input.c;
+}
+
+void compare(const ncnn::Mat& a, const ncnn::Mat& b, double& psnrDb, float& maxAbsDiff) {
+    double squared = 0.0;
+    maxAbsDiff = 0.0f;
+    const size_t plane = static_cast<size_t>(a.w) * a.h;
+    for (int c = 0; c < a.c; ++c) {
+        const float* pa = a.channel(c);
+        const float* pb = b.channel(c);
+        for (size_t i = 0; i < plane; ++i) {
+            const float diff = std::fabs(pa[i] - pb[i]);
+            maxAbsDiff = std::max(maxAbsDiff, diff);
+            squared += static_cast<double>(diff) * diff;
+        }
+    }
+    const double mse = squared / (static_cast<double>(plane) * a.c);
+    psnrDb = mse > 0.0 ? std::min(kPsnrCapDb, 10.0 * std::log10(1.0 / mse)) : kPsnrCapDb;
+}
+
+bool hasJpegExtension(const std::string& name) {
+    const size_t dot = name.find_last_of('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    std::string ext = name.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char ch) { return std::tolower(ch); });
+    return ext == "jpg" || ext == "jpeg";
+}
+
+bool loadImage(const std::string& path, int maxSide, ncnn::Mat& image) {
+    JpegImageInfo info;
+    if (!readJpegInfo(path.c_str(), maxSide, info) || !decodeJpegPlanar(path.c_str(), info.scaleDenom, image)) {
+        return false;
+    }
+    const int longest = std::max(image.w, image.h);
+    if (maxSide > 0 && longest > maxSide) {
+        const float scale = static_cast<float>(maxSide) / static_cast<float>(longest);
+        ncnn::Mat resized;
+        ncnn::resize_bilinear(
+            image,
+            resized,
+            std::max(1, static_cast<int>(image.w * scale + 0.5f)),
+            std::max(1, static_cast<int>(image.h * scale + 0.5f))
+        );
+        image = resized;
+    }
+    return !image.empty();
+}
+
+SweepRow runConfig(const ncnn::Net& net, const Options& options, const TileConfig& config, std::vector<Image>& images) {
+    SweepRow row;
+    row.config = config;
+    row.psnrMinDb = kPsnrCapDb;
+    double psnrSum = 0.0;
+    double seamMeanSum = 0.0;
+    bool rssMeasured = true;
+
+    for (Image& image : images) {
+        std::atomic<bool> cancelFlag{false};
+        TelemetryData telemetry;
+        TileProcessStats stats;
+        ncnn::Mat output;
+        long rssPeakKb = -1;
+        bool ok;
+        {
+            RunContext context(cancelFlag, telemetry);
+            TileProcessor processor(config, cancelFlag);
+            auto processTile = [&](const ncnn::Mat& tileIn, ncnn::Mat& tileOut, ncnn::Net*, int* errorCode) {
+                return runNet(net, options, context, tileIn, tileOut, errorCode);
+            };
+            const bool rssReset = rssMeasured && resetPeakRss();
+            context.beginStage(PipelineStage::ZERODCE);
+            const auto start = std::chrono::steady_clock::now();
+            ok = processor.processTiled(image.input, output, nullptr, processTile, nullptr, &stats);
+            row.timeMs += elapsedMs(start);
+            MatCharge outputCharge(context.memory(), output);
+            context.endStage();
+            ProcessMemory process;
+            if (rssReset && readProcessMemory(process)) {
+                rssPeakKb = process.vmHwmKb;
+            }
+        }
+        if (!ok || output.w != image.reference.w || output.h != image.reference.h) {
+            row.failed = true;
+            return row;
+        }
+
+        double psnrDb = 0.0;
+        float maxAbsDiff = 0.0f;
+        compare(output, image.reference, psnrDb, maxAbsDiff);
+        psnrSum += psnrDb;
+        row.psnrMinDb = std::min(row.psnrMinDb, psnrDb);
+        row.maxAbsDiff = std::max(row.maxAbsDiff, maxAbsDiff);
+        row.seamMaxDelta = std::max(row.seamMaxDelta, stats.seamMaxDelta);
+        seamMeanSum += stats.seamMeanDelta;
+        row.tiles += stats.tileCount;
+        row.ncnnPeakKb = std::max(row.ncnnPeakKb, telemetry.memory.stagePeakKb[static_cast<int>(PipelineStage::ZERODCE)]);
+        rssMeasured = rssMeasured && rssPeakKb >= 0;
+        row.rssPeakKb = rssMeasured ? std::max(row.rssPeakKb, rssPeakKb) : -1;
+    }
+    row.psnrMeanDb = psnrSum / images.size();
+    row.seamMeanDelta = static_cast<float>(seamMeanSum / images.size());
+    return row;
+}
+
+long memoryKb(const SweepRow& row) {
+    return row.rssPeakKb >= 0 ? row.rssPeakKb : row.ncnnPeakKb;
+}
+
+// a не хуже b по качеству, времени и памяти и строго лучше хотя бы по одному.
+bool dominates(const SweepRow& a, const SweepRow& b) {
+    const bool noWorse = a.psnrMeanDb >= b.psnrMeanDb && a.timeMs <= b.timeMs && memoryKb(a) <= memoryKb(b);
+    const bool better = a.psnrMeanDb > b.psnrMeanDb || a.timeMs < b.timeMs || memoryKb(a) < memoryKb(b);
+    return noWorse && better;
+}
+
+void markPareto(std::vector<SweepRow>& rows) {
+    for (SweepRow& row : rows) {
+        row.pareto = !row.failed;
+        for (const SweepRow& other : rows) {
+            if (row.pareto && !other.failed && dominates(other, row)) {
+                row.pareto = false;
+            }
+        }
+    }
+}
+
+void printRow(const SweepRow& row) {
+    const TileConfig& config = row.config;
+    if (row.failed) {
+        std::printf("  tile=%4d overlap=%3d reflect=%d hann=%d  ошибка обработки\n",
+                    config.tileSize, config.overlap, config.useReflectPadding, config.enableHannWindow);
+        return;
+    }
+    std::printf("%s tile=%4d overlap=%3d reflect=%d hann=%d tiles=%5d psnr=%6.2f/%6.2f max_diff=%.4f "
+                "seam_max=%.4f seam_mean=%.5f time_ms=%9.1f ncnn_peak_kb=%8ld rss_peak_kb=%8ld\n",
+                row.pareto ? "*" : " ",
+                config.tileSize,
+                config.overlap,
+                config.useReflectPadding,
+                config.enableHannWindow,
+                row.tiles,
+                row.psnrMeanDb,
+                row.psnrMinDb,
+                row.maxAbsDiff,
+                row.seamMaxDelta,
+                row.seamMeanDelta,
+                row.timeMs,
+                row.ncnnPeakKb,
+                row.rssPeakKb);
+}
+
+bool writeJson(const std::string& path, const std::vector<SweepRow>& rows, const std::vector<Image>& images) {
+    FILE* file = std::fopen(path.c_str(), "we");
+    if (file == nullptr) {
+        return false;
+    }
+    double referenceMs = 0.0;
+    for (const Image& image : images) {
+        referenceMs += image.referenceMs;
+    }
+    std::fprintf(file, "{\n  \"images\": %zu,\n  \"reference_time_ms\": %.3f,\n  \"configs\": [\n",
+                 images.size(), referenceMs);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const SweepRow& row = rows[i];
+        std::fprintf(file,
+                     "    {\"tile_size\": %d, \"overlap\": %d, \"reflect_padding\": %s, \"hann_window\": %s, "
+                     "\"failed\": %s, \"pareto\": %s, \"tiles\": %d, \"psnr_mean_db\": %.4f, "
+                     "\"psnr_min_db\": %.4f, \"max_abs_diff\": %.6f, \"seam_max_delta\": %.6f, "
+                     "\"seam_mean_delta\": %.6f, \"time_ms\": %.3f, \"ncnn_peak_kb\": %ld, "
+                     "\"rss_peak_kb\": %ld}%s\n",
+                     row.config.tileSize,
+                     row.config.overlap,
+                     row.config.useReflectPadding ? "true" : "false",
+                     row.config.enableHannWindow ? "true" : "false",
+                     row.failed ? "true" : "false",
+                     row.pareto ? "true" : "false",
+                     row.tiles,
+                     row.psnrMeanDb,
+                     row.psnrMinDb,
+                     row.maxAbsDiff,
+                     row.seamMaxDelta,
+                     row.seamMeanDelta,
+                     row.timeMs,
+                     row.ncnnPeakKb,
+                     row.rssPeakKb,
+                     i + 1 < rows.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    return std::fclose(file) == 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    const char* modelsOverride = std::getenv("KOTOPOGODA_MODELS_DIR");
+    options.modelsDir = modelsOverride != nullptr ? modelsOverride : KOTOPOGODA_SWEEP_MODELS_DIR;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    if (!options.tracePath.empty()) {
+        setTracingEnabled(true);
+    }
+
+    ncnn::Net net;
+    net.opt.use_vulkan_compute = false;
+    net.opt.use_fp16_packed = false;
+    net.opt.use_fp16_storage = true;
+    net.opt.use_fp16_arithmetic = false;
+    net.opt.num_threads = options.threads > 0 ? options.threads : std::max(1, std::min(4, ncnn::get_big_cpu_count()));
+    const std::string paramPath = options.modelsDir + "/" + options.param;
+    const std::string binPath = options.modelsDir + "/" + options.bin;
+    if (net.load_param(paramPath.c_str()) != 0 || net.load_model(binPath.c_str()) != 0) {
+        std::fprintf(stderr, "Не удалось загрузить модель %s / %s\n", paramPath.c_str(), binPath.c_str());
+        return 1;
+    }
+
+    std::vector<std::string> names;
+    if (DIR* dir = opendir(options.imagesDir.c_str())) {
+        while (const dirent* entry = readdir(dir)) {
+            if (hasJpegExtension(entry->d_name)) {
+                names.emplace_back(entry->d_name);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(names.begin(), names.end());
+
+    std::vector<Image> images;
+    for (const std::string& name : names) {
+        Image image;
+        image.name = name;
+        if (!loadImage(options.imagesDir + "/" + name, options.maxSide, image.input)) {
+            std::fprintf(stderr, "Пропущено %s: не декодируется\n", name.c_str());
+            continue;
+        }
+        std::atomic<bool> cancelFlag{false};
+        TelemetryData telemetry;
+        RunContext context(cancelFlag, telemetry);
+        const auto start = std::chrono::steady_clock::now();
+        int ret = 0;
+        if (!runNet(net, options, context, image.input, image.reference, &ret)) {
+            std::fprintf(stderr, "Пропущено %s: эталонный прогон без тайлов не удался (ret=%d)\n", name.c_str(), ret);
+            continue;
+        }
+        image.referenceMs = elapsedMs(start);
+        std::printf("%s: %dx%d, эталон без тайлов %.1f мс\n", name.c_str(), image.input.w, image.input.h, image.referenceMs);
+        images.push_back(std::move(image));
+    }
+    if (images.empty()) {
+        std::fprintf(stderr, "В %s нет JPEG, пригодных для перебора\n", options.imagesDir.c_str());
+        return 1;
+    }
+
+    std::vector<SweepRow> rows;
+    for (int tileSize : options.tileSizes) {
+        for (int overlap : options.overlaps) {
+            // Шаг сетки tileSize - 2 * overlap должен быть положительным.
+            if (tileSize - 2 * overlap <= 0) {
+                continue;
+            }
+            for (int reflect : options.reflect) {
+                for (int hann : options.hann) {
+                    TileConfig config;
+                    config.tileSize = tileSize;
+                    config.overlap = overlap;
+                    config.useReflectPadding = reflect != 0;
+                    config.enableHannWindow = hann != 0;
+                    TraceScope trace("sweep_config", static_cast<int>(rows.size()));
+                    rows.push_back(runConfig(net, options, config, images));
+                }
+            }
+        }
+    }
+    markPareto(rows);
+
+    std::sort(rows.begin(), rows.end(), [](const SweepRow& a, const SweepRow& b) { return a.timeMs < b.timeMs; });
+    std::printf("\nКонфигурации (psnr — среднее/минимум по кадрам, дБ; * — Парето-оптимальные):\n");
+    for (const SweepRow& row : rows) {
+        printRow(row);
+    }
+    std::printf("\nПарето-фронт по качеству, времени и памяти:\n");
+    for (const SweepRow& row : rows) {
+        if (row.pareto) {
+            printRow(row);
+        }
+    }
+
+    if (!options.jsonPath.empty() && !writeJson(options.jsonPath, rows, images)) {
+        std::fprintf(stderr, "Не удалось записать %s\n", options.jsonPath.c_str());
+        return 1;
+    }
+    if (!options.tracePath.empty() && !writeChromeTrace(options.tracePath.c_str())) {
+        std::fprintf(stderr, "Не удалось записать трассу %s\n", options.tracePath.c_str());
+        return 1;
+    }
+    return 0;
+}
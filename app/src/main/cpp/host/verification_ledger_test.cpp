@@ -0,0 +1,324 @@
+#include "verification_ledger.h"
+#include "ncnn_engine.h"
+#include "sha256_verifier.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Журнал проверок доверяет записи, только пока совпадают подпись HMAC,
+// размер, mtime и inode файла и не истёк интервал перепроверки. Во всех
+// остальных случаях модель хешируется заново, и несовпадение дайджеста
+// уходит в reportIntegrityFailure как без журнала.
+
+namespace {
+
+using namespace kotopogoda;
+
+constexpr int64_t kInterval = 3600;
+constexpr const char* kSignaturePrefix = "hmac\t";
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const std::string& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+}
+
+struct stat statOf(const std::string& path) {
+    struct stat st {};
+    EXPECT_EQ(::stat(path.c_str(), &st), 0) << path;
+    return st;
+}
+
+// Возвращает файлу atime/mtime из before: содержимое меняется «незаметно» для stat.
+void restoreTimes(const std::string& path, const struct stat& before) {
+    const struct timespec times[2] = {before.st_atim, before.st_mtim};
+    ASSERT_EQ(::utimensat(AT_FDCWD, path.c_str(), times, 0), 0);
+}
+
+// Меняет байт в середине файла, сохраняя размер, mtime и inode.
+void corruptKeepingStat(const std::string& path) {
+    const struct stat before = statOf(path);
+    std::string content = readFile(path);
+    ASSERT_FALSE(content.empty());
+    content[content.size() / 2] = static_cast<char>(content[content.size() / 2] ^ 0x5A);
+    const int fd = ::open(path.c_str(), O_WRONLY);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(::pwrite(fd, content.data(), content.size(), 0), static_cast<ssize_t>(content.size()));
+    ::close(fd);
+    restoreTimes(path, before);
+    const struct stat after = statOf(path);
+    ASSERT_EQ(after.st_size, before.st_size);
+    ASSERT_EQ(after.st_ino, before.st_ino);
+}
+
+class TempDir {
+public:
+    explicit TempDir(const std::string& name) : path_(::testing::TempDir() + name + "_XXXXXX") {
+        if (::mkdtemp(&path_[0]) == nullptr) {
+            path_.clear();
+        }
+    }
+
+    ~TempDir() {
+        if (!path_.empty()) {
+            std::error_code error;
+            std::filesystem::remove_all(path_, error);
+        }
+    }
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+class LedgerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_FALSE(dir_.path().empty());
+        file_ = dir_.path() + "/model.bin";
+        writeFile(file_, std::string(4096, 'm'));
+        digest_ = Sha256Verifier::computeSha256(file_);
+        ASSERT_FALSE(digest_.empty());
+    }
+
+    // Записывает и сохраняет журнал с одной записью для file_.
+    void recordAndSave() {
+        VerificationLedger ledger(dir_.path(), key_, kInterval);
+        ledger.load();
+        ledger.record(file_, digest_);
+        ASSERT_TRUE(ledger.save());
+    }
+
+    bool verifiedWith(const std::vector<uint8_t>& key) const {
+        VerificationLedger ledger(dir_.path(), key, kInterval);
+        ledger.load();
+        return ledger.isVerified(file_, digest_);
+    }
+
+    std::string ledgerPath() const { return dir_.path() + "/" + VerificationLedger::kFileName; }
+
+    // Переписывает время проверки записи и заново подписывает журнал ключом key_:
+    // так журнал остаётся подлинным, меняется только возраст записи.
+    void resignWithVerifiedAt(int64_t verifiedAtSec) {
+        const std::string content = readFile(ledgerPath());
+        const size_t signaturePos = content.rfind(kSignaturePrefix);
+        ASSERT_NE(signaturePos, std::string::npos);
+        std::string payload = content.substr(0, signaturePos);
+        const size_t lastTab = payload.rfind('\t');
+        ASSERT_NE(lastTab, std::string::npos);
+        payload = payload.substr(0, lastTab + 1) + std::to_string(verifiedAtSec) + "\n";
+        HmacSha256 hmac(key_.data(), key_.size());
+        hmac.update(payload.data(), payload.size());
+        writeFile(ledgerPath(), payload + kSignaturePrefix + hmac.finalHex() + "\n");
+    }
+
+    TempDir dir_{"verification_ledger"};
+    std::string file_;
+    std::string digest_;
+    std::vector<uint8_t> key_ = std::vector<uint8_t>(32, 0x42);
+};
+
+TEST_F(LedgerTest, RecordedFileIsVerifiedAfterReload) {
+    recordAndSave();
+    EXPECT_TRUE(verifiedWith(key_));
+
+    VerificationLedger ledger(dir_.path(), key_, kInterval);
+    ledger.load();
+    EXPECT_FALSE(ledger.isVerified(file_, std::string(64, '0')));
+}
+
+TEST_F(LedgerTest, FlippedByteRejectsLedger) {
+    recordAndSave();
+    const std::string original = readFile(ledgerPath());
+    const size_t signaturePos = original.rfind(kSignaturePrefix);
+    ASSERT_NE(signaturePos, std::string::npos);
+
+    // Байт в записях и байт в подписи.
+    for (size_t offset : {original.find(file_) + 1, signaturePos + std::string(kSignaturePrefix).size() + 3}) {
+        std::string tampered = original;
+        tampered[offset] = static_cast<char>(tampered[offset] ^ 0x01);
+        writeFile(ledgerPath(), tampered);
+        EXPECT_FALSE(verifiedWith(key_)) << "смещение " << offset;
+    }
+}
+
+TEST_F(LedgerTest, WrongKeyRejectsLedger) {
+    recordAndSave();
+    EXPECT_FALSE(verifiedWith(std::vector<uint8_t>(32, 0x43)));
+    EXPECT_TRUE(verifiedWith(key_));
+}
+
+TEST_F(LedgerTest, SizeChangeForcesRehash) {
+    recordAndSave();
+    const struct stat before = statOf(file_);
+    writeFile(file_, readFile(file_) + "x");
+    restoreTimes(file_, before);
+    EXPECT_FALSE(verifiedWith(key_));
+}
+
+TEST_F(LedgerTest, MtimeChangeForcesRehash) {
+    recordAndSave();
+    struct stat shifted = statOf(file_);
+    shifted.st_mtim.tv_sec += 1;
+    restoreTimes(file_, shifted);
+    EXPECT_FALSE(verifiedWith(key_));
+}
+
+TEST_F(LedgerTest, InodeChangeForcesRehash) {
+    recordAndSave();
+    const struct stat before = statOf(file_);
+    // Тот же размер и mtime, но файл подменён через rename.
+    const std::string replacement = file_ + ".new";
+    writeFile(replacement, readFile(file_));
+    restoreTimes(replacement, before);
+    ASSERT_EQ(std::rename(replacement.c_str(), file_.c_str()), 0);
+    const struct stat after = statOf(file_);
+    ASSERT_EQ(after.st_size, before.st_size);
+    ASSERT_EQ(after.st_mtim.tv_sec, before.st_mtim.tv_sec);
+    ASSERT_EQ(after.st_mtim.tv_nsec, before.st_mtim.tv_nsec);
+    ASSERT_NE(after.st_ino, before.st_ino);
+    EXPECT_FALSE(verifiedWith(key_));
+}
+
+TEST_F(LedgerTest, ExpiredIntervalForcesRehash) {
+    recordAndSave();
+    const int64_t now = static_cast<int64_t>(::time(nullptr));
+
+    resignWithVerifiedAt(now - 10);
+    EXPECT_TRUE(verifiedWith(key_));
+
+    resignWithVerifiedAt(now - kInterval - 1);
+    EXPECT_FALSE(verifiedWith(key_));
+
+    // Время проверки из будущего (переведённые часы) тоже не доверяется.
+    resignWithVerifiedAt(now + kInterval);
+    EXPECT_FALSE(verifiedWith(key_));
+}
+
+// Тот же журнал внутри NcnnEngine::initialize на копии моделей: подмена
+// весов с сохранением stat проходит только при доверенном журнале.
+class LedgerEngineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const char* override = std::getenv("KOTOPOGODA_MODELS_DIR");
+        const std::string source = override != nullptr ? override : KOTOPOGODA_TEST_MODELS_DIR;
+        const std::string param = readFile(source + "/zerodcepp_fp16.param");
+        const std::string bin = readFile(source + "/zerodcepp_fp16.bin");
+        if (param.empty() || bin.empty()) {
+            GTEST_SKIP() << "модель Zero-DCE++ не найдена (KOTOPOGODA_MODELS_DIR)";
+        }
+        ASSERT_FALSE(dir_.path().empty());
+        param_ = dir_.path() + "/zerodcepp_fp16.param";
+        bin_ = dir_.path() + "/zerodcepp_fp16.bin";
+        writeFile(param_, param);
+        writeFile(bin_, bin);
+        checksums_.param = Sha256Verifier::computeSha256(param_);
+        checksums_.bin = Sha256Verifier::computeSha256(bin_);
+        NcnnEngine::consumeLastIntegrityFailure();
+    }
+
+    bool initialize(const std::vector<uint8_t>& key, const NcnnEngine::ModelChecksums& checksums) {
+        VerificationPolicy policy;
+        policy.ledgerKey = key;
+        policy.reverifyIntervalSec = kInterval;
+        NcnnEngine engine;
+        const bool ok = engine.initialize(nullptr, dir_.path(), checksums, {}, PreviewProfile::BALANCED, true, policy);
+        engine.release();
+        return ok;
+    }
+
+    // Первый запуск хеширует модели и записывает журнал.
+    void primeLedger() {
+        ASSERT_TRUE(initialize(key_, checksums_));
+        ASSERT_FALSE(NcnnEngine::consumeLastIntegrityFailure().hasFailure);
+    }
+
+    void expectBinFailure() {
+        const NcnnEngine::IntegrityFailure failure = NcnnEngine::consumeLastIntegrityFailure();
+        EXPECT_TRUE(failure.hasFailure);
+        EXPECT_EQ(failure.filePath, bin_);
+        EXPECT_EQ(failure.expectedChecksum, checksums_.bin);
+        EXPECT_FALSE(failure.actualChecksum.empty());
+        EXPECT_NE(failure.actualChecksum, checksums_.bin);
+    }
+
+    TempDir dir_{"ledger_engine"};
+    std::string param_;
+    std::string bin_;
+    NcnnEngine::ModelChecksums checksums_;
+    std::vector<uint8_t> key_ = std::vector<uint8_t>(32, 0x17);
+};
+
+TEST_F(LedgerEngineTest, TrustedLedgerSkipsRehash) {
+    primeLedger();
+    corruptKeepingStat(bin_);
+    // Журнал подлинный, stat не изменился: веса не перечитываются для хеша.
+    EXPECT_TRUE(initialize(key_, checksums_));
+    EXPECT_FALSE(NcnnEngine::consumeLastIntegrityFailure().hasFailure);
+}
+
+TEST_F(LedgerEngineTest, FlippedLedgerByteForcesRehash) {
+    primeLedger();
+    corruptKeepingStat(bin_);
+    const std::string ledgerPath = dir_.path() + "/" + VerificationLedger::kFileName;
+    std::string ledger = readFile(ledgerPath);
+    ASSERT_FALSE(ledger.empty());
+    ledger[ledger.size() / 2] = static_cast<char>(ledger[ledger.size() / 2] ^ 0x01);
+    writeFile(ledgerPath, ledger);
+
+    EXPECT_FALSE(initialize(key_, checksums_));
+    expectBinFailure();
+}
+
+TEST_F(LedgerEngineTest, WrongKeyForcesRehash) {
+    primeLedger();
+    corruptKeepingStat(bin_);
+    EXPECT_FALSE(initialize(std::vector<uint8_t>(32, 0x18), checksums_));
+    expectBinFailure();
+}
+
+TEST_F(LedgerEngineTest, ChangedMtimeForcesRehash) {
+    primeLedger();
+    corruptKeepingStat(bin_);
+    struct stat shifted = statOf(bin_);
+    shifted.st_mtim.tv_sec += 1;
+    restoreTimes(bin_, shifted);
+    EXPECT_FALSE(initialize(key_, checksums_));
+    expectBinFailure();
+}
+
+TEST_F(LedgerEngineTest, DigestMismatchIsReportedAndForgotten) {
+    primeLedger();
+    // Ожидаемый дайджест сменился (новая версия модели): журнал не подходит,
+    // веса хешируются, несовпадение сообщается.
+    NcnnEngine::ModelChecksums updated = checksums_;
+    updated.bin = std::string(64, 'a');
+    EXPECT_FALSE(initialize(key_, updated));
+    const NcnnEngine::IntegrityFailure failure = NcnnEngine::consumeLastIntegrityFailure();
+    EXPECT_TRUE(failure.hasFailure);
+    EXPECT_EQ(failure.filePath, bin_);
+    EXPECT_EQ(failure.expectedChecksum, updated.bin);
+    EXPECT_EQ(failure.actualChecksum, checksums_.bin);
+
+    // Запись о весах удалена: подменённые веса больше не проходят по журналу.
+    corruptKeepingStat(bin_);
+    EXPECT_FALSE(initialize(key_, checksums_));
+    expectBinFailure();
+}
+
+}
@@ -0,0 +1,291 @@
+#include "image_stats.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace kotopogoda {
+
+namespace {
+
+// Яркость Rec. 709 в целых весах: w = 2126 r + 7152 g + 722 b, максимум
+// kWeightScale = 10000 * 255. Так среднее и доля тёмных пикселей точные.
+constexpr uint32_t kWeightR = 2126;
+constexpr uint32_t kWeightG = 7152;
+constexpr uint32_t kWeightB = 722;
+constexpr uint32_t kWeightScale = 10000u * 255u;
+constexpr float kInvWeightScale = 1.0f / static_cast<float>(kWeightScale);
+// Порог тёмного пикселя MetricsCalculator (яркость < 0.22) в весах.
+constexpr uint32_t kDarkWeight = 561000;
+// Высокая насыщенность: S >= 0.9, то есть 10 (max - min) >= 9 max.
+constexpr uint32_t kHighSaturationNum = 9;
+constexpr uint32_t kHighSaturationDen = 10;
+
+// Нормировка шума, как в MetricsCalculator.
+constexpr double kNoiseLumaEpsilon = 1e-3;
+constexpr double kNoiseRelativeFloor = 0.04;
+constexpr double kNoiseRelativeCeil = 0.32;
+
+// Пиксель с весом ровно kDarkWeight: MetricsCalculator сравнивает с 0.22
+// яркость в double, и от её округления зависит, тёмный ли он. Выражение
+// повторяет Kotlin по шагам; volatile не даёт -ffast-math переставить
+// операции или слить их в FMA.
+bool darkAtThreshold(uint32_t r, uint32_t g, uint32_t b) {
+    volatile double scale = 255.0;
+    volatile double red = 0.2126 * (static_cast<double>(r) / scale);
+    volatile double green = 0.7152 * (static_cast<double>(g) / scale);
+    volatile double blue = 0.0722 * (static_cast<double>(b) / scale);
+    volatile double sum = red + green;
+    sum = sum + blue;
+    return sum < 0.22;
+}
+
+// 8-битный уровень яркости с округлением.
+inline int lumaLevel(uint32_t weight) {
+    return static_cast<int>((weight + 5000u) / 10000u);
+}
+
+float percentile(const uint32_t* levels, int64_t total, double fraction) {
+    const int64_t rank = std::max<int64_t>(1, static_cast<int64_t>(std::ceil(fraction * static_cast<double>(total))));
+    int64_t seen = 0;
+    for (int level = 0; level < 256; ++level) {
+        seen += levels[level];
+        if (seen >= rank) {
+            return static_cast<float>(level) / 255.0f;
+        }
+    }
+    return 1.0f;
+}
+
+}
+
+ImageStatsAccumulator::ImageStatsAccumulator(int width, int height)
+    : width_(std::max(0, width)),
+      height_(std::max(0, height)),
+      luma_(static_cast<size_t>(width_) * 3) {}
+
+void ImageStatsAccumulator::addRow(const uint8_t* rgb) {
+    if (rows_ >= height_ || width_ == 0) {
+        return;
+    }
+    float* luma = luma_.data() + static_cast<size_t>(rows_ % 3) * width_;
+    int x = 0;
+
+#if defined(__ARM_NEON)
+    // По 8 пикселей: веса яркости, счётчики и насыщенность в лейнах;
+    // гистограмма — скалярно по сохранённым весам. Счётчики uint16 сбрасываются
+    // каждую строку, поэтому не переполняются при ширине до 512K.
+    uint32x4_t darkAcc = vdupq_n_u32(0);
+    uint16x8_t shadowAcc = vdupq_n_u16(0);
+    uint16x8_t highlightAcc = vdupq_n_u16(0);
+    uint16x8_t saturatedAcc = vdupq_n_u16(0);
+    float32x4_t saturationAcc = vdupq_n_f32(0.0f);
+    const uint32x4_t darkWeight = vdupq_n_u32(kDarkWeight);
+    const uint8x8_t zero = vdup_n_u8(0);
+    const uint8x8_t full = vdup_n_u8(255);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    uint32_t weights[8];
+    for (; x + 8 <= width_; x += 8) {
+        const uint8x8x3_t px = vld3_u8(rgb + x * 3);
+        const uint16x8_t r = vmovl_u8(px.val[0]);
+        const uint16x8_t g = vmovl_u8(px.val[1]);
+        const uint16x8_t b = vmovl_u8(px.val[2]);
+        uint32x4_t weightLow = vmull_n_u16(vget_low_u16(r), kWeightR);
+        weightLow = vmlal_n_u16(weightLow, vget_low_u16(g), kWeightG);
+        weightLow = vmlal_n_u16(weightLow, vget_low_u16(b), kWeightB);
+        uint32x4_t weightHigh = vmull_n_u16(vget_high_u16(r), kWeightR);
+        weightHigh = vmlal_n_u16(weightHigh, vget_high_u16(g), kWeightG);
+        weightHigh = vmlal_n_u16(weightHigh, vget_high_u16(b), kWeightB);
+        vst1q_u32(weights, weightLow);
+        vst1q_u32(weights + 4, weightHigh);
+        vst1q_f32(luma + x, vmulq_n_f32(vcvtq_f32_u32(weightLow), kInvWeightScale));
+        vst1q_f32(luma + x + 4, vmulq_n_f32(vcvtq_f32_u32(weightHigh), kInvWeightScale));
+        // Маска сравнения — все единицы, то есть -1: вычитание прибавляет 1.
+        darkAcc = vsubq_u32(darkAcc, vcltq_u32(weightLow, darkWeight));
+        darkAcc = vsubq_u32(darkAcc, vcltq_u32(weightHigh, darkWeight));
+
+        const uint8x8_t maxc = vmax_u8(vmax_u8(px.val[0], px.val[1]), px.val[2]);
+        const uint8x8_t minc = vmin_u8(vmin_u8(px.val[0], px.val[1]), px.val[2]);
+        shadowAcc = vaddw_u8(shadowAcc, vshr_n_u8(vceq_u8(minc, zero), 7));
+        highlightAcc = vaddw_u8(highlightAcc, vshr_n_u8(vceq_u8(maxc, full), 7));
+
+        const uint16x8_t spread = vsubl_u8(maxc, minc);
+        const uint16x8_t peak = vmovl_u8(maxc);
+        const uint16x8_t saturated = vandq_u16(
+            vcgeq_u16(vmulq_n_u16(spread, kHighSaturationDen), vmulq_n_u16(peak, kHighSaturationNum)),
+            vtstq_u16(peak, peak)
+        );
+        saturatedAcc = vaddq_u16(saturatedAcc, vshrq_n_u16(saturated, 15));
+        // При max = 0 и разброс 0, поэтому деление на max(peak, 1) даёт S = 0.
+        const float32x4_t spreadLow = vcvtq_f32_u32(vmovl_u16(vget_low_u16(spread)));
+        const float32x4_t spreadHigh = vcvtq_f32_u32(vmovl_u16(vget_high_u16(spread)));
+        const float32x4_t peakLow = vmaxq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(peak))), one);
+        const float32x4_t peakHigh = vmaxq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(peak))), one);
+        saturationAcc = vaddq_f32(saturationAcc, vdivq_f32(spreadLow, peakLow));
+        saturationAcc = vaddq_f32(saturationAcc, vdivq_f32(spreadHigh, peakHigh));
+
+        for (int i = 0; i < 8; ++i) {
+            ++levels_[lumaLevel(weights[i])];
+            weightedLumaSum_ += weights[i];
+            if (weights[i] == kDarkWeight) {
+                const uint8_t* pixel = rgb + (x + i) * 3;
+                dark_ += darkAtThreshold(pixel[0], pixel[1], pixel[2]) ? 1 : 0;
+            }
+        }
+    }
+    dark_ += vaddvq_u32(darkAcc);
+    clippedShadows_ += vaddlvq_u16(shadowAcc);
+    clippedHighlights_ += vaddlvq_u16(highlightAcc);
+    saturated_ += vaddlvq_u16(saturatedAcc);
+    saturationSum_ += vaddvq_f32(saturationAcc);
+#endif
+
+    float saturationRow = 0.0f;
+    for (; x < width_; ++x) {
+        const uint32_t r = rgb[x * 3];
+        const uint32_t g = rgb[x * 3 + 1];
+        const uint32_t b = rgb[x * 3 + 2];
+        const uint32_t weight = kWeightR * r + kWeightG * g + kWeightB * b;
+        luma[x] = static_cast<float>(weight) * kInvWeightScale;
+        ++levels_[lumaLevel(weight)];
+        weightedLumaSum_ += weight;
+        dark_ += weight < kDarkWeight || (weight == kDarkWeight && darkAtThreshold(r, g, b)) ? 1 : 0;
+
+        const uint32_t maxc = std::max(r, std::max(g, b));
+        const uint32_t minc = std::min(r, std::min(g, b));
+        clippedShadows_ += minc == 0 ? 1 : 0;
+        clippedHighlights_ += maxc == 255 ? 1 : 0;
+        const uint32_t spread = maxc - minc;
+        saturated_ += maxc > 0 && spread * kHighSaturationDen >= maxc * kHighSaturationNum ? 1 : 0;
+        saturationRow += static_cast<float>(spread) / static_cast<float>(std::max<uint32_t>(maxc, 1));
+    }
+    saturationSum_ += saturationRow;
+
+    ++rows_;
+    // Соседи строки y известны, когда пришла строка y + 1.
+    if (rows_ >= 2) {
+        const int center = rows_ - 2;
+        const float* above = luma_.data() + static_cast<size_t>((center > 0 ? center - 1 : center) % 3) * width_;
+        const float* middle = luma_.data() + static_cast<size_t>(center % 3) * width_;
+        addNeighbourhood(above, middle, luma);
+    }
+}
+
+// Лапласиан и остаток после гауссова 1-2-1 x 1-2-1 / 16 для строки center;
+// за краем повторяется крайний пиксель, как в laplacianAt/gaussianBlurAt.
+void ImageStatsAccumulator::addNeighbourhood(const float* above, const float* center, const float* below) {
+    const int last = width_ - 1;
+    float laplacianSum = 0.0f;
+    float laplacianSqSum = 0.0f;
+    float noiseSqSum = 0.0f;
+    auto addPixel = [&](int x) {
+        const int left = std::max(x - 1, 0);
+        const int right = std::min(x + 1, last);
+        const float c = center[x];
+        const float laplacian = center[left] + center[right] + above[x] + below[x] - 4.0f * c;
+        const float blurred = (above[left] + 2.0f * above[x] + above[right] +
+                               2.0f * (center[left] + 2.0f * c + center[right]) +
+                               below[left] + 2.0f * below[x] + below[right]) * (1.0f / 16.0f);
+        const float residual = c - blurred;
+        laplacianSum += laplacian;
+        laplacianSqSum += laplacian * laplacian;
+        noiseSqSum += residual * residual;
+    };
+
+    addPixel(0);
+    int x = 1;
+#if defined(__ARM_NEON)
+    float32x4_t lapAcc = vdupq_n_f32(0.0f);
+    float32x4_t lapSqAcc = vdupq_n_f32(0.0f);
+    float32x4_t noiseAcc = vdupq_n_f32(0.0f);
+    const float32x4_t two = vdupq_n_f32(2.0f);
+    for (; x + 4 <= last; x += 4) {
+        const float32x4_t aL = vld1q_f32(above + x - 1);
+        const float32x4_t aC = vld1q_f32(above + x);
+        const float32x4_t aR = vld1q_f32(above + x + 1);
+        const float32x4_t cL = vld1q_f32(center + x - 1);
+        const float32x4_t cC = vld1q_f32(center + x);
+        const float32x4_t cR = vld1q_f32(center + x + 1);
+        const float32x4_t bL = vld1q_f32(below + x - 1);
+        const float32x4_t bC = vld1q_f32(below + x);
+        const float32x4_t bR = vld1q_f32(below + x + 1);
+
+        const float32x4_t laplacian = vmlsq_n_f32(vaddq_f32(vaddq_f32(cL, cR), vaddq_f32(aC, bC)), cC, 4.0f);
+        const float32x4_t rowAbove = vmlaq_f32(vaddq_f32(aL, aR), aC, two);
+        const float32x4_t rowCenter = vmlaq_f32(vaddq_f32(cL, cR), cC, two);
+        const float32x4_t rowBelow = vmlaq_f32(vaddq_f32(bL, bR), bC, two);
+        const float32x4_t blurred = vmulq_n_f32(
+            vmlaq_f32(vaddq_f32(rowAbove, rowBelow), rowCenter, two),
+            1.0f / 16.0f
+        );
+        const float32x4_t residual = vsubq_f32(cC, blurred);
+        lapAcc = vaddq_f32(lapAcc, laplacian);
+        lapSqAcc = vmlaq_f32(lapSqAcc, laplacian, laplacian);
+        noiseAcc = vmlaq_f32(noiseAcc, residual, residual);
+    }
+    laplacianSum += vaddvq_f32(lapAcc);
+    laplacianSqSum += vaddvq_f32(lapSqAcc);
+    noiseSqSum += vaddvq_f32(noiseAcc);
+#endif
+    for (; x <= last; ++x) {
+        addPixel(x);
+    }
+
+    laplacianSum_ += laplacianSum;
+    laplacianSqSum_ += laplacianSqSum;
+    noiseSqSum_ += noiseSqSum;
+}
+
+bool ImageStatsAccumulator::finish(ImageStats& stats) {
+    if (rows_ < height_ || height_ == 0 || width_ == 0) {
+        return false;
+    }
+    // Последняя строка: снизу за краем — она сама.
+    const int center = height_ - 1;
+    const float* above = luma_.data() + static_cast<size_t>((center > 0 ? center - 1 : center) % 3) * width_;
+    const float* middle = luma_.data() + static_cast<size_t>(center % 3) * width_;
+    addNeighbourhood(above, middle, middle);
+
+    const int64_t total = static_cast<int64_t>(width_) * height_;
+    const double norm = static_cast<double>(total);
+    const double lumaMean = static_cast<double>(weightedLumaSum_) / (static_cast<double>(kWeightScale) * norm);
+    const double laplacianMean = laplacianSum_ / norm;
+    const double laplacianEnergy = laplacianSqSum_ / norm;
+    const double laplacianVariance = laplacianEnergy - laplacianMean * laplacianMean;
+    const double sharpness = laplacianEnergy <= 1e-12
+        ? 0.0
+        : std::max(0.0, std::min(1.0, laplacianVariance / laplacianEnergy));
+    const double noiseRelative = std::sqrt(noiseSqSum_ / norm) / std::max(lumaMean, kNoiseLumaEpsilon);
+    double noise;
+    if (noiseRelative <= kNoiseRelativeFloor) {
+        noise = 0.0;
+    } else if (noiseRelative >= kNoiseRelativeCeil) {
+        noise = 1.0;
+    } else {
+        noise = (noiseRelative - kNoiseRelativeFloor) / (kNoiseRelativeCeil - kNoiseRelativeFloor);
+    }
+
+    stats = ImageStats();
+    stats.valid = true;
+    stats.pixels = total;
+    stats.lumaMean = static_cast<float>(lumaMean);
+    stats.darkShare = static_cast<float>(static_cast<double>(dark_) / norm);
+    stats.sharpness = static_cast<float>(sharpness);
+    stats.noise = static_cast<float>(noise);
+    stats.lumaP05 = percentile(levels_, total, 0.05);
+    stats.lumaP50 = percentile(levels_, total, 0.50);
+    stats.lumaP95 = percentile(levels_, total, 0.95);
+    stats.clippedShadowShare = static_cast<float>(static_cast<double>(clippedShadows_) / norm);
+    stats.clippedHighlightShare = static_cast<float>(static_cast<double>(clippedHighlights_) / norm);
+    stats.saturationMean = static_cast<float>(saturationSum_ / norm);
+    stats.saturatedShare = static_cast<float>(static_cast<double>(saturated_) / norm);
+    constexpr int kLevelsPerBin = 256 / kImageStatsBins;
+    for (int level = 0; level < 256; ++level) {
+        stats.histogram[level / kLevelsPerBin] += levels_[level];
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,72 @@
+#ifndef IMAGE_STATS_H
+#define IMAGE_STATS_H
+
+#include <cstdint>
+#include <vector>
+
+namespace kotopogoda {
+
+// Корзин гистограммы яркости в телеметрии: по 4 уровня 8-битной яркости.
+constexpr int kImageStatsBins = 64;
+
+// Статистика 8-битного результата. lumaMean, darkShare, sharpness и noise
+// считаются так же, как EnhanceEngine.MetricsCalculator (яркость Rec. 709,
+// лапласиан и остаток после гауссова 3x3 с повтором краевых пикселей), и
+// заменяют его для результата. Перцентили яркости — по ближайшему рангу в
+// [0, 1]; клиппинг — доля пикселей, у которых хотя бы один канал равен 0
+// (тени) или 255 (света); насыщенность — S из HSV.
+struct ImageStats {
+    bool valid = false;
+    int64_t pixels = 0;
+    float lumaMean = 0.0f;
+    float darkShare = 0.0f;
+    float sharpness = 0.0f;
+    float noise = 0.0f;
+    float lumaP05 = 0.0f;
+    float lumaP50 = 0.0f;
+    float lumaP95 = 0.0f;
+    float clippedShadowShare = 0.0f;
+    float clippedHighlightShare = 0.0f;
+    float saturationMean = 0.0f;
+    // Доля пикселей с S не ниже kHighSaturation.
+    float saturatedShare = 0.0f;
+    uint32_t histogram[kImageStatsBins] = {};
+};
+
+// Накапливает ImageStats по строкам сверху вниз попутно с квантованием в 8 бит
+// (matToBitmap, JpegBandEncoder), не держа изображение: для лапласиана и
+// размытия хранятся три строки яркости. Строка — RGB по 3 байта на пиксель.
+class ImageStatsAccumulator {
+public:
+    ImageStatsAccumulator(int width, int height);
+
+    ImageStatsAccumulator(const ImageStatsAccumulator&) = delete;
+    ImageStatsAccumulator& operator=(const ImageStatsAccumulator&) = delete;
+
+    void addRow(const uint8_t* rgb);
+    // false — строк меньше height (запуск прерван), stats не трогается.
+    bool finish(ImageStats& stats);
+
+private:
+    void addNeighbourhood(const float* above, const float* center, const float* below);
+
+    int width_;
+    int height_;
+    int rows_ = 0;
+    // Кольцо из трёх строк яркости в [0, 1].
+    std::vector<float> luma_;
+    uint32_t levels_[256] = {};
+    uint64_t weightedLumaSum_ = 0;
+    int64_t dark_ = 0;
+    int64_t clippedShadows_ = 0;
+    int64_t clippedHighlights_ = 0;
+    int64_t saturated_ = 0;
+    double saturationSum_ = 0.0;
+    double laplacianSum_ = 0.0;
+    double laplacianSqSum_ = 0.0;
+    double noiseSqSum_ = 0.0;
+};
+
+}
+
+#endif
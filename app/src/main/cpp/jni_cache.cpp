@@ -0,0 +1,172 @@
+#include "jni_cache.h"
+#include "ncnn_engine.h"
+#include <android/log.h>
+#include <cstring>
+
+#define LOG_TAG "JniCache"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace kotopogoda {
+
+namespace {
+
+JniCache g_cache;
+
+jclass findGlobalClass(JNIEnv* env, const char* name) {
+    jclass local = env->FindClass(name);
+    if (local == nullptr) {
+        env->ExceptionClear();
+        LOGE("Класс %s не найден", name);
+        return nullptr;
+    }
+    auto global = static_cast<jclass>(env->NewGlobalRef(local));
+    env->DeleteLocalRef(local);
+    return global;
+}
+
+jmethodID findMethod(JNIEnv* env, const char* className, const char* method, const char* signature) {
+    jclass clazz = env->FindClass(className);
+    if (clazz == nullptr) {
+        env->ExceptionClear();
+        LOGE("Класс %s не найден", className);
+        return nullptr;
+    }
+    jmethodID id = env->GetMethodID(clazz, method, signature);
+    env->DeleteLocalRef(clazz);
+    if (id == nullptr) {
+        env->ExceptionClear();
+        LOGE("Метод %s.%s%s не найден", className, method, signature);
+    }
+    return id;
+}
+
+jstring newGlobalString(JNIEnv* env, const char* value) {
+    jstring local = env->NewStringUTF(value);
+    if (local == nullptr) {
+        env->ExceptionClear();
+        return nullptr;
+    }
+    auto global = static_cast<jstring>(env->NewGlobalRef(local));
+    env->DeleteLocalRef(local);
+    return global;
+}
+
+bool populate(JNIEnv* env, JniCache& cache) {
+    cache.objectClass = findGlobalClass(env, "java/lang/Object");
+    cache.stringClass = findGlobalClass(env, "java/lang/String");
+
+    cache.onTileProgress = findMethod(
+        env,
+        "com/kotopogoda/uploader/feature/viewer/enhance/NativeTileProgressCallback",
+        "onTileProgress",
+        "(Ljava/lang/String;II)V"
+    );
+    cache.onJobFinished = findMethod(
+        env,
+        "com/kotopogoda/uploader/feature/viewer/enhance/NativeJobCompletion",
+        "onJobFinished",
+        "(JI)V"
+    );
+    cache.batchDecode = findMethod(
+        env,
+        "com/kotopogoda/uploader/feature/viewer/enhance/NativeBatchCodec",
+        "decode",
+        "(Ljava/lang/String;)Landroid/graphics/Bitmap;"
+    );
+    cache.batchEncode = findMethod(
+        env,
+        "com/kotopogoda/uploader/feature/viewer/enhance/NativeBatchCodec",
+        "encode",
+        "(Landroid/graphics/Bitmap;Ljava/lang/String;Ljava/lang/String;)Z"
+    );
+    cache.onBatchItemFinished = findMethod(
+        env,
+        "com/kotopogoda/uploader/feature/viewer/enhance/NativeBatchListener",
+        "onItemFinished",
+        "(II)V"
+    );
+    cache.onPreviewLevelReady = findMethod(
+        env,
+        "com/kotopogoda/uploader/feature/viewer/enhance/NativePreviewLevelListener",
+        "onLevelReady",
+        "(I)V"
+    );
+    cache.onHashProgress = findMethod(
+        env,
+        "com/kotopogoda/uploader/core/data/util/NativeHashing$ProgressListener",
+        "onProgress",
+        "(JJ)Z"
+    );
+    cache.onBatchHashProgress = findMethod(
+        env,
+        "com/kotopogoda/uploader/core/data/util/NativeHashing$BatchProgressListener",
+        "onProgress",
+        "(IJJ)Z"
+    );
+
+    cache.stageZerodcePreview = newGlobalString(env, kStageZerodcePreview);
+    cache.stageZerodceFull = newGlobalString(env, kStageZerodceFull);
+
+    return cache.objectClass != nullptr &&
+           cache.stringClass != nullptr &&
+           cache.onTileProgress != nullptr &&
+           cache.onJobFinished != nullptr &&
+           cache.batchDecode != nullptr &&
+           cache.batchEncode != nullptr &&
+           cache.onBatchItemFinished != nullptr &&
+           cache.onPreviewLevelReady != nullptr &&
+           cache.onHashProgress != nullptr &&
+           cache.onBatchHashProgress != nullptr &&
+           cache.stageZerodcePreview != nullptr &&
+           cache.stageZerodceFull != nullptr;
+}
+
+}
+
+const JniCache& jniCache() {
+    return g_cache;
+}
+
+JNIEnv* currentJniEnv() {
+    JNIEnv* env = nullptr;
+    if (g_cache.vm == nullptr ||
+        g_cache.vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        return nullptr;
+    }
+    return env;
+}
+
+jstring cachedStageString(const char* stage) {
+    if (stage == nullptr) {
+        return nullptr;
+    }
+    if (std::strcmp(stage, kStageZerodcePreview) == 0) {
+        return g_cache.stageZerodcePreview;
+    }
+    if (std::strcmp(stage, kStageZerodceFull) == 0) {
+        return g_cache.stageZerodceFull;
+    }
+    return nullptr;
+}
+
+}
+
+extern "C" JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
+    (void)reserved;
+    JNIEnv* env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK || env == nullptr) {
+        LOGE("JNI_OnLoad: JNIEnv недоступен");
+        return JNI_ERR;
+    }
+
+    kotopogoda::JniCache cache;
+    cache.vm = vm;
+    if (!kotopogoda::populate(env, cache)) {
+        LOGE("JNI_OnLoad: не удалось разрешить классы и методы Java");
+        return JNI_ERR;
+    }
+    kotopogoda::g_cache = cache;
+    LOGI("JNI_OnLoad: ссылки на классы и методы закешированы");
+    return JNI_VERSION_1_6;
+}
@@ -0,0 +1,51 @@
+#ifndef JNI_CACHE_H
+#define JNI_CACHE_H
+
+#include <jni.h>
+
+namespace kotopogoda {
+
+// Классы, методы и строки Java, к которым обращается нативный код. Всё
+// разрешается один раз в JNI_OnLoad и хранится глобальными ссылками, поэтому
+// частые вызовы (прогресс тайлов и хеширования, превью) не делают FindClass,
+// GetMethodID и NewStringUTF. Если что-то не разрешилось, библиотека не
+// загружается: System.loadLibrary бросает UnsatisfiedLinkError.
+struct JniCache {
+    JavaVM* vm = nullptr;
+
+    jclass objectClass = nullptr;
+    jclass stringClass = nullptr;
+
+    // NativeTileProgressCallback.onTileProgress(String, int, int)
+    jmethodID onTileProgress = nullptr;
+    // NativeJobCompletion.onJobFinished(long, int)
+    jmethodID onJobFinished = nullptr;
+    // NativeBatchCodec.decode(String): Bitmap?
+    jmethodID batchDecode = nullptr;
+    // NativeBatchCodec.encode(Bitmap, String, String): Boolean
+    jmethodID batchEncode = nullptr;
+    // NativeBatchListener.onItemFinished(int, int)
+    jmethodID onBatchItemFinished = nullptr;
+    // NativePreviewLevelListener.onLevelReady(int)
+    jmethodID onPreviewLevelReady = nullptr;
+    // NativeHashing.ProgressListener.onProgress(long, long): Boolean
+    jmethodID onHashProgress = nullptr;
+    // NativeHashing.BatchProgressListener.onProgress(int, long, long): Boolean
+    jmethodID onBatchHashProgress = nullptr;
+
+    jstring stageZerodcePreview = nullptr;
+    jstring stageZerodceFull = nullptr;
+};
+
+const JniCache& jniCache();
+
+// JNIEnv текущего потока или nullptr, если поток не прикреплён к JavaVM.
+JNIEnv* currentJniEnv();
+
+// Готовая Java-строка для имени стадии или nullptr, если стадия неизвестна
+// и строку нужно создать через NewStringUTF.
+jstring cachedStageString(const char* stage);
+
+}
+
+#endif
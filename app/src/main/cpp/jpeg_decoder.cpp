@@ -0,0 +1,356 @@
+#include "jpeg_decoder.h"
+#include "trace.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <jpeglib.h>
+
+#define LOG_TAG "JpegDecoder"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace kotopogoda {
+
+namespace {
+
+// Высота полосы, которую декодер отдаёт за раз; RGB-буфер полосы — единственный
+// промежуточный буфер.
+constexpr int kStripRows = 16;
+
+// Ошибки libjpeg возвращаются через longjmp: error_exit по умолчанию вызывает exit().
+struct JpegErrorManager {
+    jpeg_error_mgr base;
+    jmp_buf jump;
+};
+
+void onJpegError(j_common_ptr cinfo) {
+    auto* manager = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+    char message[JMSG_LENGTH_MAX];
+    cinfo->err->format_message(cinfo, message);
+    LOGW("libjpeg: %s", message);
+    longjmp(manager->jump, 1);
+}
+
+void onJpegMessage(j_common_ptr cinfo) {
+    char message[JMSG_LENGTH_MAX];
+    cinfo->err->format_message(cinfo, message);
+    LOGW("libjpeg: %s", message);
+}
+
+// Владеет FILE* и jpeg_decompress_struct. Объявляется до setjmp, поэтому
+// longjmp не пропускает его деструктор.
+class JpegSource {
+public:
+    explicit JpegSource(const char* path) : file_(std::fopen(path, "rbe")) {
+        cinfo_.err = jpeg_std_error(&error_.base);
+        error_.base.error_exit = onJpegError;
+        error_.base.output_message = onJpegMessage;
+    }
+
+    ~JpegSource() {
+        if (created_) {
+            jpeg_destroy_decompress(&cinfo_);
+        }
+        if (file_ != nullptr) {
+            std::fclose(file_);
+        }
+    }
+
+    JpegSource(const JpegSource&) = delete;
+    JpegSource& operator=(const JpegSource&) = delete;
+
+    bool isOpen() const { return file_ != nullptr; }
+
+    // Вызывать сразу после setjmp(jump()).
+    void create() {
+        jpeg_create_decompress(&cinfo_);
+        created_ = true;
+        jpeg_stdio_src(&cinfo_, file_);
+    }
+
+    jpeg_decompress_struct& cinfo() { return cinfo_; }
+    jmp_buf& jump() { return error_.jump; }
+
+private:
+    FILE* file_;
+    jpeg_decompress_struct cinfo_{};
+    JpegErrorManager error_{};
+    bool created_ = false;
+};
+
+const float* byteToUnitTable() {
+    static const std::vector<float> table = [] {
+        std::vector<float> values(256);
+        for (int i = 0; i < 256; ++i) {
+            values[i] = i / 255.0f;
+        }
+        return values;
+    }();
+    return table.data();
+}
+
+int scaledSize(int size, int scaleDenom) {
+    return (size + scaleDenom - 1) / scaleDenom;
+}
+
+}
+
+int chooseJpegScaleDenom(int width, int height, int maxSide) {
+    const int longestSide = std::max(width, height);
+    if (maxSide <= 0 || longestSide <= 0) {
+        return 1;
+    }
+    int scaleDenom = 1;
+    for (int candidate : {2, 4, 8}) {
+        if (scaledSize(longestSide, candidate) < maxSide) {
+            break;
+        }
+        scaleDenom = candidate;
+    }
+    return scaleDenom;
+}
+
+bool readJpegInfo(const char* path, int maxSide, JpegImageInfo& info) {
+    JpegSource source(path);
+    if (!source.isOpen()) {
+        LOGW("Не удалось открыть %s", path);
+        return false;
+    }
+    if (setjmp(source.jump())) {
+        return false;
+    }
+    source.create();
+    jpeg_decompress_struct& cinfo = source.cinfo();
+    jpeg_read_header(&cinfo, TRUE);
+    if (cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK) {
+        LOGW("CMYK JPEG не поддерживается нативным декодером: %s", path);
+        return false;
+    }
+
+    info.width = static_cast<int>(cinfo.image_width);
+    info.height = static_cast<int>(cinfo.image_height);
+    info.scaleDenom = chooseJpegScaleDenom(info.width, info.height, maxSide);
+
+    // Точный размер результата считает сам libjpeg (округление вверх по MCU).
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = static_cast<unsigned int>(info.scaleDenom);
+    jpeg_calc_output_dimensions(&cinfo);
+    info.scaledWidth = static_cast<int>(cinfo.output_width);
+    info.scaledHeight = static_cast<int>(cinfo.output_height);
+    return true;
+}
+
+bool readJpegExif(const char* path, std::vector<uint8_t>& app1) {
+    app1.clear();
+    JpegSource source(path);
+    if (!source.isOpen()) {
+        LOGW("Не удалось открыть %s", path);
+        return false;
+    }
+    if (setjmp(source.jump())) {
+        app1.clear();
+        return false;
+    }
+    source.create();
+    jpeg_decompress_struct& cinfo = source.cinfo();
+    jpeg_save_markers(&cinfo, JPEG_APP0 + 1, 0xFFFF);
+    jpeg_read_header(&cinfo, TRUE);
+
+    // В APP1 бывает и XMP: берём только сегмент с сигнатурой Exif.
+    static const char kExifSignature[] = "Exif\0";
+    for (jpeg_saved_marker_ptr marker = cinfo.marker_list; marker != nullptr; marker = marker->next) {
+        if (marker->marker == JPEG_APP0 + 1 && marker->data_length >= sizeof(kExifSignature) &&
+            std::memcmp(marker->data, kExifSignature, sizeof(kExifSignature)) == 0) {
+            app1.assign(marker->data, marker->data + marker->data_length);
+            break;
+        }
+    }
+    return true;
+}
+
+bool decodeJpegPlanar(
+    const char* path,
+    int scaleDenom,
+    ncnn::Mat& output,
+    const std::atomic<bool>* cancelFlag
+) {
+    TRACE_SCOPE("decodeJpegPlanar");
+    if (scaleDenom != 1 && scaleDenom != 2 && scaleDenom != 4 && scaleDenom != 8) {
+        LOGW("Неподдерживаемый масштаб 1/%d", scaleDenom);
+        output.release();
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> strip;
+    std::vector<JSAMPROW> rows(kStripRows);
+    JpegSource source(path);
+    if (!source.isOpen()) {
+        LOGW("Не удалось открыть %s", path);
+        output.release();
+        return false;
+    }
+    if (setjmp(source.jump())) {
+        output.release();
+        return false;
+    }
+    source.create();
+    jpeg_decompress_struct& cinfo = source.cinfo();
+    jpeg_read_header(&cinfo, TRUE);
+
+    // CMYK/YCCK в RGB libjpeg не конвертирует: вызывающий откатывается на Bitmap.
+    if (cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK) {
+        LOGW("CMYK JPEG не поддерживается нативным декодером: %s", path);
+        output.release();
+        return false;
+    }
+    cinfo.out_color_space = JCS_RGB;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = static_cast<unsigned int>(scaleDenom);
+    jpeg_start_decompress(&cinfo);
+
+    const int width = static_cast<int>(cinfo.output_width);
+    const int height = static_cast<int>(cinfo.output_height);
+    output.create(width, height, 3, 4u, nullptr);
+    if (output.empty()) {
+        LOGW("Не удалось выделить %dx%d для декодирования", width, height);
+        return false;
+    }
+
+    const size_t rowStride = static_cast<size_t>(width) * 3;
+    strip.resize(rowStride * kStripRows);
+    for (int i = 0; i < kStripRows; ++i) {
+        rows[i] = strip.data() + rowStride * i;
+    }
+
+    const float* toUnit = byteToUnitTable();
+    float* red = output.channel(0);
+    float* green = output.channel(1);
+    float* blue = output.channel(2);
+
+    while (cinfo.output_scanline < cinfo.output_height) {
+        if (cancelFlag != nullptr && cancelFlag->load()) {
+            LOGI("Декодирование отменено на строке %u из %d", cinfo.output_scanline, height);
+            jpeg_abort_decompress(&cinfo);
+            output.release();
+            return false;
+        }
+        const int firstRow = static_cast<int>(cinfo.output_scanline);
+        const int wanted = std::min(kStripRows, height - firstRow);
+        int read = 0;
+        while (read < wanted) {
+            read += static_cast<int>(jpeg_read_scanlines(
+                &cinfo,
+                rows.data() + read,
+                static_cast<JDIMENSION>(wanted - read)
+            ));
+        }
+        for (int row = 0; row < read; ++row) {
+            const uint8_t* rgb = rows[row];
+            const size_t offset = static_cast<size_t>(firstRow + row) * width;
+            for (int x = 0; x < width; ++x) {
+                red[offset + x] = toUnit[rgb[0]];
+                green[offset + x] = toUnit[rgb[1]];
+                blue[offset + x] = toUnit[rgb[2]];
+                rgb += 3;
+            }
+        }
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    LOGI("JPEG %dx%d (1/%d) декодирован за %lldмс",
+         width,
+         height,
+         scaleDenom,
+         static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - start
+         ).count()));
+    return true;
+}
+
+bool computeJpegImageStats(
+    const char* path,
+    int maxSide,
+    JpegImageInfo& info,
+    ImageStats& stats,
+    const std::atomic<bool>* cancelFlag
+) {
+    TRACE_SCOPE("computeJpegImageStats");
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> strip;
+    std::vector<JSAMPROW> rows(kStripRows);
+    JpegSource source(path);
+    if (!source.isOpen()) {
+        LOGW("Не удалось открыть %s", path);
+        return false;
+    }
+    if (setjmp(source.jump())) {
+        return false;
+    }
+    source.create();
+    jpeg_decompress_struct& cinfo = source.cinfo();
+    jpeg_read_header(&cinfo, TRUE);
+    if (cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK) {
+        LOGW("CMYK JPEG не поддерживается нативным декодером: %s", path);
+        return false;
+    }
+
+    info.width = static_cast<int>(cinfo.image_width);
+    info.height = static_cast<int>(cinfo.image_height);
+    info.scaleDenom = chooseJpegScaleDenom(info.width, info.height, maxSide);
+    cinfo.out_color_space = JCS_RGB;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = static_cast<unsigned int>(info.scaleDenom);
+    jpeg_start_decompress(&cinfo);
+
+    const int width = static_cast<int>(cinfo.output_width);
+    const int height = static_cast<int>(cinfo.output_height);
+    info.scaledWidth = width;
+    info.scaledHeight = height;
+    const size_t rowStride = static_cast<size_t>(width) * 3;
+    strip.resize(rowStride * kStripRows);
+    for (int i = 0; i < kStripRows; ++i) {
+        rows[i] = strip.data() + rowStride * i;
+    }
+
+    ImageStatsAccumulator accumulator(width, height);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        if (cancelFlag != nullptr && cancelFlag->load()) {
+            LOGI("Статистика JPEG отменена на строке %u из %d", cinfo.output_scanline, height);
+            jpeg_abort_decompress(&cinfo);
+            return false;
+        }
+        const int wanted = std::min(kStripRows, height - static_cast<int>(cinfo.output_scanline));
+        int read = 0;
+        while (read < wanted) {
+            read += static_cast<int>(jpeg_read_scanlines(
+                &cinfo,
+                rows.data() + read,
+                static_cast<JDIMENSION>(wanted - read)
+            ));
+        }
+        for (int row = 0; row < read; ++row) {
+            accumulator.addRow(rows[row]);
+        }
+    }
+    jpeg_finish_decompress(&cinfo);
+    if (!accumulator.finish(stats)) {
+        return false;
+    }
+    LOGI("Статистика JPEG %dx%d по кадру 1/%d (%dx%d) за %lldмс",
+         info.width,
+         info.height,
+         info.scaleDenom,
+         width,
+         height,
+         static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - start
+         ).count()));
+    return true;
+}
+
+}
@@ -0,0 +1,60 @@
+#ifndef JPEG_DECODER_H
+#define JPEG_DECODER_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <ncnn/mat.h>
+#include "image_stats.h"
+
+namespace kotopogoda {
+
+struct JpegImageInfo {
+    int width = 0;
+    int height = 0;
+    // Знаменатель DCT-масштабирования (1, 2, 4 или 8) и размер результата с ним.
+    int scaleDenom = 1;
+    int scaledWidth = 0;
+    int scaledHeight = 0;
+};
+
+// Наибольший знаменатель из 1, 2, 4, 8, при котором длинная сторона результата
+// не меньше maxSide. maxSide <= 0 — без масштабирования.
+int chooseJpegScaleDenom(int width, int height, int maxSide);
+
+// Читает только заголовок JPEG и подбирает масштаб для maxSide.
+// false — файл не читается, не является JPEG или записан в CMYK.
+bool readJpegInfo(const char* path, int maxSide, JpegImageInfo& info);
+
+// Читает полезную нагрузку сегмента APP1 Exif ("Exif\0\0" + TIFF) без
+// декодирования пикселей. false — файл не читается; если EXIF нет, app1 пуст.
+bool readJpegExif(const char* path, std::vector<uint8_t>& app1);
+
+// Декодирует JPEG сразу в планарный float RGB в [0, 1] (раскладка входа движка,
+// как у bitmapToMat). Масштаб 1/scaleDenom применяется в DCT-домене, а строки
+// читаются полосами, так что полноразмерного промежуточного RGB/ARGB буфера нет.
+// cancelFlag проверяется между полосами. false — ошибка декодирования,
+// неподдерживаемое цветовое пространство (CMYK) или отмена; output пуст.
+bool decodeJpegPlanar(
+    const char* path,
+    int scaleDenom,
+    ncnn::Mat& output,
+    const std::atomic<bool>* cancelFlag = nullptr
+);
+
+// Статистика входа без полноразмерного декодирования: JPEG уменьшается в
+// DCT-домене до наименьшего размера с длинной стороной не меньше maxSide
+// (как readJpegInfo), и RGB-полосы libjpeg идут прямо в ImageStatsAccumulator.
+// info заполняется, как у readJpegInfo; резкость и шум — на уменьшенном кадре.
+// false — файл не читается, не JPEG, CMYK/YCCK или отмена.
+bool computeJpegImageStats(
+    const char* path,
+    int maxSide,
+    JpegImageInfo& info,
+    ImageStats& stats,
+    const std::atomic<bool>* cancelFlag = nullptr
+);
+
+}
+
+#endif
@@ -0,0 +1,312 @@
+#include "jpeg_encoder.h"
+#include "trace.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cerrno>
+#include <csetjmp>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <jpeglib.h>
+#include <jerror.h>
+
+#define LOG_TAG "JpegEncoder"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace kotopogoda {
+
+namespace {
+
+constexpr size_t kOutputBufferSize = 64 * 1024;
+// Полезная нагрузка маркера ограничена 16-битной длиной сегмента.
+constexpr size_t kMaxMarkerPayload = 65533;
+
+struct EncoderErrorManager {
+    jpeg_error_mgr base;
+    jmp_buf jump;
+};
+
+void onJpegError(j_common_ptr cinfo) {
+    auto* manager = reinterpret_cast<EncoderErrorManager*>(cinfo->err);
+    char message[JMSG_LENGTH_MAX];
+    cinfo->err->format_message(cinfo, message);
+    LOGW("libjpeg: %s", message);
+    longjmp(manager->jump, 1);
+}
+
+void onJpegMessage(j_common_ptr cinfo) {
+    char message[JMSG_LENGTH_MAX];
+    cinfo->err->format_message(cinfo, message);
+    LOGW("libjpeg: %s", message);
+}
+
+bool writeAll(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOGW("Ошибка записи JPEG в fd=%d: errno=%d", fd, errno);
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+uint8_t quantize(float value) {
+    return static_cast<uint8_t>(std::max(0.0f, std::min(1.0f, value)) * 255.0f);
+}
+
+}
+
+struct JpegBandEncoder::State {
+    // base — первым полем: libjpeg видит только jpeg_destination_mgr.
+    struct Destination {
+        jpeg_destination_mgr base;
+        State* owner;
+    };
+
+    Destination destination{};
+    jpeg_compress_struct cinfo{};
+    EncoderErrorManager error{};
+
+    int fd;
+    int quality;
+    std::vector<uint8_t> exifApp1;
+    std::vector<uint8_t> outputBuffer;
+    std::vector<uint8_t> rgbRow;
+    ImageStats* stats;
+    const ColorLut* colorLut;
+    std::unique_ptr<ImageStatsAccumulator> statsAccumulator;
+    uint64_t bytesWritten = 0;
+    int width = 0;
+    int height = 0;
+    int nextRow = 0;
+    bool created = false;
+    bool failed = false;
+
+    State(int fd, int quality, std::vector<uint8_t> exifApp1, ImageStats* stats, const ColorLut* colorLut)
+        : fd(fd), quality(quality), exifApp1(std::move(exifApp1)), stats(stats), colorLut(colorLut) {
+        destination.owner = this;
+    }
+
+    static State* from(j_compress_ptr cinfo) {
+        return reinterpret_cast<Destination*>(cinfo->dest)->owner;
+    }
+
+    static void initDestination(j_compress_ptr cinfo) {
+        State* state = from(cinfo);
+        cinfo->dest->next_output_byte = state->outputBuffer.data();
+        cinfo->dest->free_in_buffer = state->outputBuffer.size();
+    }
+
+    static boolean emptyOutputBuffer(j_compress_ptr cinfo) {
+        State* state = from(cinfo);
+        if (!state->flush(state->outputBuffer.size())) {
+            ERREXIT(cinfo, JERR_FILE_WRITE);
+        }
+        cinfo->dest->next_output_byte = state->outputBuffer.data();
+        cinfo->dest->free_in_buffer = state->outputBuffer.size();
+        return TRUE;
+    }
+
+    static void termDestination(j_compress_ptr cinfo) {
+        State* state = from(cinfo);
+        const size_t pending = state->outputBuffer.size() - cinfo->dest->free_in_buffer;
+        if (!state->flush(pending)) {
+            ERREXIT(cinfo, JERR_FILE_WRITE);
+        }
+    }
+
+    bool flush(size_t size) {
+        if (!writeAll(fd, outputBuffer.data(), size)) {
+            return false;
+        }
+        bytesWritten += size;
+        return true;
+    }
+};
+
+JpegBandEncoder::JpegBandEncoder(
+    int fd,
+    int quality,
+    std::vector<uint8_t> exifApp1,
+    ImageStats* stats,
+    const ColorLut* colorLut
+)
+    : state_(std::make_unique<State>(
+          fd, std::max(1, std::min(100, quality)), std::move(exifApp1), stats, colorLut
+      )) {
+    State& state = *state_;
+    state.cinfo.err = jpeg_std_error(&state.error.base);
+    state.error.base.error_exit = onJpegError;
+    state.error.base.output_message = onJpegMessage;
+    state.destination.base.init_destination = State::initDestination;
+    state.destination.base.empty_output_buffer = State::emptyOutputBuffer;
+    state.destination.base.term_destination = State::termDestination;
+}
+
+JpegBandEncoder::~JpegBandEncoder() {
+    if (state_->created) {
+        jpeg_destroy_compress(&state_->cinfo);
+    }
+}
+
+uint64_t JpegBandEncoder::bytesWritten() const {
+    return state_->bytesWritten;
+}
+
+bool JpegBandEncoder::begin(int width, int height) {
+    State& state = *state_;
+    if (state.created || state.fd < 0 || width <= 0 || height <= 0) {
+        return false;
+    }
+    state.width = width;
+    state.height = height;
+    state.outputBuffer.resize(kOutputBufferSize);
+    state.rgbRow.resize(static_cast<size_t>(width) * 3);
+    if (state.stats != nullptr) {
+        *state.stats = ImageStats();
+        state.statsAccumulator = std::make_unique<ImageStatsAccumulator>(width, height);
+    }
+
+    if (setjmp(state.error.jump)) {
+        state.failed = true;
+        return false;
+    }
+    jpeg_create_compress(&state.cinfo);
+    state.created = true;
+    state.cinfo.dest = &state.destination.base;
+    state.cinfo.image_width = static_cast<JDIMENSION>(width);
+    state.cinfo.image_height = static_cast<JDIMENSION>(height);
+    state.cinfo.input_components = 3;
+    state.cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&state.cinfo);
+    jpeg_set_quality(&state.cinfo, state.quality, TRUE);
+
+    const bool hasExif = !state.exifApp1.empty() && state.exifApp1.size() <= kMaxMarkerPayload;
+    if (!state.exifApp1.empty() && !hasExif) {
+        LOGW("EXIF источника больше одного сегмента APP1 (%zu байт), не переносится", state.exifApp1.size());
+    }
+    // APP1 Exif должен идти сразу после SOI, JFIF при этом не пишется.
+    state.cinfo.write_JFIF_header = hasExif ? FALSE : TRUE;
+    jpeg_start_compress(&state.cinfo, TRUE);
+    if (hasExif) {
+        jpeg_write_marker(
+            &state.cinfo,
+            JPEG_APP0 + 1,
+            state.exifApp1.data(),
+            static_cast<unsigned int>(state.exifApp1.size())
+        );
+    }
+    return true;
+}
+
+bool JpegBandEncoder::writeRows(const ncnn::Mat& band, int firstRow) {
+    State& state = *state_;
+    if (!state.created || state.failed || band.c != 3 || band.w != state.width ||
+        firstRow != state.nextRow || firstRow + band.h > state.height) {
+        LOGW("Полоса %d..%d не подходит кодировщику (ожидалась строка %d)",
+             firstRow, firstRow + band.h, state.nextRow);
+        state.failed = true;
+        return false;
+    }
+
+    // Объекты с деструкторами — до setjmp: longjmp не должен их перепрыгивать.
+    const ncnn::Mat red = band.channel(0);
+    const ncnn::Mat green = band.channel(1);
+    const ncnn::Mat blue = band.channel(2);
+    if (setjmp(state.error.jump)) {
+        state.failed = true;
+        return false;
+    }
+    for (int row = 0; row < band.h; ++row) {
+        const float* r = red.row(row);
+        const float* g = green.row(row);
+        const float* b = blue.row(row);
+        uint8_t* rgb = state.rgbRow.data();
+        for (int x = 0; x < state.width; ++x) {
+            rgb[0] = quantize(r[x]);
+            rgb[1] = quantize(g[x]);
+            rgb[2] = quantize(b[x]);
+            rgb += 3;
+        }
+        if (state.colorLut != nullptr) {
+            state.colorLut->applyRgbRow(state.rgbRow.data(), state.width);
+        }
+        JSAMPROW scanline = state.rgbRow.data();
+        jpeg_write_scanlines(&state.cinfo, &scanline, 1);
+        if (state.statsAccumulator) {
+            state.statsAccumulator->addRow(state.rgbRow.data());
+        }
+    }
+    state.nextRow += band.h;
+    return true;
+}
+
+bool JpegBandEncoder::finish() {
+    State& state = *state_;
+    if (!state.created || state.failed || state.nextRow != state.height) {
+        LOGW("Кодирование не завершено: записано %d из %d строк", state.nextRow, state.height);
+        return false;
+    }
+    if (setjmp(state.error.jump)) {
+        state.failed = true;
+        return false;
+    }
+    jpeg_finish_compress(&state.cinfo);
+    if (state.statsAccumulator) {
+        state.statsAccumulator->finish(*state.stats);
+    }
+    LOGI("JPEG %dx%d q=%d записан: %llu байт",
+         state.width, state.height, state.quality, static_cast<unsigned long long>(state.bytesWritten));
+    return true;
+}
+
+bool writeJpegFile(
+    const char* path,
+    const ncnn::Mat& image,
+    int width,
+    int height,
+    int quality,
+    std::vector<uint8_t> exifApp1,
+    const std::atomic<bool>* cancelFlag,
+    ImageStats* stats,
+    const ColorLut* colorLut
+) {
+    TRACE_SCOPE("writeJpegFile");
+    const auto start = std::chrono::steady_clock::now();
+    const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOGW("Не удалось открыть %s для записи: errno=%d", path, errno);
+        return false;
+    }
+    bool ok;
+    {
+        JpegBandEncoder encoder(fd, quality, std::move(exifApp1), stats, colorLut);
+        ok = writeResizedBands(image, width, height, encoder, cancelFlag);
+    }
+    if (::close(fd) != 0) {
+        LOGW("Ошибка закрытия %s: errno=%d", path, errno);
+        ok = false;
+    }
+    if (!ok) {
+        ::unlink(path);
+        return false;
+    }
+    LOGI("JPEG %s записан полосами из %dx%d за %lldмс",
+         path,
+         image.w,
+         image.h,
+         static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - start
+         ).count()));
+    return true;
+}
+
+}
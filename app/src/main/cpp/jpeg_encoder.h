@@ -0,0 +1,66 @@
+#ifndef JPEG_ENCODER_H
+#define JPEG_ENCODER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "color_lut.h"
+#include "image_stats.h"
+#include "row_band_sink.h"
+
+namespace kotopogoda {
+
+// Построчный JPEG-кодировщик (libjpeg-turbo), пишущий прямо в fd. Полосы
+// квантуются в 8 бит так же, как matToBitmap, и сразу уходят в
+// jpeg_write_scanlines, поэтому в памяти только одна RGB-строка и буфер вывода.
+// exifApp1 — полезная нагрузка APP1 источника ("Exif\0\0..."); если она есть,
+// пишется сразу после SOI вместо JFIF-заголовка. colorLut, если задана,
+// применяется к каждой строке после квантования (как в matToBitmap) и должна
+// жить до конца кодирования. stats, если задан, в finish получает статистику
+// записанных 8-битных строк. fd не закрывается.
+class JpegBandEncoder : public RowBandSink {
+public:
+    JpegBandEncoder(
+        int fd,
+        int quality,
+        std::vector<uint8_t> exifApp1 = {},
+        ImageStats* stats = nullptr,
+        const ColorLut* colorLut = nullptr
+    );
+    ~JpegBandEncoder() override;
+
+    JpegBandEncoder(const JpegBandEncoder&) = delete;
+    JpegBandEncoder& operator=(const JpegBandEncoder&) = delete;
+
+    bool begin(int width, int height) override;
+    bool writeRows(const ncnn::Mat& band, int firstRow) override;
+    bool finish() override;
+
+    // Байт записано в fd.
+    uint64_t bytesWritten() const;
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
+// Пишет image, увеличенный до width x height полосами (writeResizedBands), в
+// JPEG-файл path. Полноразмерный результат при этом не создаётся. При ошибке
+// или отмене недописанный файл удаляется. stats и colorLut — как у
+// JpegBandEncoder.
+bool writeJpegFile(
+    const char* path,
+    const ncnn::Mat& image,
+    int width,
+    int height,
+    int quality,
+    std::vector<uint8_t> exifApp1,
+    const std::atomic<bool>* cancelFlag = nullptr,
+    ImageStats* stats = nullptr,
+    const ColorLut* colorLut = nullptr
+);
+
+}
+
+#endif
@@ -0,0 +1,140 @@
+#include "memory_tracker.h"
+#include "ncnn_engine.h"
+#include "trace.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define LOG_TAG "MemoryTracker"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace kotopogoda {
+
+namespace {
+
+long bytesToKb(size_t bytes) {
+    return static_cast<long>((bytes + 1023) / 1024);
+}
+
+// Строка вида "VmHWM:\t  123456 kB".
+bool parseStatusKb(const char* line, const char* key, long& value) {
+    const size_t keyLength = std::strlen(key);
+    if (std::strncmp(line, key, keyLength) != 0) {
+        return false;
+    }
+    value = std::strtol(line + keyLength, nullptr, 10);
+    return true;
+}
+
+}
+
+bool readProcessMemory(ProcessMemory& memory) {
+    FILE* status = std::fopen("/proc/self/status", "re");
+    if (status == nullptr) {
+        return false;
+    }
+    char line[128];
+    int found = 0;
+    while (found < 2 && std::fgets(line, sizeof(line), status) != nullptr) {
+        if (parseStatusKb(line, "VmHWM:", memory.vmHwmKb) || parseStatusKb(line, "VmRSS:", memory.vmRssKb)) {
+            ++found;
+        }
+    }
+    std::fclose(status);
+    return found == 2;
+}
+
+MemoryTracker::MemoryTracker(TelemetryData& telemetry) : telemetry_(telemetry) {}
+
+void MemoryTracker::allocated(size_t bytes) {
+    const size_t live = live_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t peak = stagePeak_.load(std::memory_order_relaxed);
+    while (live > peak && !stagePeak_.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    traceCounter("ncnn_live_kb", bytesToKb(live));
+}
+
+void MemoryTracker::released(size_t bytes) {
+    const size_t live = live_.fetch_sub(bytes, std::memory_order_relaxed) - bytes;
+    traceCounter("ncnn_live_kb", bytesToKb(live));
+}
+
+void MemoryTracker::beginStage(PipelineStage stage) {
+    endStage();
+    std::lock_guard<std::mutex> lock(stageMutex_);
+    currentStage_ = static_cast<int>(stage);
+    stagePeak_.store(live_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void MemoryTracker::endStage() {
+    std::lock_guard<std::mutex> lock(stageMutex_);
+    if (currentStage_ < 0) {
+        return;
+    }
+    const int stage = currentStage_;
+    currentStage_ = -1;
+
+    const long peakKb = bytesToKb(stagePeak_.load(std::memory_order_relaxed));
+    TelemetryData::MemoryTelemetry& memory = telemetry_.memory;
+    memory.stagePeakKb[stage] = std::max(memory.stagePeakKb[stage], peakKb);
+    telemetry_.peakMemoryKb = std::max(telemetry_.peakMemoryKb, peakKb);
+
+    ProcessMemory process;
+    if (readProcessMemory(process)) {
+        traceCounter("rss_kb", process.vmRssKb);
+        memory.stageRssKb[stage] = std::max(memory.stageRssKb[stage], process.vmRssKb);
+        memory.processPeakRssKb = std::max(memory.processPeakRssKb, process.vmHwmKb);
+    }
+    LOGI("Память: stage=%s peak_kb=%ld rss_kb=%ld hwm_kb=%ld",
+         pipelineStageName(static_cast<PipelineStage>(stage)),
+         peakKb,
+         process.vmRssKb,
+         process.vmHwmKb);
+}
+
+MatCharge::MatCharge(MemoryTracker& tracker, const ncnn::Mat& mat)
+    : tracker_(tracker), bytes_(mat.empty() ? 0 : mat.total() * mat.elemsize) {
+    if (bytes_ > 0) {
+        tracker_.allocated(bytes_);
+    }
+}
+
+MatCharge::~MatCharge() {
+    if (bytes_ > 0) {
+        tracker_.released(bytes_);
+    }
+}
+
+TrackingAllocator::TrackingAllocator(ncnn::Allocator* inner, MemoryTracker& tracker)
+    : inner_(inner), tracker_(tracker) {}
+
+TrackingAllocator::~TrackingAllocator() {
+    if (!sizes_.empty()) {
+        LOGW("Аллокатор уничтожается с %zu невозвращёнными блоками", sizes_.size());
+    }
+}
+
+void* TrackingAllocator::fastMalloc(size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    void* ptr = inner_->fastMalloc(size);
+    if (ptr != nullptr) {
+        sizes_[ptr] = size;
+        tracker_.allocated(size);
+    }
+    return ptr;
+}
+
+void TrackingAllocator::fastFree(void* ptr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = sizes_.find(ptr);
+    if (it != sizes_.end()) {
+        tracker_.released(it->second);
+        sizes_.erase(it);
+    }
+    inner_->fastFree(ptr);
+}
+
+}
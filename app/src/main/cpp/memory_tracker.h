@@ -0,0 +1,91 @@
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <ncnn/mat.h>
+#include "pipeline_stage.h"
+
+namespace kotopogoda {
+
+struct TelemetryData;
+
+// Снимок /proc/self/status: VmHWM — пик RSS процесса за всё время, VmRSS — текущий.
+struct ProcessMemory {
+    long vmHwmKb = 0;
+    long vmRssKb = 0;
+};
+
+bool readProcessMemory(ProcessMemory& memory);
+
+// Учёт памяти одного запуска: байты, выданные ncnn-аллокаторами RunContext
+// (TrackingAllocator), плюс собственные ncnn::Mat движка, записанные через
+// MatCharge. Пик считается отдельно для каждой стадии; на границе стадии
+// снимаются VmRSS/VmHWM. Итоги пишутся в TelemetryData при завершении стадии,
+// поэтому повторные стадии одного запуска (уровни превью) дают максимум.
+// allocated/released вызываются из любых потоков ncnn.
+class MemoryTracker {
+public:
+    explicit MemoryTracker(TelemetryData& telemetry);
+
+    MemoryTracker(const MemoryTracker&) = delete;
+    MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+    void allocated(size_t bytes);
+    void released(size_t bytes);
+
+    // Завершает текущую стадию (если есть) и начинает stage; пик новой стадии
+    // отсчитывается от уже занятого объёма.
+    void beginStage(PipelineStage stage);
+    // Завершает текущую стадию: её пик и снимок /proc попадают в телеметрию.
+    void endStage();
+
+    size_t liveBytes() const { return live_.load(std::memory_order_relaxed); }
+
+private:
+    TelemetryData& telemetry_;
+    std::atomic<size_t> live_{0};
+    std::atomic<size_t> stagePeak_{0};
+    std::mutex stageMutex_;
+    int currentStage_ = -1;
+};
+
+// Учитывает Mat, выделенную мимо аллокаторов RunContext, пока charge жив.
+// Держать её нужно ровно столько, сколько живёт сама Mat в этой области;
+// поверхностные копии (общие данные) не учитываются повторно.
+class MatCharge {
+public:
+    MatCharge(MemoryTracker& tracker, const ncnn::Mat& mat);
+    ~MatCharge();
+
+    MatCharge(const MatCharge&) = delete;
+    MatCharge& operator=(const MatCharge&) = delete;
+
+private:
+    MemoryTracker& tracker_;
+    size_t bytes_;
+};
+
+// Обёртка над аллокатором ncnn (пулом блобов или рабочей области), которая
+// сообщает трекеру размер каждого выданного и возвращённого блока. Размеры
+// блоков хранятся у себя: ncnn::Allocator::fastFree размер не передаёт.
+class TrackingAllocator : public ncnn::Allocator {
+public:
+    TrackingAllocator(ncnn::Allocator* inner, MemoryTracker& tracker);
+    ~TrackingAllocator() override;
+
+    void* fastMalloc(size_t size) override;
+    void fastFree(void* ptr) override;
+
+private:
+    ncnn::Allocator* inner_;
+    MemoryTracker& tracker_;
+    std::mutex mutex_;
+    std::unordered_map<void*, size_t> sizes_;
+};
+
+}
+
+#endif
@@ -1,83 +1,451 @@
 #include <jni.h>
 #include <android/asset_manager_jni.h>
 #include <android/log.h>
+#include <ncnn/cpu.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
+#include "jni_cache.h"
+#include "batch_pipeline.h"
+#include "color_lut.h"
+#include "edge_unsharp.h"
+#include "enhance_job_queue.h"
+#include "jpeg_decoder.h"
+#include "jpeg_encoder.h"
 #include "ncnn_engine.h"
+#include "progress_channel.h"
+#include "telemetry_buffer.h"
+#include "trace.h"
 
 #define LOG_TAG "NativeEnhanceJNI"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-static std::map<jlong, kotopogoda::NcnnEngine*> g_engines;
-static std::mutex g_enginesMutex;
-static jlong g_nextHandle = 1;
-
 namespace {
 
-jobject buildTelemetryPayload(
-    JNIEnv* env,
-    const kotopogoda::TelemetryData& telemetry,
-    bool success
-) {
-    jclass telemetryClass = env->FindClass(
-        "com/kotopogoda/uploader/feature/viewer/enhance/NativeRunTelemetry"
-    );
-    if (telemetryClass == nullptr) {
-        return nullptr;
+void* telemetryBufferAddress(JNIEnv* env, jobject telemetryBuffer, jlong& capacity);
+
+// Движок и его очередь задач. Очередь разрушается первой: она отменяет задачи
+// и дожидается рабочего потока, который ещё может обращаться к движку.
+struct EngineSlot {
+    std::unique_ptr<kotopogoda::NcnnEngine> engine;
+    std::unique_ptr<kotopogoda::EnhanceJobQueue> queue;
+
+    // Пакеты в очереди или в работе, по jobId — для отмены отдельных элементов.
+    std::mutex batchesMutex;
+    std::map<jlong, std::shared_ptr<kotopogoda::BatchPipeline>> batches;
+
+    ~EngineSlot() {
+        queue.reset();
+        if (engine) {
+            engine->release();
+        }
     }
-    jmethodID ctor = env->GetMethodID(
-        telemetryClass,
-        "<init>",
-        "(ZJZJZZIJJZIIIIFFILjava/lang/String;Ljava/lang/String;)V"
-    );
-    if (ctor == nullptr) {
-        env->DeleteLocalRef(telemetryClass);
+};
+
+std::map<jlong, std::shared_ptr<EngineSlot>> g_engines;
+std::mutex g_enginesMutex;
+jlong g_nextHandle = 1;
+
+std::shared_ptr<EngineSlot> findEngine(jlong handle) {
+    std::lock_guard<std::mutex> lock(g_enginesMutex);
+    auto it = g_engines.find(handle);
+    if (it == g_engines.end()) {
+        LOGE("Недействительный handle: %lld", (long long)handle);
         return nullptr;
     }
+    return it->second;
+}
 
-    const char* delegateName = "cpu";
-    jstring delegateUsed = env->NewStringUTF(delegateName);
-    if (delegateUsed == nullptr) {
-        env->DeleteLocalRef(telemetryClass);
-        return nullptr;
+// Превью и полная обработка идут параллельно: движок реентерабелен, а очередь
+// не запускает две задачи одного вида одновременно.
+constexpr size_t kQueueWorkers = 2;
+
+// Рабочие потоки очереди прикреплены к JavaVM: задачи блокируют Bitmap и
+// вызывают обратные вызовы Kotlin из них.
+kotopogoda::EnhanceJobQueueHooks jvmAttachedHooks() {
+    kotopogoda::EnhanceJobQueueHooks hooks;
+    hooks.onThreadStart = []() {
+        JavaVM* vm = kotopogoda::jniCache().vm;
+        JNIEnv* env = nullptr;
+        JavaVMAttachArgs args{JNI_VERSION_1_6, "kotopogoda-enhance", nullptr};
+        if (vm == nullptr || vm->AttachCurrentThread(&env, &args) != JNI_OK) {
+            LOGE("Не удалось прикрепить поток очереди к JavaVM");
+        }
+    };
+    hooks.onThreadStop = []() {
+        if (kotopogoda::currentJniEnv() != nullptr) {
+            kotopogoda::jniCache().vm->DetachCurrentThread();
+        }
+    };
+    return hooks;
+}
+
+// Глобальные ссылки, которые задача держит до завершения.
+struct JobRefs {
+    jobject sourceBitmap = nullptr;
+    jobject outputBitmap = nullptr;
+    jobject progressCallback = nullptr;
+    jobject completion = nullptr;
+    // Только для пакетов.
+    jobject batchCodec = nullptr;
+    jobject batchListener = nullptr;
+    jobject batchItems = nullptr;
+    // Только для прогрессивного превью.
+    jobject previewBitmaps = nullptr;
+    jobject previewListener = nullptr;
+
+    static std::shared_ptr<JobRefs> create(
+        JNIEnv* env,
+        jobject sourceBitmap,
+        jobject outputBitmap,
+        jobject progressCallback,
+        jobject completion
+    ) {
+        auto refs = std::make_shared<JobRefs>();
+        refs->sourceBitmap = sourceBitmap != nullptr ? env->NewGlobalRef(sourceBitmap) : nullptr;
+        refs->outputBitmap = outputBitmap != nullptr ? env->NewGlobalRef(outputBitmap) : nullptr;
+        refs->progressCallback = progressCallback != nullptr ? env->NewGlobalRef(progressCallback) : nullptr;
+        refs->completion = completion != nullptr ? env->NewGlobalRef(completion) : nullptr;
+        return refs;
+    }
+
+    void release() {
+        JNIEnv* env = kotopogoda::currentJniEnv();
+        if (env == nullptr) {
+            LOGE("Глобальные ссылки задачи освобождаются вне потока JavaVM");
+            return;
+        }
+        for (jobject* ref : {
+                 &sourceBitmap, &outputBitmap, &progressCallback, &completion,
+                 &batchCodec, &batchListener, &batchItems,
+                 &previewBitmaps, &previewListener }) {
+            if (*ref != nullptr) {
+                env->DeleteGlobalRef(*ref);
+                *ref = nullptr;
+            }
+        }
+    }
+
+    void notifyFinished(int64_t jobId, kotopogoda::EnhanceJobState state) const {
+        TRACE_SCOPE("jni_on_job_finished");
+        JNIEnv* env = kotopogoda::currentJniEnv();
+        if (env == nullptr || completion == nullptr) {
+            return;
+        }
+        env->CallVoidMethod(
+            completion,
+            kotopogoda::jniCache().onJobFinished,
+            static_cast<jlong>(jobId),
+            static_cast<jint>(state)
+        );
+        if (env->ExceptionCheck()) {
+            LOGE("Исключение в onJobFinished для job=%lld", (long long)jobId);
+            env->ExceptionClear();
+        }
+    }
+};
+
+jlong submitJob(
+    const std::shared_ptr<EngineSlot>& slot,
+    kotopogoda::EnhanceJob job,
+    const std::shared_ptr<JobRefs>& refs
+) {
+    job.release = [refs]() { refs->release(); };
+    job.onFinished = [refs](int64_t jobId, kotopogoda::EnhanceJobState state) {
+        refs->notifyFinished(jobId, state);
+    };
+    return static_cast<jlong>(slot->queue->submit(std::move(job)));
+}
+
+// Глобальная ссылка на Bitmap источника: декодер передаёт её кодировщику, который
+// записывает результат в тот же Bitmap. Удаляется в потоке, отпустившем кадр.
+std::shared_ptr<void> globalBitmapRef(JNIEnv* env, jobject bitmap) {
+    jobject global = env->NewGlobalRef(bitmap);
+    return std::shared_ptr<void>(global, [](void* ref) {
+        JNIEnv* currentEnv = kotopogoda::currentJniEnv();
+        if (currentEnv != nullptr) {
+            currentEnv->DeleteGlobalRef(static_cast<jobject>(ref));
+        } else {
+            LOGE("Bitmap пакета освобождается вне потока JavaVM");
+        }
+    });
+}
+
+bool readStringArray(JNIEnv* env, jobjectArray array, std::vector<std::string>& out) {
+    if (array == nullptr) {
+        return false;
     }
+    const jsize length = env->GetArrayLength(array);
+    out.reserve(static_cast<size_t>(length));
+    for (jsize i = 0; i < length; ++i) {
+        auto element = static_cast<jstring>(env->GetObjectArrayElement(array, i));
+        if (element == nullptr) {
+            return false;
+        }
+        const char* chars = env->GetStringUTFChars(element, nullptr);
+        out.emplace_back(chars);
+        env->ReleaseStringUTFChars(element, chars);
+        env->DeleteLocalRef(element);
+    }
+    return true;
+}
+
+// Качество нативного JPEG — как у Bitmap.compress в Kotlin-кодировщике.
+constexpr int kJpegQuality = 95;
 
-    jstring restPrecision = env->NewStringUTF(telemetry.restPrecision.c_str());
-    if (restPrecision == nullptr) {
-        env->DeleteLocalRef(delegateUsed);
-        env->DeleteLocalRef(telemetryClass);
+// LUT цветового профиля для записи результата; nullptr, если профиль
+// нейтральный и запись идёт без лишнего прохода по таблице.
+std::shared_ptr<const kotopogoda::ColorLut> profileColorLut(jfloat vibranceGain, jfloat saturationGain) {
+    if (kotopogoda::isIdentityColorProfile(vibranceGain, saturationGain)) {
         return nullptr;
     }
+    return kotopogoda::vibranceSaturationLut(vibranceGain, saturationGain, kotopogoda::ColorLut::kSize65);
+}
 
-    jobject payload = env->NewObject(
-        telemetryClass,
-        ctor,
-        success ? JNI_TRUE : JNI_FALSE,
-        static_cast<jlong>(telemetry.timingMs),
-        telemetry.usedVulkan ? JNI_TRUE : JNI_FALSE,
-        static_cast<jlong>(telemetry.peakMemoryKb),
-        telemetry.cancelled ? JNI_TRUE : JNI_FALSE,
-        telemetry.fallbackUsed ? JNI_TRUE : JNI_FALSE,
-        static_cast<jint>(telemetry.fallbackCause),
-        static_cast<jlong>(telemetry.durationMsVulkan),
-        static_cast<jlong>(telemetry.durationMsCpu),
-        telemetry.tileTelemetry.tileUsed ? JNI_TRUE : JNI_FALSE,
-        static_cast<jint>(telemetry.tileTelemetry.tileSize),
-        static_cast<jint>(telemetry.tileTelemetry.overlap),
-        static_cast<jint>(telemetry.tileTelemetry.totalTiles),
-        static_cast<jint>(telemetry.tileTelemetry.processedTiles),
-        telemetry.seamMaxDelta,
-        telemetry.seamMeanDelta,
-        static_cast<jint>(telemetry.gpuAllocRetryCount),
-        delegateUsed,
-        restPrecision
-    );
+// Стадии пакета. JPEG декодируется нативно сразу в рабочем разрешении сети
+// (DCT-масштабирование), а результат кодируется нативно полосами с переносом
+// EXIF источника. Остальные форматы декодирует и кодирует Kotlin
+// (NativeBatchCodec), который натив вызывает из потоков пайплайна.
+kotopogoda::BatchStages jniBatchStages(
+    kotopogoda::NcnnEngine* engine,
+    const std::shared_ptr<JobRefs>& refs,
+    std::shared_ptr<const std::vector<std::string>> inputs,
+    std::shared_ptr<const std::vector<std::string>> outputs,
+    float strength,
+    void* itemsAddress,
+    size_t itemsCapacity
+) {
+    kotopogoda::BatchStages stages;
+    stages.decode = [refs, inputs](kotopogoda::BatchFrame& frame) {
+        const char* inputPath = (*inputs)[frame.index].c_str();
+        kotopogoda::JpegImageInfo info;
+        if (kotopogoda::readJpegInfo(inputPath, kotopogoda::kZeroDceMaxSide, info) &&
+            kotopogoda::decodeJpegPlanar(inputPath, info.scaleDenom, frame.image)) {
+            frame.width = info.width;
+            frame.height = info.height;
+            return true;
+        }
+        JNIEnv* env = kotopogoda::currentJniEnv();
+        if (env == nullptr) {
+            return false;
+        }
+        jstring path = env->NewStringUTF((*inputs)[frame.index].c_str());
+        jobject bitmap = env->CallObjectMethod(refs->batchCodec, kotopogoda::jniCache().batchDecode, path);
+        env->DeleteLocalRef(path);
+        if (env->ExceptionCheck()) {
+            LOGE("Исключение в NativeBatchCodec.decode для элемента %zu", frame.index);
+            env->ExceptionClear();
+            return false;
+        }
+        if (bitmap == nullptr) {
+            return false;
+        }
+        kotopogoda::bitmapToMat(env, bitmap, frame.image);
+        frame.codecState = globalBitmapRef(env, bitmap);
+        env->DeleteLocalRef(bitmap);
+        return true;
+    };
+    stages.infer = [engine, strength](
+        const kotopogoda::BatchFrame& frame,
+        ncnn::Mat& output,
+        kotopogoda::RunContext& context
+    ) {
+        kotopogoda::MatCharge inputCharge(context.memory(), frame.image);
+        return engine->enhanceReduced(frame.image, strength, output, context);
+    };
+    stages.encode = [refs, inputs, outputs](kotopogoda::BatchFrame& frame) {
+        // Нативно декодированный JPEG сразу пишется в файл полосами.
+        jobject bitmap = static_cast<jobject>(frame.codecState.get());
+        if (bitmap == nullptr) {
+            std::vector<uint8_t> exif;
+            kotopogoda::readJpegExif((*inputs)[frame.index].c_str(), exif);
+            return kotopogoda::writeJpegFile(
+                (*outputs)[frame.index].c_str(),
+                frame.image,
+                frame.width,
+                frame.height,
+                kJpegQuality,
+                std::move(exif),
+                nullptr,
+                &frame.imageStats
+            );
+        }
+
+        // Источник, декодированный в Kotlin, отдаёт свой Bitmap под результат.
+        JNIEnv* env = kotopogoda::currentJniEnv();
+        if (env == nullptr) {
+            return false;
+        }
+        if (frame.image.w != frame.width || frame.image.h != frame.height) {
+            ncnn::Mat upscaled;
+            ncnn::resize_bilinear(frame.image, upscaled, frame.width, frame.height);
+            frame.image = upscaled;
+        }
+        kotopogoda::matToBitmap(env, frame.image, bitmap, &frame.imageStats);
+        jstring inputPath = env->NewStringUTF((*inputs)[frame.index].c_str());
+        jstring outputPath = env->NewStringUTF((*outputs)[frame.index].c_str());
+        const jboolean encoded = env->CallBooleanMethod(
+            refs->batchCodec,
+            kotopogoda::jniCache().batchEncode,
+            bitmap,
+            inputPath,
+            outputPath
+        );
+        env->DeleteLocalRef(inputPath);
+        env->DeleteLocalRef(outputPath);
+        const bool failed = env->ExceptionCheck();
+        if (failed) {
+            LOGE("Исключение в NativeBatchCodec.encode для элемента %zu", frame.index);
+            env->ExceptionClear();
+        }
+        return !failed && encoded == JNI_TRUE;
+    };
+    stages.onStageThreadStart = []() {
+        JavaVM* vm = kotopogoda::jniCache().vm;
+        JNIEnv* env = nullptr;
+        JavaVMAttachArgs args{JNI_VERSION_1_6, "kotopogoda-batch", nullptr};
+        if (vm == nullptr || vm->AttachCurrentThread(&env, &args) != JNI_OK) {
+            LOGE("Не удалось прикрепить поток пакета к JavaVM");
+        }
+    };
+    stages.onStageThreadStop = []() {
+        if (kotopogoda::currentJniEnv() != nullptr) {
+            kotopogoda::jniCache().vm->DetachCurrentThread();
+        }
+    };
+    stages.onItemFinished = [refs, itemsAddress, itemsCapacity](
+        size_t index,
+        const kotopogoda::BatchItemResult& result
+    ) {
+        kotopogoda::TraceScope trace("jni_on_batch_item_finished", static_cast<int>(index));
+        kotopogoda::writeBatchItemRecord(itemsAddress, itemsCapacity, index, result);
+        JNIEnv* env = kotopogoda::currentJniEnv();
+        if (env == nullptr || refs->batchListener == nullptr) {
+            return;
+        }
+        env->CallVoidMethod(
+            refs->batchListener,
+            kotopogoda::jniCache().onBatchItemFinished,
+            static_cast<jint>(index),
+            static_cast<jint>(result.state)
+        );
+        if (env->ExceptionCheck()) {
+            LOGE("Исключение в onItemFinished для элемента %zu", index);
+            env->ExceptionClear();
+        }
+    };
+    return stages;
+}
+
+// Записывает телеметрию конечного состояния; для QUEUED/RUNNING/UNKNOWN буфер не трогается.
+jint finishJobQuery(
+    JNIEnv* env,
+    jobject telemetryBuffer,
+    kotopogoda::EnhanceJobState state,
+    const kotopogoda::EnhanceJobResult& result
+) {
+    if (kotopogoda::isTerminal(state)) {
+        jlong capacity = 0;
+        void* address = telemetryBufferAddress(env, telemetryBuffer, capacity);
+        if (address != nullptr) {
+            kotopogoda::writeTelemetryBuffer(
+                address,
+                static_cast<size_t>(capacity),
+                result.telemetry,
+                state == kotopogoda::EnhanceJobState::SUCCEEDED
+            );
+        }
+    }
+    return static_cast<jint>(state);
+}
 
-    env->DeleteLocalRef(delegateUsed);
-    env->DeleteLocalRef(restPrecision);
-    env->DeleteLocalRef(telemetryClass);
-    return payload;
+// Прогресс тайлов идёт через ProgressDispatcher: вычислительные потоки только
+// пишут события в кольцо, а в Kotlin их доставляет отдельный поток, прикреплённый
+// к JavaVM, не чаще maxRateHz раз в секунду на стадию. Деструктор дожидается
+// доставки последних событий, поэтому к возврату из JNI прогресс уже передан.
+class JniProgressChannel {
+public:
+    JniProgressChannel(JNIEnv* env, jobject callbackObj, jint maxRateHz)
+        : env_(env),
+          callback_(env->NewGlobalRef(callbackObj)) {
+        const kotopogoda::JniCache& cache = kotopogoda::jniCache();
+        JavaVM* vm = cache.vm;
+        const jobject callback = callback_;
+        const jmethodID onTileProgress = cache.onTileProgress;
+        auto threadEnv = std::make_shared<JNIEnv*>(nullptr);
+
+        kotopogoda::ProgressSink sink;
+        sink.onThreadStart = [vm, threadEnv]() {
+            JavaVMAttachArgs args{JNI_VERSION_1_6, "kotopogoda-progress", nullptr};
+            if (vm->AttachCurrentThread(threadEnv.get(), &args) != JNI_OK) {
+                LOGE("Не удалось прикрепить поток прогресса к JavaVM");
+                *threadEnv = nullptr;
+            }
+        };
+        sink.deliver = [threadEnv, callback, onTileProgress](const kotopogoda::ProgressEvent& event) {
+            JNIEnv* env = *threadEnv;
+            if (env == nullptr) {
+                return;
+            }
+            jstring stageString = kotopogoda::cachedStageString(event.stage);
+            const bool ownsString = stageString == nullptr;
+            if (ownsString) {
+                stageString = env->NewStringUTF(event.stage != nullptr ? event.stage : "");
+            }
+            env->CallVoidMethod(callback, onTileProgress, stageString, event.current, event.total);
+            if (env->ExceptionCheck()) {
+                // Пробросить исключение из потока диспетчера некуда.
+                LOGE("Исключение в onTileProgress, событие пропущено");
+                env->ExceptionClear();
+            }
+            if (ownsString) {
+                env->DeleteLocalRef(stageString);
+            }
+        };
+        sink.onThreadStop = [vm, threadEnv]() {
+            if (*threadEnv != nullptr) {
+                vm->DetachCurrentThread();
+            }
+        };
+        dispatcher_.reset(new kotopogoda::ProgressDispatcher(std::move(sink), static_cast<int>(maxRateHz)));
+    }
+
+    ~JniProgressChannel() {
+        dispatcher_.reset();
+        env_->DeleteGlobalRef(callback_);
+    }
+
+    JniProgressChannel(const JniProgressChannel&) = delete;
+    JniProgressChannel& operator=(const JniProgressChannel&) = delete;
+
+    kotopogoda::TileProgressCallback callback() {
+        return dispatcher_->asCallback();
+    }
+
+private:
+    JNIEnv* env_;
+    jobject callback_;
+    std::unique_ptr<kotopogoda::ProgressDispatcher> dispatcher_;
+};
+
+// Адрес прямого ByteBuffer для телеметрии; nullptr, если буфер не прямой или мал.
+void* telemetryBufferAddress(JNIEnv* env, jobject telemetryBuffer, jlong& capacity) {
+    if (telemetryBuffer == nullptr) {
+        return nullptr;
+    }
+    void* address = env->GetDirectBufferAddress(telemetryBuffer);
+    capacity = env->GetDirectBufferCapacity(telemetryBuffer);
+    if (address == nullptr || capacity < static_cast<jlong>(kotopogoda::telemetry_layout::kSize)) {
+        LOGE("Буфер телеметрии не прямой или меньше %zu байт", kotopogoda::telemetry_layout::kSize);
+        return nullptr;
+    }
+    return address;
 }
 
 }
@@ -95,9 +463,12 @@ Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nati
     jstring restormerParamChecksum,
     jstring restormerBinChecksum,
     jint previewProfile,
-    jboolean forceCpu
+    jboolean forceCpu,
+    jbyteArray ledgerKey,
+    jlong reverifyIntervalSec
 ) {
     LOGI("nativeInit вызван");
+    TRACE_SCOPE("jni_init");
     
     const char* modelsDirStr = env->GetStringUTFChars(modelsDir, nullptr);
     const char* zeroDceParamChecksumStr = env->GetStringUTFChars(zeroDceParamChecksum, nullptr);
@@ -107,11 +478,26 @@ Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nati
     
     AAssetManager* mgr = AAssetManager_fromJava(env, assetManager);
     
-    auto* engine = new kotopogoda::NcnnEngine();
+    auto engine = std::make_unique<kotopogoda::NcnnEngine>();
     
     kotopogoda::PreviewProfile profile = previewProfile == 1 
         ? kotopogoda::PreviewProfile::QUALITY 
         : kotopogoda::PreviewProfile::BALANCED;
+
+    kotopogoda::VerificationPolicy verificationPolicy;
+    verificationPolicy.reverifyIntervalSec = static_cast<int64_t>(reverifyIntervalSec);
+    if (ledgerKey != nullptr) {
+        const jsize keyLength = env->GetArrayLength(ledgerKey);
+        verificationPolicy.ledgerKey.resize(static_cast<size_t>(keyLength));
+        if (keyLength > 0) {
+            env->GetByteArrayRegion(
+                ledgerKey,
+                0,
+                keyLength,
+                reinterpret_cast<jbyte*>(verificationPolicy.ledgerKey.data())
+            );
+        }
+    }
     
     bool success = engine->initialize(
         mgr,
@@ -119,9 +505,12 @@ Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nati
         { std::string(zeroDceParamChecksumStr), std::string(zeroDceBinChecksumStr) },
         { std::string(restormerParamChecksumStr), std::string(restormerBinChecksumStr) },
         profile,
-        forceCpu == JNI_TRUE
+        forceCpu == JNI_TRUE,
+        verificationPolicy
     );
 
+    std::fill(verificationPolicy.ledgerKey.begin(), verificationPolicy.ledgerKey.end(), 0);
+
     env->ReleaseStringUTFChars(modelsDir, modelsDirStr);
     env->ReleaseStringUTFChars(zeroDceParamChecksum, zeroDceParamChecksumStr);
     env->ReleaseStringUTFChars(zeroDceBinChecksum, zeroDceBinChecksumStr);
@@ -130,147 +519,683 @@ Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nati
     
     if (!success) {
         LOGE("Не удалось инициализировать движок");
-        delete engine;
         return 0;
     }
+
+    auto slot = std::make_shared<EngineSlot>();
+    slot->engine = std::move(engine);
+    slot->queue = std::make_unique<kotopogoda::EnhanceJobQueue>(jvmAttachedHooks(), kQueueWorkers);
     
     std::lock_guard<std::mutex> lock(g_enginesMutex);
     jlong handle = g_nextHandle++;
-    g_engines[handle] = engine;
+    g_engines[handle] = std::move(slot);
     
     LOGI("Движок инициализирован с handle=%lld", (long long)handle);
     
     return handle;
 }
 
-JNIEXPORT jobject JNICALL
-Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeRunPreview(
+JNIEXPORT jlong JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeSubmitPreview(
     JNIEnv* env,
     jobject thiz,
     jlong handle,
     jobject bitmap,
     jfloat strength,
-    jobject progressCallbackObj
+    jfloat vibranceGain,
+    jfloat saturationGain,
+    jstring photoKey,
+    jint priority,
+    jobject progressCallbackObj,
+    jint progressMaxRateHz,
+    jobject completion
 ) {
-    LOGI("nativeRunPreview вызван: handle=%lld, strength=%.2f", (long long)handle, strength);
-    
-    kotopogoda::NcnnEngine* engine = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(g_enginesMutex);
-        auto it = g_engines.find(handle);
-        if (it == g_engines.end()) {
-            LOGE("Недействительный handle: %lld", (long long)handle);
-            return nullptr;
+    std::shared_ptr<EngineSlot> slot = findEngine(handle);
+    if (!slot) {
+        return 0;
+    }
+
+    kotopogoda::EnhanceJob job;
+    job.kind = kotopogoda::EnhanceJobKind::PREVIEW;
+    job.priority = static_cast<int>(priority);
+    if (photoKey != nullptr) {
+        const char* photoKeyStr = env->GetStringUTFChars(photoKey, nullptr);
+        job.photoKey = photoKeyStr;
+        env->ReleaseStringUTFChars(photoKey, photoKeyStr);
+    }
+
+    auto refs = JobRefs::create(env, bitmap, nullptr, progressCallbackObj, completion);
+    kotopogoda::NcnnEngine* engine = slot->engine.get();
+    auto colorLut = profileColorLut(vibranceGain, saturationGain);
+    job.run = [engine, refs, strength, colorLut, progressMaxRateHz](
+        std::atomic<bool>& cancelFlag,
+        kotopogoda::TelemetryData& telemetry
+    ) {
+        TRACE_SCOPE("jni_preview");
+        JNIEnv* jobEnv = kotopogoda::currentJniEnv();
+        if (jobEnv == nullptr) {
+            return false;
         }
-        engine = it->second;
+        LOGI("Превью: старт задачи, strength=%.2f", strength);
+        std::unique_ptr<JniProgressChannel> progressChannel;
+        kotopogoda::TileProgressCallback tileProgressCallback;
+        if (refs->progressCallback != nullptr) {
+            progressChannel.reset(new JniProgressChannel(jobEnv, refs->progressCallback, progressMaxRateHz));
+            tileProgressCallback = progressChannel->callback();
+        }
+        kotopogoda::RunContext context(cancelFlag, telemetry, tileProgressCallback);
+        context.setColorLut(colorLut);
+        const bool success = engine->runPreview(jobEnv, refs->sourceBitmap, strength, context);
+        progressChannel.reset();
+        LOGI("Превью завершено: success=%d, timing=%ldms", success, telemetry.timingMs);
+        return success;
+    };
+
+    const jlong jobId = submitJob(slot, std::move(job), refs);
+    LOGI("nativeSubmitPreview: handle=%lld job=%lld priority=%d",
+         (long long)handle, (long long)jobId, static_cast<int>(priority));
+    return jobId;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeReadJpegInfo(
+    JNIEnv* env,
+    jobject thiz,
+    jstring path,
+    jint maxSide,
+    jintArray outInfo
+) {
+    if (path == nullptr || outInfo == nullptr || env->GetArrayLength(outInfo) < 5) {
+        return JNI_FALSE;
     }
+    const char* pathStr = env->GetStringUTFChars(path, nullptr);
+    kotopogoda::JpegImageInfo info;
+    const bool ok = kotopogoda::readJpegInfo(pathStr, static_cast<int>(maxSide), info);
+    env->ReleaseStringUTFChars(path, pathStr);
+    if (!ok) {
+        return JNI_FALSE;
+    }
+    const jint values[5] = {
+        info.width,
+        info.height,
+        info.scaleDenom,
+        info.scaledWidth,
+        info.scaledHeight,
+    };
+    env->SetIntArrayRegion(outInfo, 0, 5, values);
+    return JNI_TRUE;
+}
 
-    kotopogoda::TileProgressCallback tileProgressCallback;
-    jobject progressGlobal = nullptr;
-    jmethodID onTileProgressMethod = nullptr;
+JNIEXPORT jboolean JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeComputeJpegStats(
+    JNIEnv* env,
+    jobject thiz,
+    jstring path,
+    jint maxSide,
+    jintArray outInfo,
+    jfloatArray outStats
+) {
+    if (path == nullptr || outInfo == nullptr || outStats == nullptr ||
+        env->GetArrayLength(outInfo) < 5 || env->GetArrayLength(outStats) < 4) {
+        return JNI_FALSE;
+    }
+    const char* pathStr = env->GetStringUTFChars(path, nullptr);
+    kotopogoda::JpegImageInfo info;
+    kotopogoda::ImageStats stats;
+    const bool ok = kotopogoda::computeJpegImageStats(pathStr, static_cast<int>(maxSide), info, stats);
+    env->ReleaseStringUTFChars(path, pathStr);
+    if (!ok) {
+        return JNI_FALSE;
+    }
+    const jint infoValues[5] = {
+        info.width,
+        info.height,
+        info.scaleDenom,
+        info.scaledWidth,
+        info.scaledHeight,
+    };
+    const jfloat statsValues[4] = {
+        stats.lumaMean,
+        stats.darkShare,
+        stats.sharpness,
+        stats.noise,
+    };
+    env->SetIntArrayRegion(outInfo, 0, 5, infoValues);
+    env->SetFloatArrayRegion(outStats, 0, 4, statsValues);
+    return JNI_TRUE;
+}
 
-    if (progressCallbackObj != nullptr) {
-        jclass callbackClass = env->GetObjectClass(progressCallbackObj);
-        if (callbackClass != nullptr) {
-            onTileProgressMethod = env->GetMethodID(
-                callbackClass,
-                "onTileProgress",
-                "(Ljava/lang/String;II)V"
-            );
-            env->DeleteLocalRef(callbackClass);
-        }
-        if (onTileProgressMethod != nullptr) {
-            progressGlobal = env->NewGlobalRef(progressCallbackObj);
-            JNIEnv* threadEnv = env;
-            tileProgressCallback = [threadEnv, progressGlobal, onTileProgressMethod](const char* stage, int completed, int total) {
-                if (progressGlobal == nullptr) {
-                    return;
-                }
-                jstring stageString = threadEnv->NewStringUTF(stage != nullptr ? stage : "");
-                threadEnv->CallVoidMethod(progressGlobal, onTileProgressMethod, stageString, completed, total);
-                threadEnv->DeleteLocalRef(stageString);
-            };
+JNIEXPORT jlong JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeSubmitPreviewJpeg(
+    JNIEnv* env,
+    jobject thiz,
+    jlong handle,
+    jstring path,
+    jint scaleDenom,
+    jobject outputBitmap,
+    jfloat strength,
+    jfloat vibranceGain,
+    jfloat saturationGain,
+    jstring photoKey,
+    jint priority,
+    jobject progressCallbackObj,
+    jint progressMaxRateHz,
+    jobject completion
+) {
+    std::shared_ptr<EngineSlot> slot = findEngine(handle);
+    if (!slot || path == nullptr || outputBitmap == nullptr) {
+        return 0;
+    }
+
+    kotopogoda::EnhanceJob job;
+    job.kind = kotopogoda::EnhanceJobKind::PREVIEW;
+    job.priority = static_cast<int>(priority);
+    if (photoKey != nullptr) {
+        const char* photoKeyStr = env->GetStringUTFChars(photoKey, nullptr);
+        job.photoKey = photoKeyStr;
+        env->ReleaseStringUTFChars(photoKey, photoKeyStr);
+    }
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    std::string sourcePath(pathChars);
+    env->ReleaseStringUTFChars(path, pathChars);
+
+    auto refs = JobRefs::create(env, nullptr, outputBitmap, progressCallbackObj, completion);
+    kotopogoda::NcnnEngine* engine = slot->engine.get();
+    auto colorLut = profileColorLut(vibranceGain, saturationGain);
+    job.run = [engine, refs, sourcePath, scaleDenom, strength, colorLut, progressMaxRateHz](
+        std::atomic<bool>& cancelFlag,
+        kotopogoda::TelemetryData& telemetry
+    ) {
+        TRACE_SCOPE("jni_preview_jpeg");
+        JNIEnv* jobEnv = kotopogoda::currentJniEnv();
+        if (jobEnv == nullptr) {
+            return false;
+        }
+        LOGI("Превью JPEG: старт задачи, 1/%d, strength=%.2f", static_cast<int>(scaleDenom), strength);
+        std::unique_ptr<JniProgressChannel> progressChannel;
+        kotopogoda::TileProgressCallback tileProgressCallback;
+        if (refs->progressCallback != nullptr) {
+            progressChannel.reset(new JniProgressChannel(jobEnv, refs->progressCallback, progressMaxRateHz));
+            tileProgressCallback = progressChannel->callback();
+        }
+        kotopogoda::RunContext context(cancelFlag, telemetry, tileProgressCallback);
+        context.setColorLut(colorLut);
+        context.beginStage(kotopogoda::PipelineStage::CONVERT_IN);
+        ncnn::Mat input;
+        if (!kotopogoda::decodeJpegPlanar(sourcePath.c_str(), static_cast<int>(scaleDenom), input, &cancelFlag)) {
+            return false;
         }
+        kotopogoda::MatCharge inputCharge(context.memory(), input);
+        const bool success = engine->runPreview(jobEnv, input, strength, refs->outputBitmap, context);
+        progressChannel.reset();
+        LOGI("Превью JPEG завершено: success=%d, timing=%ldms", success, telemetry.timingMs);
+        return success;
+    };
+
+    const jlong jobId = submitJob(slot, std::move(job), refs);
+    LOGI("nativeSubmitPreviewJpeg: handle=%lld job=%lld priority=%d",
+         (long long)handle, (long long)jobId, static_cast<int>(priority));
+    return jobId;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeSubmitProgressivePreviewJpeg(
+    JNIEnv* env,
+    jobject thiz,
+    jlong handle,
+    jstring path,
+    jintArray scaleDenoms,
+    jobjectArray outputBitmaps,
+    jfloat strength,
+    jfloat vibranceGain,
+    jfloat saturationGain,
+    jstring photoKey,
+    jint priority,
+    jobject progressCallbackObj,
+    jint progressMaxRateHz,
+    jobject levelListener,
+    jobject completion
+) {
+    std::shared_ptr<EngineSlot> slot = findEngine(handle);
+    if (!slot || path == nullptr || scaleDenoms == nullptr || outputBitmaps == nullptr) {
+        return 0;
     }
-    
-    kotopogoda::TelemetryData telemetry;
-    bool success = engine->runPreview(env, bitmap, strength, telemetry, tileProgressCallback);
-    
-    jobject payload = buildTelemetryPayload(env, telemetry, success);
+    const jsize levelCount = env->GetArrayLength(scaleDenoms);
+    if (levelCount <= 0 || env->GetArrayLength(outputBitmaps) != levelCount) {
+        LOGE("nativeSubmitProgressivePreviewJpeg: уровни и Bitmap не совпадают");
+        return 0;
+    }
+    std::vector<jint> levels(static_cast<size_t>(levelCount));
+    env->GetIntArrayRegion(scaleDenoms, 0, levelCount, levels.data());
 
-    if (progressGlobal != nullptr) {
-        env->DeleteGlobalRef(progressGlobal);
+    kotopogoda::EnhanceJob job;
+    job.kind = kotopogoda::EnhanceJobKind::PREVIEW;
+    job.priority = static_cast<int>(priority);
+    if (photoKey != nullptr) {
+        const char* photoKeyStr = env->GetStringUTFChars(photoKey, nullptr);
+        job.photoKey = photoKeyStr;
+        env->ReleaseStringUTFChars(photoKey, photoKeyStr);
     }
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    std::string sourcePath(pathChars);
+    env->ReleaseStringUTFChars(path, pathChars);
+
+    auto refs = JobRefs::create(env, nullptr, nullptr, progressCallbackObj, completion);
+    refs->previewBitmaps = env->NewGlobalRef(outputBitmaps);
+    refs->previewListener = levelListener != nullptr ? env->NewGlobalRef(levelListener) : nullptr;
+    kotopogoda::NcnnEngine* engine = slot->engine.get();
+    auto colorLut = profileColorLut(vibranceGain, saturationGain);
+    job.run = [engine, refs, sourcePath, levels, strength, colorLut, progressMaxRateHz](
+        std::atomic<bool>& cancelFlag,
+        kotopogoda::TelemetryData& telemetry
+    ) {
+        TRACE_SCOPE("jni_progressive_preview_jpeg");
+        JNIEnv* jobEnv = kotopogoda::currentJniEnv();
+        if (jobEnv == nullptr) {
+            return false;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        std::unique_ptr<JniProgressChannel> progressChannel;
+        kotopogoda::TileProgressCallback tileProgressCallback;
+        if (refs->progressCallback != nullptr) {
+            progressChannel.reset(new JniProgressChannel(jobEnv, refs->progressCallback, progressMaxRateHz));
+            tileProgressCallback = progressChannel->callback();
+        }
+        kotopogoda::RunContext context(cancelFlag, telemetry, tileProgressCallback);
+        context.setColorLut(colorLut);
+        auto bitmaps = static_cast<jobjectArray>(refs->previewBitmaps);
 
-    LOGI("nativeRunPreview завершен: success=%d, timing=%ldms", success, telemetry.timingMs);
+        // От грубого к точному; вытеснение превью этого фото выставляет флаг
+        // отмены, и следующий уровень уже не начинается.
+        for (size_t level = 0; level < levels.size(); ++level) {
+            if (cancelFlag.load()) {
+                LOGI("Прогрессивное превью: остановлено перед уровнем %zu", level);
+                return false;
+            }
+            context.beginStage(kotopogoda::PipelineStage::CONVERT_IN);
+            ncnn::Mat input;
+            if (!kotopogoda::decodeJpegPlanar(sourcePath.c_str(), static_cast<int>(levels[level]), input, &cancelFlag)) {
+                return false;
+            }
+            kotopogoda::MatCharge inputCharge(context.memory(), input);
+            jobject bitmap = jobEnv->GetObjectArrayElement(bitmaps, static_cast<jsize>(level));
+            const bool success = engine->runPreview(jobEnv, input, strength, bitmap, context);
+            jobEnv->DeleteLocalRef(bitmap);
+            if (!success) {
+                return false;
+            }
+            LOGI("Прогрессивное превью: уровень %zu (1/%d, %dx%d) готов через %lldмс",
+                 level,
+                 static_cast<int>(levels[level]),
+                 input.w,
+                 input.h,
+                 static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start
+                 ).count()));
+            if (refs->previewListener != nullptr) {
+                jobEnv->CallVoidMethod(
+                    refs->previewListener,
+                    kotopogoda::jniCache().onPreviewLevelReady,
+                    static_cast<jint>(level)
+                );
+                if (jobEnv->ExceptionCheck()) {
+                    LOGE("Исключение в onLevelReady для уровня %zu", level);
+                    jobEnv->ExceptionClear();
+                }
+            }
+        }
+        progressChannel.reset();
+        return true;
+    };
 
-    return payload;
+    const jlong jobId = submitJob(slot, std::move(job), refs);
+    LOGI("nativeSubmitProgressivePreviewJpeg: handle=%lld job=%lld levels=%d priority=%d",
+         (long long)handle, (long long)jobId, static_cast<int>(levelCount), static_cast<int>(priority));
+    return jobId;
 }
 
-JNIEXPORT jobject JNICALL
-Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeRunFull(
+JNIEXPORT jlong JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeSubmitFull(
     JNIEnv* env,
     jobject thiz,
     jlong handle,
     jobject sourceBitmap,
     jfloat strength,
+    jfloat vibranceGain,
+    jfloat saturationGain,
     jobject outputBitmap,
-    jobject progressCallbackObj
+    jint priority,
+    jobject progressCallbackObj,
+    jint progressMaxRateHz,
+    jobject completion
 ) {
-    LOGI("nativeRunFull вызван: handle=%lld, strength=%.2f", (long long)handle, strength);
-    
-    kotopogoda::NcnnEngine* engine = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(g_enginesMutex);
-        auto it = g_engines.find(handle);
-        if (it == g_engines.end()) {
-            LOGE("Недействительный handle: %lld", (long long)handle);
-            return nullptr;
+    std::shared_ptr<EngineSlot> slot = findEngine(handle);
+    if (!slot) {
+        return 0;
+    }
+
+    kotopogoda::EnhanceJob job;
+    job.kind = kotopogoda::EnhanceJobKind::FULL;
+    job.priority = static_cast<int>(priority);
+
+    auto refs = JobRefs::create(env, sourceBitmap, outputBitmap, progressCallbackObj, completion);
+    kotopogoda::NcnnEngine* engine = slot->engine.get();
+    auto colorLut = profileColorLut(vibranceGain, saturationGain);
+    job.run = [engine, refs, strength, colorLut, progressMaxRateHz](
+        std::atomic<bool>& cancelFlag,
+        kotopogoda::TelemetryData& telemetry
+    ) {
+        TRACE_SCOPE("jni_full");
+        JNIEnv* jobEnv = kotopogoda::currentJniEnv();
+        if (jobEnv == nullptr) {
+            return false;
+        }
+        LOGI("Полная обработка: старт задачи, strength=%.2f", strength);
+        std::unique_ptr<JniProgressChannel> progressChannel;
+        kotopogoda::TileProgressCallback tileProgressCallback;
+        if (refs->progressCallback != nullptr) {
+            progressChannel.reset(new JniProgressChannel(jobEnv, refs->progressCallback, progressMaxRateHz));
+            tileProgressCallback = progressChannel->callback();
         }
-        engine = it->second;
+        kotopogoda::RunContext context(cancelFlag, telemetry, tileProgressCallback);
+        context.setColorLut(colorLut);
+        const bool success = engine->runFull(jobEnv, refs->sourceBitmap, strength, refs->outputBitmap, context);
+        progressChannel.reset();
+        LOGI("Полная обработка завершена: success=%d, timing=%ldms, cancelled=%d",
+             success, telemetry.timingMs, cancelFlag.load());
+        return success;
+    };
+
+    const jlong jobId = submitJob(slot, std::move(job), refs);
+    LOGI("nativeSubmitFull: handle=%lld job=%lld priority=%d",
+         (long long)handle, (long long)jobId, static_cast<int>(priority));
+    return jobId;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeSubmitFullJpeg(
+    JNIEnv* env,
+    jobject thiz,
+    jlong handle,
+    jstring inputPath,
+    jstring outputPath,
+    jint quality,
+    jfloat strength,
+    jfloat vibranceGain,
+    jfloat saturationGain,
+    jint priority,
+    jobject progressCallbackObj,
+    jint progressMaxRateHz,
+    jobject completion
+) {
+    std::shared_ptr<EngineSlot> slot = findEngine(handle);
+    if (!slot || inputPath == nullptr || outputPath == nullptr) {
+        return 0;
     }
 
-    kotopogoda::TileProgressCallback tileProgressCallback;
-    jobject progressGlobal = nullptr;
-    jmethodID onTileProgressMethod = nullptr;
+    kotopogoda::EnhanceJob job;
+    job.kind = kotopogoda::EnhanceJobKind::FULL;
+    job.priority = static_cast<int>(priority);
+    const char* inputChars = env->GetStringUTFChars(inputPath, nullptr);
+    std::string sourcePath(inputChars);
+    env->ReleaseStringUTFChars(inputPath, inputChars);
+    const char* outputChars = env->GetStringUTFChars(outputPath, nullptr);
+    std::string targetPath(outputChars);
+    env->ReleaseStringUTFChars(outputPath, outputChars);
+
+    auto refs = JobRefs::create(env, nullptr, nullptr, progressCallbackObj, completion);
+    kotopogoda::NcnnEngine* engine = slot->engine.get();
+    auto colorLut = profileColorLut(vibranceGain, saturationGain);
+    job.run = [engine, refs, sourcePath, targetPath, quality, strength, colorLut, progressMaxRateHz](
+        std::atomic<bool>& cancelFlag,
+        kotopogoda::TelemetryData& telemetry
+    ) {
+        TRACE_SCOPE("jni_full_jpeg");
+        JNIEnv* jobEnv = kotopogoda::currentJniEnv();
+        if (jobEnv == nullptr) {
+            return false;
+        }
+        std::unique_ptr<JniProgressChannel> progressChannel;
+        kotopogoda::TileProgressCallback tileProgressCallback;
+        if (refs->progressCallback != nullptr) {
+            progressChannel.reset(new JniProgressChannel(jobEnv, refs->progressCallback, progressMaxRateHz));
+            tileProgressCallback = progressChannel->callback();
+        }
+        kotopogoda::RunContext context(cancelFlag, telemetry, tileProgressCallback);
+        context.setColorLut(colorLut);
+        kotopogoda::MemoryTracker& memory = context.memory();
 
-    if (progressCallbackObj != nullptr) {
-        jclass callbackClass = env->GetObjectClass(progressCallbackObj);
-        if (callbackClass != nullptr) {
-            onTileProgressMethod = env->GetMethodID(
-                callbackClass,
-                "onTileProgress",
-                "(Ljava/lang/String;II)V"
+        // Декодируем сразу в рабочем разрешении сети: полноразмерными не бывают
+        // ни вход, ни результат — он увеличивается полосами прямо в кодировщик.
+        kotopogoda::JpegImageInfo info;
+        ncnn::Mat reduced;
+        bool success;
+        {
+            context.beginStage(kotopogoda::PipelineStage::CONVERT_IN);
+            ncnn::Mat input;
+            if (!kotopogoda::readJpegInfo(sourcePath.c_str(), kotopogoda::kZeroDceMaxSide, info) ||
+                !kotopogoda::decodeJpegPlanar(sourcePath.c_str(), info.scaleDenom, input, &cancelFlag)) {
+                return false;
+            }
+            kotopogoda::MatCharge inputCharge(memory, input);
+            LOGI("Полная обработка JPEG: старт задачи, %dx%d (1/%d), strength=%.2f",
+                 info.width, info.height, info.scaleDenom, strength);
+            success = engine->enhanceReduced(input, strength, reduced, context);
+        }
+        progressChannel.reset();
+        kotopogoda::MatCharge reducedCharge(memory, reduced);
+        if (success) {
+            context.beginStage(kotopogoda::PipelineStage::CONVERT_OUT);
+            std::vector<uint8_t> exif;
+            kotopogoda::readJpegExif(sourcePath.c_str(), exif);
+            success = kotopogoda::writeJpegFile(
+                targetPath.c_str(),
+                reduced,
+                info.width,
+                info.height,
+                static_cast<int>(quality),
+                std::move(exif),
+                &cancelFlag,
+                &telemetry.imageStats,
+                context.colorLut()
             );
-            env->DeleteLocalRef(callbackClass);
-        }
-        if (onTileProgressMethod != nullptr) {
-            progressGlobal = env->NewGlobalRef(progressCallbackObj);
-            JNIEnv* threadEnv = env;
-            tileProgressCallback = [threadEnv, progressGlobal, onTileProgressMethod](const char* stage, int completed, int total) {
-                if (progressGlobal == nullptr) {
-                    return;
-                }
-                jstring stageString = threadEnv->NewStringUTF(stage != nullptr ? stage : "");
-                threadEnv->CallVoidMethod(progressGlobal, onTileProgressMethod, stageString, completed, total);
-                threadEnv->DeleteLocalRef(stageString);
-            };
+            context.endStage();
         }
+        LOGI("Полная обработка JPEG завершена: success=%d, timing=%ldms, cancelled=%d",
+             success, telemetry.timingMs, cancelFlag.load());
+        return success;
+    };
+
+    const jlong jobId = submitJob(slot, std::move(job), refs);
+    LOGI("nativeSubmitFullJpeg: handle=%lld job=%lld priority=%d",
+         (long long)handle, (long long)jobId, static_cast<int>(priority));
+    return jobId;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeSubmitBatch(
+    JNIEnv* env,
+    jobject thiz,
+    jlong handle,
+    jobjectArray inputPaths,
+    jobjectArray outputPaths,
+    jfloat strength,
+    jint priority,
+    jobject codec,
+    jobject listener,
+    jobject itemsBuffer,
+    jobject completion
+) {
+    std::shared_ptr<EngineSlot> slot = findEngine(handle);
+    if (!slot) {
+        return 0;
     }
-    
-    kotopogoda::TelemetryData telemetry;
-    bool success = engine->runFull(env, sourceBitmap, strength, outputBitmap, telemetry, tileProgressCallback);
-    
-    jobject payload = buildTelemetryPayload(env, telemetry, success);
 
-    if (progressGlobal != nullptr) {
-        env->DeleteGlobalRef(progressGlobal);
+    auto inputs = std::make_shared<std::vector<std::string>>();
+    auto outputs = std::make_shared<std::vector<std::string>>();
+    if (!readStringArray(env, inputPaths, *inputs) ||
+        !readStringArray(env, outputPaths, *outputs) ||
+        inputs->size() != outputs->size() ||
+        inputs->empty() ||
+        codec == nullptr) {
+        LOGE("nativeSubmitBatch: некорректные аргументы пакета");
+        return 0;
+    }
+
+    jlong itemsCapacity = 0;
+    void* itemsAddress = telemetryBufferAddress(env, itemsBuffer, itemsCapacity);
+    if (itemsAddress == nullptr ||
+        static_cast<size_t>(itemsCapacity) < inputs->size() * kotopogoda::batch_item_layout::kSize) {
+        LOGE("nativeSubmitBatch: буфер элементов меньше %zu записей", inputs->size());
+        return 0;
+    }
+
+    auto refs = JobRefs::create(env, nullptr, nullptr, nullptr, completion);
+    refs->batchCodec = env->NewGlobalRef(codec);
+    refs->batchListener = listener != nullptr ? env->NewGlobalRef(listener) : nullptr;
+    refs->batchItems = env->NewGlobalRef(itemsBuffer);
+
+    const size_t itemCount = inputs->size();
+    auto pipeline = std::make_shared<kotopogoda::BatchPipeline>(
+        itemCount,
+        jniBatchStages(
+            slot->engine.get(),
+            refs,
+            inputs,
+            outputs,
+            strength,
+            itemsAddress,
+            static_cast<size_t>(itemsCapacity)
+        )
+    );
+
+    // Пакет — полноразмерная работа: идёт в очереди как FULL и не выполняется
+    // одновременно с другой полной обработкой.
+    kotopogoda::EnhanceJob job;
+    job.kind = kotopogoda::EnhanceJobKind::FULL;
+    job.priority = static_cast<int>(priority);
+    job.run = [pipeline](std::atomic<bool>& cancelFlag, kotopogoda::TelemetryData& telemetry) {
+        TRACE_SCOPE("jni_batch");
+        const bool success = pipeline->run(cancelFlag);
+        for (const kotopogoda::BatchItemResult& result : pipeline->results()) {
+            telemetry.timingMs += result.telemetry.timingMs;
+            telemetry.durationMsCpu += result.telemetry.durationMsCpu;
+            telemetry.peakMemoryKb = std::max(telemetry.peakMemoryKb, result.telemetry.peakMemoryKb);
+            const kotopogoda::TelemetryData::MemoryTelemetry& itemMemory = result.telemetry.memory;
+            for (int stage = 0; stage < kotopogoda::kPipelineStageCount; ++stage) {
+                telemetry.memory.stagePeakKb[stage] =
+                    std::max(telemetry.memory.stagePeakKb[stage], itemMemory.stagePeakKb[stage]);
+                telemetry.memory.stageRssKb[stage] =
+                    std::max(telemetry.memory.stageRssKb[stage], itemMemory.stageRssKb[stage]);
+            }
+            telemetry.memory.processPeakRssKb =
+                std::max(telemetry.memory.processPeakRssKb, itemMemory.processPeakRssKb);
+            // Итог пакета показывает состояние устойчивого режима после последнего вывода.
+            if (result.telemetry.sustained.enabled) {
+                telemetry.sustained = result.telemetry.sustained;
+            }
+        }
+        return success;
+    };
+
+    // Флаг задачи пайплайн видит только между стадиями; отмена задачи сразу
+    // отменяет и текущий элемент.
+    job.onCancel = [pipeline]() { pipeline->cancelAll(); };
+
+    EngineSlot* rawSlot = slot.get();
+    job.release = [refs]() { refs->release(); };
+    job.onFinished = [refs, rawSlot](int64_t jobId, kotopogoda::EnhanceJobState state) {
+        {
+            std::lock_guard<std::mutex> lock(rawSlot->batchesMutex);
+            rawSlot->batches.erase(static_cast<jlong>(jobId));
+        }
+        refs->notifyFinished(jobId, state);
+    };
+
+    // Регистрация под блокировкой: onFinished не может удалить запись раньше, чем она появится.
+    std::lock_guard<std::mutex> lock(slot->batchesMutex);
+    const jlong jobId = static_cast<jlong>(slot->queue->submit(std::move(job)));
+    if (jobId != 0) {
+        slot->batches[jobId] = pipeline;
+    }
+    LOGI("nativeSubmitBatch: handle=%lld job=%lld items=%zu",
+         (long long)handle, (long long)jobId, itemCount);
+    return jobId;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeCancelBatchItem(
+    JNIEnv* env,
+    jobject thiz,
+    jlong handle,
+    jlong jobId,
+    jint index
+) {
+    std::shared_ptr<EngineSlot> slot = findEngine(handle);
+    if (!slot || index < 0) {
+        return JNI_FALSE;
+    }
+    std::lock_guard<std::mutex> lock(slot->batchesMutex);
+    auto it = slot->batches.find(jobId);
+    if (it == slot->batches.end()) {
+        return JNI_FALSE;
+    }
+    LOGI("nativeCancelBatchItem: job=%lld index=%d", (long long)jobId, static_cast<int>(index));
+    return it->second->cancelItem(static_cast<size_t>(index)) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativePollJob(
+    JNIEnv* env,
+    jobject thiz,
+    jlong handle,
+    jlong jobId,
+    jobject telemetryBuffer
+) {
+    std::shared_ptr<EngineSlot> slot = findEngine(handle);
+    if (!slot) {
+        return static_cast<jint>(kotopogoda::EnhanceJobState::UNKNOWN);
     }
+    kotopogoda::EnhanceJobResult result;
+    const kotopogoda::EnhanceJobState state = slot->queue->poll(static_cast<int64_t>(jobId), &result);
+    return finishJobQuery(env, telemetryBuffer, state, result);
+}
 
-    LOGI("nativeRunFull завершен: success=%d, timing=%ldms, cancelled=%d",
-         success, telemetry.timingMs, telemetry.cancelled);
+JNIEXPORT jint JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeAwaitJob(
+    JNIEnv* env,
+    jobject thiz,
+    jlong handle,
+    jlong jobId,
+    jlong timeoutMs,
+    jobject telemetryBuffer
+) {
+    std::shared_ptr<EngineSlot> slot = findEngine(handle);
+    if (!slot) {
+        return static_cast<jint>(kotopogoda::EnhanceJobState::UNKNOWN);
+    }
+    kotopogoda::EnhanceJobResult result;
+    const kotopogoda::EnhanceJobState state = slot->queue->await(
+        static_cast<int64_t>(jobId),
+        static_cast<int64_t>(timeoutMs),
+        &result
+    );
+    return finishJobQuery(env, telemetryBuffer, state, result);
+}
 
-    return payload;
+JNIEXPORT jboolean JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeCancelJob(
+    JNIEnv* env,
+    jobject thiz,
+    jlong handle,
+    jlong jobId
+) {
+    std::shared_ptr<EngineSlot> slot = findEngine(handle);
+    if (!slot) {
+        return JNI_FALSE;
+    }
+    LOGI("nativeCancelJob: handle=%lld job=%lld", (long long)handle, (long long)jobId);
+    return slot->queue->cancel(static_cast<int64_t>(jobId)) ? JNI_TRUE : JNI_FALSE;
 }
 
 JNIEXPORT void JNICALL
@@ -281,18 +1206,12 @@ Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nati
 ) {
     LOGI("nativeCancel вызван: handle=%lld", (long long)handle);
     
-    kotopogoda::NcnnEngine* engine = nullptr;
-    {
-        std::lock_guard<std::mutex> lock(g_enginesMutex);
-        auto it = g_engines.find(handle);
-        if (it == g_engines.end()) {
-            LOGE("Недействительный handle: %lld", (long long)handle);
-            return;
-        }
-        engine = it->second;
+    std::shared_ptr<EngineSlot> slot = findEngine(handle);
+    if (!slot) {
+        return;
     }
     
-    engine->cancel();
+    slot->queue->cancelAll();
 }
 
 JNIEXPORT void JNICALL
@@ -303,7 +1222,7 @@ Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nati
 ) {
     LOGI("nativeRelease вызван: handle=%lld", (long long)handle);
     
-    kotopogoda::NcnnEngine* engine = nullptr;
+    std::shared_ptr<EngineSlot> slot;
     {
         std::lock_guard<std::mutex> lock(g_enginesMutex);
         auto it = g_engines.find(handle);
@@ -311,17 +1230,145 @@ Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nati
             LOGE("Недействительный handle: %lld", (long long)handle);
             return;
         }
-        engine = it->second;
+        slot = std::move(it->second);
         g_engines.erase(it);
     }
     
-    engine->release();
-    delete engine;
+    slot.reset();
     
     LOGI("Движок с handle=%lld освобожден", (long long)handle);
 }
 
 
+JNIEXPORT void JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeSetProfilingEnabled(
+    JNIEnv* env,
+    jclass clazz,
+    jboolean enabled
+) {
+    (void)env;
+    (void)clazz;
+    kotopogoda::setProfilingEnabled(enabled == JNI_TRUE);
+}
+
+JNIEXPORT void JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeSetSustainedModeEnabled(
+    JNIEnv* env,
+    jclass clazz,
+    jboolean enabled
+) {
+    (void)env;
+    (void)clazz;
+    kotopogoda::setSustainedModeEnabled(enabled == JNI_TRUE);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeApplyEdgeAwareUnsharp(
+    JNIEnv* env,
+    jclass clazz,
+    jintArray pixels,
+    jintArray output,
+    jint width,
+    jint height,
+    jfloat amount,
+    jfloat radius,
+    jfloat threshold
+) {
+    (void)clazz;
+    if (pixels == nullptr || output == nullptr || width <= 0 || height <= 0) {
+        return JNI_FALSE;
+    }
+    const int64_t total = static_cast<int64_t>(width) * height;
+    if (env->GetArrayLength(pixels) != total || env->GetArrayLength(output) != total) {
+        LOGE("nativeApplyEdgeAwareUnsharp: размер массивов не совпадает с %dx%d", width, height);
+        return JNI_FALSE;
+    }
+
+    // Не critical-доступ: ядро работает десятки миллисекунд в нескольких
+    // потоках, а большие массивы ART и так отдаёт без копии.
+    jint* src = env->GetIntArrayElements(pixels, nullptr);
+    jint* dst = env->GetIntArrayElements(output, nullptr);
+    if (src == nullptr || dst == nullptr) {
+        if (src != nullptr) {
+            env->ReleaseIntArrayElements(pixels, src, JNI_ABORT);
+        }
+        if (dst != nullptr) {
+            env->ReleaseIntArrayElements(output, dst, JNI_ABORT);
+        }
+        return JNI_FALSE;
+    }
+
+    const int threads = std::max(1, std::min(4, ncnn::get_big_cpu_count()));
+    const bool ok = kotopogoda::applyEdgeAwareUnsharp(
+        reinterpret_cast<const uint32_t*>(src),
+        reinterpret_cast<uint32_t*>(dst),
+        width,
+        height,
+        amount,
+        radius,
+        threshold,
+        threads
+    );
+    env->ReleaseIntArrayElements(pixels, src, JNI_ABORT);
+    env->ReleaseIntArrayElements(output, dst, ok ? 0 : JNI_ABORT);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeApplyColorLut(
+    JNIEnv* env,
+    jclass clazz,
+    jintArray pixels,
+    jintArray output,
+    jint width,
+    jint height,
+    jfloat vibranceGain,
+    jfloat saturationGain,
+    jint lutSize
+) {
+    (void)clazz;
+    if (pixels == nullptr || output == nullptr || width <= 0 || height <= 0) {
+        return JNI_FALSE;
+    }
+    const int64_t total = static_cast<int64_t>(width) * height;
+    if (env->GetArrayLength(pixels) != total || env->GetArrayLength(output) != total) {
+        LOGE("nativeApplyColorLut: размер массивов не совпадает с %dx%d", width, height);
+        return JNI_FALSE;
+    }
+
+    jint* src = env->GetIntArrayElements(pixels, nullptr);
+    jint* dst = env->GetIntArrayElements(output, nullptr);
+    if (src == nullptr || dst == nullptr) {
+        if (src != nullptr) {
+            env->ReleaseIntArrayElements(pixels, src, JNI_ABORT);
+        }
+        if (dst != nullptr) {
+            env->ReleaseIntArrayElements(output, dst, JNI_ABORT);
+        }
+        return JNI_FALSE;
+    }
+
+    bool ok = true;
+    if (kotopogoda::isIdentityColorProfile(vibranceGain, saturationGain)) {
+        std::memcpy(dst, src, static_cast<size_t>(total) * sizeof(jint));
+    } else {
+        const std::shared_ptr<const kotopogoda::ColorLut> lut =
+            kotopogoda::vibranceSaturationLut(vibranceGain, saturationGain, lutSize);
+        const int threads = std::max(1, std::min(4, ncnn::get_big_cpu_count()));
+        ok = kotopogoda::applyColorLut(
+            *lut,
+            reinterpret_cast<const uint32_t*>(src),
+            reinterpret_cast<uint32_t*>(dst),
+            width,
+            height,
+            threads
+        );
+    }
+    env->ReleaseIntArrayElements(pixels, src, JNI_ABORT);
+    env->ReleaseIntArrayElements(output, dst, ok ? 0 : JNI_ABORT);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
 JNIEXPORT jobjectArray JNICALL
 Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nativeConsumeIntegrityFailure(
     JNIEnv* env,
@@ -335,12 +1382,7 @@ Java_com_kotopogoda_uploader_feature_viewer_enhance_NativeEnhanceController_nati
         return nullptr;
     }
 
-    jclass stringClass = env->FindClass("java/lang/String");
-    if (stringClass == nullptr) {
-        return nullptr;
-    }
-
-    jobjectArray array = env->NewObjectArray(3, stringClass, nullptr);
+    jobjectArray array = env->NewObjectArray(3, kotopogoda::jniCache().stringClass, nullptr);
     if (array == nullptr) {
         return nullptr;
     }
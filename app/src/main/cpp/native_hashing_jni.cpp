@@ -0,0 +1,281 @@
+#include <jni.h>
+#include <android/log.h>
+#include <algorithm>
+#include <vector>
+#include "body_digest.h"
+#include "content_chunker.h"
+#include "jni_cache.h"
+#include "sha256_batch.h"
+#include "sha256_verifier.h"
+
+#define LOG_TAG "NativeHashingJNI"
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+// Вызывает ProgressListener.onProgress(JJ)Z из потока хеширования; ID метода
+// закеширован в JNI_OnLoad. Отмену Kotlin-обёртка распознаёт сама: null после
+// ответа false от слушателя.
+struct ProgressBridge {
+    JNIEnv* env;
+    jobject listener;
+    jmethodID onProgress;
+
+    bool operator()(uint64_t processedBytes, uint64_t totalBytes) const {
+        if (listener == nullptr) {
+            return true;
+        }
+        const jboolean proceed = env->CallBooleanMethod(
+            listener,
+            onProgress,
+            static_cast<jlong>(processedBytes),
+            static_cast<jlong>(totalBytes)
+        );
+        if (env->ExceptionCheck()) {
+            // Исключение из слушателя останавливает хеширование и пробрасывается в Kotlin.
+            return false;
+        }
+        return proceed == JNI_TRUE;
+    }
+};
+
+bool copyByteArray(JNIEnv* env, jbyteArray array, std::vector<uint8_t>& out) {
+    if (array == nullptr) {
+        return false;
+    }
+    const jsize length = env->GetArrayLength(array);
+    out.resize(static_cast<size_t>(length));
+    if (length > 0) {
+        env->GetByteArrayRegion(array, 0, length, reinterpret_cast<jbyte*>(out.data()));
+    }
+    return true;
+}
+
+struct BatchProgressBridge {
+    JNIEnv* env;
+    jobject listener;
+    jmethodID onProgress;
+
+    bool operator()(size_t filesCompleted, uint64_t hashedBytes, uint64_t totalBytes) const {
+        if (listener == nullptr) {
+            return true;
+        }
+        const jboolean proceed = env->CallBooleanMethod(
+            listener,
+            onProgress,
+            static_cast<jint>(filesCompleted),
+            static_cast<jlong>(hashedBytes),
+            static_cast<jlong>(totalBytes)
+        );
+        if (env->ExceptionCheck()) {
+            return false;
+        }
+        return proceed == JNI_TRUE;
+    }
+};
+
+}
+
+extern "C" {
+
+JNIEXPORT jstring JNICALL
+Java_com_kotopogoda_uploader_core_data_util_NativeHashing_nativeSha256Fd(
+    JNIEnv* env,
+    jclass clazz,
+    jint fd,
+    jobject progressListener
+) {
+    (void)clazz;
+
+    const ProgressBridge bridge{env, progressListener, kotopogoda::jniCache().onHashProgress};
+
+    kotopogoda::FdStreamResult result = kotopogoda::FdStreamResult::IO_ERROR;
+    const std::string digest = kotopogoda::Sha256Verifier::computeSha256Fd(
+        static_cast<int>(fd),
+        bridge,
+        &result
+    );
+
+    if (env->ExceptionCheck()) {
+        return nullptr;
+    }
+    if (result == kotopogoda::FdStreamResult::CANCELLED) {
+        return nullptr;
+    }
+    if (result != kotopogoda::FdStreamResult::OK) {
+        LOGW("Не удалось прочитать fd=%d для SHA-256", static_cast<int>(fd));
+        return nullptr;
+    }
+    return env->NewStringUTF(digest.c_str());
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_kotopogoda_uploader_core_data_util_NativeHashing_nativeSha256Batch(
+    JNIEnv* env,
+    jclass clazz,
+    jintArray fds,
+    jobject progressListener
+) {
+    (void)clazz;
+    if (fds == nullptr) {
+        return nullptr;
+    }
+
+    const BatchProgressBridge bridge{env, progressListener, kotopogoda::jniCache().onBatchHashProgress};
+
+    const jsize count = env->GetArrayLength(fds);
+    std::vector<jint> rawFds(static_cast<size_t>(count));
+    if (count > 0) {
+        env->GetIntArrayRegion(fds, 0, count, rawFds.data());
+    }
+    const std::vector<int> descriptors(rawFds.begin(), rawFds.end());
+
+    std::vector<std::string> digests;
+    std::vector<kotopogoda::FdStreamResult> results;
+    const kotopogoda::Sha256Batch batch;
+    const kotopogoda::FdStreamResult status = batch.hashFds(descriptors, digests, results, bridge);
+    if (env->ExceptionCheck() || status == kotopogoda::FdStreamResult::CANCELLED) {
+        return nullptr;
+    }
+
+    jobjectArray array = env->NewObjectArray(count, kotopogoda::jniCache().stringClass, nullptr);
+    if (array == nullptr) {
+        return nullptr;
+    }
+    for (jsize i = 0; i < count; ++i) {
+        if (results[static_cast<size_t>(i)] != kotopogoda::FdStreamResult::OK) {
+            continue;
+        }
+        jstring digest = env->NewStringUTF(digests[static_cast<size_t>(i)].c_str());
+        env->SetObjectArrayElement(array, i, digest);
+        env->DeleteLocalRef(digest);
+    }
+    return array;
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_kotopogoda_uploader_core_data_util_NativeHashing_nativeDigestBody(
+    JNIEnv* env,
+    jclass clazz,
+    jint fd,
+    jbyteArray framePrefix,
+    jbyteArray frameSuffix,
+    jbyteArray hmacKey,
+    jbyteArray hmacPrefix,
+    jobject progressListener
+) {
+    (void)clazz;
+
+    const ProgressBridge bridge{env, progressListener, kotopogoda::jniCache().onHashProgress};
+
+    kotopogoda::BodyDigestSpec spec;
+    const bool hasPrefix = copyByteArray(env, framePrefix, spec.framePrefix);
+    const bool hasSuffix = copyByteArray(env, frameSuffix, spec.frameSuffix);
+    spec.framed = hasPrefix || hasSuffix;
+    spec.signedBody = copyByteArray(env, hmacKey, spec.hmacKey);
+    copyByteArray(env, hmacPrefix, spec.hmacPrefix);
+
+    kotopogoda::BodyDigests digests;
+    const kotopogoda::FdStreamResult result =
+        kotopogoda::computeBodyDigests(static_cast<int>(fd), spec, digests, bridge);
+    std::fill(spec.hmacKey.begin(), spec.hmacKey.end(), 0);
+
+    if (env->ExceptionCheck() || result == kotopogoda::FdStreamResult::CANCELLED) {
+        return nullptr;
+    }
+    if (result != kotopogoda::FdStreamResult::OK) {
+        LOGW("Не удалось прочитать fd=%d для дайджестов тела", static_cast<int>(fd));
+        return nullptr;
+    }
+
+    jobjectArray array = env->NewObjectArray(3, kotopogoda::jniCache().stringClass, nullptr);
+    if (array == nullptr) {
+        return nullptr;
+    }
+    const std::string* values[3] = { &digests.contentSha256, &digests.framedSha256, &digests.hmacSha256 };
+    for (jsize i = 0; i < 3; ++i) {
+        if (values[i]->empty()) {
+            continue;
+        }
+        jstring value = env->NewStringUTF(values[i]->c_str());
+        env->SetObjectArrayElement(array, i, value);
+        env->DeleteLocalRef(value);
+    }
+    return array;
+}
+
+// Возвращает [rootSha256: String, contentSha256: String, lengths: LongArray,
+// digests: String[]]; смещения чанков восстанавливаются в Kotlin по длинам.
+JNIEXPORT jobjectArray JNICALL
+Java_com_kotopogoda_uploader_core_data_util_NativeHashing_nativeChunkFd(
+    JNIEnv* env,
+    jclass clazz,
+    jint fd,
+    jint minSize,
+    jint avgSize,
+    jint maxSize,
+    jobject progressListener
+) {
+    (void)clazz;
+
+    kotopogoda::CdcParams params;
+    params.minSize = static_cast<uint32_t>(minSize);
+    params.avgSize = static_cast<uint32_t>(avgSize);
+    params.maxSize = static_cast<uint32_t>(maxSize);
+    if (minSize <= 0 || !kotopogoda::ContentDefinedChunker::isValid(params)) {
+        LOGW("Некорректные параметры чанков: min=%d avg=%d max=%d", minSize, avgSize, maxSize);
+        return nullptr;
+    }
+
+    const ProgressBridge bridge{env, progressListener, kotopogoda::jniCache().onHashProgress};
+
+    kotopogoda::ContentDefinedChunker chunker(params);
+    const kotopogoda::FdStreamResult result =
+        kotopogoda::ContentDefinedChunker::chunkFd(static_cast<int>(fd), chunker, bridge);
+    if (env->ExceptionCheck() || result == kotopogoda::FdStreamResult::CANCELLED) {
+        return nullptr;
+    }
+    if (result != kotopogoda::FdStreamResult::OK) {
+        LOGW("Не удалось прочитать fd=%d для разбиения на чанки", static_cast<int>(fd));
+        return nullptr;
+    }
+
+    const std::vector<kotopogoda::CdcChunk>& chunks = chunker.chunks();
+    const jsize chunkCount = static_cast<jsize>(chunks.size());
+
+    const kotopogoda::JniCache& cache = kotopogoda::jniCache();
+    jobjectArray payload = env->NewObjectArray(4, cache.objectClass, nullptr);
+    jobjectArray digests = env->NewObjectArray(chunkCount, cache.stringClass, nullptr);
+    jlongArray lengths = env->NewLongArray(chunkCount);
+    if (payload == nullptr || digests == nullptr || lengths == nullptr) {
+        return nullptr;
+    }
+
+    std::vector<jlong> lengthValues(chunks.size());
+    for (jsize i = 0; i < chunkCount; ++i) {
+        const kotopogoda::CdcChunk& chunk = chunks[static_cast<size_t>(i)];
+        lengthValues[static_cast<size_t>(i)] = static_cast<jlong>(chunk.length);
+        jstring digest = env->NewStringUTF(
+            kotopogoda::Sha256::toHex(chunk.digest, sizeof(chunk.digest)).c_str()
+        );
+        env->SetObjectArrayElement(digests, i, digest);
+        env->DeleteLocalRef(digest);
+    }
+    if (chunkCount > 0) {
+        env->SetLongArrayRegion(lengths, 0, chunkCount, lengthValues.data());
+    }
+
+    jstring root = env->NewStringUTF(chunker.rootDigestHex().c_str());
+    jstring content = env->NewStringUTF(chunker.contentSha256Hex().c_str());
+    env->SetObjectArrayElement(payload, 0, root);
+    env->SetObjectArrayElement(payload, 1, content);
+    env->SetObjectArrayElement(payload, 2, lengths);
+    env->SetObjectArrayElement(payload, 3, digests);
+    env->DeleteLocalRef(root);
+    env->DeleteLocalRef(content);
+    env->DeleteLocalRef(lengths);
+    env->DeleteLocalRef(digests);
+    return payload;
+}
+
+}
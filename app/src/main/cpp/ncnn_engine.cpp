@@ -1,6 +1,9 @@
 #include "ncnn_engine.h"
-#include "sha256_verifier.h"
+#include "hashing_data_reader.h"
+#include "trace.h"
+#include "verification_ledger.h"
 #include "zerodce_backend.h"
+#include <ncnn/allocator.h>
 #include <ncnn/net.h>
 #include <ncnn/cpu.h>
 #include <android/log.h>
@@ -12,6 +15,7 @@
 #include <cstdio>
 #include <cstring>
 #include <fstream>
+#include <thread>
 #include <sys/stat.h>
 #include <cerrno>
 
@@ -29,8 +33,25 @@ const char* delegateToString(DelegateType delegate) {
 
 constexpr int kTileDefault = 384;
 constexpr int kTileOverlapDefault = 64;
-constexpr const char* kStageZerodcePreview = "zerodce_preview";
-constexpr const char* kStageZerodceFull = "zerodce_full";
+// Шаг ожидания паузы устойчивого режима: отмена замечается не позже.
+constexpr auto kSustainedPauseSlice = std::chrono::milliseconds(20);
+
+// Выдерживает паузу перед запуском; false — запуск отменили во время паузы.
+bool waitSustainedPause(int64_t pauseMicros, const std::atomic<bool>& cancelFlag) {
+    if (pauseMicros <= 0) {
+        return !cancelFlag.load();
+    }
+    TRACE_SCOPE("sustained_pause");
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(pauseMicros);
+    while (!cancelFlag.load()) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(deadline - now, kSustainedPauseSlice));
+    }
+    return false;
+}
 
 std::function<void(int, int)> makeStageCallback(
     const TileProgressCallback& callback,
@@ -82,6 +103,17 @@ void logFileDiagnostics(const char* stage, const std::string& path) {
     }
 }
 
+std::string normalizeChecksum(const std::string& checksum) {
+    std::string normalized = checksum;
+    std::transform(
+        normalized.begin(),
+        normalized.end(),
+        normalized.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); }
+    );
+    return normalized;
+}
+
 void logNcnnFailureHint(const char* operation, const char* model, int ret) {
     if (ret == -100) {
         LOGW(
@@ -94,6 +126,53 @@ void logNcnnFailureHint(const char* operation, const char* model, int ret) {
 }
 }
 
+RunContext::RunContext(
+    std::atomic<bool>& cancelFlag,
+    TelemetryData& telemetry,
+    TileProgressCallback progressCallback
+)
+    : cancelFlag_(cancelFlag),
+      telemetry_(telemetry),
+      progressCallback_(std::move(progressCallback)),
+      memory_(telemetry),
+      profiler_(telemetry, isProfilingEnabled()),
+      cpu_(telemetry, isProfilingEnabled()),
+      blobPool_(std::make_unique<ncnn::UnlockedPoolAllocator>()),
+      workspacePool_(std::make_unique<ncnn::PoolAllocator>()),
+      blobAllocator_(std::make_unique<TrackingAllocator>(blobPool_.get(), memory_)),
+      workspaceAllocator_(std::make_unique<TrackingAllocator>(workspacePool_.get(), memory_)) {
+}
+
+RunContext::~RunContext() {
+    memory_.endStage();
+    profiler_.finish();
+    cpu_.finish();
+    blobAllocator_.reset();
+    workspaceAllocator_.reset();
+    blobPool_->clear();
+    workspacePool_->clear();
+}
+
+void RunContext::beginStage(PipelineStage stage) {
+    memory_.beginStage(stage);
+    profiler_.beginStage(stage);
+    traceCounter("pipeline_stage", static_cast<int64_t>(stage));
+}
+
+void RunContext::endStage() {
+    memory_.endStage();
+    profiler_.endStage();
+    traceCounter("pipeline_stage", -1);
+}
+
+ncnn::Allocator* RunContext::blobAllocator() const {
+    return blobAllocator_.get();
+}
+
+ncnn::Allocator* RunContext::workspaceAllocator() const {
+    return workspaceAllocator_.get();
+}
+
 std::mutex NcnnEngine::integrityMutex_;
 NcnnEngine::IntegrityFailure NcnnEngine::lastIntegrityFailure_;
 
@@ -102,7 +181,6 @@ NcnnEngine::NcnnEngine()
       modelsDir_(),
       assetManager_(nullptr),
       initialized_(false),
-      cancelled_(false),
       forceCpuMode_(false),
       currentDelegate_(DelegateType::CPU),
       restPrecision_("fp16") {
@@ -132,46 +210,127 @@ NcnnEngine::IntegrityFailure NcnnEngine::consumeLastIntegrityFailure() {
     return failure;
 }
 
-bool NcnnEngine::verifyChecksum(const std::string& filePath, const std::string& expectedChecksum) {
+bool NcnnEngine::isVerifiedByLedger(const std::string& filePath, const std::string& expectedChecksum) const {
+    if (!verificationLedger_ || !verificationLedger_->isVerified(filePath, normalizeChecksum(expectedChecksum))) {
+        return false;
+    }
+    LOGI("Контрольная сумма подтверждена журналом проверок для %s", filePath.c_str());
+    return true;
+}
+
+bool NcnnEngine::acceptChecksum(
+    const std::string& filePath,
+    const std::string& expectedChecksum,
+    const std::string& computed
+) {
     if (expectedChecksum.empty()) {
         LOGE("Ожидаемая контрольная сумма не указана для %s", filePath.c_str());
         reportIntegrityFailure(filePath, expectedChecksum, "");
         return false;
     }
 
-    std::string computed = Sha256Verifier::computeSha256(filePath);
-
     if (computed.empty()) {
         LOGE("Не удалось вычислить SHA256 для %s", filePath.c_str());
+        if (verificationLedger_) {
+            verificationLedger_->forget(filePath);
+        }
         reportIntegrityFailure(filePath, expectedChecksum, "");
         return false;
     }
 
-    std::string normalizedExpected = expectedChecksum;
-    std::transform(
-        normalizedExpected.begin(),
-        normalizedExpected.end(),
-        normalizedExpected.begin(),
-        [](unsigned char c) { return static_cast<char>(std::tolower(c)); }
-    );
-
+    const std::string normalizedExpected = normalizeChecksum(expectedChecksum);
     if (computed != normalizedExpected) {
         LOGW("Несоответствие контрольной суммы для %s", filePath.c_str());
         LOGW("Ожидалось: %s", normalizedExpected.c_str());
         LOGW("Получено:  %s", computed.c_str());
+        if (verificationLedger_) {
+            verificationLedger_->forget(filePath);
+        }
         reportIntegrityFailure(filePath, normalizedExpected, computed);
         return false;
     }
 
+    if (verificationLedger_) {
+        verificationLedger_->record(filePath, computed);
+    }
     LOGI("Контрольная сумма проверена для %s", filePath.c_str());
     return true;
 }
 
+bool NcnnEngine::loadParamVerified(
+    ncnn::Net& net,
+    const std::string& paramPath,
+    const std::string& expectedChecksum,
+    const char* model
+) {
+    const char* delegateName = delegateToString(currentDelegate_.load());
+    logFileDiagnostics((std::string(model) + "_param").c_str(), paramPath);
+    LOGI("NCNN load_param: model=%s delegate=%s path=%s", model, delegateName, paramPath.c_str());
+
+    int ret = 0;
+    if (!expectedChecksum.empty() && isVerifiedByLedger(paramPath, expectedChecksum)) {
+        ret = net.load_param(paramPath.c_str());
+    } else {
+        // .param небольшой: читаем его один раз в память, сверяем хеш до
+        // разбора и отдаём тот же буфер парсеру ncnn.
+        std::string content;
+        std::string computed;
+        HashingDataReader::readAll(paramPath, content, computed);
+        if (!acceptChecksum(paramPath, expectedChecksum, computed)) {
+            LOGE("Контрольная сумма %s param не совпадает", model);
+            return false;
+        }
+        ret = net.load_param_mem(content.c_str());
+    }
+
+    if (ret != 0) {
+        LOGE("NCNN load_param_failed: model=%s delegate=%s path=%s ret=%d", model, delegateName, paramPath.c_str(), ret);
+        logNcnnFailureHint("load_param", model, ret);
+        return false;
+    }
+    return true;
+}
+
+bool NcnnEngine::loadModelVerified(
+    ncnn::Net& net,
+    const std::string& binPath,
+    const std::string& expectedChecksum,
+    const char* model
+) {
+    const char* delegateName = delegateToString(currentDelegate_.load());
+    logFileDiagnostics((std::string(model) + "_bin").c_str(), binPath);
+    LOGI("NCNN load_model: model=%s delegate=%s path=%s", model, delegateName, binPath.c_str());
+
+    int ret = 0;
+    if (!expectedChecksum.empty() && isVerifiedByLedger(binPath, expectedChecksum)) {
+        ret = net.load_model(binPath.c_str());
+    } else {
+        // Веса хешируются в том же проходе, в котором ncnn их читает.
+        // Сеть принимается только если итоговый дайджест совпал; при
+        // несовпадении приоритет у ошибки целостности, даже если ncnn
+        // успел отказать раньше.
+        HashingDataReader reader(binPath);
+        ret = reader.isOpen() ? net.load_model(reader) : -1;
+        const std::string computed = reader.finishHex();
+        if (!acceptChecksum(binPath, expectedChecksum, computed)) {
+            LOGE("Контрольная сумма %s bin не совпадает, загруженная сеть отброшена", model);
+            return false;
+        }
+    }
+
+    if (ret != 0) {
+        LOGE("NCNN load_model_failed: model=%s delegate=%s path=%s ret=%d", model, delegateName, binPath.c_str(), ret);
+        logNcnnFailureHint("load_model", model, ret);
+        return false;
+    }
+    return true;
+}
+
 bool NcnnEngine::loadModels(AAssetManager* assetManager, const std::string& modelsDir) {
     (void)assetManager;
 
     zeroDceNet_.reset();
-    zeroDceNet_ = std::make_unique<ncnn::Net>();
+    auto zeroDceNet = std::make_unique<ncnn::Net>();
 
     const int cpuThreads = std::max(1, std::min(4, ncnn::get_big_cpu_count()));
     auto configureNet = [&](ncnn::Net& net) {
@@ -182,10 +341,14 @@ bool NcnnEngine::loadModels(AAssetManager* assetManager, const std::string& mode
         net.opt.num_threads = cpuThreads;
     };
 
-    configureNet(*zeroDceNet_);
+    configureNet(*zeroDceNet);
 
     LOGI("NCNN models configured for CPU: threads=%d", cpuThreads);
 
+    SustainedConfig sustainedConfig;
+    sustainedConfig.maxThreads = cpuThreads;
+    sustained_ = std::make_unique<SustainedPerformanceController>(sustainedConfig);
+
     const DelegateType delegate = currentDelegate_.load();
     const char* delegateName = delegateToString(delegate);
     std::string zeroDceParam = modelsDir + "/zerodcepp_fp16.param";
@@ -193,33 +356,15 @@ bool NcnnEngine::loadModels(AAssetManager* assetManager, const std::string& mode
 
     restPrecision_ = "fp16";
 
-    if (!verifyChecksum(zeroDceParam, zeroDceChecksums_.param)) {
-        LOGE("Контрольная сумма Zero-DCE++ param не совпадает");
+    if (!loadParamVerified(*zeroDceNet, zeroDceParam, zeroDceChecksums_.param, "zerodce")) {
         return false;
     }
 
-    logFileDiagnostics("zerodce_param", zeroDceParam);
-    LOGI("NCNN load_param: model=zerodce delegate=%s path=%s", delegateName, zeroDceParam.c_str());
-    int ret = zeroDceNet_->load_param(zeroDceParam.c_str());
-    if (ret != 0) {
-        LOGE("NCNN load_param_failed: model=zerodce delegate=%s path=%s ret=%d", delegateName, zeroDceParam.c_str(), ret);
-        logNcnnFailureHint("load_param", "zerodce", ret);
+    if (!loadModelVerified(*zeroDceNet, zeroDceBin, zeroDceChecksums_.bin, "zerodce")) {
         return false;
     }
 
-    if (!verifyChecksum(zeroDceBin, zeroDceChecksums_.bin)) {
-        LOGE("Контрольная сумма Zero-DCE++ bin не совпадает");
-        return false;
-    }
-
-    logFileDiagnostics("zerodce_bin", zeroDceBin);
-    LOGI("NCNN load_model: model=zerodce delegate=%s path=%s", delegateName, zeroDceBin.c_str());
-    ret = zeroDceNet_->load_model(zeroDceBin.c_str());
-    if (ret != 0) {
-        LOGE("NCNN load_model_failed: model=zerodce delegate=%s path=%s ret=%d", delegateName, zeroDceBin.c_str(), ret);
-        logNcnnFailureHint("load_model", "zerodce", ret);
-        return false;
-    }
+    zeroDceNet_ = std::move(zeroDceNet);
 
     LOGI("NCNN models ready: backend=ncnn delegate=%s precision=%s tile_default=%d", delegateName, restPrecision_.c_str(), kTileDefault);
     return true;
@@ -231,8 +376,11 @@ bool NcnnEngine::initialize(
     const ModelChecksums& zeroDceChecksums,
     const ModelChecksums& restormerChecksums,
     PreviewProfile profile,
-    bool forceCpu
+    bool forceCpu,
+    const VerificationPolicy& verificationPolicy
 ) {
+    TRACE_SCOPE("NcnnEngine::initialize");
+    std::unique_lock<std::shared_mutex> lifecycle(lifecycleMutex_);
     if (initialized_.load()) {
         LOGW("Движок уже инициализирован");
         return true;
@@ -252,7 +400,23 @@ bool NcnnEngine::initialize(
     currentDelegate_.store(DelegateType::CPU);
     LOGI("NcnnEngine: running in CPU-only mode (Vulkan disabled)");
 
-    if (!loadModels(assetManager, modelsDir)) {
+    verificationLedger_ = std::make_unique<VerificationLedger>(
+        modelsDir,
+        verificationPolicy.ledgerKey,
+        verificationPolicy.reverifyIntervalSec
+    );
+    verificationLedger_->load();
+    LOGI(
+        "Журнал проверок: enabled=%d reverify_interval_s=%lld",
+        verificationLedger_->enabled() ? 1 : 0,
+        static_cast<long long>(verificationPolicy.reverifyIntervalSec)
+    );
+
+    const bool modelsLoaded = loadModels(assetManager, modelsDir);
+    verificationLedger_->save();
+    verificationLedger_.reset();
+
+    if (!modelsLoaded) {
         LOGE("Не удалось загрузить модели");
         return false;
     }
@@ -263,80 +427,167 @@ bool NcnnEngine::initialize(
     return true;
 }
 
-static void bitmapToMat(JNIEnv* env, jobject bitmap, ncnn::Mat& mat) {
+void bitmapToMat(JNIEnv* env, jobject bitmap, ncnn::Mat& mat) {
+    TRACE_SCOPE("bitmapToMat");
     AndroidBitmapInfo info;
     AndroidBitmap_getInfo(env, bitmap, &info);
     
     void* pixels;
     AndroidBitmap_lockPixels(env, bitmap, &pixels);
     
-    mat.create(static_cast<int>(info.width), static_cast<int>(info.height), 3, 4u, nullptr);
-    
-    uint32_t* pixelData = reinterpret_cast<uint32_t*>(pixels);
+    const int width = static_cast<int>(info.width);
+    const int height = static_cast<int>(info.height);
+    mat.create(width, height, 3, 4u, nullptr);
     
-    for (int y = 0; y < static_cast<int>(info.height); ++y) {
-        for (int x = 0; x < static_cast<int>(info.width); ++x) {
-            uint32_t pixel = pixelData[y * info.width + x];
-            
-            float r = ((pixel >> 16) & 0xFF) / 255.0f;
-            float g = ((pixel >> 8) & 0xFF) / 255.0f;
-            float b = (pixel & 0xFF) / 255.0f;
+    // RGBA_8888 лежит в памяти байтами R, G, B, A: в uint32 (little-endian)
+    // красный — младший байт, синий — биты 16..23.
+    for (int y = 0; y < height; ++y) {
+        const uint32_t* pixelRow = reinterpret_cast<const uint32_t*>(
+            static_cast<const uint8_t*>(pixels) + static_cast<size_t>(y) * info.stride
+        );
+        float* rowR = mat.channel(0).row(y);
+        float* rowG = mat.channel(1).row(y);
+        float* rowB = mat.channel(2).row(y);
+        for (int x = 0; x < width; ++x) {
+            uint32_t pixel = pixelRow[x];
             
-            mat.channel(0)[y * info.width + x] = r;
-            mat.channel(1)[y * info.width + x] = g;
-            mat.channel(2)[y * info.width + x] = b;
+            rowR[x] = (pixel & 0xFF) / 255.0f;
+            rowG[x] = ((pixel >> 8) & 0xFF) / 255.0f;
+            rowB[x] = ((pixel >> 16) & 0xFF) / 255.0f;
         }
     }
     
     AndroidBitmap_unlockPixels(env, bitmap);
 }
 
-static void matToBitmap(JNIEnv* env, const ncnn::Mat& mat, jobject bitmap) {
+void matToBitmap(JNIEnv* env, const ncnn::Mat& mat, jobject bitmap, ImageStats* stats, const ColorLut* colorLut) {
+    TRACE_SCOPE("matToBitmap");
     AndroidBitmapInfo info;
     AndroidBitmap_getInfo(env, bitmap, &info);
     
     void* pixels;
     AndroidBitmap_lockPixels(env, bitmap, &pixels);
     
-    uint32_t* pixelData = reinterpret_cast<uint32_t*>(pixels);
+    std::vector<uint8_t> rgbRow(static_cast<size_t>(mat.w) * 3);
+    std::unique_ptr<ImageStatsAccumulator> accumulator;
+    if (stats != nullptr) {
+        *stats = ImageStats();
+        accumulator = std::make_unique<ImageStatsAccumulator>(mat.w, mat.h);
+    }
     
     for (int y = 0; y < mat.h; ++y) {
+        const float* rowR = mat.channel(0).row(y);
+        const float* rowG = mat.channel(1).row(y);
+        const float* rowB = mat.channel(2).row(y);
+        uint32_t* pixelRow = reinterpret_cast<uint32_t*>(
+            static_cast<uint8_t*>(pixels) + static_cast<size_t>(y) * info.stride
+        );
+        uint8_t* rgb = rgbRow.data();
         for (int x = 0; x < mat.w; ++x) {
-            float r = mat.channel(0)[y * mat.w + x];
-            float g = mat.channel(1)[y * mat.w + x];
-            float b = mat.channel(2)[y * mat.w + x];
-            
-            r = std::max(0.0f, std::min(1.0f, r));
-            g = std::max(0.0f, std::min(1.0f, g));
-            b = std::max(0.0f, std::min(1.0f, b));
-            
-            uint8_t ri = static_cast<uint8_t>(r * 255.0f);
-            uint8_t gi = static_cast<uint8_t>(g * 255.0f);
-            uint8_t bi = static_cast<uint8_t>(b * 255.0f);
+            float r = std::max(0.0f, std::min(1.0f, rowR[x]));
+            float g = std::max(0.0f, std::min(1.0f, rowG[x]));
+            float b = std::max(0.0f, std::min(1.0f, rowB[x]));
             
-            pixelData[y * info.width + x] = 0xFF000000 | (ri << 16) | (gi << 8) | bi;
+            rgb[0] = static_cast<uint8_t>(r * 255.0f);
+            rgb[1] = static_cast<uint8_t>(g * 255.0f);
+            rgb[2] = static_cast<uint8_t>(b * 255.0f);
+            rgb += 3;
+        }
+        if (colorLut != nullptr) {
+            colorLut->applyRgbRow(rgbRow.data(), mat.w);
+        }
+        rgb = rgbRow.data();
+        for (int x = 0; x < mat.w; ++x) {
+            pixelRow[x] = 0xFF000000u | (static_cast<uint32_t>(rgb[2]) << 16) |
+                          (static_cast<uint32_t>(rgb[1]) << 8) | rgb[0];
+            rgb += 3;
+        }
+        if (accumulator) {
+            accumulator->addRow(rgbRow.data());
         }
     }
     
     AndroidBitmap_unlockPixels(env, bitmap);
+    if (accumulator) {
+        accumulator->finish(*stats);
+    }
 }
 
 bool NcnnEngine::runPreview(
     JNIEnv* env,
     jobject sourceBitmap,
     float strength,
-    TelemetryData& telemetry,
-    const TileProgressCallback& progressCallback
+    RunContext& context
 ) {
+    TRACE_SCOPE("NcnnEngine::runPreview");
+    std::shared_lock<std::shared_mutex> lifecycle(lifecycleMutex_);
     if (!initialized_.load()) {
         LOGE("Движок не инициализирован");
         return false;
     }
 
-    cancelled_ = false;
-
+    MemoryTracker& memory = context.memory();
+    context.beginStage(PipelineStage::CONVERT_IN);
     ncnn::Mat inputMat;
     bitmapToMat(env, sourceBitmap, inputMat);
+    MatCharge inputCharge(memory, inputMat);
+
+    ncnn::Mat outputMat;
+    if (!previewLocked(inputMat, strength, outputMat, context)) {
+        return false;
+    }
+    MatCharge outputCharge(memory, outputMat);
+
+    context.beginStage(PipelineStage::CONVERT_OUT);
+    matToBitmap(env, outputMat, sourceBitmap, nullptr, context.colorLut());
+    context.endStage();
+
+    return true;
+}
+
+bool NcnnEngine::runPreview(
+    JNIEnv* env,
+    const ncnn::Mat& input,
+    float strength,
+    jobject outputBitmap,
+    RunContext& context
+) {
+    TRACE_SCOPE("NcnnEngine::runPreview");
+    std::shared_lock<std::shared_mutex> lifecycle(lifecycleMutex_);
+    if (!initialized_.load()) {
+        LOGE("Движок не инициализирован");
+        return false;
+    }
+
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, outputBitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS ||
+        static_cast<int>(info.width) != input.w ||
+        static_cast<int>(info.height) != input.h) {
+        LOGE("Превью: Bitmap результата не совпадает с входом %dx%d", input.w, input.h);
+        return false;
+    }
+
+    ncnn::Mat outputMat;
+    if (!previewLocked(input, strength, outputMat, context)) {
+        return false;
+    }
+    MemoryTracker& memory = context.memory();
+    MatCharge outputCharge(memory, outputMat);
+
+    context.beginStage(PipelineStage::CONVERT_OUT);
+    matToBitmap(env, outputMat, outputBitmap, nullptr, context.colorLut());
+    context.endStage();
+
+    return true;
+}
+
+bool NcnnEngine::previewLocked(
+    const ncnn::Mat& inputMat,
+    float strength,
+    ncnn::Mat& outputMat,
+    RunContext& context
+) {
+    TelemetryData& telemetry = context.telemetry();
 
     LOGI("Превью: размер входа %dx%d", inputMat.w, inputMat.h);
 
@@ -378,8 +629,8 @@ bool NcnnEngine::runPreview(
         telemetry.seamMeanDelta = 0.0f;
         telemetry.gpuAllocRetryCount = 0;
 
-        ZeroDceBackend zeroDce(zeroDceNet_.get(), cancelled_);
-        auto zeroProgress = makeStageCallback(progressCallback, kStageZerodcePreview);
+        ZeroDceBackend zeroDce(zeroDceNet_.get(), context);
+        auto zeroProgress = makeStageCallback(context.progressCallback(), kStageZerodcePreview);
         bool ok = zeroDce.process(inputMat, output, strength, telemetry, zeroProgress);
         if (!ok) {
             propagateExtractorError(telemetry, "zerodce_preview");
@@ -387,7 +638,6 @@ bool NcnnEngine::runPreview(
         return ok;
     };
 
-    ncnn::Mat outputMat;
     auto cpuStart = std::chrono::high_resolution_clock::now();
     if (!runPipeline(outputMat)) {
         return false;
@@ -400,9 +650,7 @@ bool NcnnEngine::runPreview(
         telemetry.durationMsCpu = telemetry.timingMs;
     }
 
-    matToBitmap(env, outputMat, sourceBitmap);
-
-    telemetry.cancelled = cancelled_.load();
+    telemetry.cancelled = context.isCancelled();
 
     return true;
 }
@@ -412,21 +660,75 @@ bool NcnnEngine::runFull(
     jobject sourceBitmap,
     float strength,
     jobject outputBitmap,
-    TelemetryData& telemetry,
-    const TileProgressCallback& progressCallback
+    RunContext& context
 ) {
+    TRACE_SCOPE("NcnnEngine::runFull");
+    std::shared_lock<std::shared_mutex> lifecycle(lifecycleMutex_);
     if (!initialized_.load()) {
         LOGE("Движок не инициализирован");
         return false;
     }
 
-    cancelled_ = false;
-
+    MemoryTracker& memory = context.memory();
+    context.beginStage(PipelineStage::CONVERT_IN);
     ncnn::Mat inputMat;
     bitmapToMat(env, sourceBitmap, inputMat);
+    MatCharge inputCharge(memory, inputMat);
 
     LOGI("Полная обработка: размер входа %dx%d", inputMat.w, inputMat.h);
 
+    ncnn::Mat finalMat;
+    if (!enhanceLocked(inputMat, strength, finalMat, context, true)) {
+        return false;
+    }
+    MatCharge finalCharge(memory, finalMat);
+
+    context.beginStage(PipelineStage::CONVERT_OUT);
+    matToBitmap(env, finalMat, outputBitmap, &context.telemetry().imageStats, context.colorLut());
+    context.endStage();
+
+    return true;
+}
+
+bool NcnnEngine::enhance(
+    const ncnn::Mat& input,
+    float strength,
+    ncnn::Mat& output,
+    RunContext& context
+) {
+    TRACE_SCOPE("NcnnEngine::enhance");
+    std::shared_lock<std::shared_mutex> lifecycle(lifecycleMutex_);
+    if (!initialized_.load()) {
+        LOGE("Движок не инициализирован");
+        return false;
+    }
+    return enhanceLocked(input, strength, output, context, true);
+}
+
+bool NcnnEngine::enhanceReduced(
+    const ncnn::Mat& input,
+    float strength,
+    ncnn::Mat& output,
+    RunContext& context
+) {
+    TRACE_SCOPE("NcnnEngine::enhanceReduced");
+    std::shared_lock<std::shared_mutex> lifecycle(lifecycleMutex_);
+    if (!initialized_.load()) {
+        LOGE("Движок не инициализирован");
+        return false;
+    }
+    return enhanceLocked(input, strength, output, context, false);
+}
+
+bool NcnnEngine::enhanceLocked(
+    const ncnn::Mat& inputMat,
+    float strength,
+    ncnn::Mat& finalMat,
+    RunContext& context,
+    bool upscaleOutput
+) {
+    TelemetryData& telemetry = context.telemetry();
+
     telemetry.fallbackUsed = false;
     telemetry.durationMsVulkan = 0;
     telemetry.durationMsCpu = 0;
@@ -444,6 +746,24 @@ bool NcnnEngine::runFull(
          kTileDefault,
          kTileOverlapDefault);
 
+    // Элементы пакета (длинные очереди) идут в устойчивом режиме: перед каждым
+    // выдерживается пауза, а число потоков берётся из бюджета. Одиночный запуск
+    // просмотрщика контекст в этот режим не переводит.
+    telemetry.sustained = TelemetryData::SustainedTelemetry{};
+    SustainedBudget sustainedBudget;
+    SustainedPerformanceController* sustained =
+        context.sustained() && isSustainedModeEnabled() ? sustained_.get() : nullptr;
+    if (sustained != nullptr) {
+        sustainedBudget = sustained->budget();
+        telemetry.sustained.enabled = true;
+        telemetry.sustained.report.applied = sustainedBudget;
+        if (!waitSustainedPause(sustainedBudget.pauseMicros, context.cancelFlag())) {
+            LOGW("Полная обработка отменена во время паузы устойчивого режима");
+            telemetry.cancelled = true;
+            return false;
+        }
+    }
+
     auto propagateExtractorError = [&](const TelemetryData& sourceTelemetry, const char* stage) {
         if (!sourceTelemetry.extractorError.hasError) {
             return;
@@ -458,18 +778,21 @@ bool NcnnEngine::runFull(
         );
     };
 
-    auto runPipeline = [&, strength](ncnn::Mat& finalMat) -> bool {
+    auto runPipeline = [&, strength](ncnn::Mat& pipelineOutput) -> bool {
         telemetry.tileTelemetry = TelemetryData::TileTelemetry{};
         telemetry.timingMs = 0;
         telemetry.seamMaxDelta = 0.0f;
         telemetry.seamMeanDelta = 0.0f;
         telemetry.gpuAllocRetryCount = 0;
 
-        ZeroDceBackend zeroDce(zeroDceNet_.get(), cancelled_);
+        ZeroDceBackend zeroDce(zeroDceNet_.get(), context);
+        if (sustained != nullptr) {
+            zeroDce.setSustainedBudget(sustained, sustainedBudget);
+        }
         TelemetryData zeroDceTelemetry;
-        auto zeroProgress = makeStageCallback(progressCallback, kStageZerodceFull);
+        auto zeroProgress = makeStageCallback(context.progressCallback(), kStageZerodceFull);
 
-        if (!zeroDce.process(inputMat, finalMat, strength, zeroDceTelemetry, zeroProgress)) {
+        if (!zeroDce.process(inputMat, pipelineOutput, strength, zeroDceTelemetry, zeroProgress, upscaleOutput)) {
             propagateExtractorError(zeroDceTelemetry, "zerodce_full");
             return false;
         }
@@ -482,7 +805,6 @@ bool NcnnEngine::runFull(
         return true;
     };
 
-    ncnn::Mat finalMat;
     auto cpuStart = std::chrono::high_resolution_clock::now();
     if (!runPipeline(finalMat)) {
         return false;
@@ -495,19 +817,13 @@ bool NcnnEngine::runFull(
         telemetry.durationMsCpu = telemetry.timingMs;
     }
 
-    matToBitmap(env, finalMat, outputBitmap);
-
-    telemetry.cancelled = cancelled_.load();
+    telemetry.cancelled = context.isCancelled();
 
     return true;
 }
 
-void NcnnEngine::cancel() {
-    LOGI("Запрошена отмена операции");
-    cancelled_ = true;
-}
-
 void NcnnEngine::release() {
+    std::unique_lock<std::shared_mutex> lifecycle(lifecycleMutex_);
     if (!initialized_.load()) {
         return;
     }
@@ -515,6 +831,7 @@ void NcnnEngine::release() {
     LOGI("Освобождение ресурсов NCNN движка");
     
     zeroDceNet_.reset();
+    sustained_.reset();
 
     currentDelegate_.store(DelegateType::CPU);
 
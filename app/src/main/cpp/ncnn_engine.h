@@ -1,22 +1,36 @@
 #ifndef NCNN_ENGINE_H
 #define NCNN_ENGINE_H
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <atomic>
 #include <mutex>
+#include <shared_mutex>
 #include <functional>
+#include <vector>
 #include <jni.h>
 #include <android/asset_manager.h>
 #include <android/bitmap.h>
+#include "color_lut.h"
+#include "cpu_accounting.h"
+#include "image_stats.h"
+#include "memory_tracker.h"
+#include "profiler.h"
+#include "sustained_performance.h"
 
 namespace ncnn {
     class Net;
     class Mat;
+    class Allocator;
+    class PoolAllocator;
+    class UnlockedPoolAllocator;
 }
 
 namespace kotopogoda {
 
+class VerificationLedger;
+
 enum class PreviewProfile {
     BALANCED = 0,
     QUALITY = 1
@@ -48,8 +62,56 @@ struct TelemetryData {
         long durationMs = 0;
     } extractorError;
 
+    // Пики памяти по стадиям PipelineStage (КиБ): учтённые аллокации запуска и
+    // VmRSS на границе стадии; processPeakRssKb — VmHWM процесса.
+    struct MemoryTelemetry {
+        long stagePeakKb[kPipelineStageCount] = {};
+        long stageRssKb[kPipelineStageCount] = {};
+        long processPeakRssKb = 0;
+    } memory;
+
+    // Профиль запуска (StageProfiler): время стадий PipelineStage, задержки
+    // тайлов и слоёв ncnn. Заполняется только в режиме профилирования.
+    struct ProfileTelemetry {
+        bool enabled = false;
+        int64_t stageMicros[kPipelineStageCount] = {};
+        LatencySummary tiles;
+        int layerCount = 0;
+        int64_t layersTotalMicros = 0;
+        // Самые медленные слои по убыванию времени, не больше kProfileTopLayers.
+        std::vector<LayerTiming> topLayers;
+    } profile;
+
+    // CPU запуска (CpuAccounting): время потока запуска и процесса, переключения
+    // контекста, время процесса по классам ядер CoreClass и маска замеченных CPU
+    // (последние два — только в режиме профилирования, иначе нули).
+    // cpuMsPerMegapixel — время процесса на мегапиксель входа.
+    struct CpuTelemetry {
+        int64_t threadCpuMicros = 0;
+        int64_t processCpuMicros = 0;
+        int64_t voluntarySwitches = 0;
+        int64_t involuntarySwitches = 0;
+        int64_t coreClassMicros[kCoreClassCount] = {};
+        uint64_t cpuMask = 0;
+        int64_t pixels = 0;
+        float cpuMsPerMegapixel = 0.0f;
+    } cpu;
+
+    // Устойчивый режим (SustainedPerformanceController) элемента пакета:
+    // применённый бюджет с фактической паузой перед запуском и решение
+    // контроллера после него. enabled — бюджет контроллера был применён.
+    struct SustainedTelemetry {
+        bool enabled = false;
+        SustainedReport report;
+    } sustained;
+
+    // Статистика 8-битного результата, собранная при его записи (matToBitmap,
+    // JpegBandEncoder); valid = false, если результат не записывался нативно.
+    ImageStats imageStats;
+
     long timingMs = 0;
     bool usedVulkan = false;
+    // Максимум stagePeakKb: сколько памяти запуск занимал одновременно.
     long peakMemoryKb = 0;
     bool cancelled = false;
     float seamMaxDelta = 0.0f;
@@ -63,8 +125,103 @@ struct TelemetryData {
     FallbackCause fallbackCause = FallbackCause::NONE;
 };
 
+// Параметры журнала проверок моделей: ключ HMAC уникален для установки,
+// reverifyIntervalSec <= 0 отключает журнал (хеш считается всегда).
+struct VerificationPolicy {
+    std::vector<uint8_t> ledgerKey;
+    int64_t reverifyIntervalSec = 0;
+};
+
 using TileProgressCallback = std::function<void(const char*, int, int)>;
 
+// Имена стадий, передаваемые в TileProgressCallback. JNI держит для них
+// готовые Java-строки (см. jni_cache.h), поэтому новые стадии добавляются и туда.
+constexpr const char* kStageZerodcePreview = "zerodce_preview";
+constexpr const char* kStageZerodceFull = "zerodce_full";
+
+// Длинная сторона рабочего разрешения Zero-DCE++: больший вход уменьшается
+// перед сетью, а результат увеличивается обратно билинейно.
+constexpr int kZeroDceMaxSide = 2048;
+
+// Контекст одного запроса к движку: собственный флаг отмены, телеметрия,
+// прогресс, пулы памяти экстрактора (блобы и рабочая область) и учёт памяти
+// запуска: пулы обёрнуты в TrackingAllocator того же MemoryTracker. В режиме
+// профилирования (setProfilingEnabled) тот же контекст ведёт StageProfiler, а
+// границы стадий отмечаются один раз через beginStage/endStage. CPU запуска
+// (CpuAccounting) считается от создания контекста до его разрушения. Всё изменяемое
+// состояние запуска живёт здесь, поэтому несколько контекстов одновременно
+// работают над общей ncnn::Net. Сам контекст принадлежит одному запуску и
+// между потоками не делится; флаг отмены можно выставлять из любого потока.
+// Устойчивый режим запуск получает только по setSustained(true): его включают
+// элементы пакета, а одиночные запуски просмотрщика идут без пауз и бюджета.
+// Цветовая LUT профиля (setColorLut) применяется при записи результата
+// (matToBitmap, JpegBandEncoder) в том же проходе, что и квантование.
+class RunContext {
+public:
+    RunContext(
+        std::atomic<bool>& cancelFlag,
+        TelemetryData& telemetry,
+        TileProgressCallback progressCallback = TileProgressCallback()
+    );
+    ~RunContext();
+
+    RunContext(const RunContext&) = delete;
+    RunContext& operator=(const RunContext&) = delete;
+
+    std::atomic<bool>& cancelFlag() const { return cancelFlag_; }
+    bool isCancelled() const { return cancelFlag_.load(); }
+    TelemetryData& telemetry() const { return telemetry_; }
+    const TileProgressCallback& progressCallback() const { return progressCallback_; }
+    MemoryTracker& memory() { return memory_; }
+    StageProfiler& profiler() { return profiler_; }
+    CpuAccounting& cpu() { return cpu_; }
+    bool sustained() const { return sustained_; }
+    void setSustained(bool sustained) { sustained_ = sustained; }
+    const ColorLut* colorLut() const { return colorLut_.get(); }
+    void setColorLut(std::shared_ptr<const ColorLut> colorLut) { colorLut_ = std::move(colorLut); }
+
+    // Граница стадии для учёта памяти и профайлера сразу.
+    void beginStage(PipelineStage stage);
+    void endStage();
+
+    ncnn::Allocator* blobAllocator() const;
+    ncnn::Allocator* workspaceAllocator() const;
+
+private:
+    std::atomic<bool>& cancelFlag_;
+    TelemetryData& telemetry_;
+    TileProgressCallback progressCallback_;
+    bool sustained_ = false;
+    std::shared_ptr<const ColorLut> colorLut_;
+    MemoryTracker memory_;
+    StageProfiler profiler_;
+    CpuAccounting cpu_;
+    std::unique_ptr<ncnn::UnlockedPoolAllocator> blobPool_;
+    std::unique_ptr<ncnn::PoolAllocator> workspacePool_;
+    std::unique_ptr<TrackingAllocator> blobAllocator_;
+    std::unique_ptr<TrackingAllocator> workspaceAllocator_;
+};
+
+// Преобразования ARGB_8888 Bitmap <-> планарный float RGB в [0, 1]. Пиксели
+// Bitmap в памяти — байты R, G, B, A (ANDROID_BITMAP_FORMAT_RGBA_8888), строки
+// с шагом info.stride; канал 0 Mat — красный, как у decodeJpegPlanar.
+// matToBitmap попутно с квантованием применяет цветовую LUT профиля, если она
+// задана, и заполняет stats уже по результату после неё.
+void bitmapToMat(JNIEnv* env, jobject bitmap, ncnn::Mat& mat);
+void matToBitmap(
+    JNIEnv* env,
+    const ncnn::Mat& mat,
+    jobject bitmap,
+    ImageStats* stats = nullptr,
+    const ColorLut* colorLut = nullptr
+);
+
+// Потокобезопасность: runPreview и runFull реентерабельны и могут выполняться
+// одновременно на одном движке, каждый со своим RunContext. Общие между ними
+// ncnn::Net и параметры движка после initialize только читаются; общий
+// SustainedPerformanceController пакетных запусков потокобезопасен. initialize и
+// release берут блокировку жизненного цикла эксклюзивно и ждут завершения
+// текущих запусков; запуск после release возвращает false.
 class NcnnEngine {
 public:
     struct ModelChecksums {
@@ -88,15 +245,25 @@ public:
         const ModelChecksums& zeroDceChecksums,
         const ModelChecksums& restormerChecksums,
         PreviewProfile profile,
-        bool forceCpu
+        bool forceCpu,
+        const VerificationPolicy& verificationPolicy = VerificationPolicy()
     );
 
     bool runPreview(
         JNIEnv* env,
         jobject sourceBitmap,
         float strength,
-        TelemetryData& telemetry,
-        const TileProgressCallback& progressCallback = TileProgressCallback()
+        RunContext& context
+    );
+
+    // Превью из уже декодированного планарного входа (нативный JPEG-декодер);
+    // результат пишется в outputBitmap того же размера, что и input.
+    bool runPreview(
+        JNIEnv* env,
+        const ncnn::Mat& input,
+        float strength,
+        jobject outputBitmap,
+        RunContext& context
     );
 
     bool runFull(
@@ -104,11 +271,30 @@ public:
         jobject sourceBitmap,
         float strength,
         jobject outputBitmap,
-        TelemetryData& telemetry,
-        const TileProgressCallback& progressCallback = TileProgressCallback()
+        RunContext& context
+    );
+
+    // Полная обработка без Bitmap: вход и выход — планарные float RGB в [0, 1].
+    // Используется пакетным пайплайном, где декодирование и кодирование идут
+    // в своих потоках.
+    bool enhance(
+        const ncnn::Mat& input,
+        float strength,
+        ncnn::Mat& output,
+        RunContext& context
+    );
+
+    // Как enhance, но без финального увеличения до размера входа: output
+    // остаётся на рабочем разрешении (длинная сторона не больше kZeroDceMaxSide).
+    // Увеличивает его потребитель полосами (writeResizedBands), не держа
+    // полноразмерный результат в памяти.
+    bool enhanceReduced(
+        const ncnn::Mat& input,
+        float strength,
+        ncnn::Mat& output,
+        RunContext& context
     );
 
-    void cancel();
     void release();
 
     bool isInitialized() const { return initialized_; }
@@ -116,15 +302,51 @@ public:
     static IntegrityFailure consumeLastIntegrityFailure();
 
 private:
+    bool previewLocked(
+        const ncnn::Mat& input,
+        float strength,
+        ncnn::Mat& output,
+        RunContext& context
+    );
+    bool enhanceLocked(
+        const ncnn::Mat& input,
+        float strength,
+        ncnn::Mat& output,
+        RunContext& context,
+        bool upscaleOutput
+    );
     bool loadModels(AAssetManager* assetManager, const std::string& modelsDir);
-    bool verifyChecksum(const std::string& filePath, const std::string& expectedChecksum);
+    bool loadParamVerified(
+        ncnn::Net& net,
+        const std::string& paramPath,
+        const std::string& expectedChecksum,
+        const char* model
+    );
+    bool loadModelVerified(
+        ncnn::Net& net,
+        const std::string& binPath,
+        const std::string& expectedChecksum,
+        const char* model
+    );
+    bool isVerifiedByLedger(const std::string& filePath, const std::string& expectedChecksum) const;
+    bool acceptChecksum(
+        const std::string& filePath,
+        const std::string& expectedChecksum,
+        const std::string& computed
+    );
     static void reportIntegrityFailure(
         const std::string& filePath,
         const std::string& expectedChecksum,
         const std::string& actualChecksum
     );
 
+    // Разделяемо — запуски, эксклюзивно — initialize/release.
+    mutable std::shared_mutex lifecycleMutex_;
+
     std::unique_ptr<ncnn::Net> zeroDceNet_;
+    std::unique_ptr<VerificationLedger> verificationLedger_;
+    // Бюджет полноразмерных запусков; создаётся в loadModels под число потоков сети.
+    std::unique_ptr<SustainedPerformanceController> sustained_;
 
     ModelChecksums zeroDceChecksums_;
     ModelChecksums restormerChecksums_;
@@ -133,7 +355,6 @@ private:
     AAssetManager* assetManager_;
 
     std::atomic<bool> initialized_;
-    std::atomic<bool> cancelled_;
     std::atomic<bool> forceCpuMode_;
     std::atomic<DelegateType> currentDelegate_;
     std::string restPrecision_;
@@ -0,0 +1,37 @@
+#ifndef PIPELINE_STAGE_H
+#define PIPELINE_STAGE_H
+
+namespace kotopogoda {
+
+// Стадии одного запуска. По ним считаются пики памяти (MemoryTracker) и время
+// (StageProfiler); порядок совпадает с массивами по стадиям в telemetry_layout
+// и с NativeTelemetryBuffer.kt.
+enum class PipelineStage {
+    CONVERT_IN = 0,
+    ZERODCE = 1,
+    BLEND = 2,
+    UPSCALE = 3,
+    CONVERT_OUT = 4,
+};
+
+constexpr int kPipelineStageCount = 5;
+
+inline const char* pipelineStageName(PipelineStage stage) {
+    switch (stage) {
+        case PipelineStage::CONVERT_IN:
+            return "convert_in";
+        case PipelineStage::ZERODCE:
+            return "zerodce";
+        case PipelineStage::BLEND:
+            return "blend";
+        case PipelineStage::UPSCALE:
+            return "upscale";
+        case PipelineStage::CONVERT_OUT:
+            return "convert_out";
+    }
+    return "unknown";
+}
+
+}
+
+#endif
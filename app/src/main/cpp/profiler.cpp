@@ -0,0 +1,195 @@
+#include "profiler.h"
+#include "ncnn_engine.h"
+#include <ncnn/layer.h>
+#include <ncnn/mat.h>
+#include <ncnn/net.h>
+#include <android/log.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+
+#define LOG_TAG "StageProfiler"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace kotopogoda {
+
+namespace {
+
+std::atomic<bool> gProfilingEnabled{false};
+
+int64_t microsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+}
+
+void appendFormat(std::string& line, const char* format, ...) {
+    char chunk[160];
+    va_list args;
+    va_start(args, format);
+    const int written = std::vsnprintf(chunk, sizeof(chunk), format, args);
+    va_end(args);
+    if (written > 0) {
+        line.append(chunk, std::min(static_cast<size_t>(written), sizeof(chunk) - 1));
+    }
+}
+
+}
+
+void setProfilingEnabled(bool enabled) {
+    gProfilingEnabled.store(enabled);
+    LOGI("Профилирование запусков %s", enabled ? "включено" : "выключено");
+}
+
+bool isProfilingEnabled() {
+    return gProfilingEnabled.load();
+}
+
+LatencySummary summarizeLatencies(std::vector<int64_t> micros) {
+    LatencySummary summary;
+    if (micros.empty()) {
+        return summary;
+    }
+    std::sort(micros.begin(), micros.end());
+    const size_t count = micros.size();
+    auto rank = [&](double percentile) {
+        const size_t position = static_cast<size_t>(std::ceil(percentile * static_cast<double>(count)));
+        return micros[std::min(count, std::max<size_t>(1, position)) - 1];
+    };
+    summary.count = static_cast<int>(count);
+    summary.p50Micros = rank(0.50);
+    summary.p95Micros = rank(0.95);
+    summary.maxMicros = micros.back();
+    return summary;
+}
+
+StageProfiler::StageProfiler(TelemetryData& telemetry, bool enabled)
+    : telemetry_(telemetry), enabled_(enabled) {}
+
+void StageProfiler::beginStage(PipelineStage stage) {
+    if (!enabled_) {
+        return;
+    }
+    endStage();
+    std::lock_guard<std::mutex> lock(mutex_);
+    currentStage_ = static_cast<int>(stage);
+    stageStart_ = Clock::now();
+}
+
+void StageProfiler::endStage() {
+    if (!enabled_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (currentStage_ < 0) {
+        return;
+    }
+    stageMicros_[currentStage_] += microsSince(stageStart_);
+    currentStage_ = -1;
+}
+
+void StageProfiler::recordTile(int64_t micros) {
+    if (!enabled_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    tileMicros_.push_back(micros);
+}
+
+void StageProfiler::recordLayer(int index, const std::string& name, const std::string& type, int64_t micros) {
+    if (!enabled_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (LayerTiming& layer : layers_) {
+        if (layer.index == index) {
+            layer.micros += micros;
+            return;
+        }
+    }
+    layers_.push_back(LayerTiming{index, name, type, micros});
+}
+
+void StageProfiler::finish() {
+    if (!enabled_) {
+        return;
+    }
+    endStage();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+
+    TelemetryData::ProfileTelemetry& profile = telemetry_.profile;
+    profile.enabled = true;
+    std::copy(std::begin(stageMicros_), std::end(stageMicros_), std::begin(profile.stageMicros));
+    profile.tiles = summarizeLatencies(tileMicros_);
+    profile.layerCount = static_cast<int>(layers_.size());
+    profile.layersTotalMicros = 0;
+    for (const LayerTiming& layer : layers_) {
+        profile.layersTotalMicros += layer.micros;
+    }
+    profile.topLayers = layers_;
+    std::stable_sort(profile.topLayers.begin(), profile.topLayers.end(), [](const LayerTiming& a, const LayerTiming& b) {
+        return a.micros > b.micros;
+    });
+    if (profile.topLayers.size() > static_cast<size_t>(kProfileTopLayers)) {
+        profile.topLayers.resize(kProfileTopLayers);
+    }
+
+    std::string line = "PROFILE";
+    for (int stage = 0; stage < kPipelineStageCount; ++stage) {
+        appendFormat(line, " %s_us=%lld",
+                     pipelineStageName(static_cast<PipelineStage>(stage)),
+                     static_cast<long long>(profile.stageMicros[stage]));
+    }
+    appendFormat(line, " tiles=%d tile_p50_us=%lld tile_p95_us=%lld tile_max_us=%lld layers=%d layers_us=%lld top=",
+                 profile.tiles.count,
+                 static_cast<long long>(profile.tiles.p50Micros),
+                 static_cast<long long>(profile.tiles.p95Micros),
+                 static_cast<long long>(profile.tiles.maxMicros),
+                 profile.layerCount,
+                 static_cast<long long>(profile.layersTotalMicros));
+    for (size_t i = 0; i < profile.topLayers.size(); ++i) {
+        const LayerTiming& layer = profile.topLayers[i];
+        appendFormat(line, "%s%s/%s:%lld",
+                     i == 0 ? "" : ",",
+                     layer.name.c_str(),
+                     layer.type.c_str(),
+                     static_cast<long long>(layer.micros));
+    }
+    LOGI("%s", line.c_str());
+}
+
+int extractWithLayerTimings(
+    const ncnn::Net& net,
+    ncnn::Extractor& ex,
+    const char* outputName,
+    ncnn::Mat& output,
+    StageProfiler& profiler
+) {
+    ex.set_light_mode(false);
+    const std::vector<ncnn::Layer*>& layers = net.layers();
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const ncnn::Layer* layer = layers[i];
+        if (layer == nullptr || layer->tops.empty() || layer->type == "Input") {
+            continue;
+        }
+        ncnn::Mat blob;
+        const auto start = std::chrono::steady_clock::now();
+        // type = 1: блоб нужен только как граница слоя, без распаковки в fp32.
+        const int ret = ex.extract(layer->tops[0], blob, 1);
+        if (ret != 0) {
+            LOGW("Профилирование: слой %zu (%s) вернул %d", i, layer->name.c_str(), ret);
+            return ret;
+        }
+        profiler.recordLayer(static_cast<int>(i), layer->name, layer->type, microsSince(start));
+    }
+    return ex.extract(outputName, output);
+}
+
+}
@@ -0,0 +1,101 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "pipeline_stage.h"
+
+namespace ncnn {
+    class Net;
+    class Extractor;
+    class Mat;
+}
+
+namespace kotopogoda {
+
+struct TelemetryData;
+
+// Режим профилирования на весь процесс. Читается при создании RunContext,
+// поэтому переключение влияет только на запуски, начатые после него.
+void setProfilingEnabled(bool enabled);
+bool isProfilingEnabled();
+
+// Сколько самых медленных слоёв попадает в телеметрию.
+constexpr int kProfileTopLayers = 8;
+
+struct LayerTiming {
+    int index = 0;
+    std::string name;
+    std::string type;
+    int64_t micros = 0;
+};
+
+// Перцентили по ближайшему рангу; пустой список даёт нули.
+struct LatencySummary {
+    int count = 0;
+    int64_t p50Micros = 0;
+    int64_t p95Micros = 0;
+    int64_t maxMicros = 0;
+};
+
+LatencySummary summarizeLatencies(std::vector<int64_t> micros);
+
+// Профиль одного запуска: монотонное время стадий PipelineStage, задержки
+// тайлов и время слоёв ncnn. Повторные стадии и слои одного запуска (уровни
+// прогрессивного превью) суммируются. Выключенный профайлер ничего не замеряет
+// и не пишет. finish сводит замеры в telemetry.profile и выводит одну строку
+// PROFILE в лог; его вызывает деструктор RunContext.
+class StageProfiler {
+public:
+    StageProfiler(TelemetryData& telemetry, bool enabled);
+
+    StageProfiler(const StageProfiler&) = delete;
+    StageProfiler& operator=(const StageProfiler&) = delete;
+
+    bool enabled() const { return enabled_; }
+
+    // Завершает текущую стадию (если есть) и начинает stage.
+    void beginStage(PipelineStage stage);
+    void endStage();
+
+    // Zero-DCE++ записывает один тайл на вывод кадра: у полной обработки выборка
+    // из одного значения (p50 = p95 = max), у прогрессивного превью — по значению
+    // на уровень.
+    void recordTile(int64_t micros);
+    void recordLayer(int index, const std::string& name, const std::string& type, int64_t micros);
+
+    void finish();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    TelemetryData& telemetry_;
+    const bool enabled_;
+    std::mutex mutex_;
+    int currentStage_ = -1;
+    Clock::time_point stageStart_;
+    int64_t stageMicros_[kPipelineStageCount] = {};
+    std::vector<int64_t> tileMicros_;
+    std::vector<LayerTiming> layers_;
+    bool finished_ = false;
+};
+
+// Экстракция outputName, при которой каждый слой сети запускается и замеряется
+// отдельно: экстрактор без light mode извлекает верхний блоб каждого слоя по
+// порядку (зависимости к этому моменту уже посчитаны), затем сам выход.
+// Промежуточные блобы при этом не освобождаются, поэтому режим только для
+// профилирования. Возвращает код ncnn, как Extractor::extract.
+int extractWithLayerTimings(
+    const ncnn::Net& net,
+    ncnn::Extractor& ex,
+    const char* outputName,
+    ncnn::Mat& output,
+    StageProfiler& profiler
+);
+
+}
+
+#endif
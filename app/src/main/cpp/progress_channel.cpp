@@ -0,0 +1,235 @@
+#include "progress_channel.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstring>
+
+#define LOG_TAG "ProgressChannel"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+namespace kotopogoda {
+
+namespace {
+
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 2;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+bool sameStage(const char* a, const char* b) {
+    if (a == b) {
+        return true;
+    }
+    return a != nullptr && b != nullptr && std::strcmp(a, b) == 0;
+}
+
+}
+
+ProgressRing::ProgressRing(size_t capacity)
+    : cells_(new Cell[roundUpToPowerOfTwo(capacity)]),
+      mask_(roundUpToPowerOfTwo(capacity) - 1),
+      enqueuePos_(0),
+      dequeuePos_(0) {
+    for (size_t i = 0; i <= mask_; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool ProgressRing::tryPush(const ProgressEvent& event) {
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = cells_[pos & mask_];
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.event = event;
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool ProgressRing::tryPop(ProgressEvent& event) {
+    size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = cells_[pos & mask_];
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                event = cell.event;
+                cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = dequeuePos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+ProgressDispatcher::ProgressDispatcher(ProgressSink sink, int maxRateHz, size_t capacity)
+    : sink_(std::move(sink)),
+      ring_(capacity),
+      interval_(std::chrono::nanoseconds(1000000000LL / std::clamp(
+          maxRateHz > 0 ? maxRateHz : kDefaultMaxRateHz, 1, 1000))),
+      hasOverflow_(false),
+      published_(0),
+      delivered_(0),
+      overflowed_(0),
+      dropped_(0) {
+    thread_ = std::thread(&ProgressDispatcher::run, this);
+}
+
+ProgressDispatcher::~ProgressDispatcher() {
+    stop();
+}
+
+int64_t ProgressDispatcher::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+void ProgressDispatcher::publish(const char* stage, int current, int total) {
+    ProgressEvent event;
+    event.stage = stage;
+    event.current = current;
+    event.total = total;
+    event.timestampNs = nowNs();
+    published_.fetch_add(1, std::memory_order_relaxed);
+    if (ring_.tryPush(event)) {
+        return;
+    }
+
+    // Диспетчер отстал на всю ёмкость кольца: сворачиваем событие в слот стадии,
+    // чтобы последнее значение дошло даже после всплеска.
+    overflowed_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(overflowMutex_);
+    for (size_t i = 0; i < overflowCount_; ++i) {
+        if (sameStage(overflow_[i].stage, stage)) {
+            if (event.timestampNs >= overflow_[i].timestampNs) {
+                overflow_[i] = event;
+            }
+            hasOverflow_.store(true, std::memory_order_release);
+            return;
+        }
+    }
+    if (overflowCount_ == kMaxStages) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    overflow_[overflowCount_++] = event;
+    hasOverflow_.store(true, std::memory_order_release);
+}
+
+std::function<void(const char*, int, int)> ProgressDispatcher::asCallback() {
+    return [this](const char* stage, int current, int total) {
+        publish(stage, current, total);
+    };
+}
+
+void ProgressDispatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        if (stopRequested_ && !thread_.joinable()) {
+            return;
+        }
+        stopRequested_ = true;
+    }
+    wake_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+        LOGI("Прогресс: опубликовано=%llu доставлено=%llu свёрнуто=%llu отброшено=%llu",
+             static_cast<unsigned long long>(publishedEvents()),
+             static_cast<unsigned long long>(deliveredEvents()),
+             static_cast<unsigned long long>(overflowedEvents()),
+             static_cast<unsigned long long>(droppedEvents()));
+    }
+}
+
+void ProgressDispatcher::run() {
+    if (sink_.onThreadStart) {
+        sink_.onThreadStart();
+    }
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    while (!stopRequested_) {
+        wake_.wait_for(lock, interval_, [this] { return stopRequested_; });
+        lock.unlock();
+        drain();
+        deliverPending();
+        lock.lock();
+    }
+    lock.unlock();
+    // Производители к этому моменту завершены: stop() вызывается после прогона.
+    drain();
+    deliverPending();
+    if (sink_.onThreadStop) {
+        sink_.onThreadStop();
+    }
+}
+
+void ProgressDispatcher::drain() {
+    ProgressEvent event;
+    while (ring_.tryPop(event)) {
+        absorb(event);
+    }
+    if (hasOverflow_.exchange(false, std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(overflowMutex_);
+        for (size_t i = 0; i < overflowCount_; ++i) {
+            absorb(overflow_[i]);
+        }
+        overflowCount_ = 0;
+    }
+}
+
+void ProgressDispatcher::absorb(const ProgressEvent& event) {
+    for (size_t i = 0; i < stageCount_; ++i) {
+        StageSlot& slot = stages_[i];
+        if (!sameStage(slot.latest.stage, event.stage)) {
+            continue;
+        }
+        // Параллельные производители могут прийти не по порядку: оставляем более позднее.
+        if (event.timestampNs >= slot.latest.timestampNs) {
+            slot.latest = event;
+            slot.pending = true;
+        }
+        return;
+    }
+    if (stageCount_ == kMaxStages) {
+        // Стадий больше, чем слотов: доставляем без объединения.
+        if (sink_.deliver) {
+            sink_.deliver(event);
+        }
+        delivered_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    StageSlot& slot = stages_[stageCount_++];
+    slot.latest = event;
+    slot.pending = true;
+}
+
+void ProgressDispatcher::deliverPending() {
+    for (size_t i = 0; i < stageCount_; ++i) {
+        StageSlot& slot = stages_[i];
+        if (!slot.pending) {
+            continue;
+        }
+        slot.pending = false;
+        if (sink_.deliver) {
+            sink_.deliver(slot.latest);
+        }
+        delivered_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+}
@@ -0,0 +1,128 @@
+#ifndef PROGRESS_CHANNEL_H
+#define PROGRESS_CHANNEL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace kotopogoda {
+
+// Событие прогресса стадии. stage должен указывать на строку со статическим
+// временем жизни (константы kStage* из ncnn_engine.h).
+struct ProgressEvent {
+    const char* stage = nullptr;
+    int32_t current = 0;
+    int32_t total = 0;
+    int64_t timestampNs = 0;
+};
+
+// Ограниченная lock-free очередь событий (алгоритм Вьюкова): любое число
+// производителей и потребителей, без аллокаций после создания. Ёмкость
+// округляется вверх до степени двойки.
+class ProgressRing {
+public:
+    explicit ProgressRing(size_t capacity);
+
+    bool tryPush(const ProgressEvent& event);
+    bool tryPop(ProgressEvent& event);
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        ProgressEvent event;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> enqueuePos_;
+    alignas(64) std::atomic<size_t> dequeuePos_;
+};
+
+// Точки входа потока диспетчера: onThreadStart/onThreadStop вызываются в самом
+// потоке (JNI прикрепляет и открепляет его от JavaVM), deliver — для каждого
+// доставляемого события.
+struct ProgressSink {
+    std::function<void()> onThreadStart;
+    std::function<void(const ProgressEvent&)> deliver;
+    std::function<void()> onThreadStop;
+};
+
+// Асинхронный канал прогресса. publish() можно вызывать из любого потока
+// вычислений: это одна запись в кольцо без блокировок и без обращения к JNI.
+// Поток диспетчера раз в 1/maxRateHz секунды забирает события и доставляет
+// по каждой стадии только последнее изменившееся, так что частота вызовов
+// в Kotlin не превышает maxRateHz на стадию. Если всплеск событий переполнил
+// кольцо, событие сворачивается в слот стадии под мьютексом: промежуточные
+// значения теряются, последнее — нет. stop() доставляет остаток и дожидается
+// потока; после него последний прогресс каждой стадии уже передан.
+class ProgressDispatcher {
+public:
+    static constexpr int kDefaultMaxRateHz = 30;
+    static constexpr size_t kDefaultCapacity = 1024;
+
+    ProgressDispatcher(ProgressSink sink, int maxRateHz, size_t capacity = kDefaultCapacity);
+    ~ProgressDispatcher();
+
+    ProgressDispatcher(const ProgressDispatcher&) = delete;
+    ProgressDispatcher& operator=(const ProgressDispatcher&) = delete;
+
+    void publish(const char* stage, int current, int total);
+    void stop();
+
+    // Совместим с TileProgressCallback.
+    std::function<void(const char*, int, int)> asCallback();
+
+    uint64_t publishedEvents() const { return published_.load(std::memory_order_relaxed); }
+    uint64_t deliveredEvents() const { return delivered_.load(std::memory_order_relaxed); }
+    uint64_t overflowedEvents() const { return overflowed_.load(std::memory_order_relaxed); }
+    uint64_t droppedEvents() const { return dropped_.load(std::memory_order_relaxed); }
+
+    static int64_t nowNs();
+
+private:
+    static constexpr size_t kMaxStages = 8;
+
+    struct StageSlot {
+        ProgressEvent latest;
+        bool pending = false;
+    };
+
+    void run();
+    void drain();
+    void absorb(const ProgressEvent& event);
+    void deliverPending();
+
+    ProgressSink sink_;
+    ProgressRing ring_;
+    std::chrono::nanoseconds interval_;
+
+    StageSlot stages_[kMaxStages];
+    size_t stageCount_ = 0;
+
+    std::mutex overflowMutex_;
+    ProgressEvent overflow_[kMaxStages];
+    size_t overflowCount_ = 0;
+    std::atomic<bool> hasOverflow_;
+
+    std::atomic<uint64_t> published_;
+    std::atomic<uint64_t> delivered_;
+    std::atomic<uint64_t> overflowed_;
+    std::atomic<uint64_t> dropped_;
+
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    bool stopRequested_ = false;
+    std::thread thread_;
+};
+
+}
+
+#endif
@@ -0,0 +1,113 @@
+#include "row_band_sink.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#define LOG_TAG "RowBandSink"
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace kotopogoda {
+
+namespace {
+
+// Левая опорная точка и вес правой для каждой координаты результата.
+struct AxisWeights {
+    std::vector<int> index;
+    std::vector<float> weight;
+};
+
+AxisWeights computeAxisWeights(int sourceSize, int targetSize) {
+    AxisWeights axis;
+    axis.index.resize(targetSize);
+    axis.weight.resize(targetSize);
+    const double scale = static_cast<double>(sourceSize) / targetSize;
+    for (int i = 0; i < targetSize; ++i) {
+        float f = static_cast<float>((i + 0.5) * scale - 0.5);
+        int s = static_cast<int>(std::floor(f));
+        f -= s;
+        if (s < 0) {
+            s = 0;
+            f = 0.0f;
+        }
+        if (s >= sourceSize - 1) {
+            s = std::max(0, sourceSize - 2);
+            f = sourceSize > 1 ? 1.0f : 0.0f;
+        }
+        axis.index[i] = s;
+        axis.weight[i] = f;
+    }
+    return axis;
+}
+
+}
+
+bool writeResizedBands(
+    const ncnn::Mat& source,
+    int width,
+    int height,
+    RowBandSink& sink,
+    const std::atomic<bool>* cancelFlag,
+    int bandRows
+) {
+    if (source.empty() || source.c != 3 || width <= 0 || height <= 0 || bandRows <= 0) {
+        LOGW("Некорректный вход для полос: %dx%dx%d -> %dx%d", source.w, source.h, source.c, width, height);
+        return false;
+    }
+    if (!sink.begin(width, height)) {
+        return false;
+    }
+
+    const bool sameSize = source.w == width && source.h == height;
+    const AxisWeights columns = sameSize ? AxisWeights() : computeAxisWeights(source.w, width);
+    const AxisWeights rows = sameSize ? AxisWeights() : computeAxisWeights(source.h, height);
+    const int lastColumn = source.w - 1;
+    const int lastRow = source.h - 1;
+
+    ncnn::Mat band;
+    for (int firstRow = 0; firstRow < height; firstRow += bandRows) {
+        if (cancelFlag != nullptr && cancelFlag->load()) {
+            return false;
+        }
+        const int count = std::min(bandRows, height - firstRow);
+        band.create(width, count, 3, 4u, nullptr);
+        if (band.empty()) {
+            LOGW("Не удалось выделить полосу %dx%d", width, count);
+            return false;
+        }
+
+        for (int c = 0; c < 3; ++c) {
+            const ncnn::Mat channel = source.channel(c);
+            float* out = band.channel(c);
+            for (int row = 0; row < count; ++row) {
+                float* outRow = out + static_cast<size_t>(row) * width;
+                const int y = firstRow + row;
+                if (sameSize) {
+                    std::memcpy(outRow, channel.row(y), sizeof(float) * width);
+                    continue;
+                }
+                const int y0 = rows.index[y];
+                const int y1 = std::min(y0 + 1, lastRow);
+                const float by = rows.weight[y];
+                const float* top = channel.row(y0);
+                const float* bottom = channel.row(y1);
+                for (int x = 0; x < width; ++x) {
+                    const int x0 = columns.index[x];
+                    const int x1 = std::min(x0 + 1, lastColumn);
+                    const float ax = columns.weight[x];
+                    const float upper = top[x0] * (1.0f - ax) + top[x1] * ax;
+                    const float lower = bottom[x0] * (1.0f - ax) + bottom[x1] * ax;
+                    outRow[x] = upper * (1.0f - by) + lower * by;
+                }
+            }
+        }
+
+        if (!sink.writeRows(band, firstRow)) {
+            return false;
+        }
+    }
+    return sink.finish();
+}
+
+}
@@ -0,0 +1,44 @@
+#ifndef ROW_BAND_SINK_H
+#define ROW_BAND_SINK_H
+
+#include <atomic>
+#include <ncnn/mat.h>
+
+namespace kotopogoda {
+
+// Высота полосы по умолчанию: 32 строки делятся на высоту MCU JPEG (8/16).
+constexpr int kRowBandHeight = 32;
+
+// Получатель результата полосами строк сверху вниз: полоса отдаётся, как только
+// её строки окончательны, и приёмнику не нужен полноразмерный буфер.
+class RowBandSink {
+public:
+    virtual ~RowBandSink() = default;
+
+    // Вызывается один раз до первой полосы.
+    virtual bool begin(int width, int height) = 0;
+    // band — планарный float RGB в [0, 1] шириной width; строки
+    // [firstRow, firstRow + band.h) результата.
+    virtual bool writeRows(const ncnn::Mat& band, int firstRow) = 0;
+    // Вызывается после последней полосы.
+    virtual bool finish() = 0;
+};
+
+// Отдаёт source, увеличенный билинейно до width x height, полосами по
+// bandRows строк. Отображение координат как у ncnn::resize_bilinear
+// (центры пикселей), поэтому результат совпадает с resize + нарезкой, но в
+// памяти одновременно только одна полоса. Совпадение размеров — просто
+// нарезка. cancelFlag (если задан) проверяется между полосами; false — отмена
+// или отказ приёмника.
+bool writeResizedBands(
+    const ncnn::Mat& source,
+    int width,
+    int height,
+    RowBandSink& sink,
+    const std::atomic<bool>* cancelFlag = nullptr,
+    int bandRows = kRowBandHeight
+);
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include "sha256_backends.h"
+
+#if defined(KOTOPOGODA_SHA256_ARMV8)
+
+#include <arm_neon.h>
+
+// Файл собирается с -march=armv8-a+crypto (см. CMakeLists.txt); вызывается
+// только после проверки HWCAP_SHA2 в рантайме.
+
+namespace kotopogoda {
+
+void sha256CompressArmv8(uint32_t state[8], const uint8_t* blocks, size_t blockCount) {
+    uint32x4_t state0 = vld1q_u32(&state[0]);
+    uint32x4_t state1 = vld1q_u32(&state[4]);
+
+    while (blockCount-- > 0) {
+        const uint32x4_t abcdSaved = state0;
+        const uint32x4_t efghSaved = state1;
+
+        uint32x4_t msg0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 0)));
+        uint32x4_t msg1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 16)));
+        uint32x4_t msg2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 32)));
+        uint32x4_t msg3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 48)));
+
+        uint32x4_t tmp0;
+        uint32x4_t tmp1;
+        uint32x4_t tmp2;
+
+        // Раунды 0-47: по 4 раунда на итерацию с расширением расписания.
+        for (int i = 0; i < 12; ++i) {
+            tmp0 = vaddq_u32(msg0, vld1q_u32(&kSha256RoundConstants[i * 4]));
+            msg0 = vsha256su0q_u32(msg0, msg1);
+            tmp2 = state0;
+            tmp1 = vsha256hq_u32(state0, state1, tmp0);
+            state1 = vsha256h2q_u32(state1, tmp2, tmp0);
+            state0 = tmp1;
+            msg0 = vsha256su1q_u32(msg0, msg2, msg3);
+
+            const uint32x4_t rotated = msg0;
+            msg0 = msg1;
+            msg1 = msg2;
+            msg2 = msg3;
+            msg3 = rotated;
+        }
+
+        // Раунды 48-63: расписание уже полностью вычислено.
+        for (int i = 12; i < 16; ++i) {
+            tmp0 = vaddq_u32(msg0, vld1q_u32(&kSha256RoundConstants[i * 4]));
+            tmp2 = state0;
+            tmp1 = vsha256hq_u32(state0, state1, tmp0);
+            state1 = vsha256h2q_u32(state1, tmp2, tmp0);
+            state0 = tmp1;
+
+            msg0 = msg1;
+            msg1 = msg2;
+            msg2 = msg3;
+        }
+
+        state0 = vaddq_u32(state0, abcdSaved);
+        state1 = vaddq_u32(state1, efghSaved);
+        blocks += 64;
+    }
+
+    vst1q_u32(&state[0], state0);
+    vst1q_u32(&state[4], state1);
+}
+
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef SHA256_BACKENDS_H
+#define SHA256_BACKENDS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "sha256_verifier.h"
+
+// Внутренние реализации функции сжатия SHA-256. Каждая обрабатывает
+// blockCount последовательных 64-байтных блоков и обновляет state.
+
+#if defined(__aarch64__)
+#define KOTOPOGODA_SHA256_ARMV8 1
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KOTOPOGODA_SHA256_X86 1
+#endif
+
+namespace kotopogoda {
+
+extern const uint32_t kSha256RoundConstants[64];
+extern const uint32_t kSha256InitialState[8];
+
+// Функция сжатия выбранного бэкенда; для неподдерживаемого — scalar.
+Sha256CompressFn sha256CompressFor(Sha256Backend backend);
+
+void sha256CompressScalar(uint32_t state[8], const uint8_t* blocks, size_t blockCount);
+
+#if defined(KOTOPOGODA_SHA256_ARMV8)
+void sha256CompressArmv8(uint32_t state[8], const uint8_t* blocks, size_t blockCount);
+#endif
+
+#if defined(KOTOPOGODA_SHA256_X86)
+void sha256CompressShaNi(uint32_t state[8], const uint8_t* blocks, size_t blockCount);
+#endif
+
+// Многобуферные ядра: независимые потоки в SIMD-лейнах. states[i] указывает на
+// состояние i-го потока, blocks[i] — на его blockCount последовательных блоков.
+#if defined(KOTOPOGODA_SHA256_ARMV8)
+void sha256CompressX4Neon(uint32_t* const states[4], const uint8_t* const blocks[4], size_t blockCount);
+#endif
+
+#if defined(KOTOPOGODA_SHA256_X86)
+void sha256CompressX8Avx2(uint32_t* const states[8], const uint8_t* const blocks[8], size_t blockCount);
+#endif
+
+}
+
+#endif
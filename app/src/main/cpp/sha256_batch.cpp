@@ -0,0 +1,559 @@
+#include "sha256_batch.h"
+#include "sha256_backends.h"
+#include "sha256_verifier.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#if defined(KOTOPOGODA_SHA256_X86)
+#include <cpuid.h>
+#endif
+
+#define LOG_TAG "Sha256Batch"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace kotopogoda {
+
+namespace {
+
+// Размер порции чтения кратен блоку SHA-256: все порции, кроме последней,
+// содержат только полные блоки, и лейнам не нужен перенос хвоста между порциями.
+constexpr size_t kChunkSize = 256 * 1024;
+static_assert(kChunkSize % Sha256::kBlockSize == 0, "chunk must hold whole blocks");
+// Сколько прочитанных порций может ждать каждый файл.
+constexpr size_t kQueueDepth = 2;
+// Ограничение шага ядра, чтобы прогресс и отмена проверялись регулярно.
+constexpr size_t kMaxStepBlocks = 1024;
+
+bool detectAvx2() {
+#if defined(KOTOPOGODA_SHA256_X86)
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    const bool osxsave = (ecx & (1u << 27)) != 0;
+    if (!osxsave) {
+        return false;
+    }
+    // ОС должна сохранять регистры YMM (XCR0 биты 1 и 2).
+    unsigned int xcrLow = 0, xcrHigh = 0;
+    __asm__("xgetbv" : "=a"(xcrLow), "=d"(xcrHigh) : "c"(0));
+    if ((xcrLow & 0x6) != 0x6) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & (1u << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+struct Chunk {
+    std::vector<uint8_t> data;
+    size_t size = 0;
+    bool last = false;
+    bool error = false;
+};
+
+// Общее состояние хеширующего потока и потока ввода-вывода.
+class ChunkPipeline {
+public:
+    ChunkPipeline(const std::vector<int>& fds, size_t readAhead)
+        : fds_(fds), queues_(fds.size()), readAhead_(readAhead) {
+    }
+
+    ~ChunkPipeline() {
+        stop();
+    }
+
+    void start() {
+        reader_ = std::thread([this] { readLoop(); });
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        cv_.notify_all();
+        if (reader_.joinable()) {
+            reader_.join();
+        }
+    }
+
+    // Блокирует до появления следующей порции файла fileIndex.
+    Chunk take(size_t fileIndex) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return stopped_ || !queues_[fileIndex].empty(); });
+        if (queues_[fileIndex].empty()) {
+            Chunk aborted;
+            aborted.last = true;
+            aborted.error = true;
+            return aborted;
+        }
+        Chunk chunk = std::move(queues_[fileIndex].front());
+        queues_[fileIndex].pop_front();
+        lock.unlock();
+        cv_.notify_all();
+        return chunk;
+    }
+
+    void recycle(std::vector<uint8_t>&& buffer) {
+        if (buffer.empty()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        freeBuffers_.push_back(std::move(buffer));
+    }
+
+private:
+    struct Reader {
+        size_t fileIndex;
+        bool regular;
+        off_t offset;
+    };
+
+    // Поток ввода-вывода держит открытыми до readAhead_ файлов (по числу лейнов)
+    // и по кругу дочитывает те, у которых очередь не заполнена. Файлы
+    // открываются в том же порядке, в каком хеширующий поток раздаёт их лейнам,
+    // поэтому ожидаемый лейном файл всегда среди читаемых.
+    void readLoop() {
+        std::vector<Reader> active;
+        size_t nextFile = 0;
+        size_t cursor = 0;
+
+        while (true) {
+            while (active.size() < readAhead_ && nextFile < fds_.size()) {
+                active.push_back(openReader(nextFile++));
+            }
+            if (active.empty()) {
+                return;
+            }
+
+            size_t picked = active.size();
+            std::vector<uint8_t> buffer;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [&] {
+                    if (stopped_) {
+                        return true;
+                    }
+                    for (size_t i = 0; i < active.size(); ++i) {
+                        const size_t candidate = (cursor + i) % active.size();
+                        if (queues_[active[candidate].fileIndex].size() < kQueueDepth) {
+                            picked = candidate;
+                            return true;
+                        }
+                    }
+                    return false;
+                });
+                if (stopped_) {
+                    return;
+                }
+                if (!freeBuffers_.empty()) {
+                    buffer = std::move(freeBuffers_.back());
+                    freeBuffers_.pop_back();
+                }
+            }
+            cursor = picked + 1;
+
+            Reader& reader = active[picked];
+            Chunk chunk = readChunk(reader, std::move(buffer));
+            const bool finished = chunk.last;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                queues_[reader.fileIndex].push_back(std::move(chunk));
+            }
+            cv_.notify_all();
+            if (finished) {
+                active.erase(active.begin() + static_cast<std::ptrdiff_t>(picked));
+            }
+        }
+    }
+
+    Reader openReader(size_t fileIndex) {
+        Reader reader{fileIndex, false, 0};
+        struct stat st;
+        const int fd = fds_[fileIndex];
+        if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            reader.regular = true;
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+        return reader;
+    }
+
+    Chunk readChunk(Reader& reader, std::vector<uint8_t>&& buffer) {
+        Chunk chunk;
+        chunk.data = std::move(buffer);
+        chunk.data.resize(kChunkSize);
+        const int fd = fds_[reader.fileIndex];
+        if (fd < 0) {
+            chunk.last = true;
+            chunk.error = true;
+            return chunk;
+        }
+        while (chunk.size < kChunkSize) {
+            const ssize_t bytesRead = reader.regular
+                ? pread(fd, chunk.data.data() + chunk.size, kChunkSize - chunk.size, reader.offset)
+                : read(fd, chunk.data.data() + chunk.size, kChunkSize - chunk.size);
+            if (bytesRead < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                chunk.size = 0;
+                chunk.last = true;
+                chunk.error = true;
+                return chunk;
+            }
+            if (bytesRead == 0) {
+                chunk.last = true;
+                break;
+            }
+            chunk.size += static_cast<size_t>(bytesRead);
+            reader.offset += bytesRead;
+        }
+        return chunk;
+    }
+
+    const std::vector<int>& fds_;
+    std::vector<std::deque<Chunk>> queues_;
+    std::vector<std::vector<uint8_t>> freeBuffers_;
+    const size_t readAhead_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopped_ = false;
+    std::thread reader_;
+};
+
+struct Lane {
+    bool busy = false;
+    size_t fileIndex = 0;
+    Chunk chunk;
+    bool hasChunk = false;
+    size_t offset = 0;
+    uint64_t totalBytes = 0;
+    alignas(32) uint32_t state[8];
+
+    size_t availableBytes() const {
+        return hasChunk ? chunk.size - offset : 0;
+    }
+};
+
+std::string finishLane(Lane& lane, Sha256CompressFn compress) {
+    const size_t tailSize = lane.availableBytes();
+    uint8_t block[Sha256::kBlockSize * 2] = {};
+    if (tailSize > 0) {
+        std::memcpy(block, lane.chunk.data.data() + lane.offset, tailSize);
+    }
+    lane.totalBytes += tailSize;
+    block[tailSize] = 0x80;
+    const size_t paddedSize = tailSize + 1 + 8 <= Sha256::kBlockSize
+        ? Sha256::kBlockSize
+        : Sha256::kBlockSize * 2;
+    const uint64_t bitLength = lane.totalBytes * 8;
+    for (int i = 0; i < 8; ++i) {
+        block[paddedSize - 1 - i] = static_cast<uint8_t>(bitLength >> (8 * i));
+    }
+    compress(lane.state, block, paddedSize / Sha256::kBlockSize);
+
+    uint8_t digest[Sha256::kDigestSize];
+    for (int i = 0; i < 8; ++i) {
+        digest[i * 4] = static_cast<uint8_t>(lane.state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(lane.state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(lane.state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(lane.state[i]);
+    }
+    return Sha256::toHex(digest, sizeof(digest));
+}
+
+void compressLanes(
+    Sha256LaneKernel kernel,
+    Sha256CompressFn single,
+    uint32_t* const states[],
+    const uint8_t* const blocks[],
+    size_t lanes,
+    size_t blockCount
+) {
+    switch (kernel) {
+#if defined(KOTOPOGODA_SHA256_ARMV8)
+        case Sha256LaneKernel::NEON_X4:
+            sha256CompressX4Neon(states, blocks, blockCount);
+            return;
+#endif
+#if defined(KOTOPOGODA_SHA256_X86)
+        case Sha256LaneKernel::AVX2_X8:
+            sha256CompressX8Avx2(states, blocks, blockCount);
+            return;
+#endif
+        default:
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                single(states[lane], blocks[lane], blockCount);
+            }
+            return;
+    }
+}
+
+}
+
+Sha256Batch::Sha256Batch() : Sha256Batch(bestKernel()) {
+}
+
+Sha256Batch::Sha256Batch(Sha256LaneKernel kernel)
+    : kernel_(isKernelSupported(kernel) ? kernel : Sha256LaneKernel::SEQUENTIAL),
+      lanes_(laneCount(kernel_)) {
+}
+
+FdStreamResult Sha256Batch::hashFds(
+    const std::vector<int>& fds,
+    std::vector<std::string>& digests,
+    std::vector<FdStreamResult>& results,
+    const Sha256BatchProgressCallback& progress
+) const {
+    digests.assign(fds.size(), std::string());
+    results.assign(fds.size(), FdStreamResult::CANCELLED);
+    if (fds.empty()) {
+        return FdStreamResult::OK;
+    }
+
+    uint64_t totalBytes = 0;
+    for (int fd : fds) {
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            totalBytes += static_cast<uint64_t>(st.st_size);
+        }
+    }
+
+    // Хвосты и последовательное ядро сжимаются лучшим одиночным бэкендом.
+    const Sha256CompressFn single = sha256CompressFor(Sha256::bestBackend());
+
+    ChunkPipeline pipeline(fds, lanes_);
+    pipeline.start();
+
+    Lane lanes[kMaxLanes];
+    size_t nextFile = 0;
+    size_t filesCompleted = 0;
+    uint64_t hashedBytes = 0;
+
+    if (progress && !progress(0, 0, totalBytes)) {
+        return FdStreamResult::CANCELLED;
+    }
+
+    while (filesCompleted < fds.size()) {
+        // Каждому занятому лейну нужен хотя бы один полный блок; законченные
+        // файлы финализируются, а освободившийся лейн берёт следующий файл.
+        size_t activeLanes = 0;
+        for (size_t i = 0; i < lanes_; ++i) {
+            Lane& lane = lanes[i];
+            while (true) {
+                if (!lane.busy) {
+                    if (nextFile >= fds.size()) {
+                        break;
+                    }
+                    lane.busy = true;
+                    lane.fileIndex = nextFile++;
+                    lane.hasChunk = false;
+                    lane.offset = 0;
+                    lane.totalBytes = 0;
+                    std::memcpy(lane.state, kSha256InitialState, sizeof(lane.state));
+                }
+                if (lane.availableBytes() >= Sha256::kBlockSize) {
+                    ++activeLanes;
+                    break;
+                }
+                if (lane.hasChunk && lane.chunk.last) {
+                    if (lane.chunk.error) {
+                        results[lane.fileIndex] = FdStreamResult::IO_ERROR;
+                        LOGW("Не удалось прочитать файл #%zu пакета", lane.fileIndex);
+                    } else {
+                        hashedBytes += lane.availableBytes();
+                        digests[lane.fileIndex] = finishLane(lane, single);
+                        results[lane.fileIndex] = FdStreamResult::OK;
+                    }
+                    pipeline.recycle(std::move(lane.chunk.data));
+                    lane.busy = false;
+                    lane.hasChunk = false;
+                    ++filesCompleted;
+                    continue;
+                }
+                if (lane.hasChunk) {
+                    pipeline.recycle(std::move(lane.chunk.data));
+                }
+                lane.chunk = pipeline.take(lane.fileIndex);
+                lane.hasChunk = true;
+                lane.offset = 0;
+            }
+        }
+        if (activeLanes == 0) {
+            continue;
+        }
+
+        size_t stepBlocks = kMaxStepBlocks;
+        for (size_t i = 0; i < lanes_; ++i) {
+            if (lanes[i].busy) {
+                stepBlocks = std::min(stepBlocks, lanes[i].availableBytes() / Sha256::kBlockSize);
+            }
+        }
+
+        // Свободные лейны многобуферного ядра сжимают данные первого занятого
+        // лейна в выброшенное состояние: ядро всегда работает на полную ширину.
+        alignas(32) uint32_t scratchStates[kMaxLanes][8];
+        uint32_t* states[kMaxLanes];
+        const uint8_t* blocks[kMaxLanes];
+        const uint8_t* filler = nullptr;
+        for (size_t i = 0; i < lanes_; ++i) {
+            if (lanes[i].busy) {
+                filler = lanes[i].chunk.data.data() + lanes[i].offset;
+                break;
+            }
+        }
+        size_t packed = 0;
+        for (size_t i = 0; i < lanes_; ++i) {
+            if (lanes[i].busy) {
+                states[packed] = lanes[i].state;
+                blocks[packed] = lanes[i].chunk.data.data() + lanes[i].offset;
+                ++packed;
+            }
+        }
+        const size_t kernelLanes = kernel_ == Sha256LaneKernel::SEQUENTIAL ? packed : lanes_;
+        for (size_t i = packed; i < kernelLanes; ++i) {
+            states[i] = scratchStates[i];
+            blocks[i] = filler;
+        }
+        compressLanes(kernel_, single, states, blocks, kernelLanes, stepBlocks);
+
+        const size_t stepBytes = stepBlocks * Sha256::kBlockSize;
+        for (size_t i = 0; i < lanes_; ++i) {
+            if (lanes[i].busy) {
+                lanes[i].offset += stepBytes;
+                lanes[i].totalBytes += stepBytes;
+                hashedBytes += stepBytes;
+            }
+        }
+
+        if (progress && !progress(filesCompleted, hashedBytes, totalBytes)) {
+            pipeline.stop();
+            for (size_t i = 0; i < fds.size(); ++i) {
+                if (results[i] != FdStreamResult::OK) {
+                    digests[i].clear();
+                }
+            }
+            return FdStreamResult::CANCELLED;
+        }
+    }
+
+    pipeline.stop();
+    if (progress) {
+        progress(filesCompleted, hashedBytes, totalBytes);
+    }
+    return FdStreamResult::OK;
+}
+
+bool Sha256Batch::isKernelSupported(Sha256LaneKernel kernel) {
+    static const bool avx2Supported = detectAvx2();
+    switch (kernel) {
+        case Sha256LaneKernel::SEQUENTIAL:
+            return true;
+        case Sha256LaneKernel::NEON_X4:
+#if defined(KOTOPOGODA_SHA256_ARMV8)
+            return true;
+#else
+            return false;
+#endif
+        case Sha256LaneKernel::AVX2_X8:
+            return avx2Supported;
+    }
+    return false;
+}
+
+Sha256LaneKernel Sha256Batch::bestKernel() {
+    static const Sha256LaneKernel selected = [] {
+        if (Sha256::bestBackend() != Sha256Backend::SCALAR) {
+            LOGI("Пакетный SHA-256: %s (аппаратный SHA-256 быстрее многобуферного SIMD)",
+                 kernelName(Sha256LaneKernel::SEQUENTIAL));
+            return Sha256LaneKernel::SEQUENTIAL;
+        }
+        const Sha256LaneKernel candidates[] = { Sha256LaneKernel::AVX2_X8, Sha256LaneKernel::NEON_X4 };
+        for (Sha256LaneKernel candidate : candidates) {
+            if (!isKernelSupported(candidate)) {
+                continue;
+            }
+            if (selfTest(candidate)) {
+                LOGI("Пакетный SHA-256: %s", kernelName(candidate));
+                return candidate;
+            }
+            LOGW("Ядро %s не прошло самопроверку, используем sequential", kernelName(candidate));
+        }
+        return Sha256LaneKernel::SEQUENTIAL;
+    }();
+    return selected;
+}
+
+const char* Sha256Batch::kernelName(Sha256LaneKernel kernel) {
+    switch (kernel) {
+        case Sha256LaneKernel::NEON_X4:
+            return "neon_x4";
+        case Sha256LaneKernel::AVX2_X8:
+            return "avx2_x8";
+        case Sha256LaneKernel::SEQUENTIAL:
+        default:
+            return "sequential";
+    }
+}
+
+size_t Sha256Batch::laneCount(Sha256LaneKernel kernel) {
+    switch (kernel) {
+        case Sha256LaneKernel::NEON_X4:
+            return 4;
+        case Sha256LaneKernel::AVX2_X8:
+            return 8;
+        case Sha256LaneKernel::SEQUENTIAL:
+        default:
+            // Несколько файлов в работе сохраняют упреждающее чтение и без SIMD.
+            return 4;
+    }
+}
+
+bool Sha256Batch::selfTest(Sha256LaneKernel kernel) {
+    if (!isKernelSupported(kernel)) {
+        return false;
+    }
+    const size_t lanes = laneCount(kernel);
+    constexpr size_t kBlocks = 3;
+
+    std::vector<uint8_t> data(kMaxLanes * kBlocks * Sha256::kBlockSize);
+    uint32_t seed = 0x12345678u;
+    for (uint8_t& byte : data) {
+        seed = seed * 1664525u + 1013904223u;
+        byte = static_cast<uint8_t>(seed >> 24);
+    }
+
+    uint32_t expected[kMaxLanes][8];
+    uint32_t actual[kMaxLanes][8];
+    uint32_t* states[kMaxLanes];
+    const uint8_t* blocks[kMaxLanes];
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        // Разные начальные состояния ловят перепутанные лейны.
+        for (int i = 0; i < 8; ++i) {
+            expected[lane][i] = kSha256InitialState[i] ^ static_cast<uint32_t>(lane * 0x9e3779b9u);
+            actual[lane][i] = expected[lane][i];
+        }
+        blocks[lane] = data.data() + lane * kBlocks * Sha256::kBlockSize;
+        states[lane] = actual[lane];
+        sha256CompressScalar(expected[lane], blocks[lane], kBlocks);
+    }
+    compressLanes(kernel, sha256CompressScalar, states, blocks, lanes, kBlocks);
+    return std::memcmp(expected, actual, lanes * sizeof(expected[0])) == 0;
+}
+
+}
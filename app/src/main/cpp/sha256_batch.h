@@ -0,0 +1,67 @@
+#ifndef SHA256_BATCH_H
+#define SHA256_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "fd_stream.h"
+
+namespace kotopogoda {
+
+// Способ параллельного сжатия нескольких потоков в Sha256Batch.
+enum class Sha256LaneKernel {
+    // Потоки сжимаются по очереди лучшим одиночным бэкендом (ARMv8 CE / SHA-NI / scalar).
+    SEQUENTIAL = 0,
+    // Четыре потока в лейнах NEON.
+    NEON_X4 = 1,
+    // Восемь потоков в лейнах AVX2.
+    AVX2_X8 = 2,
+};
+
+// Вызывается из хеширующего потока между шагами; false отменяет пакет.
+// totalBytes — сумма размеров обычных файлов (0 для pipe).
+using Sha256BatchProgressCallback =
+    std::function<bool(size_t filesCompleted, uint64_t hashedBytes, uint64_t totalBytes)>;
+
+// Пакетный SHA-256 для многих файлов: отдельный поток ввода-вывода читает
+// дескрипторы с опережением, а хеширующий поток сжимает несколько файлов
+// одновременно, по одному в каждом SIMD-лейне. Дескрипторы не закрываются.
+class Sha256Batch {
+public:
+    static constexpr size_t kMaxLanes = 8;
+
+    Sha256Batch();
+    explicit Sha256Batch(Sha256LaneKernel kernel);
+
+    Sha256LaneKernel kernel() const { return kernel_; }
+    size_t lanes() const { return lanes_; }
+
+    // digests[i] — hex-дайджест fds[i] или пустая строка, если results[i] != OK.
+    // Возвращает CANCELLED при отмене, иначе OK (ошибки отдельных файлов — в results).
+    FdStreamResult hashFds(
+        const std::vector<int>& fds,
+        std::vector<std::string>& digests,
+        std::vector<FdStreamResult>& results,
+        const Sha256BatchProgressCallback& progress = Sha256BatchProgressCallback()
+    ) const;
+
+    // Многобуферное ядро выбирается, только если нет аппаратного SHA-256:
+    // одиночный поток на ARMv8 CE / SHA-NI быстрее 4-8 лейнов обычного SIMD.
+    static Sha256LaneKernel bestKernel();
+    static bool isKernelSupported(Sha256LaneKernel kernel);
+    static const char* kernelName(Sha256LaneKernel kernel);
+    static size_t laneCount(Sha256LaneKernel kernel);
+
+    // Сверка ядра с одиночным scalar SHA-256 на потоках разной длины.
+    static bool selfTest(Sha256LaneKernel kernel);
+
+private:
+    Sha256LaneKernel kernel_;
+    size_t lanes_;
+};
+
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include "sha256_backends.h"
+
+#if defined(KOTOPOGODA_SHA256_X86)
+
+#include <immintrin.h>
+
+// Восемь независимых потоков SHA-256 в 32-битных лейнах AVX2. Вызывается
+// только после проверки поддержки AVX2 в рантайме (Sha256Batch).
+
+namespace kotopogoda {
+
+namespace {
+
+#define KOTOPOGODA_AVX2 __attribute__((target("avx2")))
+
+KOTOPOGODA_AVX2 inline __m256i rotr(__m256i x, int n) {
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+KOTOPOGODA_AVX2 inline __m256i add(__m256i a, __m256i b) {
+    return _mm256_add_epi32(a, b);
+}
+
+KOTOPOGODA_AVX2 inline __m256i bigSigma0(__m256i x) {
+    return _mm256_xor_si256(_mm256_xor_si256(rotr(x, 2), rotr(x, 13)), rotr(x, 22));
+}
+
+KOTOPOGODA_AVX2 inline __m256i bigSigma1(__m256i x) {
+    return _mm256_xor_si256(_mm256_xor_si256(rotr(x, 6), rotr(x, 11)), rotr(x, 25));
+}
+
+KOTOPOGODA_AVX2 inline __m256i smallSigma0(__m256i x) {
+    return _mm256_xor_si256(_mm256_xor_si256(rotr(x, 7), rotr(x, 18)), _mm256_srli_epi32(x, 3));
+}
+
+KOTOPOGODA_AVX2 inline __m256i smallSigma1(__m256i x) {
+    return _mm256_xor_si256(_mm256_xor_si256(rotr(x, 17), rotr(x, 19)), _mm256_srli_epi32(x, 10));
+}
+
+// Транспонирование 8x8: строка i (слова потока i) -> вектор i (слово i всех потоков).
+KOTOPOGODA_AVX2 inline void transpose8(__m256i r[8]) {
+    const __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    const __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    const __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    const __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    const __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    const __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    const __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    const __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+    const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+}
+
+KOTOPOGODA_AVX2
+void sha256CompressX8Avx2(uint32_t* const states[8], const uint8_t* const blocks[8], size_t blockCount) {
+    const __m256i byteSwapMask = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+    );
+
+    __m256i state[8];
+    for (int i = 0; i < 8; ++i) {
+        state[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(states[i]));
+    }
+    transpose8(state);
+
+    for (size_t block = 0; block < blockCount; ++block) {
+        __m256i w[16];
+        for (int half = 0; half < 2; ++half) {
+            __m256i* rows = w + half * 8;
+            for (int lane = 0; lane < 8; ++lane) {
+                rows[lane] = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(blocks[lane] + block * 64 + half * 32)
+                );
+            }
+            transpose8(rows);
+            for (int i = 0; i < 8; ++i) {
+                rows[i] = _mm256_shuffle_epi8(rows[i], byteSwapMask);
+            }
+        }
+
+        __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+        __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int t = 0; t < 64; ++t) {
+            if (t >= 16) {
+                w[t & 15] = add(
+                    add(smallSigma1(w[(t - 2) & 15]), w[(t - 7) & 15]),
+                    add(smallSigma0(w[(t - 15) & 15]), w[t & 15])
+                );
+            }
+            const __m256i choose = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            const __m256i majority = _mm256_xor_si256(
+                _mm256_and_si256(a, b),
+                _mm256_and_si256(c, _mm256_xor_si256(a, b))
+            );
+            const __m256i t1 = add(
+                add(h, bigSigma1(e)),
+                add(add(choose, _mm256_set1_epi32(static_cast<int>(kSha256RoundConstants[t]))), w[t & 15])
+            );
+            const __m256i t2 = add(bigSigma0(a), majority);
+            h = g;
+            g = f;
+            f = e;
+            e = add(d, t1);
+            d = c;
+            c = b;
+            b = a;
+            a = add(t1, t2);
+        }
+
+        state[0] = add(state[0], a);
+        state[1] = add(state[1], b);
+        state[2] = add(state[2], c);
+        state[3] = add(state[3], d);
+        state[4] = add(state[4], e);
+        state[5] = add(state[5], f);
+        state[6] = add(state[6], g);
+        state[7] = add(state[7], h);
+    }
+
+    // Транспонирование 8x8 обратимо: возвращаем состояние потоков построчно.
+    transpose8(state);
+    for (int i = 0; i < 8; ++i) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(states[i]), state[i]);
+    }
+}
+
+#undef KOTOPOGODA_AVX2
+
+}
+
+#endif
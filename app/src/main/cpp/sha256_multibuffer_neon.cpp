@@ -0,0 +1,120 @@
+#include "sha256_backends.h"
+
+#if defined(KOTOPOGODA_SHA256_ARMV8)
+
+#include <arm_neon.h>
+
+// Четыре независимых потока SHA-256 в лейнах NEON. NEON входит в базовый
+// ARMv8-A, поэтому ядро не требует проверки возможностей процессора.
+
+namespace kotopogoda {
+
+namespace {
+
+template <int N>
+inline uint32x4_t rotr(uint32x4_t x) {
+    return vorrq_u32(vshrq_n_u32(x, N), vshlq_n_u32(x, 32 - N));
+}
+
+inline uint32x4_t bigSigma0(uint32x4_t x) {
+    return veorq_u32(veorq_u32(rotr<2>(x), rotr<13>(x)), rotr<22>(x));
+}
+
+inline uint32x4_t bigSigma1(uint32x4_t x) {
+    return veorq_u32(veorq_u32(rotr<6>(x), rotr<11>(x)), rotr<25>(x));
+}
+
+inline uint32x4_t smallSigma0(uint32x4_t x) {
+    return veorq_u32(veorq_u32(rotr<7>(x), rotr<18>(x)), vshrq_n_u32(x, 3));
+}
+
+inline uint32x4_t smallSigma1(uint32x4_t x) {
+    return veorq_u32(veorq_u32(rotr<17>(x), rotr<19>(x)), vshrq_n_u32(x, 10));
+}
+
+// Транспонирование 4x4: строка i (четыре слова потока i) -> вектор i.
+inline void transpose4(uint32x4_t r[4]) {
+    const uint32x4x2_t p01 = vtrnq_u32(r[0], r[1]);
+    const uint32x4x2_t p23 = vtrnq_u32(r[2], r[3]);
+    r[0] = vcombine_u32(vget_low_u32(p01.val[0]), vget_low_u32(p23.val[0]));
+    r[1] = vcombine_u32(vget_low_u32(p01.val[1]), vget_low_u32(p23.val[1]));
+    r[2] = vcombine_u32(vget_high_u32(p01.val[0]), vget_high_u32(p23.val[0]));
+    r[3] = vcombine_u32(vget_high_u32(p01.val[1]), vget_high_u32(p23.val[1]));
+}
+
+inline uint32x4_t loadBigEndian(const uint8_t* bytes) {
+    return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(bytes)));
+}
+
+}
+
+void sha256CompressX4Neon(uint32_t* const states[4], const uint8_t* const blocks[4], size_t blockCount) {
+    uint32x4_t state[8];
+    for (int half = 0; half < 2; ++half) {
+        uint32x4_t* rows = state + half * 4;
+        for (int lane = 0; lane < 4; ++lane) {
+            rows[lane] = vld1q_u32(states[lane] + half * 4);
+        }
+        transpose4(rows);
+    }
+
+    for (size_t block = 0; block < blockCount; ++block) {
+        uint32x4_t w[16];
+        for (int group = 0; group < 4; ++group) {
+            uint32x4_t* rows = w + group * 4;
+            for (int lane = 0; lane < 4; ++lane) {
+                rows[lane] = loadBigEndian(blocks[lane] + block * 64 + group * 16);
+            }
+            transpose4(rows);
+        }
+
+        uint32x4_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32x4_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int t = 0; t < 64; ++t) {
+            if (t >= 16) {
+                w[t & 15] = vaddq_u32(
+                    vaddq_u32(smallSigma1(w[(t - 2) & 15]), w[(t - 7) & 15]),
+                    vaddq_u32(smallSigma0(w[(t - 15) & 15]), w[t & 15])
+                );
+            }
+            // vbslq: побитовый выбор, ровно Ch(e, f, g) и Maj через (a ^ b) ? c : b.
+            const uint32x4_t choose = vbslq_u32(e, f, g);
+            const uint32x4_t majority = vbslq_u32(veorq_u32(a, b), c, b);
+            const uint32x4_t t1 = vaddq_u32(
+                vaddq_u32(h, bigSigma1(e)),
+                vaddq_u32(vaddq_u32(choose, vdupq_n_u32(kSha256RoundConstants[t])), w[t & 15])
+            );
+            const uint32x4_t t2 = vaddq_u32(bigSigma0(a), majority);
+            h = g;
+            g = f;
+            f = e;
+            e = vaddq_u32(d, t1);
+            d = c;
+            c = b;
+            b = a;
+            a = vaddq_u32(t1, t2);
+        }
+
+        state[0] = vaddq_u32(state[0], a);
+        state[1] = vaddq_u32(state[1], b);
+        state[2] = vaddq_u32(state[2], c);
+        state[3] = vaddq_u32(state[3], d);
+        state[4] = vaddq_u32(state[4], e);
+        state[5] = vaddq_u32(state[5], f);
+        state[6] = vaddq_u32(state[6], g);
+        state[7] = vaddq_u32(state[7], h);
+    }
+
+    for (int half = 0; half < 2; ++half) {
+        uint32x4_t* rows = state + half * 4;
+        transpose4(rows);
+        for (int lane = 0; lane < 4; ++lane) {
+            vst1q_u32(states[lane] + half * 4, rows[lane]);
+        }
+    }
+}
+
+}
+
+#endif
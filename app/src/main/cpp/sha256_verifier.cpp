@@ -1,12 +1,30 @@
 #include "sha256_verifier.h"
-#include <fstream>
-#include <iomanip>
-#include <sstream>
+#include "sha256_backends.h"
+#include <android/log.h>
+#include <algorithm>
 #include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(KOTOPOGODA_SHA256_ARMV8)
+#include <sys/auxv.h>
+#endif
+
+#if defined(KOTOPOGODA_SHA256_X86)
+#include <cpuid.h>
+#endif
+
+#define LOG_TAG "Sha256Verifier"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+#if defined(KOTOPOGODA_SHA256_ARMV8) && !defined(HWCAP_SHA2)
+#define HWCAP_SHA2 (1 << 6)
+#endif
 
 namespace kotopogoda {
 
-static const unsigned int K[64] = {
+const uint32_t kSha256RoundConstants[64] = {
     0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
     0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
     0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
@@ -17,128 +35,409 @@ static const unsigned int K[64] = {
     0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
 };
 
-static inline unsigned int rotr(unsigned int x, unsigned int n) {
+const uint32_t kSha256InitialState[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+namespace {
+
+inline uint32_t rotr(uint32_t x, uint32_t n) {
     return (x >> n) | (x << (32 - n));
 }
 
-static inline unsigned int ch(unsigned int x, unsigned int y, unsigned int z) {
+inline uint32_t ch(uint32_t x, uint32_t y, uint32_t z) {
     return (x & y) ^ (~x & z);
 }
 
-static inline unsigned int maj(unsigned int x, unsigned int y, unsigned int z) {
+inline uint32_t maj(uint32_t x, uint32_t y, uint32_t z) {
     return (x & y) ^ (x & z) ^ (y & z);
 }
 
-static inline unsigned int sigma0(unsigned int x) {
+inline uint32_t sigma0(uint32_t x) {
     return rotr(x, 2) ^ rotr(x, 13) ^ rotr(x, 22);
 }
 
-static inline unsigned int sigma1(unsigned int x) {
+inline uint32_t sigma1(uint32_t x) {
     return rotr(x, 6) ^ rotr(x, 11) ^ rotr(x, 25);
 }
 
-static inline unsigned int gamma0(unsigned int x) {
+inline uint32_t gamma0(uint32_t x) {
     return rotr(x, 7) ^ rotr(x, 18) ^ (x >> 3);
 }
 
-static inline unsigned int gamma1(unsigned int x) {
+inline uint32_t gamma1(uint32_t x) {
     return rotr(x, 17) ^ rotr(x, 19) ^ (x >> 10);
 }
 
-static void sha256Transform(unsigned int state[8], const unsigned char block[64]) {
-    unsigned int w[64];
-    unsigned int a, b, c, d, e, f, g, h;
-    
-    for (int i = 0; i < 16; ++i) {
-        w[i] = (block[i * 4] << 24) | (block[i * 4 + 1] << 16) |
-               (block[i * 4 + 2] << 8) | block[i * 4 + 3];
-    }
-    
-    for (int i = 16; i < 64; ++i) {
-        w[i] = gamma1(w[i - 2]) + w[i - 7] + gamma0(w[i - 15]) + w[i - 16];
-    }
-    
-    a = state[0];
-    b = state[1];
-    c = state[2];
-    d = state[3];
-    e = state[4];
-    f = state[5];
-    g = state[6];
-    h = state[7];
-    
-    for (int i = 0; i < 64; ++i) {
-        unsigned int t1 = h + sigma1(e) + ch(e, f, g) + K[i] + w[i];
-        unsigned int t2 = sigma0(a) + maj(a, b, c);
-        h = g;
-        g = f;
-        f = e;
-        e = d + t1;
-        d = c;
-        c = b;
-        b = a;
-        a = t1 + t2;
-    }
-    
-    state[0] += a;
-    state[1] += b;
-    state[2] += c;
-    state[3] += d;
-    state[4] += e;
-    state[5] += f;
-    state[6] += g;
-    state[7] += h;
+bool detectArmv8Sha2() {
+#if defined(KOTOPOGODA_SHA256_ARMV8)
+    return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+#else
+    return false;
+#endif
 }
 
-std::string Sha256Verifier::computeSha256(const std::string& filePath) {
-    std::ifstream file(filePath, std::ios::binary);
-    if (!file) {
-        return "";
+bool detectX86ShaNi() {
+#if defined(KOTOPOGODA_SHA256_X86)
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    const bool hasSsse3 = (ecx & (1u << 9)) != 0;
+    const bool hasSse41 = (ecx & (1u << 19)) != 0;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    const bool hasSha = (ebx & (1u << 29)) != 0;
+    return hasSsse3 && hasSse41 && hasSha;
+#else
+    return false;
+#endif
+}
+
+struct KnownAnswer {
+    const char* message;
+    size_t repeat;
+    const char* digest;
+};
+
+// FIPS 180-2, приложение B.
+const KnownAnswer kKnownAnswers[] = {
+    { "", 1, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+    { "abc", 1, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+    {
+        "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+        1,
+        "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"
+    },
+    { "a", 1000000, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+};
+
+}
+
+void sha256CompressScalar(uint32_t state[8], const uint8_t* blocks, size_t blockCount) {
+    uint32_t w[64];
+
+    while (blockCount-- > 0) {
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (static_cast<uint32_t>(blocks[i * 4]) << 24) |
+                   (static_cast<uint32_t>(blocks[i * 4 + 1]) << 16) |
+                   (static_cast<uint32_t>(blocks[i * 4 + 2]) << 8) |
+                   static_cast<uint32_t>(blocks[i * 4 + 3]);
+        }
+
+        for (int i = 16; i < 64; ++i) {
+            w[i] = gamma1(w[i - 2]) + w[i - 7] + gamma0(w[i - 15]) + w[i - 16];
+        }
+
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        uint32_t e = state[4];
+        uint32_t f = state[5];
+        uint32_t g = state[6];
+        uint32_t h = state[7];
+
+        for (int i = 0; i < 64; ++i) {
+            uint32_t t1 = h + sigma1(e) + ch(e, f, g) + kSha256RoundConstants[i] + w[i];
+            uint32_t t2 = sigma0(a) + maj(a, b, c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+
+        blocks += 64;
+    }
+}
+
+Sha256::Sha256() : Sha256(bestBackend()) {
+}
+
+Sha256CompressFn sha256CompressFor(Sha256Backend backend) {
+    if (!Sha256::isBackendSupported(backend)) {
+        return sha256CompressScalar;
+    }
+    switch (backend) {
+#if defined(KOTOPOGODA_SHA256_ARMV8)
+        case Sha256Backend::ARMV8_CE:
+            return sha256CompressArmv8;
+#endif
+#if defined(KOTOPOGODA_SHA256_X86)
+        case Sha256Backend::X86_SHANI:
+            return sha256CompressShaNi;
+#endif
+        default:
+            return sha256CompressScalar;
+    }
+}
+
+Sha256::Sha256(Sha256Backend backend) : backend_(Sha256Backend::SCALAR), compress_(sha256CompressScalar) {
+    compress_ = sha256CompressFor(backend);
+    if (compress_ != sha256CompressScalar) {
+        backend_ = backend;
+    }
+    reset();
+}
+
+void Sha256::reset() {
+    std::memcpy(state_, kSha256InitialState, sizeof(state_));
+    bufferSize_ = 0;
+    totalBytes_ = 0;
+}
+
+void Sha256::update(const void* data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    totalBytes_ += size;
+
+    if (bufferSize_ > 0) {
+        const size_t take = std::min(size, kBlockSize - bufferSize_);
+        std::memcpy(buffer_ + bufferSize_, bytes, take);
+        bufferSize_ += take;
+        bytes += take;
+        size -= take;
+        if (bufferSize_ < kBlockSize) {
+            return;
+        }
+        compress_(state_, buffer_, 1);
+        bufferSize_ = 0;
+    }
+
+    const size_t fullBlocks = size / kBlockSize;
+    if (fullBlocks > 0) {
+        compress_(state_, bytes, fullBlocks);
+        bytes += fullBlocks * kBlockSize;
+        size -= fullBlocks * kBlockSize;
+    }
+
+    if (size > 0) {
+        std::memcpy(buffer_, bytes, size);
+        bufferSize_ = size;
+    }
+}
+
+void Sha256::final(uint8_t digest[kDigestSize]) {
+    const uint64_t bitLength = totalBytes_ * 8;
+
+    buffer_[bufferSize_++] = 0x80;
+    if (bufferSize_ > kBlockSize - 8) {
+        std::memset(buffer_ + bufferSize_, 0, kBlockSize - bufferSize_);
+        compress_(state_, buffer_, 1);
+        bufferSize_ = 0;
+    }
+    std::memset(buffer_ + bufferSize_, 0, kBlockSize - 8 - bufferSize_);
+    for (int i = 0; i < 8; ++i) {
+        buffer_[kBlockSize - 1 - i] = static_cast<uint8_t>(bitLength >> (i * 8));
+    }
+    compress_(state_, buffer_, 1);
+
+    for (int i = 0; i < 8; ++i) {
+        digest[i * 4] = static_cast<uint8_t>(state_[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(state_[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(state_[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(state_[i]);
+    }
+
+    reset();
+}
+
+std::string Sha256::finalHex() {
+    uint8_t digest[kDigestSize];
+    final(digest);
+    return toHex(digest, kDigestSize);
+}
+
+std::string Sha256::toHex(const uint8_t* data, size_t size) {
+    static const char kHexDigits[] = "0123456789abcdef";
+    std::string hex(size * 2, '0');
+    for (size_t i = 0; i < size; ++i) {
+        hex[i * 2] = kHexDigits[data[i] >> 4];
+        hex[i * 2 + 1] = kHexDigits[data[i] & 0x0f];
     }
-    
-    unsigned int state[8] = {
-        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
-        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
-    };
-    
-    unsigned char buffer[64];
-    unsigned long long totalLength = 0;
-    
-    while (file.read(reinterpret_cast<char*>(buffer), 64) || file.gcount() > 0) {
-        std::streamsize bytesRead = file.gcount();
-        totalLength += bytesRead;
-        
-        if (bytesRead < 64) {
-            buffer[bytesRead++] = 0x80;
-            
-            if (bytesRead > 56) {
-                std::memset(buffer + bytesRead, 0, 64 - bytesRead);
-                sha256Transform(state, buffer);
-                bytesRead = 0;
+    return hex;
+}
+
+bool Sha256::isBackendSupported(Sha256Backend backend) {
+    static const bool armv8Supported = detectArmv8Sha2();
+    static const bool shaNiSupported = detectX86ShaNi();
+    switch (backend) {
+        case Sha256Backend::SCALAR:
+            return true;
+        case Sha256Backend::ARMV8_CE:
+            return armv8Supported;
+        case Sha256Backend::X86_SHANI:
+            return shaNiSupported;
+    }
+    return false;
+}
+
+Sha256Backend Sha256::bestBackend() {
+    static const Sha256Backend selected = [] {
+        const Sha256Backend candidates[] = { Sha256Backend::ARMV8_CE, Sha256Backend::X86_SHANI };
+        for (Sha256Backend candidate : candidates) {
+            if (!isBackendSupported(candidate)) {
+                continue;
             }
-            
-            std::memset(buffer + bytesRead, 0, 56 - bytesRead);
-            
-            unsigned long long bitLength = totalLength * 8;
-            for (int i = 0; i < 8; ++i) {
-                buffer[63 - i] = bitLength & 0xff;
-                bitLength >>= 8;
+            if (Sha256Verifier::selfTest(candidate)) {
+                LOGI("SHA-256 backend: %s", backendName(candidate));
+                return candidate;
             }
-            
-            sha256Transform(state, buffer);
-            break;
+            LOGW("SHA-256 backend %s не прошёл самопроверку, используем scalar", backendName(candidate));
         }
-        
-        sha256Transform(state, buffer);
+        LOGI("SHA-256 backend: %s", backendName(Sha256Backend::SCALAR));
+        return Sha256Backend::SCALAR;
+    }();
+    return selected;
+}
+
+const char* Sha256::backendName(Sha256Backend backend) {
+    switch (backend) {
+        case Sha256Backend::ARMV8_CE:
+            return "armv8_ce";
+        case Sha256Backend::X86_SHANI:
+            return "x86_shani";
+        case Sha256Backend::SCALAR:
+        default:
+            return "scalar";
     }
-    
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-    for (int i = 0; i < 8; ++i) {
-        ss << std::setw(8) << state[i];
+}
+
+HmacSha256::HmacSha256(const uint8_t* key, size_t keySize) {
+    uint8_t blockKey[Sha256::kBlockSize] = {};
+    if (keySize > Sha256::kBlockSize) {
+        Sha256 keyHasher;
+        keyHasher.update(key, keySize);
+        keyHasher.final(blockKey);
+    } else if (keySize > 0) {
+        std::memcpy(blockKey, key, keySize);
+    }
+
+    uint8_t pad[Sha256::kBlockSize];
+    for (size_t i = 0; i < Sha256::kBlockSize; ++i) {
+        pad[i] = blockKey[i] ^ 0x36;
+    }
+    inner_.update(pad, sizeof(pad));
+    for (size_t i = 0; i < Sha256::kBlockSize; ++i) {
+        pad[i] = blockKey[i] ^ 0x5c;
+    }
+    outer_.update(pad, sizeof(pad));
+
+    std::memset(blockKey, 0, sizeof(blockKey));
+    std::memset(pad, 0, sizeof(pad));
+}
+
+void HmacSha256::update(const void* data, size_t size) {
+    inner_.update(data, size);
+}
+
+void HmacSha256::final(uint8_t mac[Sha256::kDigestSize]) {
+    uint8_t innerDigest[Sha256::kDigestSize];
+    inner_.final(innerDigest);
+    outer_.update(innerDigest, sizeof(innerDigest));
+    outer_.final(mac);
+}
+
+std::string HmacSha256::finalHex() {
+    uint8_t mac[Sha256::kDigestSize];
+    final(mac);
+    return Sha256::toHex(mac, sizeof(mac));
+}
+
+bool HmacSha256::equalsConstantTime(const uint8_t* a, const uint8_t* b, size_t size) {
+    uint8_t diff = 0;
+    for (size_t i = 0; i < size; ++i) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+bool Sha256Verifier::selfTest(Sha256Backend backend) {
+    if (!Sha256::isBackendSupported(backend)) {
+        return false;
+    }
+
+    for (const KnownAnswer& answer : kKnownAnswers) {
+        Sha256 hasher(backend);
+        const size_t length = std::strlen(answer.message);
+        if (length == 1 && answer.repeat > 1) {
+            uint8_t chunk[1000];
+            std::memset(chunk, answer.message[0], sizeof(chunk));
+            size_t remaining = answer.repeat;
+            while (remaining > 0) {
+                // Нечётный размер порций проверяет буферизацию update().
+                const size_t take = std::min(remaining, static_cast<size_t>(997));
+                hasher.update(chunk, take);
+                remaining -= take;
+            }
+        } else {
+            for (size_t i = 0; i < answer.repeat; ++i) {
+                hasher.update(answer.message, length);
+            }
+        }
+        if (hasher.finalHex() != answer.digest) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string Sha256Verifier::computeSha256(const std::string& filePath) {
+    return computeSha256(filePath, Sha256::bestBackend());
+}
+
+std::string Sha256Verifier::computeSha256(const std::string& filePath, Sha256Backend backend) {
+    const int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return "";
+    }
+
+    // Путь — файл приложения (модели), который не меняется во время чтения:
+    // его можно отображать целиком.
+    Sha256 hasher(backend);
+    const FdStreamResult result = streamFd(
+        fd,
+        [&hasher](const uint8_t* data, size_t size) { hasher.update(data, size); },
+        FdProgressCallback(),
+        FdReadMode::MAP
+    );
+    close(fd);
+
+    return result == FdStreamResult::OK ? hasher.finalHex() : "";
+}
+
+std::string Sha256Verifier::computeSha256Fd(
+    int fd,
+    const FdProgressCallback& progress,
+    FdStreamResult* result
+) {
+    Sha256 hasher;
+    const FdStreamResult status = streamFd(
+        fd,
+        [&hasher](const uint8_t* data, size_t size) { hasher.update(data, size); },
+        progress
+    );
+    if (result != nullptr) {
+        *result = status;
     }
-    
-    return ss.str();
+    return status == FdStreamResult::OK ? hasher.finalHex() : "";
 }
 
 bool Sha256Verifier::verify(const std::string& filePath, const std::string& expectedChecksum) {
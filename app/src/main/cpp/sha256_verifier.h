@@ -1,14 +1,85 @@
 #ifndef SHA256_VERIFIER_H
 #define SHA256_VERIFIER_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include "fd_stream.h"
 
 namespace kotopogoda {
 
+enum class Sha256Backend {
+    SCALAR = 0,
+    ARMV8_CE = 1,
+    X86_SHANI = 2,
+};
+
+using Sha256CompressFn = void (*)(uint32_t state[8], const uint8_t* blocks, size_t blockCount);
+
+// Потоковый SHA-256: update() можно вызывать произвольными порциями,
+// final() завершает вычисление. Реализация сжатия выбирается в рантайме.
+class Sha256 {
+public:
+    static constexpr size_t kDigestSize = 32;
+    static constexpr size_t kBlockSize = 64;
+
+    Sha256();
+    explicit Sha256(Sha256Backend backend);
+
+    void reset();
+    void update(const void* data, size_t size);
+    void final(uint8_t digest[kDigestSize]);
+    std::string finalHex();
+
+    Sha256Backend backend() const { return backend_; }
+    uint64_t totalBytes() const { return totalBytes_; }
+
+    static Sha256Backend bestBackend();
+    static bool isBackendSupported(Sha256Backend backend);
+    static const char* backendName(Sha256Backend backend);
+    static std::string toHex(const uint8_t* data, size_t size);
+
+private:
+    Sha256Backend backend_;
+    Sha256CompressFn compress_;
+    uint32_t state_[8];
+    uint8_t buffer_[kBlockSize];
+    size_t bufferSize_;
+    uint64_t totalBytes_;
+};
+
+// HMAC-SHA256 (RFC 2104) поверх потокового Sha256.
+class HmacSha256 {
+public:
+    HmacSha256(const uint8_t* key, size_t keySize);
+
+    void update(const void* data, size_t size);
+    void final(uint8_t mac[Sha256::kDigestSize]);
+    std::string finalHex();
+
+    static bool equalsConstantTime(const uint8_t* a, const uint8_t* b, size_t size);
+
+private:
+    Sha256 inner_;
+    Sha256 outer_;
+};
+
 class Sha256Verifier {
 public:
     static std::string computeSha256(const std::string& filePath);
+    static std::string computeSha256(const std::string& filePath, Sha256Backend backend);
     static bool verify(const std::string& filePath, const std::string& expectedChecksum);
+
+    // Хеширует открытый дескриптор с начала файла (см. streamFd). При ошибке
+    // или отмене возвращает пустую строку и соответствующий статус.
+    static std::string computeSha256Fd(
+        int fd,
+        const FdProgressCallback& progress,
+        FdStreamResult* result
+    );
+
+    // Проверка реализации на известных векторах (FIPS 180-2).
+    static bool selfTest(Sha256Backend backend);
 };
 
 }
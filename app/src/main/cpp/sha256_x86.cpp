@@ -0,0 +1,74 @@
+#include "sha256_backends.h"
+
+#if defined(KOTOPOGODA_SHA256_X86)
+
+#include <immintrin.h>
+
+// Реализация на инструкциях Intel SHA Extensions. Вызывается только после
+// проверки CPUID (leaf 7, EBX bit 29) в рантайме.
+
+namespace kotopogoda {
+
+__attribute__((target("sha,sse4.1,ssse3")))
+void sha256CompressShaNi(uint32_t state[8], const uint8_t* blocks, size_t blockCount) {
+    const __m128i byteSwapMask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // Перекладываем состояние в раскладку ABEF/CDGH, которую ожидает sha256rnds2.
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    while (blockCount-- > 0) {
+        const __m128i abefSaved = state0;
+        const __m128i cdghSaved = state1;
+
+        __m128i msg[4];
+        for (int i = 0; i < 4; ++i) {
+            msg[i] = _mm_shuffle_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + i * 16)),
+                byteSwapMask
+            );
+        }
+
+        for (int group = 0; group < 16; ++group) {
+            const __m128i& current = msg[group & 3];
+            __m128i words = _mm_add_epi32(
+                current,
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&kSha256RoundConstants[group * 4]))
+            );
+            state1 = _mm_sha256rnds2_epu32(state1, state0, words);
+            words = _mm_shuffle_epi32(words, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, words);
+
+            if (group < 12) {
+                // W[g+4] = msg2(msg1(W[g], W[g+1]) + alignr(W[g+3], W[g+2]), W[g+3])
+                __m128i& next = msg[group & 3];
+                const __m128i& w1 = msg[(group + 1) & 3];
+                const __m128i& w2 = msg[(group + 2) & 3];
+                const __m128i& w3 = msg[(group + 3) & 3];
+                __m128i scheduled = _mm_sha256msg1_epu32(next, w1);
+                scheduled = _mm_add_epi32(scheduled, _mm_alignr_epi8(w3, w2, 4));
+                next = _mm_sha256msg2_epu32(scheduled, w3);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, abefSaved);
+        state1 = _mm_add_epi32(state1, cdghSaved);
+        blocks += 64;
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+}
+
+#endif
@@ -0,0 +1,228 @@
+#include "sustained_performance.h"
+#include <android/log.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#define LOG_TAG "SustainedPerformance"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+namespace kotopogoda {
+
+namespace {
+
+std::atomic<bool> gSustainedModeEnabled{true};
+
+// Неудачный подъём удваивает ожидание следующего, но не больше чем в 8 раз.
+constexpr int64_t kMaxHoldMultiplier = 8;
+
+int64_t steadyMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+const char* decisionName(SustainedDecision decision) {
+    switch (decision) {
+        case SustainedDecision::THROTTLE: return "throttle";
+        case SustainedDecision::RECOVER: return "recover";
+        case SustainedDecision::HOLD: break;
+    }
+    return "hold";
+}
+
+double median(std::vector<double> values) {
+    const size_t middle = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + middle, values.end());
+    if (values.size() % 2 != 0) {
+        return values[middle];
+    }
+    const double upper = values[middle];
+    return (upper + *std::max_element(values.begin(), values.begin() + middle)) / 2.0;
+}
+
+std::vector<SustainedBudget> buildLadder(const SustainedConfig& config) {
+    std::vector<SustainedBudget> ladder;
+    auto push = [&ladder](int threads, int tileSize, int64_t pauseMicros) {
+        SustainedBudget step;
+        step.level = static_cast<int>(ladder.size());
+        step.threads = threads;
+        step.tileSize = tileSize;
+        step.pauseMicros = pauseMicros;
+        ladder.push_back(step);
+    };
+
+    int threads = config.maxThreads;
+    int tileSize = config.baseTileSize;
+    int64_t pause = 0;
+    push(threads, tileSize, pause);
+    if (config.pauseStepMicros > 0) {
+        pause = std::min(config.pauseStepMicros, config.maxPauseMicros);
+        push(threads, tileSize, pause);
+    }
+    while (threads > config.minThreads) {
+        push(--threads, tileSize, pause);
+    }
+    while (tileSize > 0 && tileSize / 2 >= config.minTileSize) {
+        tileSize /= 2;
+        push(threads, tileSize, pause);
+    }
+    while (pause > 0 && pause < config.maxPauseMicros) {
+        pause = std::min(pause * 2, config.maxPauseMicros);
+        push(threads, tileSize, pause);
+    }
+    return ladder;
+}
+
+SustainedConfig normalized(SustainedConfig config) {
+    config.maxThreads = std::max(1, config.maxThreads);
+    config.minThreads = std::max(1, std::min(config.minThreads, config.maxThreads));
+    config.minTileSize = std::max(1, config.minTileSize);
+    config.pauseStepMicros = std::max<int64_t>(0, config.pauseStepMicros);
+    config.maxPauseMicros = std::max<int64_t>(0, config.maxPauseMicros);
+    config.window = std::max(1, config.window);
+    config.recoverHoldMicros = std::max<int64_t>(0, config.recoverHoldMicros);
+    return config;
+}
+
+}
+
+void setSustainedModeEnabled(bool enabled) {
+    gSustainedModeEnabled.store(enabled);
+    LOGI("Режим устойчивой производительности %s", enabled ? "включён" : "выключен");
+}
+
+bool isSustainedModeEnabled() {
+    return gSustainedModeEnabled.load();
+}
+
+SustainedPerformanceController::SustainedPerformanceController(
+    const SustainedConfig& config,
+    MicrosClock clock
+)
+    : config_(normalized(config)),
+      clock_(clock ? std::move(clock) : MicrosClock(steadyMicros)),
+      ladder_(buildLadder(config_)),
+      bestByThreads_(config_.maxThreads + 1, 0.0),
+      levelSince_(clock_()),
+      recoverHold_(config_.recoverHoldMicros) {}
+
+SustainedBudget SustainedPerformanceController::budget() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (lastRunEnd_ < 0) {
+        SustainedBudget result = ladder_[level_];
+        result.pauseMicros = 0;
+        return result;
+    }
+    const int64_t now = clock_();
+    const int64_t idle = now - lastRunEnd_;
+    if (level_ > 0 && config_.cooldownResetMicros > 0 && idle >= config_.cooldownResetMicros) {
+        LOGI("Устойчивый режим: простой %lld с, уровень %d -> 0",
+             static_cast<long long>(idle / 1000000), level_);
+        changeLevelLocked(0, now);
+        probing_ = false;
+        recoverHold_ = config_.recoverHoldMicros;
+    }
+    SustainedBudget result = ladder_[level_];
+    result.pauseMicros = std::max<int64_t>(0, result.pauseMicros - idle);
+    return result;
+}
+
+int SustainedPerformanceController::level() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return level_;
+}
+
+double SustainedPerformanceController::baselineLocked(int threads) const {
+    const double scaled = bestByThreads_[config_.maxThreads] * threads / config_.maxThreads;
+    return std::max(bestByThreads_[threads], scaled);
+}
+
+void SustainedPerformanceController::changeLevelLocked(int level, int64_t now) {
+    level_ = level;
+    levelSince_ = now;
+    window_.clear();
+    ++levelChanges_;
+}
+
+SustainedDecision SustainedPerformanceController::recordTile(
+    const SustainedBudget& applied,
+    int64_t pixels,
+    int64_t micros,
+    SustainedReport* report
+) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int64_t now = clock_();
+    lastRunEnd_ = now;
+    SustainedDecision decision = SustainedDecision::HOLD;
+    double windowThroughput = 0.0;
+    const int threads = std::max(1, std::min(applied.threads, config_.maxThreads));
+
+    const bool sampled = applied.level == level_ && pixels > 0 && micros > 0;
+    if (sampled) {
+        window_.push_back(static_cast<double>(pixels) / static_cast<double>(micros));
+        while (static_cast<int>(window_.size()) > config_.window) {
+            window_.pop_front();
+        }
+    }
+
+    if (!window_.empty()) {
+        windowThroughput = median(std::vector<double>(window_.begin(), window_.end()));
+    }
+    if (sampled && static_cast<int>(window_.size()) >= config_.window) {
+        double& best = bestByThreads_[threads];
+        best = std::max(best, windowThroughput);
+        const double baseline = baselineLocked(threads);
+        const bool last = level_ + 1 >= static_cast<int>(ladder_.size());
+
+        if (windowThroughput < baseline * config_.throttleRatio) {
+            if (probing_) {
+                recoverHold_ = std::min(recoverHold_ * 2, config_.recoverHoldMicros * kMaxHoldMultiplier);
+            }
+            probing_ = false;
+            if (!last) {
+                decision = SustainedDecision::THROTTLE;
+                changeLevelLocked(level_ + 1, now);
+            }
+        } else {
+            probing_ = false;
+            if (level_ > 0 &&
+                windowThroughput >= baseline * config_.recoverRatio &&
+                now - levelSince_ >= recoverHold_) {
+                decision = SustainedDecision::RECOVER;
+                changeLevelLocked(level_ - 1, now);
+                probing_ = true;
+                if (level_ == 0) {
+                    recoverHold_ = config_.recoverHoldMicros;
+                }
+            }
+        }
+    }
+
+    const double baseline = baselineLocked(threads);
+    if (decision != SustainedDecision::HOLD) {
+        const SustainedBudget& next = ladder_[level_];
+        LOGI("Устойчивый режим: %s, уровень %d -> %d, threads=%d tile=%d pause_ms=%lld, "
+             "окно %.2f Мп/с при эталоне %.2f Мп/с",
+             decisionName(decision),
+             applied.level,
+             level_,
+             next.threads,
+             next.tileSize,
+             static_cast<long long>(next.pauseMicros / 1000),
+             windowThroughput,
+             baseline);
+    }
+    if (report != nullptr) {
+        report->applied = applied;
+        report->decision = decision;
+        report->nextLevel = level_;
+        report->levelChanges = levelChanges_;
+        // Пикселей в мкс — это и есть Мп/с.
+        report->windowMpps = static_cast<float>(windowThroughput);
+        report->baselineMpps = static_cast<float>(baseline);
+    }
+    return decision;
+}
+
+}
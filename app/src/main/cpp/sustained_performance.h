@@ -0,0 +1,131 @@
+#ifndef SUSTAINED_PERFORMANCE_H
+#define SUSTAINED_PERFORMANCE_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace kotopogoda {
+
+// Режим устойчивой производительности на весь процесс (по умолчанию включён).
+// Читается перед каждым элементом пакета.
+void setSustainedModeEnabled(bool enabled);
+bool isSustainedModeEnabled();
+
+// Бюджет элемента пакета на одном уровне лестницы контроллера.
+// tileSize 0 — вход обрабатывается без тайлов; pauseMicros — пауза между
+// изображениями, которую нужно выдержать перед запуском.
+struct SustainedBudget {
+    int level = 0;
+    int threads = 0;
+    int tileSize = 0;
+    int64_t pauseMicros = 0;
+};
+
+struct SustainedConfig {
+    int maxThreads = 4;
+    int minThreads = 1;
+    // 0 — путь без тайлов, шаги по размеру тайла пропускаются.
+    int baseTileSize = 0;
+    int minTileSize = 128;
+    int64_t pauseStepMicros = 250000;
+    int64_t maxPauseMicros = 2000000;
+    // Тайлов в скользящем окне; решение принимается по медиане полного окна.
+    int window = 6;
+    // Медиана окна ниже throttleRatio эталона — шаг вниз по лестнице.
+    float throttleRatio = 0.7f;
+    // Медиана не ниже recoverRatio эталона в течение recoverHoldMicros — шаг вверх.
+    float recoverRatio = 0.9f;
+    int64_t recoverHoldMicros = 30000000;
+    // Простой без запусков не короче этого — устройство остыло, уровень
+    // сбрасывается на верхний сразу, без пошагового подъёма.
+    int64_t cooldownResetMicros = 120000000;
+};
+
+// Коды совпадают с NativeSustainedTelemetry в Kotlin.
+enum class SustainedDecision {
+    HOLD = 0,
+    THROTTLE = 1,
+    RECOVER = 2,
+};
+
+// Что контроллер применил к запуску и что решил после него.
+struct SustainedReport {
+    SustainedBudget applied;
+    SustainedDecision decision = SustainedDecision::HOLD;
+    int nextLevel = 0;
+    int levelChanges = 0;
+    // Медиана окна и эталон для потоков applied.threads, Мп/с.
+    float windowMpps = 0.0f;
+    float baselineMpps = 0.0f;
+};
+
+// Монотонное время в мкс; подменяется в хостовой симуляции.
+using MicrosClock = std::function<int64_t()>;
+
+// Контроллер устойчивой производительности для длинных очередей. Следит за
+// пропускной способностью тайлов (пикселей в мкс) в скользящем окне и при
+// троттлинге спускается по лестнице бюджетов: сначала пауза между
+// изображениями, затем меньше потоков, затем меньше тайл (если путь тайловый),
+// затем пауза удваивается до maxPauseMicros. Эталон для числа потоков — лучшая
+// медиана окна, замеченная на нём, но не ниже линейной доли эталона на
+// maxThreads: так уровень, впервые увиденный уже горячим, не считается
+// нормой. Вверх контроллер поднимается на один уровень после
+// recoverHoldMicros без троттлинга; если подъём сразу приводит к троттлингу,
+// следующий подъём ждёт вдвое дольше. После долгого простоя контроллер
+// возвращается наверх сразу. После смены уровня окно набирается заново.
+// Потокобезопасен.
+class SustainedPerformanceController {
+public:
+    explicit SustainedPerformanceController(
+        const SustainedConfig& config = SustainedConfig(),
+        MicrosClock clock = MicrosClock()
+    );
+
+    SustainedPerformanceController(const SustainedPerformanceController&) = delete;
+    SustainedPerformanceController& operator=(const SustainedPerformanceController&) = delete;
+
+    // Бюджет следующего запуска. pauseMicros — сколько ещё ждать: время с
+    // конца предыдущего запуска засчитывается в паузу, а простой дольше
+    // cooldownResetMicros возвращает контроллер на уровень 0.
+    SustainedBudget budget();
+
+    // Тайл из pixels пикселей обработан за micros при бюджете applied.
+    // Отсчёт, снятый на другом уровне (параллельный запуск начался до смены),
+    // в окно не попадает. report, если задан, заполняется решением.
+    SustainedDecision recordTile(
+        const SustainedBudget& applied,
+        int64_t pixels,
+        int64_t micros,
+        SustainedReport* report = nullptr
+    );
+
+    int level() const;
+    int levelCount() const { return static_cast<int>(ladder_.size()); }
+    const SustainedBudget& ladderStep(int level) const { return ladder_[level]; }
+
+private:
+    double baselineLocked(int threads) const;
+    void changeLevelLocked(int level, int64_t now);
+
+    const SustainedConfig config_;
+    const MicrosClock clock_;
+    std::vector<SustainedBudget> ladder_;
+
+    mutable std::mutex mutex_;
+    int level_ = 0;
+    std::deque<double> window_;
+    // Лучшая медиана окна по числу потоков, пикселей в мкс.
+    std::vector<double> bestByThreads_;
+    int64_t levelSince_ = 0;
+    int64_t lastRunEnd_ = -1;
+    int64_t recoverHold_ = 0;
+    bool probing_ = false;
+    int levelChanges_ = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,183 @@
+#include "telemetry_buffer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace kotopogoda {
+
+namespace {
+
+template <typename T>
+void put(uint8_t* base, size_t offset, T value) {
+    std::memcpy(base + offset, &value, sizeof(T));
+}
+
+int32_t precisionCode(const std::string& precision) {
+    if (precision == "fp16") {
+        return telemetry_layout::kPrecisionFp16;
+    }
+    if (precision == "fp32") {
+        return telemetry_layout::kPrecisionFp32;
+    }
+    return telemetry_layout::kPrecisionUnknown;
+}
+
+// Копирует не больше length - 1 байт, остаток поля заполняется нулями.
+void putText(uint8_t* base, size_t offset, size_t length, const std::string& text) {
+    const size_t copied = std::min(text.size(), length - 1);
+    std::memcpy(base + offset, text.data(), copied);
+    std::memset(base + offset + copied, 0, length - copied);
+}
+
+void writeProfile(uint8_t* base, const TelemetryData::ProfileTelemetry& profile) {
+    using namespace telemetry_layout;
+    std::memset(base + kOffsetStageMicros, 0, kProfileEnd - kOffsetStageMicros);
+    if (!profile.enabled) {
+        return;
+    }
+    for (int stage = 0; stage < kPipelineStageCount; ++stage) {
+        put<int64_t>(base, kOffsetStageMicros + static_cast<size_t>(stage) * sizeof(int64_t), profile.stageMicros[stage]);
+    }
+    put<int32_t>(base, kOffsetTileCount, profile.tiles.count);
+    put<int32_t>(base, kOffsetLayerCount, profile.layerCount);
+    put<int64_t>(base, kOffsetTileP50Micros, profile.tiles.p50Micros);
+    put<int64_t>(base, kOffsetTileP95Micros, profile.tiles.p95Micros);
+    put<int64_t>(base, kOffsetTileMaxMicros, profile.tiles.maxMicros);
+    put<int64_t>(base, kOffsetLayersMicros, profile.layersTotalMicros);
+
+    const size_t topCount = std::min(profile.topLayers.size(), static_cast<size_t>(kProfileTopLayers));
+    put<int32_t>(base, kOffsetTopLayerCount, static_cast<int32_t>(topCount));
+    for (size_t i = 0; i < topCount; ++i) {
+        const LayerTiming& layer = profile.topLayers[i];
+        const size_t record = kOffsetTopLayers + i * kTopLayerSize;
+        put<int64_t>(base, record + kTopLayerMicros, layer.micros);
+        put<int32_t>(base, record + kTopLayerIndex, layer.index);
+        putText(base, record + kTopLayerType, kTopLayerTypeLength, layer.type);
+        putText(base, record + kTopLayerName, kTopLayerNameLength, layer.name);
+    }
+}
+
+void writeCpu(uint8_t* base, const TelemetryData::CpuTelemetry& cpu) {
+    using namespace telemetry_layout;
+    put<int64_t>(base, kOffsetThreadCpuMicros, cpu.threadCpuMicros);
+    put<int64_t>(base, kOffsetProcessCpuMicros, cpu.processCpuMicros);
+    put<int64_t>(base, kOffsetVoluntarySwitches, cpu.voluntarySwitches);
+    put<int64_t>(base, kOffsetInvoluntarySwitches, cpu.involuntarySwitches);
+    for (int coreClass = 0; coreClass < kCoreClassCount; ++coreClass) {
+        put<int64_t>(base, kOffsetCoreClassMicros + static_cast<size_t>(coreClass) * sizeof(int64_t),
+                     cpu.coreClassMicros[coreClass]);
+    }
+    put<uint64_t>(base, kOffsetCpuMask, cpu.cpuMask);
+    put<int64_t>(base, kOffsetPixels, cpu.pixels);
+    put<float>(base, kOffsetCpuMsPerMegapixel, cpu.cpuMsPerMegapixel);
+    put<int32_t>(base, kOffsetCpuReserved, 0);
+}
+
+void writeSustained(uint8_t* base, const TelemetryData::SustainedTelemetry& sustained) {
+    using namespace telemetry_layout;
+    std::memset(base + kOffsetSustainedLevel, 0, kOffsetStatsPixels - kOffsetSustainedLevel);
+    if (!sustained.enabled) {
+        return;
+    }
+    const SustainedReport& report = sustained.report;
+    put<int32_t>(base, kOffsetSustainedLevel, report.applied.level);
+    put<int32_t>(base, kOffsetSustainedThreads, report.applied.threads);
+    put<int32_t>(base, kOffsetSustainedTileSize, report.applied.tileSize);
+    put<int32_t>(base, kOffsetSustainedDecision, static_cast<int32_t>(report.decision));
+    put<int64_t>(base, kOffsetSustainedPauseMicros, report.applied.pauseMicros);
+    put<int32_t>(base, kOffsetSustainedNextLevel, report.nextLevel);
+    put<int32_t>(base, kOffsetSustainedChanges, report.levelChanges);
+    put<float>(base, kOffsetSustainedWindowMpps, report.windowMpps);
+    put<float>(base, kOffsetSustainedBaselineMpps, report.baselineMpps);
+}
+
+void writeImageStats(uint8_t* base, const ImageStats& stats) {
+    using namespace telemetry_layout;
+    std::memset(base + kOffsetStatsPixels, 0, kSize - kOffsetStatsPixels);
+    if (!stats.valid) {
+        return;
+    }
+    put<int64_t>(base, kOffsetStatsPixels, stats.pixels);
+    put<float>(base, kOffsetStatsLumaMean, stats.lumaMean);
+    put<float>(base, kOffsetStatsDarkShare, stats.darkShare);
+    put<float>(base, kOffsetStatsSharpness, stats.sharpness);
+    put<float>(base, kOffsetStatsNoise, stats.noise);
+    put<float>(base, kOffsetStatsLumaP05, stats.lumaP05);
+    put<float>(base, kOffsetStatsLumaP50, stats.lumaP50);
+    put<float>(base, kOffsetStatsLumaP95, stats.lumaP95);
+    put<float>(base, kOffsetStatsClippedShadows, stats.clippedShadowShare);
+    put<float>(base, kOffsetStatsClippedHighlights, stats.clippedHighlightShare);
+    put<float>(base, kOffsetStatsSaturationMean, stats.saturationMean);
+    put<float>(base, kOffsetStatsSaturatedShare, stats.saturatedShare);
+    std::memcpy(base + kOffsetStatsHistogram, stats.histogram, sizeof(stats.histogram));
+}
+
+}
+
+bool writeTelemetryBuffer(void* buffer, size_t capacity, const TelemetryData& telemetry, bool success) {
+    using namespace telemetry_layout;
+    if (buffer == nullptr || capacity < kSize) {
+        return false;
+    }
+    auto* base = static_cast<uint8_t*>(buffer);
+
+    int32_t flags = 0;
+    if (success) flags |= kFlagSuccess;
+    if (telemetry.usedVulkan) flags |= kFlagUsedVulkan;
+    if (telemetry.cancelled) flags |= kFlagCancelled;
+    if (telemetry.fallbackUsed) flags |= kFlagFallbackUsed;
+    if (telemetry.tileTelemetry.tileUsed) flags |= kFlagTileUsed;
+    if (telemetry.profile.enabled) flags |= kFlagProfiled;
+    if (telemetry.sustained.enabled) flags |= kFlagSustained;
+    if (telemetry.imageStats.valid) flags |= kFlagImageStats;
+
+    put<int32_t>(base, kOffsetSize, static_cast<int32_t>(kSize));
+    put<int32_t>(base, kOffsetFlags, flags);
+    put<int32_t>(base, kOffsetFallbackCause, static_cast<int32_t>(telemetry.fallbackCause));
+    put<int64_t>(base, kOffsetTimingMs, static_cast<int64_t>(telemetry.timingMs));
+    put<int64_t>(base, kOffsetPeakMemoryKb, static_cast<int64_t>(telemetry.peakMemoryKb));
+    put<int64_t>(base, kOffsetDurationMsVulkan, static_cast<int64_t>(telemetry.durationMsVulkan));
+    put<int64_t>(base, kOffsetDurationMsCpu, static_cast<int64_t>(telemetry.durationMsCpu));
+    put<int32_t>(base, kOffsetTileSize, static_cast<int32_t>(telemetry.tileTelemetry.tileSize));
+    put<int32_t>(base, kOffsetTileOverlap, static_cast<int32_t>(telemetry.tileTelemetry.overlap));
+    put<int32_t>(base, kOffsetTilesTotal, static_cast<int32_t>(telemetry.tileTelemetry.totalTiles));
+    put<int32_t>(base, kOffsetTilesCompleted, static_cast<int32_t>(telemetry.tileTelemetry.processedTiles));
+    put<float>(base, kOffsetSeamMaxDelta, telemetry.seamMaxDelta);
+    put<float>(base, kOffsetSeamMeanDelta, telemetry.seamMeanDelta);
+    put<int32_t>(base, kOffsetGpuAllocRetries, static_cast<int32_t>(telemetry.gpuAllocRetryCount));
+    put<int32_t>(base, kOffsetDelegate, static_cast<int32_t>(telemetry.delegate));
+    put<int32_t>(base, kOffsetRestPrecision, precisionCode(telemetry.restPrecision));
+    put<int32_t>(base, kOffsetReserved, 0);
+    for (int stage = 0; stage < kPipelineStageCount; ++stage) {
+        const size_t slot = static_cast<size_t>(stage) * sizeof(int64_t);
+        put<int64_t>(base, kOffsetStagePeakKb + slot, static_cast<int64_t>(telemetry.memory.stagePeakKb[stage]));
+        put<int64_t>(base, kOffsetStageRssKb + slot, static_cast<int64_t>(telemetry.memory.stageRssKb[stage]));
+    }
+    put<int64_t>(base, kOffsetProcessPeakRssKb, static_cast<int64_t>(telemetry.memory.processPeakRssKb));
+    writeProfile(base, telemetry.profile);
+    writeCpu(base, telemetry.cpu);
+    writeSustained(base, telemetry.sustained);
+    writeImageStats(base, telemetry.imageStats);
+    put<int32_t>(base, kOffsetVersion, kVersion);
+    return true;
+}
+
+bool writeBatchItemRecord(void* buffer, size_t capacity, size_t index, const BatchItemResult& result) {
+    using namespace batch_item_layout;
+    if (buffer == nullptr || capacity < (index + 1) * kSize) {
+        return false;
+    }
+    auto* base = static_cast<uint8_t*>(buffer) + index * kSize;
+
+    const bool success = result.state == BatchItemState::SUCCEEDED;
+    writeTelemetryBuffer(base + kOffsetTelemetry, telemetry_layout::kSize, result.telemetry, success);
+    put<int32_t>(base, kOffsetStoppedAt, static_cast<int32_t>(result.stoppedAt));
+    put<int64_t>(base, kOffsetDecodeMs, result.decodeMs);
+    put<int64_t>(base, kOffsetInferMs, result.inferMs);
+    put<int64_t>(base, kOffsetEncodeMs, result.encodeMs);
+    put<int32_t>(base, kOffsetWidth, result.width);
+    put<int32_t>(base, kOffsetHeight, result.height);
+    put<int32_t>(base, kOffsetState, static_cast<int32_t>(result.state));
+    return true;
+}
+
+}
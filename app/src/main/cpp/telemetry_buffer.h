@@ -0,0 +1,154 @@
+#ifndef TELEMETRY_BUFFER_H
+#define TELEMETRY_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include "batch_pipeline.h"
+#include "ncnn_engine.h"
+
+namespace kotopogoda {
+
+// Фиксированная раскладка телеметрии запуска в прямом ByteBuffer, который
+// выделяет вызывающая сторона (NativeTelemetryBuffer.kt). Порядок байтов —
+// нативный. Версия пишется последней: 0 в поле версии означает, что нативный
+// код телеметрию не записал. Любое изменение раскладки увеличивает kVersion.
+namespace telemetry_layout {
+
+constexpr int32_t kVersion = 7;
+
+constexpr size_t kOffsetVersion = 0;            // int32
+constexpr size_t kOffsetSize = 4;               // int32, размер записанной раскладки
+constexpr size_t kOffsetFlags = 8;              // int32, биты kFlag*
+constexpr size_t kOffsetFallbackCause = 12;     // int32, FallbackCause
+constexpr size_t kOffsetTimingMs = 16;          // int64
+constexpr size_t kOffsetPeakMemoryKb = 24;      // int64
+constexpr size_t kOffsetDurationMsVulkan = 32;  // int64
+constexpr size_t kOffsetDurationMsCpu = 40;     // int64
+constexpr size_t kOffsetTileSize = 48;          // int32
+constexpr size_t kOffsetTileOverlap = 52;       // int32
+constexpr size_t kOffsetTilesTotal = 56;        // int32
+constexpr size_t kOffsetTilesCompleted = 60;    // int32
+constexpr size_t kOffsetSeamMaxDelta = 64;      // float
+constexpr size_t kOffsetSeamMeanDelta = 68;     // float
+constexpr size_t kOffsetGpuAllocRetries = 72;   // int32
+constexpr size_t kOffsetDelegate = 76;          // int32, DelegateType
+constexpr size_t kOffsetRestPrecision = 80;     // int32, kPrecision*
+constexpr size_t kOffsetReserved = 84;          // int32, нули
+constexpr size_t kOffsetStagePeakKb = 88;       // int64[kPipelineStageCount], по PipelineStage
+constexpr size_t kOffsetStageRssKb = 128;       // int64[kPipelineStageCount], VmRSS в конце стадии
+constexpr size_t kOffsetProcessPeakRssKb = 168; // int64, VmHWM
+// Профиль (kFlagProfiled); без флага поля ниже нулевые.
+constexpr size_t kOffsetStageMicros = 176;      // int64[kPipelineStageCount], по PipelineStage
+constexpr size_t kOffsetTileCount = 216;        // int32, замеренных тайлов
+constexpr size_t kOffsetLayerCount = 220;       // int32, замеренных слоёв
+constexpr size_t kOffsetTileP50Micros = 224;    // int64
+constexpr size_t kOffsetTileP95Micros = 232;    // int64
+constexpr size_t kOffsetTileMaxMicros = 240;    // int64
+constexpr size_t kOffsetLayersMicros = 248;     // int64, сумма по всем слоям
+constexpr size_t kOffsetTopLayerCount = 256;    // int32, заполненных записей kOffsetTopLayers
+constexpr size_t kOffsetProfileReserved = 260;  // int32, нули
+constexpr size_t kOffsetTopLayers = 264;        // kTopLayerSize[kProfileTopLayers], по убыванию времени
+constexpr size_t kProfileEnd = 776;
+// CPU запуска (CpuAccounting), пишется всегда.
+constexpr size_t kOffsetThreadCpuMicros = 776;    // int64, поток запуска
+constexpr size_t kOffsetProcessCpuMicros = 784;   // int64, процесс (user + sys)
+constexpr size_t kOffsetVoluntarySwitches = 792;  // int64
+constexpr size_t kOffsetInvoluntarySwitches = 800; // int64
+constexpr size_t kOffsetCoreClassMicros = 808;    // int64[kCoreClassCount], по CoreClass
+constexpr size_t kOffsetCpuMask = 832;            // int64, бит на замеченный CPU
+constexpr size_t kOffsetPixels = 840;             // int64, пикселей на входе
+constexpr size_t kOffsetCpuMsPerMegapixel = 848;  // float
+constexpr size_t kOffsetCpuReserved = 852;        // int32, нули
+// Устойчивый режим (только при kFlagSustained, иначе нули).
+constexpr size_t kOffsetSustainedLevel = 856;       // int32, уровень применённого бюджета
+constexpr size_t kOffsetSustainedThreads = 860;     // int32
+constexpr size_t kOffsetSustainedTileSize = 864;    // int32, 0 — без тайлов
+constexpr size_t kOffsetSustainedDecision = 868;    // int32, SustainedDecision
+constexpr size_t kOffsetSustainedPauseMicros = 872; // int64, выдержанная пауза перед запуском
+constexpr size_t kOffsetSustainedNextLevel = 880;   // int32
+constexpr size_t kOffsetSustainedChanges = 884;     // int32, смен уровня с загрузки моделей
+constexpr size_t kOffsetSustainedWindowMpps = 888;  // float
+constexpr size_t kOffsetSustainedBaselineMpps = 892; // float
+// Статистика результата (ImageStats, только при kFlagImageStats, иначе нули).
+constexpr size_t kOffsetStatsPixels = 896;          // int64
+constexpr size_t kOffsetStatsLumaMean = 904;        // float
+constexpr size_t kOffsetStatsDarkShare = 908;       // float
+constexpr size_t kOffsetStatsSharpness = 912;       // float
+constexpr size_t kOffsetStatsNoise = 916;           // float
+constexpr size_t kOffsetStatsLumaP05 = 920;         // float
+constexpr size_t kOffsetStatsLumaP50 = 924;         // float
+constexpr size_t kOffsetStatsLumaP95 = 928;         // float
+constexpr size_t kOffsetStatsClippedShadows = 932;  // float
+constexpr size_t kOffsetStatsClippedHighlights = 936; // float
+constexpr size_t kOffsetStatsSaturationMean = 940;  // float
+constexpr size_t kOffsetStatsSaturatedShare = 944;  // float
+constexpr size_t kOffsetStatsReserved = 948;        // int32, нули
+constexpr size_t kOffsetStatsHistogram = 952;       // uint32[kImageStatsBins], пикселей в корзине
+constexpr size_t kSize = 1208;
+
+// Запись слоя: время, индекс в ncnn::Net::layers() и обрезанные до
+// размера поля ASCII-тип и имя, дополненные нулями.
+constexpr size_t kTopLayerMicros = 0;           // int64
+constexpr size_t kTopLayerIndex = 8;            // int32
+constexpr size_t kTopLayerReserved = 12;        // int32, нули
+constexpr size_t kTopLayerType = 16;            // char[kTopLayerTypeLength]
+constexpr size_t kTopLayerTypeLength = 16;
+constexpr size_t kTopLayerName = 32;            // char[kTopLayerNameLength]
+constexpr size_t kTopLayerNameLength = 32;
+constexpr size_t kTopLayerSize = 64;
+
+static_assert(kOffsetStageRssKb == kOffsetStagePeakKb + kPipelineStageCount * sizeof(int64_t),
+              "раскладка пиков памяти рассчитана на kPipelineStageCount стадий");
+static_assert(kOffsetProcessPeakRssKb == kOffsetStageRssKb + kPipelineStageCount * sizeof(int64_t),
+              "раскладка пиков памяти рассчитана на kPipelineStageCount стадий");
+static_assert(kOffsetTileCount == kOffsetStageMicros + kPipelineStageCount * sizeof(int64_t),
+              "раскладка времени стадий рассчитана на kPipelineStageCount стадий");
+static_assert(kTopLayerName + kTopLayerNameLength == kTopLayerSize, "запись слоя заполнена целиком");
+static_assert(kProfileEnd == kOffsetTopLayers + kProfileTopLayers * kTopLayerSize,
+              "раскладка профиля рассчитана на kProfileTopLayers слоёв");
+static_assert(kOffsetCpuMask == kOffsetCoreClassMicros + kCoreClassCount * sizeof(int64_t),
+              "раскладка CPU рассчитана на kCoreClassCount классов ядер");
+static_assert(kSize == kOffsetStatsHistogram + kImageStatsBins * sizeof(uint32_t),
+              "раскладка статистики рассчитана на kImageStatsBins корзин");
+
+constexpr int32_t kFlagSuccess = 1 << 0;
+constexpr int32_t kFlagUsedVulkan = 1 << 1;
+constexpr int32_t kFlagCancelled = 1 << 2;
+constexpr int32_t kFlagFallbackUsed = 1 << 3;
+constexpr int32_t kFlagTileUsed = 1 << 4;
+constexpr int32_t kFlagProfiled = 1 << 5;
+constexpr int32_t kFlagSustained = 1 << 6;
+constexpr int32_t kFlagImageStats = 1 << 7;
+
+constexpr int32_t kPrecisionUnknown = -1;
+constexpr int32_t kPrecisionFp16 = 0;
+constexpr int32_t kPrecisionFp32 = 1;
+
+}
+
+// Запись об элементе пакета (NativeBatchItemsBuffer.kt): записи идут подряд по
+// kSize байт, внутри каждой — телеметрия вывода в раскладке telemetry_layout.
+// Состояние пишется последним: PENDING (0) означает, что элемент ещё не завершён.
+namespace batch_item_layout {
+
+constexpr size_t kOffsetState = 0;              // int32, BatchItemState
+constexpr size_t kOffsetStoppedAt = 4;          // int32, BatchStage
+constexpr size_t kOffsetDecodeMs = 8;           // int64
+constexpr size_t kOffsetInferMs = 16;           // int64
+constexpr size_t kOffsetEncodeMs = 24;          // int64
+constexpr size_t kOffsetWidth = 32;             // int32
+constexpr size_t kOffsetHeight = 36;            // int32
+constexpr size_t kOffsetTelemetry = 40;         // telemetry_layout::kSize байт
+constexpr size_t kSize = kOffsetTelemetry + telemetry_layout::kSize;
+
+}
+
+// Записывает телеметрию в буфер. false — буфер меньше telemetry_layout::kSize.
+bool writeTelemetryBuffer(void* buffer, size_t capacity, const TelemetryData& telemetry, bool success);
+
+// Записывает запись элемента index. false — буфер не вмещает запись.
+bool writeBatchItemRecord(void* buffer, size_t capacity, size_t index, const BatchItemResult& result);
+
+}
+
+#endif
@@ -1,8 +1,10 @@
 #include "tile_processor.h"
 #include "hann_window.h"
+#include "trace.h"
 #include <ncnn/mat.h>
 #include <ncnn/net.h>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <android/log.h>
 
@@ -164,6 +166,7 @@ bool TileProcessor::processTiled(
     TileProcessStats* stats,
     int* errorCode
 ) {
+    TRACE_SCOPE("TileProcessor::processTiled");
     if (cancelFlag_.load()) {
         LOGW("ENHANCE/ERROR: Обработка отменена перед началом");
         return false;
@@ -183,8 +186,16 @@ bool TileProcessor::processTiled(
             stats->tileSize = config_.tileSize;
             stats->overlap = config_.overlap;
             stats->seamMaxDelta = 0.0f;
+            stats->tileMicros.clear();
         }
-        return processFunc(input, output, net, errorCode);
+        const auto start = std::chrono::steady_clock::now();
+        const bool ok = processFunc(input, output, net, errorCode);
+        if (ok && stats) {
+            stats->tileMicros.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start
+            ).count());
+        }
+        return ok;
     }
     
     output.create(input.w, input.h, input.c);
@@ -195,6 +206,8 @@ bool TileProcessor::processTiled(
         stats->tileSize = config_.tileSize;
         stats->overlap = config_.overlap;
         stats->seamMaxDelta = 0.0f;
+        stats->tileMicros.clear();
+        stats->tileMicros.reserve(tiles.size());
     }
 
     int processed = 0;
@@ -207,14 +220,24 @@ bool TileProcessor::processTiled(
             return false;
         }
 
+        TraceScope tileTrace("tile", processed);
+        const auto tileStart = std::chrono::steady_clock::now();
         ncnn::Mat tileInput, tileOutput;
-        extractTile(input, tile, tileInput);
+        {
+            TRACE_SCOPE("tile_extract");
+            extractTile(input, tile, tileInput);
+        }
 
         if (errorCode) {
             *errorCode = 0;
         }
 
-        if (!processFunc(tileInput, tileOutput, net, errorCode)) {
+        bool tileOk;
+        {
+            TRACE_SCOPE("tile_process");
+            tileOk = processFunc(tileInput, tileOutput, net, errorCode);
+        }
+        if (!tileOk) {
             int reportedCode = errorCode ? *errorCode : 0;
             LOGW(
                 "ENHANCE/ERROR: Ошибка обработки тайла %d ret=%d",
@@ -224,7 +247,15 @@ bool TileProcessor::processTiled(
             return false;
         }
 
-        blendTile(output, tileOutput, tile, seamMaxDelta, seamDeltaSum, seamSampleCount);
+        {
+            TRACE_SCOPE("tile_blend");
+            blendTile(output, tileOutput, tile, seamMaxDelta, seamDeltaSum, seamSampleCount);
+        }
+        if (stats) {
+            stats->tileMicros.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - tileStart
+            ).count());
+        }
 
         processed++;
         if (progressCallback) {
@@ -1,6 +1,7 @@
 #ifndef TILE_PROCESSOR_H
 #define TILE_PROCESSOR_H
 
+#include <cstdint>
 #include <vector>
 #include <atomic>
 #include <functional>
@@ -38,6 +39,9 @@ struct TileProcessStats {
     int overlap = 0;
     float seamMaxDelta = 0.0f;
     float seamMeanDelta = 0.0f;
+    // Задержка каждого тайла (вырезка, обработка, смешивание), мкс, в порядке
+    // обработки. В StageProfiler не попадает: движок тайлы не режет.
+    std::vector<int64_t> tileMicros;
 };
 
 class TileProcessor {
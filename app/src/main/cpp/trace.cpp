@@ -0,0 +1,304 @@
+#include "trace.h"
+#include <android/log.h>
+#include <cstdio>
+
+#ifdef __ANDROID__
+#include <android/trace.h>
+#include <dlfcn.h>
+#include <mutex>
+#else
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define LOG_TAG "Trace"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace kotopogoda {
+
+#ifdef __ANDROID__
+
+namespace {
+
+// ATrace_setCounter появился в API 29, minSdk ниже — ищем его при первом вызове.
+using SetCounterFn = void (*)(const char*, int64_t);
+
+SetCounterFn resolveSetCounter() {
+    static SetCounterFn setCounter = nullptr;
+    static std::once_flag once;
+    std::call_once(once, [] {
+        if (void* library = dlopen("libandroid.so", RTLD_NOW | RTLD_NOLOAD)) {
+            setCounter = reinterpret_cast<SetCounterFn>(dlsym(library, "ATrace_setCounter"));
+        }
+    });
+    return setCounter;
+}
+
+}
+
+bool isTracingEnabled() {
+    return ATrace_isEnabled();
+}
+
+void setTracingEnabled(bool) {}
+
+bool writeChromeTrace(const char*) {
+    LOGW("На устройстве трасса пишется в ATrace, выгрузка в JSON недоступна");
+    return false;
+}
+
+void traceBegin(const char* name, int index) {
+    if (index < 0) {
+        ATrace_beginSection(name);
+        return;
+    }
+    char section[96];
+    std::snprintf(section, sizeof(section), "%s #%d", name, index);
+    ATrace_beginSection(section);
+}
+
+void traceEnd() {
+    ATrace_endSection();
+}
+
+void traceCounter(const char* name, int64_t value) {
+    if (!ATrace_isEnabled()) {
+        return;
+    }
+    if (SetCounterFn setCounter = resolveSetCounter()) {
+        setCounter(name, value);
+    }
+}
+
+#else
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr char kPhaseComplete = 'X';
+constexpr char kPhaseCounter = 'C';
+// Глубже вложенные секции не записываются, но учитываются для парности.
+constexpr int kMaxDepth = 32;
+
+// Слот кольца (seqlock). sequence: 0 — пуст, kSlotBusy — пишется, иначе номер
+// записи + 1. Поля атомарны, чтобы чтение при выгрузке не было гонкой; целостность
+// события проверяется повторным чтением sequence.
+constexpr uint64_t kSlotBusy = ~uint64_t{0};
+
+struct TraceEvent {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> startNs{0};
+    std::atomic<int64_t> durationNs{0};
+    // Номер тайла для секции (-1 — без номера) или значение счётчика.
+    std::atomic<int64_t> value{0};
+    std::atomic<int> tid{0};
+    std::atomic<char> phase{0};
+};
+
+struct OpenSection {
+    const char* name;
+    int index;
+    int64_t startNs;
+};
+
+struct ThreadState {
+    OpenSection stack[kMaxDepth];
+    int depth = 0;
+    int tid = 0;
+};
+
+std::atomic<bool> gTracingEnabled{false};
+std::atomic<TraceEvent*> gEvents{nullptr};
+std::atomic<uint64_t> gNextTicket{0};
+const Clock::time_point gOrigin = Clock::now();
+
+std::mutex gThreadsMutex;
+std::map<int, std::string> gThreadNames;
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - gOrigin).count();
+}
+
+ThreadState& threadState() {
+    thread_local ThreadState state;
+    if (state.tid == 0) {
+        state.tid = static_cast<int>(syscall(SYS_gettid));
+        char name[32] = {};
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        std::lock_guard<std::mutex> lock(gThreadsMutex);
+        gThreadNames[state.tid] = name;
+    }
+    return state;
+}
+
+void push(char phase, const char* name, int64_t startNs, int64_t durationNs, int64_t value, int tid) {
+    TraceEvent* events = gEvents.load(std::memory_order_acquire);
+    if (events == nullptr) {
+        return;
+    }
+    const uint64_t ticket = gNextTicket.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent& event = events[ticket % kTraceCapacity];
+    // Слот ещё пишет писатель, отставший на целый круг: событие теряется.
+    if (event.sequence.exchange(kSlotBusy, std::memory_order_acquire) == kSlotBusy) {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    event.phase.store(phase, std::memory_order_relaxed);
+    event.name.store(name, std::memory_order_relaxed);
+    event.startNs.store(startNs, std::memory_order_relaxed);
+    event.durationNs.store(durationNs, std::memory_order_relaxed);
+    event.value.store(value, std::memory_order_relaxed);
+    event.tid.store(tid, std::memory_order_relaxed);
+    event.sequence.store(ticket + 1, std::memory_order_release);
+}
+
+void writeEscaped(FILE* file, const char* text) {
+    for (const char* c = text; *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\') {
+            std::fputc('\\', file);
+        }
+        if (static_cast<unsigned char>(*c) >= 0x20) {
+            std::fputc(*c, file);
+        }
+    }
+}
+
+}
+
+bool isTracingEnabled() {
+    return gTracingEnabled.load(std::memory_order_relaxed);
+}
+
+void setTracingEnabled(bool enabled) {
+    if (enabled && gEvents.load() == nullptr) {
+        // Буфер не освобождается: писатели могут держать указатель после выключения.
+        gEvents.store(new TraceEvent[kTraceCapacity]);
+    }
+    gTracingEnabled.store(enabled);
+    LOGI("Трассировка %s", enabled ? "включена" : "выключена");
+}
+
+void traceBegin(const char* name, int index) {
+    ThreadState& state = threadState();
+    if (state.depth < kMaxDepth) {
+        state.stack[state.depth] = OpenSection{name, index, nowNs()};
+    }
+    ++state.depth;
+}
+
+void traceEnd() {
+    ThreadState& state = threadState();
+    if (state.depth == 0) {
+        return;
+    }
+    --state.depth;
+    if (state.depth < kMaxDepth) {
+        const OpenSection& section = state.stack[state.depth];
+        push(kPhaseComplete, section.name, section.startNs, nowNs() - section.startNs, section.index, state.tid);
+    }
+}
+
+void traceCounter(const char* name, int64_t value) {
+    if (!isTracingEnabled()) {
+        return;
+    }
+    push(kPhaseCounter, name, nowNs(), 0, value, threadState().tid);
+}
+
+bool writeChromeTrace(const char* path) {
+    TraceEvent* events = gEvents.load(std::memory_order_acquire);
+    if (events == nullptr) {
+        LOGW("Трассировка не включалась, выгружать нечего");
+        return false;
+    }
+
+    struct Snapshot {
+        char phase;
+        const char* name;
+        int64_t startNs;
+        int64_t durationNs;
+        int64_t value;
+        int tid;
+    };
+    std::vector<Snapshot> snapshot;
+    snapshot.reserve(kTraceCapacity);
+    for (int i = 0; i < kTraceCapacity; ++i) {
+        const TraceEvent& event = events[i];
+        const uint64_t before = event.sequence.load(std::memory_order_acquire);
+        if (before == 0 || before == kSlotBusy) {
+            continue;
+        }
+        Snapshot copy{
+            event.phase.load(std::memory_order_relaxed),
+            event.name.load(std::memory_order_relaxed),
+            event.startNs.load(std::memory_order_relaxed),
+            event.durationNs.load(std::memory_order_relaxed),
+            event.value.load(std::memory_order_relaxed),
+            event.tid.load(std::memory_order_relaxed),
+        };
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (event.sequence.load(std::memory_order_relaxed) == before) {
+            snapshot.push_back(copy);
+        }
+    }
+    std::sort(snapshot.begin(), snapshot.end(), [](const Snapshot& a, const Snapshot& b) {
+        return a.startNs < b.startNs;
+    });
+
+    FILE* file = std::fopen(path, "we");
+    if (file == nullptr) {
+        LOGW("Не удалось открыть %s для трассы", path);
+        return false;
+    }
+    const int pid = static_cast<int>(getpid());
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(gThreadsMutex);
+        for (const auto& thread : gThreadNames) {
+            std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"",
+                         first ? "" : ",\n", pid, thread.first);
+            writeEscaped(file, thread.second.c_str());
+            std::fprintf(file, "\"}}");
+            first = false;
+        }
+    }
+    for (const Snapshot& event : snapshot) {
+        std::fprintf(file, "%s{\"name\":\"", first ? "" : ",\n");
+        writeEscaped(file, event.name);
+        std::fprintf(file, "\",\"ph\":\"%c\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f",
+                     event.phase, pid, event.tid, event.startNs / 1000.0);
+        if (event.phase == kPhaseComplete) {
+            std::fprintf(file, ",\"dur\":%.3f", event.durationNs / 1000.0);
+            if (event.value >= 0) {
+                std::fprintf(file, ",\"args\":{\"index\":%lld}", static_cast<long long>(event.value));
+            }
+        } else {
+            std::fprintf(file, ",\"args\":{\"value\":%lld}", static_cast<long long>(event.value));
+        }
+        std::fprintf(file, "}");
+        first = false;
+    }
+    std::fprintf(file, "\n]}\n");
+    const bool ok = std::fclose(file) == 0;
+    const uint64_t written = gNextTicket.load();
+    LOGI("Трасса %s: %zu событий%s", path, snapshot.size(),
+         written > static_cast<uint64_t>(kTraceCapacity) ? " (старые вытеснены из кольца)" : "");
+    return ok;
+}
+
+#endif
+
+}
@@ -0,0 +1,64 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+
+namespace kotopogoda {
+
+// Трассировка нативного конвейера. На устройстве секции и счётчики уходят в
+// ATrace и видны в Perfetto/systrace при записи с категорией приложения;
+// включена, пока идёт запись (ATrace_isEnabled). На хосте события пишутся в
+// кольцевой буфер в памяти (по дорожке на поток), включаются
+// setTracingEnabled и выгружаются writeChromeTrace в формате Chrome JSON.
+// Выключенная трассировка стоит одной проверки флага на секцию.
+//
+// Имена — строковые литералы: буфер хранит указатель, а не копию.
+
+bool isTracingEnabled();
+// Только хост: выделяет буфер при первом включении. На устройстве включением
+// управляет запись трассы, вызов ничего не делает.
+void setTracingEnabled(bool enabled);
+// Только хост: пишет накопленные события (последние kTraceCapacity) в path.
+// Вызывать, когда запуски завершены: события, записываемые во время выгрузки,
+// пропускаются.
+bool writeChromeTrace(const char* path);
+
+constexpr int kTraceCapacity = 1 << 16;
+
+// Секция текущего потока. index >= 0 — номер тайла или элемента пакета: на
+// устройстве добавляется к имени секции, на хосте пишется в args. Секции
+// одного потока должны быть вложены — используйте TraceScope.
+void traceBegin(const char* name, int index = -1);
+void traceEnd();
+// Значение счётчика name (отдельная дорожка).
+void traceCounter(const char* name, int64_t value);
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, int index = -1) : active_(isTracingEnabled()) {
+        if (active_) {
+            traceBegin(name, index);
+        }
+    }
+
+    ~TraceScope() {
+        if (active_) {
+            traceEnd();
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const bool active_;
+};
+
+}
+
+#define KOTOPOGODA_TRACE_CONCAT_INNER(a, b) a##b
+#define KOTOPOGODA_TRACE_CONCAT(a, b) KOTOPOGODA_TRACE_CONCAT_INNER(a, b)
+// Секция до конца текущей области видимости.
+#define TRACE_SCOPE(name) ::kotopogoda::TraceScope KOTOPOGODA_TRACE_CONCAT(traceScope_, __LINE__)(name)
+
+#endif
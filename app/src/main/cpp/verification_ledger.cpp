@@ -0,0 +1,241 @@
+#include "verification_ledger.h"
+#include "sha256_verifier.h"
+#include <android/log.h>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOG_TAG "VerificationLedger"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace kotopogoda {
+
+namespace {
+constexpr const char* kHeader = "kotopogoda-ledger v1";
+constexpr const char* kSignaturePrefix = "hmac\t";
+constexpr size_t kMaxLedgerBytes = 64 * 1024;
+
+bool parseEntryLine(const std::string& line, std::string& path, int64_t& size, int64_t& mtimeNs,
+                    uint64_t& inode, std::string& digest, int64_t& verifiedAt) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        const size_t tab = line.find('\t', start);
+        fields.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+        if (tab == std::string::npos) {
+            break;
+        }
+        start = tab + 1;
+    }
+    if (fields.size() != 6) {
+        return false;
+    }
+    char* end = nullptr;
+    path = fields[0];
+    size = std::strtoll(fields[1].c_str(), &end, 10);
+    if (*end != '\0') return false;
+    mtimeNs = std::strtoll(fields[2].c_str(), &end, 10);
+    if (*end != '\0') return false;
+    inode = std::strtoull(fields[3].c_str(), &end, 10);
+    if (*end != '\0') return false;
+    digest = fields[4];
+    verifiedAt = std::strtoll(fields[5].c_str(), &end, 10);
+    if (*end != '\0') return false;
+    return !path.empty() && digest.size() == Sha256::kDigestSize * 2;
+}
+}
+
+VerificationLedger::VerificationLedger(
+    const std::string& modelsDir,
+    std::vector<uint8_t> key,
+    int64_t reverifyIntervalSec
+)
+    : ledgerPath_(modelsDir + "/" + kFileName),
+      key_(std::move(key)),
+      reverifyIntervalSec_(reverifyIntervalSec),
+      enabled_(!key_.empty() && reverifyIntervalSec > 0 && !modelsDir.empty()),
+      dirty_(false) {
+}
+
+void VerificationLedger::load() {
+    entries_.clear();
+    dirty_ = false;
+    if (!enabled_) {
+        return;
+    }
+
+    std::ifstream file(ledgerPath_, std::ios::binary);
+    if (!file) {
+        return;
+    }
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (content.size() > kMaxLedgerBytes) {
+        LOGW("Журнал проверок слишком большой (%zu байт), игнорируем", content.size());
+        return;
+    }
+
+    const size_t signaturePos = content.rfind(kSignaturePrefix);
+    if (signaturePos == std::string::npos || (signaturePos > 0 && content[signaturePos - 1] != '\n')) {
+        LOGW("Журнал проверок без подписи, игнорируем");
+        return;
+    }
+    const std::string payload = content.substr(0, signaturePos);
+    std::string storedSignature = content.substr(signaturePos + std::strlen(kSignaturePrefix));
+    while (!storedSignature.empty() && (storedSignature.back() == '\n' || storedSignature.back() == '\r')) {
+        storedSignature.pop_back();
+    }
+    const std::string expectedSignature = signature(payload);
+    if (storedSignature.size() != expectedSignature.size() ||
+        !HmacSha256::equalsConstantTime(
+            reinterpret_cast<const uint8_t*>(storedSignature.data()),
+            reinterpret_cast<const uint8_t*>(expectedSignature.data()),
+            expectedSignature.size())) {
+        LOGW("Подпись журнала проверок не совпадает, все модели будут перепроверены");
+        return;
+    }
+
+    std::istringstream lines(payload);
+    std::string line;
+    if (!std::getline(lines, line) || line != kHeader) {
+        LOGW("Неизвестный формат журнала проверок");
+        return;
+    }
+    while (std::getline(lines, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::string path;
+        Entry entry;
+        if (!parseEntryLine(line, path, entry.size, entry.mtimeNs, entry.inode, entry.digest, entry.verifiedAtSec)) {
+            LOGW("Повреждённая запись журнала проверок, игнорируем журнал");
+            entries_.clear();
+            return;
+        }
+        entries_[path] = entry;
+    }
+    LOGI("Журнал проверок загружен: записей=%zu", entries_.size());
+}
+
+bool VerificationLedger::save() {
+    if (!enabled_ || !dirty_) {
+        return true;
+    }
+
+    const std::string payload = serializeEntries();
+    const std::string content = payload + kSignaturePrefix + signature(payload) + "\n";
+    const std::string tmpPath = ledgerPath_ + ".tmp";
+
+    FILE* fp = fopen(tmpPath.c_str(), "wb");
+    if (fp == nullptr) {
+        LOGW("Не удалось записать журнал проверок %s", tmpPath.c_str());
+        return false;
+    }
+    const bool written = fwrite(content.data(), 1, content.size(), fp) == content.size();
+    const bool flushed = fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    fclose(fp);
+    if (!written || !flushed || std::rename(tmpPath.c_str(), ledgerPath_.c_str()) != 0) {
+        LOGW("Не удалось сохранить журнал проверок %s", ledgerPath_.c_str());
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    dirty_ = false;
+    return true;
+}
+
+bool VerificationLedger::isVerified(const std::string& filePath, const std::string& expectedChecksum) const {
+    if (!enabled_) {
+        return false;
+    }
+    auto it = entries_.find(filePath);
+    if (it == entries_.end()) {
+        return false;
+    }
+    const Entry& recorded = it->second;
+    if (recorded.digest != expectedChecksum) {
+        return false;
+    }
+
+    const int64_t now = nowSeconds();
+    if (now < recorded.verifiedAtSec || now - recorded.verifiedAtSec >= reverifyIntervalSec_) {
+        LOGI("Истёк интервал перепроверки для %s", filePath.c_str());
+        return false;
+    }
+
+    Entry current;
+    if (!statFile(filePath, current)) {
+        return false;
+    }
+    return current.size == recorded.size &&
+           current.mtimeNs == recorded.mtimeNs &&
+           current.inode == recorded.inode;
+}
+
+void VerificationLedger::record(const std::string& filePath, const std::string& checksum) {
+    if (!enabled_ || filePath.find_first_of("\t\n\r") != std::string::npos) {
+        return;
+    }
+    Entry entry;
+    if (!statFile(filePath, entry)) {
+        return;
+    }
+    entry.digest = checksum;
+    entry.verifiedAtSec = nowSeconds();
+    entries_[filePath] = entry;
+    dirty_ = true;
+}
+
+void VerificationLedger::forget(const std::string& filePath) {
+    if (entries_.erase(filePath) > 0) {
+        dirty_ = true;
+    }
+}
+
+bool VerificationLedger::statFile(const std::string& filePath, Entry& entry) {
+    struct stat st;
+    if (stat(filePath.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    entry.size = static_cast<int64_t>(st.st_size);
+    entry.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    entry.inode = static_cast<uint64_t>(st.st_ino);
+    return true;
+}
+
+int64_t VerificationLedger::nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+std::string VerificationLedger::serializeEntries() const {
+    std::string payload = kHeader;
+    payload += '\n';
+    char numbers[128];
+    for (const auto& item : entries_) {
+        const Entry& entry = item.second;
+        std::snprintf(numbers, sizeof(numbers), "\t%" PRId64 "\t%" PRId64 "\t%" PRIu64 "\t",
+                      entry.size, entry.mtimeNs, entry.inode);
+        payload += item.first;
+        payload += numbers;
+        payload += entry.digest;
+        std::snprintf(numbers, sizeof(numbers), "\t%" PRId64 "\n", entry.verifiedAtSec);
+        payload += numbers;
+    }
+    return payload;
+}
+
+std::string VerificationLedger::signature(const std::string& payload) const {
+    HmacSha256 hmac(key_.data(), key_.size());
+    hmac.update(payload.data(), payload.size());
+    return hmac.finalHex();
+}
+
+}
@@ -0,0 +1,54 @@
+#ifndef VERIFICATION_LEDGER_H
+#define VERIFICATION_LEDGER_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace kotopogoda {
+
+// Журнал успешно проверенных файлов моделей. Хранится в директории моделей
+// и подписан HMAC-SHA256 ключом, уникальным для установки. Запись считается
+// действительной, пока не изменились размер, mtime и inode файла и не истёк
+// интервал периодической перепроверки.
+class VerificationLedger {
+public:
+    static constexpr const char* kFileName = ".verification_ledger";
+
+    VerificationLedger(const std::string& modelsDir, std::vector<uint8_t> key, int64_t reverifyIntervalSec);
+
+    bool enabled() const { return enabled_; }
+
+    void load();
+    bool save();
+
+    bool isVerified(const std::string& filePath, const std::string& expectedChecksum) const;
+    void record(const std::string& filePath, const std::string& checksum);
+    void forget(const std::string& filePath);
+
+private:
+    struct Entry {
+        int64_t size = 0;
+        int64_t mtimeNs = 0;
+        uint64_t inode = 0;
+        std::string digest;
+        int64_t verifiedAtSec = 0;
+    };
+
+    static bool statFile(const std::string& filePath, Entry& entry);
+    static int64_t nowSeconds();
+    std::string serializeEntries() const;
+    std::string signature(const std::string& payload) const;
+
+    std::string ledgerPath_;
+    std::vector<uint8_t> key_;
+    int64_t reverifyIntervalSec_;
+    bool enabled_;
+    bool dirty_;
+    std::map<std::string, Entry> entries_;
+};
+
+}
+
+#endif
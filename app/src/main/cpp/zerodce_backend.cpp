@@ -1,5 +1,6 @@
 #include "zerodce_backend.h"
 #include "ncnn_engine.h"
+#include "trace.h"
 #include <ncnn/mat.h>
 #include <ncnn/net.h>
 #include <android/log.h>
@@ -13,12 +14,17 @@
 
 namespace kotopogoda {
 
-ZeroDceBackend::ZeroDceBackend(ncnn::Net* net, std::atomic<bool>& cancelFlag)
-    : net_(net), cancelFlag_(cancelFlag) {}
+ZeroDceBackend::ZeroDceBackend(const ncnn::Net* net, RunContext& context)
+    : net_(net), context_(context), cancelFlag_(context.cancelFlag()) {}
 
 ZeroDceBackend::~ZeroDceBackend() {
 }
 
+void ZeroDceBackend::setSustainedBudget(SustainedPerformanceController* controller, const SustainedBudget& budget) {
+    sustained_ = controller;
+    sustainedBudget_ = budget;
+}
+
 bool ZeroDceBackend::processDirectly(
     const ncnn::Mat& input,
     ncnn::Mat& output,
@@ -35,7 +41,14 @@ bool ZeroDceBackend::processDirectly(
     }
 
     const char* delegateName = net_->opt.use_vulkan_compute ? "vulkan" : "cpu";
+    StageProfiler& profiler = context_.profiler();
+    const auto tileStart = std::chrono::steady_clock::now();
     ncnn::Extractor ex = net_->create_extractor();
+    ex.set_blob_allocator(context_.blobAllocator());
+    ex.set_workspace_allocator(context_.workspaceAllocator());
+    if (sustained_ != nullptr && sustainedBudget_.threads > 0) {
+        ex.set_num_threads(sustainedBudget_.threads);
+    }
     int ret = ex.input("input", input);
     if (ret != 0) {
         if (lastErrorCode) {
@@ -54,7 +67,12 @@ bool ZeroDceBackend::processDirectly(
     }
 
     ncnn::Mat enhancedOutput;
-    ret = ex.extract("output", enhancedOutput);
+    {
+        TRACE_SCOPE("zerodce_extract");
+        ret = profiler.enabled()
+            ? extractWithLayerTimings(*net_, ex, "output", enhancedOutput, profiler)
+            : ex.extract("output", enhancedOutput);
+    }
 
     if (ret != 0) {
         if (lastErrorCode) {
@@ -76,9 +94,28 @@ bool ZeroDceBackend::processDirectly(
         LOGW("ENHANCE/ERROR: Обработка Zero-DCE++ прервана после экстракции");
         return false;
     }
+    // Zero-DCE++ обрабатывает кадр целиком, поэтому в профиле и для устойчивого
+    // режима это один тайл.
+    const int64_t tileMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - tileStart
+    ).count();
+    profiler.recordTile(tileMicros);
+    if (sustained_ != nullptr) {
+        sustained_->recordTile(
+            sustainedBudget_,
+            static_cast<int64_t>(input.w) * input.h,
+            tileMicros,
+            &context_.telemetry().sustained.report
+        );
+    }
 
+    // Сеть отработала: дальше смешивание с входом и (в process) увеличение.
+    MemoryTracker& memory = context_.memory();
+    context_.beginStage(PipelineStage::BLEND);
     output.create(input.w, input.h, input.c);
+    MatCharge blendCharge(memory, output);
 
+    TRACE_SCOPE("zerodce_blend");
     for (int c = 0; c < input.c; ++c) {
         const float* srcChannel = input.channel(c);
         const float* enhChannel = enhancedOutput.channel(c);
@@ -97,13 +134,19 @@ bool ZeroDceBackend::process(
     ncnn::Mat& output,
     float strength,
     TelemetryData& telemetry,
-    const std::function<void(int, int)>& stageProgressCallback
+    const std::function<void(int, int)>& stageProgressCallback,
+    bool upscaleOutput
 ) {
+    TRACE_SCOPE("ZeroDceBackend::process");
     auto startTime = std::chrono::high_resolution_clock::now();
 
     LOGI("Начало обработки Zero-DCE++: %dx%dx%d, strength=%.2f", input.w, input.h, input.c, strength);
 
-    const int maxSide = 2048;
+    MemoryTracker& memory = context_.memory();
+    context_.cpu().notePixels(static_cast<int64_t>(input.w) * input.h);
+    context_.beginStage(PipelineStage::ZERODCE);
+
+    const int maxSide = kZeroDceMaxSide;
     const bool needResize = input.w > maxSide || input.h > maxSide;
 
     telemetry.tileTelemetry.tileUsed = false;
@@ -121,27 +164,40 @@ bool ZeroDceBackend::process(
 
         LOGI("Zero-DCE++ downscale: %dx%d -> %dx%d", input.w, input.h, targetW, targetH);
         ncnn::Mat resized;
+        TRACE_SCOPE("zerodce_downscale");
         ncnn::resize_bilinear(input, resized, targetW, targetH);
         processingInput = resized;
     }
+    MatCharge resizedCharge(memory, needResize ? processingInput : ncnn::Mat());
 
     telemetry.extractorError = TelemetryData::ExtractorErrorTelemetry{};
     int extractorErrorCode = 0;
     ncnn::Mat processedOutput;
     const bool success = processDirectly(processingInput, processedOutput, strength, &extractorErrorCode);
 
+    // Результат смешивания учитывается до конца process: при увеличении он живёт
+    // вместе с полноразмерным выходом.
+    MatCharge processedCharge(memory, success ? processedOutput : ncnn::Mat());
+    const bool upscale = success && needResize && upscaleOutput;
+    if (upscale) {
+        // Полноразмерный выход — отдельная стадия, а не пик смешивания.
+        context_.beginStage(PipelineStage::UPSCALE);
+        TRACE_SCOPE("zerodce_upscale");
+        ncnn::resize_bilinear(processedOutput, output, input.w, input.h);
+        LOGI("Zero-DCE++ upscale: %dx%d -> %dx%d", processedOutput.w, processedOutput.h, input.w, input.h);
+    } else if (success) {
+        output = processedOutput;
+    }
+    // Увеличенный выход учитывается до выхода из process, дальше его учитывает
+    // вызывающая сторона (MatCharge результата на convert_out).
+    MatCharge upscaledCharge(memory, upscale ? output : ncnn::Mat());
     if (success) {
-        if (needResize) {
-            ncnn::resize_bilinear(processedOutput, output, input.w, input.h);
-            LOGI("Zero-DCE++ upscale: %dx%d -> %dx%d", processedOutput.w, processedOutput.h, input.w, input.h);
-        } else {
-            output = processedOutput;
-        }
         telemetry.tileTelemetry.processedTiles = 1;
         if (stageProgressCallback) {
             stageProgressCallback(1, 1);
         }
     }
+    context_.endStage();
     telemetry.seamMaxDelta = 0.0f;
     telemetry.seamMeanDelta = 0.0f;
 
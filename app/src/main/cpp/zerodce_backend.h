@@ -4,6 +4,7 @@
 #include <atomic>
 #include <memory>
 #include <functional>
+#include "sustained_performance.h"
 
 namespace ncnn {
     class Mat;
@@ -13,20 +14,31 @@ namespace ncnn {
 namespace kotopogoda {
 
 struct TelemetryData;
+class RunContext;
 
+// Экстрактор создаётся на каждый вызов и берёт пулы памяти из RunContext,
+// поэтому бэкенды разных запросов не делят изменяемого состояния.
 class ZeroDceBackend {
 public:
-    ZeroDceBackend(ncnn::Net* net, std::atomic<bool>& cancelFlag);
+    ZeroDceBackend(const ncnn::Net* net, RunContext& context);
     ~ZeroDceBackend();
 
+    // Вход больше kZeroDceMaxSide уменьшается перед сетью; при upscaleOutput
+    // результат увеличивается обратно до размера входа, иначе остаётся на
+    // рабочем разрешении.
     bool process(
         const ncnn::Mat& input,
         ncnn::Mat& output,
         float strength,
         TelemetryData& telemetry,
-        const std::function<void(int, int)>& stageProgressCallback = std::function<void(int, int)>()
+        const std::function<void(int, int)>& stageProgressCallback = std::function<void(int, int)>(),
+        bool upscaleOutput = true
     );
 
+    // Полноразмерный запуск под устойчивым режимом: сеть работает с
+    // budget.threads потоками, а время кадра (один тайл) уходит в controller.
+    void setSustainedBudget(SustainedPerformanceController* controller, const SustainedBudget& budget);
+
 private:
     bool processDirectly(
         const ncnn::Mat& input,
@@ -35,8 +47,11 @@ private:
         int* lastErrorCode = nullptr
     );
 
-    ncnn::Net* net_;
+    const ncnn::Net* net_;
+    RunContext& context_;
     std::atomic<bool>& cancelFlag_;
+    SustainedPerformanceController* sustained_ = nullptr;
+    SustainedBudget sustainedBudget_;
 };
 
 }
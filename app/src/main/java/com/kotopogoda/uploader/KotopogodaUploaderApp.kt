@@ -123,6 +123,7 @@ class KotopogodaUploaderApp : Application(), Configuration.Provider {
         EnhanceLogging.setFileLogger(EnhanceFileLogger(this))
         runCatching {
             NativeEnhanceController.loadLibrary()
+            NativeEnhanceController.setProfilingEnabled(BuildConfig.DEBUG)
         }.onFailure { error ->
             Timber.tag("NativeEnhance").e(error, "Не удалось загрузить нативную библиотеку")
         }
@@ -1 +1,7 @@
-# Placeholder for consumer ProGuard rules.
+# JNI_OnLoad в libkotopogoda_enhance разрешает эти методы по имени.
+-keep interface com.kotopogoda.uploader.core.data.util.NativeHashing$ProgressListener {
+    boolean onProgress(long, long);
+}
+-keep interface com.kotopogoda.uploader.core.data.util.NativeHashing$BatchProgressListener {
+    boolean onProgress(int, long, long);
+}
@@ -16,6 +16,7 @@ import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.distinctUntilChanged
 import kotlinx.coroutines.flow.map
+import kotlinx.coroutines.isActive
 import kotlinx.coroutines.withContext
 import timber.log.Timber
 import javax.inject.Inject
@@ -198,7 +199,7 @@ class UploadQueueRepository @Inject constructor(
     }
 
     suspend fun computeAndStoreContentSha256(uri: Uri): String = withContext(Dispatchers.IO) {
-        val digest = Hashing.sha256(contentResolver, uri)
+        val digest = Hashing.sha256(contentResolver, uri) { _, _ -> isActive }
         val uriString = uri.toString()
         val photo = photoDao.getByUri(uriString)
         if (photo != null && photo.sha256 != digest) {
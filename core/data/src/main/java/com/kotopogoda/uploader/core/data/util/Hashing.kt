@@ -2,11 +2,16 @@ package com.kotopogoda.uploader.core.data.util
 
 import android.content.ContentResolver
 import android.net.Uri
+import android.os.ParcelFileDescriptor
+import java.io.IOException
 import java.io.InputStream
 import java.security.MessageDigest
+import java.util.concurrent.CancellationException
+import timber.log.Timber
 
 object Hashing {
     private const val BUFFER_SIZE = 1 * 1024 * 1024 // 1MB
+    private const val MAX_BATCH_DESCRIPTORS = 64
 
     fun sha256(inputStreamProvider: () -> InputStream): String {
         val digest = MessageDigest.getInstance("SHA-256")
@@ -27,12 +32,119 @@ object Hashing {
         }
     }
 
-    fun sha256(contentResolver: ContentResolver, uri: Uri): String {
+    fun sha256(contentResolver: ContentResolver, uri: Uri): String =
+        sha256(contentResolver, uri, onProgress = null)
+
+    /**
+     * Хеширует содержимое [uri]. Если доступна нативная библиотека, файл читается
+     * по дескриптору из [ContentResolver.openFileDescriptor] без копирования в Java-буферы;
+     * иначе используется потоковый [MessageDigest].
+     *
+     * [onProgress] получает число обработанных байт и общий размер (0, если неизвестен)
+     * только на нативном пути; возврат `false` прерывает хеширование с [CancellationException].
+     */
+    fun sha256(
+        contentResolver: ContentResolver,
+        uri: Uri,
+        onProgress: NativeHashing.ProgressListener?,
+    ): String {
         val normalizedUri = contentResolver.requireOriginalIfNeeded(uri)
         contentResolver.logUriReadDebug("Hashing.sha256", uri, normalizedUri)
+        if (NativeHashing.isAvailable()) {
+            try {
+                val descriptor = contentResolver.openFileDescriptor(normalizedUri, "r")
+                if (descriptor != null) {
+                    return descriptor.use { NativeHashing.sha256(it.fd, onProgress) }
+                }
+            } catch (error: CancellationException) {
+                throw error
+            } catch (error: IOException) {
+                Timber.tag("Hashing").w(error, "Native hashing failed for %s, falling back", normalizedUri)
+            } catch (error: IllegalArgumentException) {
+                Timber.tag("Hashing").w(error, "File descriptor unavailable for %s, falling back", normalizedUri)
+            }
+        }
         return sha256 {
             contentResolver.openInputStream(normalizedUri)
                 ?: throw IllegalStateException("Unable to open input stream for uri: $normalizedUri")
         }
     }
+
+    /**
+     * Хеширует список [uris] пакетами через [NativeHashing.sha256Batch]. Порядок результата
+     * совпадает с [uris]; файлы, которые не удалось открыть или прочитать нативно, а также
+     * все файлы при недоступной библиотеке хешируются по одному через [sha256].
+     *
+     * @throws CancellationException если [onProgress] вернул `false`
+     */
+    fun sha256Batch(
+        contentResolver: ContentResolver,
+        uris: List<Uri>,
+        onProgress: NativeHashing.BatchProgressListener? = null,
+    ): List<String> {
+        if (!NativeHashing.isAvailable()) {
+            return uris.map { uri -> sha256(contentResolver, uri) }
+        }
+        val digests = ArrayList<String>(uris.size)
+        var completedBefore = 0
+        uris.chunked(MAX_BATCH_DESCRIPTORS).forEach { group ->
+            val descriptors = group.map { uri -> openDescriptor(contentResolver, uri) }
+            val nativeDigests = try {
+                val fds = IntArray(descriptors.size) { index -> descriptors[index]?.fd ?: -1 }
+                val listener = onProgress?.let { delegate ->
+                    NativeHashing.BatchProgressListener { filesCompleted, hashedBytes, totalBytes ->
+                        delegate.onProgress(completedBefore + filesCompleted, hashedBytes, totalBytes)
+                    }
+                }
+                NativeHashing.sha256Batch(fds, listener)
+            } catch (error: IOException) {
+                Timber.tag("Hashing").w(error, "Native batch hashing failed, falling back")
+                List(group.size) { null }
+            } finally {
+                descriptors.forEach { descriptor -> descriptor?.close() }
+            }
+            group.forEachIndexed { index, uri ->
+                digests += nativeDigests[index] ?: sha256(contentResolver, uri)
+            }
+            completedBefore += group.size
+        }
+        return digests
+    }
+
+    /**
+     * Разбивает [uri] на чанки по содержимому для докачки и дедупликации загрузок.
+     * Возвращает `null`, если нативная библиотека недоступна или файл не открывается
+     * как дескриптор: у Kotlin-пути нет эквивалента, вызывающая сторона грузит файл целиком.
+     */
+    fun contentChunks(
+        contentResolver: ContentResolver,
+        uri: Uri,
+        params: NativeHashing.ChunkingParams = NativeHashing.ChunkingParams(),
+        onProgress: NativeHashing.ProgressListener? = null,
+    ): NativeHashing.ChunkedDigest? {
+        if (!NativeHashing.isAvailable()) {
+            return null
+        }
+        val descriptor = openDescriptor(contentResolver, uri) ?: return null
+        return try {
+            descriptor.use { NativeHashing.chunk(it.fd, params, onProgress) }
+        } catch (error: IOException) {
+            Timber.tag("Hashing").w(error, "Content chunking failed for %s", uri)
+            null
+        }
+    }
+
+    private fun openDescriptor(contentResolver: ContentResolver, uri: Uri): ParcelFileDescriptor? {
+        val normalizedUri = contentResolver.requireOriginalIfNeeded(uri)
+        contentResolver.logUriReadDebug("Hashing.sha256Batch", uri, normalizedUri)
+        return try {
+            contentResolver.openFileDescriptor(normalizedUri, "r")
+        } catch (error: IOException) {
+            Timber.tag("Hashing").w(error, "File descriptor unavailable for %s", normalizedUri)
+            null
+        } catch (error: IllegalArgumentException) {
+            Timber.tag("Hashing").w(error, "File descriptor unavailable for %s", normalizedUri)
+            null
+        }
+    }
 }
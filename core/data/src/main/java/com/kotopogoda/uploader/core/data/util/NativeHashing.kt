@@ -0,0 +1,242 @@
+package com.kotopogoda.uploader.core.data.util
+
+import java.io.IOException
+import java.util.concurrent.CancellationException
+import timber.log.Timber
+
+/**
+ * SHA-256 по файловому дескриптору через нативную реализацию из `kotopogoda_enhance`
+ * (mmap/posix_fadvise и аппаратные инструкции SHA). Результат совпадает с [Hashing.sha256].
+ */
+object NativeHashing {
+    private const val LIBRARY_NAME = "kotopogoda_enhance"
+
+    fun interface ProgressListener {
+        /** Возвращает `false`, чтобы прервать хеширование. [totalBytes] равен 0, если размер неизвестен. */
+        fun onProgress(hashedBytes: Long, totalBytes: Long): Boolean
+    }
+
+    fun interface BatchProgressListener {
+        /** Возвращает `false`, чтобы прервать весь пакет. */
+        fun onProgress(filesCompleted: Int, hashedBytes: Long, totalBytes: Long): Boolean
+    }
+
+    /**
+     * Дайджесты одного прохода по телу: [contentSha256] — SHA-256 содержимого,
+     * [framedSha256] — SHA-256 `framePrefix || body || frameSuffix`,
+     * [hmacSha256] — HMAC-SHA256 `hmacPrefix || body`. Необязательные поля равны `null`,
+     * если соответствующий дайджест не запрашивался.
+     */
+    data class BodyDigests(
+        val contentSha256: String,
+        val framedSha256: String?,
+        val hmacSha256: String?,
+    )
+
+    /**
+     * Параметры разбиения на чанки по содержимому (FastCDC). Границы зависят только от
+     * байтов файла и этих параметров, поэтому вставка в начало файла меняет лишь соседние чанки.
+     */
+    data class ChunkingParams(
+        val minSize: Int = 128 * 1024,
+        val avgSize: Int = 512 * 1024,
+        val maxSize: Int = 2 * 1024 * 1024,
+    ) {
+        init {
+            require(minSize in 64 until avgSize && avgSize < maxSize && maxSize <= 1 shl 30) {
+                "Invalid chunking params: min=$minSize avg=$avgSize max=$maxSize"
+            }
+        }
+    }
+
+    data class ContentChunk(
+        val offset: Long,
+        val length: Long,
+        val sha256: String,
+    )
+
+    /**
+     * [rootSha256] — SHA-256 от конкатенации бинарных дайджестов чанков по порядку,
+     * [contentSha256] — SHA-256 всего файла (совпадает с [Hashing.sha256]).
+     */
+    data class ChunkedDigest(
+        val rootSha256: String,
+        val contentSha256: String,
+        val chunks: List<ContentChunk>,
+    )
+
+    private val available: Boolean by lazy {
+        try {
+            System.loadLibrary(LIBRARY_NAME)
+            true
+        } catch (error: UnsatisfiedLinkError) {
+            Timber.tag("Hashing").w(error, "Native hashing is unavailable")
+            false
+        } catch (error: SecurityException) {
+            Timber.tag("Hashing").w(error, "Native hashing is unavailable")
+            false
+        }
+    }
+
+    fun isAvailable(): Boolean = available
+
+    /**
+     * Хеширует содержимое [fd] с начала файла (для pipe — с текущей позиции).
+     * Дескриптор не закрывается.
+     *
+     * @throws CancellationException если [onProgress] вернул `false`
+     * @throws IOException при ошибке чтения
+     */
+    fun sha256(fd: Int, onProgress: ProgressListener? = null): String {
+        check(available) { "Native hashing is unavailable" }
+        var cancelled = false
+        val listener = onProgress?.let { delegate ->
+            ProgressListener { hashedBytes, totalBytes ->
+                delegate.onProgress(hashedBytes, totalBytes).also { proceed ->
+                    if (!proceed) {
+                        cancelled = true
+                    }
+                }
+            }
+        }
+        val digest = nativeSha256Fd(fd, listener)
+        if (cancelled) {
+            throw CancellationException("SHA-256 hashing cancelled")
+        }
+        return digest ?: throw IOException("Unable to read file descriptor $fd")
+    }
+
+    /**
+     * Хеширует несколько дескрипторов одним пакетом: файлы читаются с опережением
+     * в отдельном потоке и сжимаются параллельно в SIMD-лейнах. Элемент результата
+     * равен `null`, если соответствующий дескриптор не удалось прочитать.
+     *
+     * @throws CancellationException если [onProgress] вернул `false`
+     */
+    fun sha256Batch(fds: IntArray, onProgress: BatchProgressListener? = null): List<String?> {
+        check(available) { "Native hashing is unavailable" }
+        var cancelled = false
+        val listener = onProgress?.let { delegate ->
+            BatchProgressListener { filesCompleted, hashedBytes, totalBytes ->
+                delegate.onProgress(filesCompleted, hashedBytes, totalBytes).also { proceed ->
+                    if (!proceed) {
+                        cancelled = true
+                    }
+                }
+            }
+        }
+        val digests = nativeSha256Batch(fds, listener)
+        if (cancelled) {
+            throw CancellationException("SHA-256 batch hashing cancelled")
+        }
+        return digests?.toList() ?: throw IOException("Unable to hash batch of ${fds.size} descriptors")
+    }
+
+    /**
+     * Считает SHA-256 содержимого [fd] и, при необходимости, SHA-256 тела в обёртке
+     * ([framePrefix]/[frameSuffix]) и HMAC-SHA256 с ключом [hmacKey] над [hmacPrefix] и телом —
+     * всё за одно чтение файла.
+     *
+     * @throws CancellationException если [onProgress] вернул `false`
+     * @throws IOException при ошибке чтения
+     */
+    fun digestBody(
+        fd: Int,
+        framePrefix: ByteArray? = null,
+        frameSuffix: ByteArray? = null,
+        hmacKey: ByteArray? = null,
+        hmacPrefix: ByteArray? = null,
+        onProgress: ProgressListener? = null,
+    ): BodyDigests {
+        check(available) { "Native hashing is unavailable" }
+        var cancelled = false
+        val listener = onProgress?.let { delegate ->
+            ProgressListener { hashedBytes, totalBytes ->
+                delegate.onProgress(hashedBytes, totalBytes).also { proceed ->
+                    if (!proceed) {
+                        cancelled = true
+                    }
+                }
+            }
+        }
+        val values = nativeDigestBody(fd, framePrefix, frameSuffix, hmacKey, hmacPrefix, listener)
+        if (cancelled) {
+            throw CancellationException("Body digest cancelled")
+        }
+        val contentSha256 = values?.getOrNull(0) ?: throw IOException("Unable to read file descriptor $fd")
+        return BodyDigests(
+            contentSha256 = contentSha256,
+            framedSha256 = values[1],
+            hmacSha256 = values[2],
+        )
+    }
+
+    /**
+     * Разбивает содержимое [fd] на чанки по содержимому и считает SHA-256 каждого чанка,
+     * корневой дайджест и SHA-256 файла за один проход.
+     *
+     * @throws CancellationException если [onProgress] вернул `false`
+     * @throws IOException при ошибке чтения
+     */
+    fun chunk(
+        fd: Int,
+        params: ChunkingParams = ChunkingParams(),
+        onProgress: ProgressListener? = null,
+    ): ChunkedDigest {
+        check(available) { "Native hashing is unavailable" }
+        var cancelled = false
+        val listener = onProgress?.let { delegate ->
+            ProgressListener { hashedBytes, totalBytes ->
+                delegate.onProgress(hashedBytes, totalBytes).also { proceed ->
+                    if (!proceed) {
+                        cancelled = true
+                    }
+                }
+            }
+        }
+        val payload = nativeChunkFd(fd, params.minSize, params.avgSize, params.maxSize, listener)
+        if (cancelled) {
+            throw CancellationException("Content chunking cancelled")
+        }
+        payload ?: throw IOException("Unable to chunk file descriptor $fd")
+        val lengths = payload[2] as LongArray
+        @Suppress("UNCHECKED_CAST")
+        val digests = payload[3] as Array<String>
+        var offset = 0L
+        val chunks = lengths.mapIndexed { index, length ->
+            ContentChunk(offset = offset, length = length, sha256 = digests[index]).also {
+                offset += length
+            }
+        }
+        return ChunkedDigest(
+            rootSha256 = payload[0] as String,
+            contentSha256 = payload[1] as String,
+            chunks = chunks,
+        )
+    }
+
+    @JvmStatic
+    private external fun nativeSha256Fd(fd: Int, progressListener: ProgressListener?): String?
+
+    @JvmStatic
+    private external fun nativeSha256Batch(fds: IntArray, progressListener: BatchProgressListener?): Array<String?>?
+
+    @JvmStatic
+    private external fun nativeDigestBody(
+        fd: Int,
+        framePrefix: ByteArray?,
+        frameSuffix: ByteArray?,
+        hmacKey: ByteArray?,
+        hmacPrefix: ByteArray?,
+        progressListener: ProgressListener?,
+    ): Array<String?>?
+
+    @JvmStatic
+    private external fun nativeChunkFd(
+        fd: Int,
+        minSize: Int,
+        avgSize: Int,
+        maxSize: Int,
+        progressListener: ProgressListener?,
+    ): Array<Any?>?
+}
@@ -14,9 +14,11 @@ import kotlinx.coroutines.withContext
 import okhttp3.MediaType
 import okhttp3.MultipartBody
 import okhttp3.RequestBody
+import okio.Buffer
 import okio.HashingSink
 import okio.buffer
 import okio.blackholeSink
+import com.kotopogoda.uploader.core.data.util.NativeHashing
 import com.kotopogoda.uploader.core.data.util.URI_READ_LOG_TAG
 import com.kotopogoda.uploader.core.data.util.hasPersistedReadPermission
 import com.kotopogoda.uploader.core.data.util.isMediaUri
@@ -88,6 +90,16 @@ internal suspend fun prepareUploadRequestPayload(
     val resolvedSize = if (totalBytes > 0) totalBytes else actualSize
     val boundary = buildBoundary(boundarySeed, fileSha)
 
+    val buildMultipart: (fileBody: RequestBody) -> MultipartBody = { fileBody ->
+        MultipartBody.Builder(boundary)
+            .setType(MultipartBody.FORM)
+            .addFormDataPart("content_sha256", fileSha)
+            .addFormDataPart("mime", mimeType)
+            .addFormDataPart("size", resolvedSize.toString())
+            .addFormDataPart("file", displayName, fileBody)
+            .build()
+    }
+
     val createBody: (onProgress: ((Long, Long) -> Unit)?) -> MultipartBody = { progressCallback ->
         val fileRequestBody = ContentUriRequestBody(
             resolver = resolver,
@@ -101,21 +113,18 @@ internal suspend fun prepareUploadRequestPayload(
         } else {
             fileRequestBody
         }
-        MultipartBody.Builder(boundary)
-            .setType(MultipartBody.FORM)
-            .addFormDataPart("content_sha256", fileSha)
-            .addFormDataPart("mime", mimeType)
-            .addFormDataPart("size", resolvedSize.toString())
-            .addFormDataPart("file", displayName, streamingBody)
-            .build()
+        buildMultipart(streamingBody)
     }
 
-    val hashingBody = createBody(null)
-    val hashingSink = HashingSink.sha256(blackholeSink())
-    val buffered = hashingSink.buffer()
-    hashingBody.writeTo(buffered)
-    buffered.close()
-    val requestSha = hashingSink.hash.hex()
+    val requestSha = computeRequestDigestNative(resolver, normalizedUri, mediaType, resolvedSize, buildMultipart)
+        ?: run {
+            val hashingBody = createBody(null)
+            val hashingSink = HashingSink.sha256(blackholeSink())
+            val buffered = hashingSink.buffer()
+            hashingBody.writeTo(buffered)
+            buffered.close()
+            hashingSink.hash.hex()
+        }
 
     UploadRequestPayload(
         fileSize = resolvedSize,
@@ -127,6 +136,43 @@ internal suspend fun prepareUploadRequestPayload(
     )
 }
 
+/**
+ * Дайджест multipart-тела без чтения файла на JVM: заголовки частей и хвост тела
+ * сериализуются вокруг маркера на месте файла, а сам файл хешируется нативно по
+ * дескриптору в обёртке из этих байтов. `null` — нативный путь недоступен.
+ */
+private fun computeRequestDigestNative(
+    resolver: ContentResolver,
+    normalizedUri: Uri,
+    mediaType: MediaType,
+    contentLength: Long,
+    buildMultipart: (fileBody: RequestBody) -> MultipartBody,
+): String? {
+    if (!NativeHashing.isAvailable()) {
+        return null
+    }
+    val marker = FramingMarkerBody(mediaType, contentLength)
+    val framing = Buffer()
+    buildMultipart(marker).writeTo(framing)
+    val markerOffset = marker.offset
+    if (markerOffset < 0) {
+        return null
+    }
+    val prefix = framing.readByteArray(markerOffset)
+    val suffix = framing.readByteArray()
+    return try {
+        resolver.openFileDescriptor(normalizedUri, "r")?.use { descriptor ->
+            NativeHashing.digestBody(descriptor.fd, framePrefix = prefix, frameSuffix = suffix).framedSha256
+        }
+    } catch (error: IOException) {
+        Timber.tag(URI_READ_LOG_TAG).w(error, "Native request digest failed for %s", normalizedUri)
+        null
+    } catch (error: IllegalArgumentException) {
+        Timber.tag(URI_READ_LOG_TAG).w(error, "File descriptor unavailable for %s", normalizedUri)
+        null
+    }
+}
+
 private fun inspectExif(stream: java.io.BufferedInputStream): ExifInspection {
     if (!stream.markSupported()) {
         return ExifInspection(hasCoordinates = null, latitudeRef = null, longitudeRef = null, canContinueReading = true)
@@ -227,6 +273,24 @@ private class ContentUriRequestBody(
     }
 }
 
+/** Пустое тело файла, запоминающее смещение, с которого MultipartBody начал бы писать файл. */
+private class FramingMarkerBody(
+    private val mediaType: MediaType,
+    private val contentLength: Long,
+) : RequestBody() {
+
+    var offset: Long = -1L
+        private set
+
+    override fun contentType(): MediaType = mediaType
+
+    override fun contentLength(): Long = contentLength
+
+    override fun writeTo(sink: okio.BufferedSink) {
+        offset = sink.buffer.size
+    }
+}
+
 private fun ByteArray.toHexString(): String =
     joinToString(separator = "") { byte -> "%02x".format(byte) }
 
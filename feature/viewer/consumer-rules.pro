@@ -1 +1,17 @@
-# Placeholder for consumer ProGuard rules.
+# JNI_OnLoad в libkotopogoda_enhance разрешает эти методы по имени.
+-keep interface com.kotopogoda.uploader.feature.viewer.enhance.NativeTileProgressCallback {
+    void onTileProgress(java.lang.String, int, int);
+}
+-keep interface com.kotopogoda.uploader.feature.viewer.enhance.NativeJobCompletion {
+    void onJobFinished(long, int);
+}
+-keep interface com.kotopogoda.uploader.feature.viewer.enhance.NativeBatchCodec {
+    android.graphics.Bitmap decode(java.lang.String);
+    boolean encode(android.graphics.Bitmap, java.lang.String, java.lang.String);
+}
+-keep interface com.kotopogoda.uploader.feature.viewer.enhance.NativeBatchListener {
+    void onItemFinished(int, int);
+}
+-keep interface com.kotopogoda.uploader.feature.viewer.enhance.NativePreviewLevelListener {
+    void onLevelReady(int);
+}
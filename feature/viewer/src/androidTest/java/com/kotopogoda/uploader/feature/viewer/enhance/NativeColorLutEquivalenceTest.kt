@@ -0,0 +1,97 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+import android.graphics.Color
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import androidx.test.filters.MediumTest
+import kotlin.math.abs
+import kotlin.math.max
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertNotNull
+import kotlin.test.assertTrue
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+
+/**
+ * Нативная 3D LUT ([NativeEnhanceController.applyColorLut]) против Kotlin-реализации
+ * [EnhanceEngine.applyVibranceAndSaturation] на сетке цветов и коэффициентов из диапазонов
+ * `ProfileCalculator`: 65^3 — не больше 1 LSB, 33^3 — не больше 2 LSB, альфа совпадает.
+ */
+@RunWith(AndroidJUnit4::class)
+@MediumTest
+class NativeColorLutEquivalenceTest {
+
+    @Before
+    fun setUp() {
+        NativeEnhanceController.loadLibrary()
+    }
+
+    @Test
+    fun lut65MatchesKotlinWithinOneLsb() {
+        assertGridMatches(NativeEnhanceController.COLOR_LUT_SIZE_65, tolerance = 1)
+    }
+
+    @Test
+    fun lut33MatchesKotlinWithinTwoLsb() {
+        assertGridMatches(NativeEnhanceController.COLOR_LUT_SIZE_33, tolerance = 2)
+    }
+
+    @Test
+    fun defaultEngineUsesNativeGrader() {
+        val buffer = colorGrid()
+        val engineResult = EnhanceEngine().applyVibranceAndSaturation(buffer, 0.4f, 1.2f)
+        val nativeResult = NativeEnhanceController.applyColorLut(buffer.pixels, buffer.width, buffer.height, 0.4f, 1.2f)
+        assertNotNull(nativeResult)
+        assertContentEquals(nativeResult, engineResult.pixels)
+    }
+
+    private fun assertGridMatches(lutSize: Int, tolerance: Int) {
+        val kotlinEngine = EnhanceEngine(colorGrader = null)
+        val buffer = colorGrid()
+        for (vibranceGain in VIBRANCE_GAINS) {
+            for (saturationGain in SATURATION_GAINS) {
+                val label = "lut=$lutSize vibrance=$vibranceGain saturation=$saturationGain"
+                val expected = kotlinEngine.applyVibranceAndSaturation(buffer, vibranceGain, saturationGain).pixels
+                val actual = NativeEnhanceController.applyColorLut(
+                    buffer.pixels,
+                    buffer.width,
+                    buffer.height,
+                    vibranceGain,
+                    saturationGain,
+                    lutSize,
+                )
+                assertNotNull(actual, "натив вернул null, $label")
+                var maxDifference = 0
+                for (i in expected.indices) {
+                    assertEquals(Color.alpha(expected[i]), Color.alpha(actual[i]), "альфа в $i, $label")
+                    maxDifference = max(maxDifference, abs(Color.red(expected[i]) - Color.red(actual[i])))
+                    maxDifference = max(maxDifference, abs(Color.green(expected[i]) - Color.green(actual[i])))
+                    maxDifference = max(maxDifference, abs(Color.blue(expected[i]) - Color.blue(actual[i])))
+                }
+                assertTrue(maxDifference <= tolerance, "расхождение $maxDifference LSB, $label")
+            }
+        }
+    }
+
+    // Все цвета с шагом 15 по каналу (0, 15, ..., 255) и разной альфой, кадр 18^2 x 18.
+    private fun colorGrid(): EnhanceEngine.ImageBuffer {
+        val levels = (0..255 step 15).toList()
+        val pixels = IntArray(levels.size * levels.size * levels.size)
+        var index = 0
+        for (r in levels) {
+            for (g in levels) {
+                for (b in levels) {
+                    pixels[index] = Color.argb((index * 29) and 0xFF, r, g, b)
+                    index++
+                }
+            }
+        }
+        return EnhanceEngine.ImageBuffer(levels.size * levels.size, levels.size, pixels)
+    }
+
+    private companion object {
+        val VIBRANCE_GAINS = listOf(0f, 0.05f, 0.3f, 0.6f, 0.9f, 1.12f)
+        val SATURATION_GAINS = listOf(0.86f, 1f, 1.15f, 1.3f, 1.48f)
+    }
+}
@@ -0,0 +1,149 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+import android.content.Context
+import android.graphics.Bitmap
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import androidx.test.filters.LargeTest
+import androidx.test.platform.app.InstrumentationRegistry
+import com.kotopogoda.uploader.core.data.ml.ModelDefinition
+import com.kotopogoda.uploader.core.data.ml.ModelsLockParser
+import com.kotopogoda.uploader.feature.viewer.BuildConfig
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.awaitAll
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.runBlocking
+import org.junit.After
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+/**
+ * Превью и полная обработка на одном handle выполняются одновременно: у
+ * каждого запуска свой RunContext поверх общей сети. Результат превью под
+ * нагрузкой должен совпадать побайтно с результатом без нагрузки.
+ */
+@RunWith(AndroidJUnit4::class)
+@LargeTest
+class NativeEnhanceConcurrencyStressTest {
+
+    private lateinit var context: Context
+    private lateinit var controller: NativeEnhanceController
+
+    @Before
+    fun setUp() {
+        NativeEnhanceController.loadLibrary()
+        context = InstrumentationRegistry.getInstrumentation().targetContext
+        val modelsDir = EnhancerModelsInstaller(context).ensureInstalled()
+        val lock = ModelsLockParser.parse(BuildConfig.MODELS_LOCK_JSON)
+        val zeroDce = lock.require("zerodcepp_fp16")
+        controller = NativeEnhanceController(dispatcher = Dispatchers.Default)
+        runBlocking {
+            controller.initialize(
+                NativeEnhanceController.InitParams(
+                    assetManager = context.assets,
+                    modelsDir = modelsDir,
+                    zeroDceChecksums = zeroDce.toChecksums(),
+                    restormerChecksums = NativeEnhanceController.ModelChecksums("dummy", "dummy"),
+                    zeroDceFiles = zeroDce.toModelFiles(),
+                    restormerFiles = NativeEnhanceController.ModelFiles("dummy.param", "dummy.bin"),
+                    previewProfile = NativeEnhanceController.PreviewProfile.BALANCED,
+                ),
+            )
+        }
+    }
+
+    @After
+    fun tearDown() {
+        runBlocking { controller.release() }
+    }
+
+    @Test
+    fun previewsRunAlongsideFullRunOnOneHandle() = runBlocking {
+        val reference = gradientBitmap(PREVIEW_SIZE)
+        val referenceResult = controller.runPreview(reference, STRENGTH)
+        assertTrue(referenceResult.success, "Эталонное превью должно выполниться")
+
+        repeat(ROUNDS) { round ->
+            coroutineScope {
+                val full = async {
+                    controller.runFull(
+                        sourceBitmap = gradientBitmap(FULL_SIZE),
+                        strength = STRENGTH,
+                        outputFile = context.cacheDir.resolve("stress_full_$round.jpg"),
+                    )
+                }
+                val previews = (0 until PREVIEWS_PER_ROUND).map { index ->
+                    async {
+                        val bitmap = gradientBitmap(PREVIEW_SIZE)
+                        val result = controller.runPreview(
+                            sourceBitmap = bitmap,
+                            strength = STRENGTH,
+                            photoKey = "stress_${round}_$index",
+                        )
+                        result to bitmap
+                    }
+                }
+
+                previews.awaitAll().forEachIndexed { index, (result, bitmap) ->
+                    assertTrue(result.success, "Превью $index раунда $round должно выполниться")
+                    assertFalse(result.superseded, "Превью с разными ключами не вытесняют друг друга")
+                    assertTrue(
+                        bitmap.sameAs(reference),
+                        "Превью $index раунда $round отличается от эталона",
+                    )
+                    bitmap.recycle()
+                }
+
+                val fullResult = full.await()
+                assertFalse(fullResult.cancelled, "Полная обработка не должна отменяться превью")
+                fullResult.bitmap?.recycle()
+            }
+        }
+        reference.recycle()
+    }
+
+    private fun gradientBitmap(size: Int): Bitmap {
+        val pixels = IntArray(size * size) { index ->
+            val x = index % size
+            val y = index / size
+            val r = x * 255 / size
+            val g = y * 255 / size
+            val b = (x + y) * 127 / size
+            (0xFF shl 24) or (r shl 16) or (g shl 8) or b
+        }
+        return Bitmap.createBitmap(pixels, size, size, Bitmap.Config.ARGB_8888)
+            .copy(Bitmap.Config.ARGB_8888, true)
+    }
+
+    private companion object {
+        const val STRENGTH = 0.8f
+        const val PREVIEW_SIZE = 256
+        const val FULL_SIZE = 1536
+        const val ROUNDS = 3
+        const val PREVIEWS_PER_ROUND = 8
+    }
+}
+
+private fun ModelDefinition.toChecksums(): NativeEnhanceController.ModelChecksums {
+    val filesByExt = filesByExtension()
+    val param = filesByExt["param"]?.sha256
+        ?: error("Модель ${name} не содержит param файла")
+    val bin = filesByExt["bin"]?.sha256
+        ?: error("Модель ${name} не содержит bin файла")
+    return NativeEnhanceController.ModelChecksums(param, bin)
+}
+
+private fun ModelDefinition.toModelFiles(): NativeEnhanceController.ModelFiles {
+    val filesByExt = filesByExtension()
+    val paramPath = filesByExt["param"]?.path
+        ?: error("Модель ${name} не содержит param файла")
+    val binPath = filesByExt["bin"]?.path
+        ?: error("Модель ${name} не содержит bin файла")
+    return NativeEnhanceController.ModelFiles(
+        paramFile = paramPath.substringAfterLast('/'),
+        binFile = binPath.substringAfterLast('/'),
+    )
+}
@@ -0,0 +1,103 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+import android.graphics.Color
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import androidx.test.filters.MediumTest
+import kotlin.math.abs
+import kotlin.math.max
+import kotlin.random.Random
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertNotNull
+import kotlin.test.assertTrue
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+
+/**
+ * Нативное [NativeEnhanceController.applyEdgeAwareUnsharp] против Kotlin-реализации
+ * [EnhanceEngine.applyEdgeAwareUnsharp] на случайных кадрах: каналы расходятся не больше
+ * чем на 1 LSB, альфа совпадает.
+ */
+@RunWith(AndroidJUnit4::class)
+@MediumTest
+class NativeSharpenerEquivalenceTest {
+
+    private data class Params(val amount: Float, val radius: Float, val threshold: Float)
+
+    @Before
+    fun setUp() {
+        NativeEnhanceController.loadLibrary()
+    }
+
+    @Test
+    fun nativeMatchesKotlinWithinOneLsb() {
+        val kotlinEngine = EnhanceEngine(sharpener = null)
+        // Радиусы с округлением вниз и вверх и за пределами ограничений Kotlin.
+        val params = listOf(
+            Params(amount = 0.6f, radius = 0.6f, threshold = 0f),
+            Params(amount = 1.0f, radius = 1.0f, threshold = 0.02f),
+            Params(amount = 1.2f, radius = 2.4f, threshold = 0.05f),
+            Params(amount = 0.8f, radius = 2.5f, threshold = 0f),
+            Params(amount = 1.5f, radius = 5f, threshold = 0.1f),
+            Params(amount = 3.0f, radius = 12f, threshold = 0.01f),
+            Params(amount = 0.4f, radius = 30f, threshold = 1.5f),
+        )
+        val sizes = listOf(67 to 41, 130 to 200, 5 to 3)
+        var seed = 1
+        for ((width, height) in sizes) {
+            for (p in params) {
+                val buffer = randomBuffer(width, height, Random(seed++))
+                val expected = kotlinEngine.applyEdgeAwareUnsharp(buffer, p.amount, p.radius, p.threshold)
+                val actual = NativeEnhanceController.applyEdgeAwareUnsharp(
+                    buffer.pixels,
+                    width,
+                    height,
+                    p.amount,
+                    p.radius,
+                    p.threshold,
+                )
+                assertNotNull(actual, "натив вернул null для ${width}x$height $p")
+                assertMatches(expected.pixels, actual, "${width}x$height $p")
+            }
+        }
+    }
+
+    @Test
+    fun defaultEngineUsesNativeSharpener() {
+        val buffer = randomBuffer(48, 32, Random(7))
+        val engineResult = EnhanceEngine().applyEdgeAwareUnsharp(buffer, 1f, 2f, 0.02f)
+        val nativeResult = NativeEnhanceController.applyEdgeAwareUnsharp(buffer.pixels, 48, 32, 1f, 2f, 0.02f)
+        assertNotNull(nativeResult)
+        assertContentEquals(nativeResult, engineResult.pixels)
+    }
+
+    private fun assertMatches(expected: IntArray, actual: IntArray, label: String) {
+        assertEquals(expected.size, actual.size)
+        var maxDifference = 0
+        for (i in expected.indices) {
+            assertEquals(Color.alpha(expected[i]), Color.alpha(actual[i]), "альфа в $i, $label")
+            maxDifference = max(maxDifference, abs(Color.red(expected[i]) - Color.red(actual[i])))
+            maxDifference = max(maxDifference, abs(Color.green(expected[i]) - Color.green(actual[i])))
+            maxDifference = max(maxDifference, abs(Color.blue(expected[i]) - Color.blue(actual[i])))
+        }
+        assertTrue(maxDifference <= 1, "расхождение $maxDifference LSB, $label")
+    }
+
+    // Шум поверх градиента: есть и резкие края, и пиксели ниже порога.
+    private fun randomBuffer(width: Int, height: Int, random: Random): EnhanceEngine.ImageBuffer {
+        val pixels = IntArray(width * height) { index ->
+            val x = index % width
+            val y = index / width
+            val base = (x * 255 / width + y * 255 / height) / 2
+            val noise = random.nextInt(-32, 32)
+            Color.argb(
+                random.nextInt(256),
+                (base + noise).coerceIn(0, 255),
+                (255 - base + noise / 2).coerceIn(0, 255),
+                random.nextInt(256),
+            )
+        }
+        return EnhanceEngine.ImageBuffer(width, height, pixels)
+    }
+}
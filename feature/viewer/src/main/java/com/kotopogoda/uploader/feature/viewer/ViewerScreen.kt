@@ -4,6 +4,7 @@ package com.kotopogoda.uploader.feature.viewer
 
 import android.app.Activity
 import android.content.Intent
+import android.graphics.Bitmap
 import android.net.Uri
 import android.provider.DocumentsContract
 import android.text.format.Formatter
@@ -14,6 +15,7 @@ import androidx.activity.result.IntentSenderRequest
 import androidx.activity.result.contract.ActivityResultContracts
 import androidx.annotation.VisibleForTesting
 import androidx.compose.foundation.ExperimentalFoundationApi
+import androidx.compose.foundation.Image
 import androidx.compose.foundation.BorderStroke
 import androidx.compose.foundation.background
 import androidx.compose.foundation.combinedClickable
@@ -94,6 +96,7 @@ import androidx.compose.runtime.snapshotFlow
 import androidx.compose.ui.Alignment
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.graphics.Color
+import androidx.compose.ui.graphics.asImageBitmap
 import androidx.compose.ui.input.pointer.pointerInput
 import androidx.compose.ui.platform.LocalContext
 import androidx.compose.ui.platform.testTag
@@ -343,6 +346,8 @@ fun ViewerRoute(
         enhancementReady = enhancementState.isResultReady,
         enhancementResultUri = enhancementState.resultUri,
         isEnhancementResultForCurrentPhoto = enhancementState.isResultForCurrentPhoto,
+        enhancementPreviewBitmap = enhancementState.previewBitmap,
+        enhancementPreviewPhotoId = enhancementState.previewPhotoId,
         enhancementProgress = enhancementState.progressByTile,
         onEnhancementStrengthChange = viewModel::onEnhancementStrengthChange,
         onEnhancementStrengthChangeFinished = viewModel::onEnhancementStrengthChangeFinished,
@@ -407,6 +412,8 @@ internal fun ViewerScreen(
     enhancementReady: Boolean,
     enhancementResultUri: Uri?,
     isEnhancementResultForCurrentPhoto: Boolean,
+    enhancementPreviewBitmap: Bitmap? = null,
+    enhancementPreviewPhotoId: String? = null,
     enhancementProgress: Map<Int, Float>,
     onEnhancementStrengthChange: (Float) -> Unit,
     onEnhancementStrengthChangeFinished: () -> Unit,
@@ -734,6 +741,13 @@ internal fun ViewerScreen(
                                 )
                             }
                             
+                            if (showLoader && enhancementPreviewBitmap != null && enhancementPreviewPhotoId == item.id) {
+                                EnhancementProgressivePreview(
+                                    bitmap = enhancementPreviewBitmap,
+                                    modifier = Modifier.fillMaxSize(),
+                                )
+                            }
+
                             if (showLoader) {
                                 val loaderProgress = enhancementProgress.values
                                     .ifEmpty { listOf(0f) }
@@ -1695,6 +1709,27 @@ private fun ViewerEmptyState() {
     }
 }
 
+/**
+ * Промежуточный уровень прогрессивного превью поверх исходника, пока идёт
+ * улучшение. Ориентация по EXIF (поворот и отражения) уже целиком применена
+ * адаптером, поэтому здесь Bitmap выводится как есть.
+ */
+@Composable
+private fun EnhancementProgressivePreview(
+    bitmap: Bitmap,
+    modifier: Modifier = Modifier,
+) {
+    val imageBitmap = remember(bitmap) { bitmap.asImageBitmap() }
+    Image(
+        bitmap = imageBitmap,
+        contentDescription = null,
+        contentScale = ContentScale.Fit,
+        modifier = modifier
+            .background(Color.Black)
+            .testTag("enhancement_progressive_preview"),
+    )
+}
+
 @Composable
 private fun EnhancementLoaderOverlay(
     modifier: Modifier = Modifier,
@@ -6,6 +6,7 @@ import android.content.ContentResolver
 import android.content.Context
 import android.content.IntentSender
 import android.database.Cursor
+import android.graphics.Bitmap
 import android.net.Uri
 import android.os.Build
 import android.os.Debug
@@ -49,6 +50,7 @@ import com.kotopogoda.uploader.core.settings.reviewProgressFolderId
 import com.kotopogoda.uploader.feature.viewer.enhance.EnhanceEngine
 import com.kotopogoda.uploader.feature.viewer.enhance.EnhanceLogging
 import com.kotopogoda.uploader.feature.viewer.enhance.NativeEnhanceAdapter
+import com.kotopogoda.uploader.feature.viewer.enhance.NativeEnhanceController
 import dagger.hilt.android.lifecycle.HiltViewModel
 import dagger.hilt.android.qualifiers.ApplicationContext
 import java.io.File
@@ -934,6 +936,8 @@ class ViewerViewModel @Inject constructor(
                     resultUri = null,
                     resultPhotoId = null,
                     isResultForCurrentPhoto = false,
+                    previewBitmap = null,
+                    previewPhotoId = null,
                 )
             }
             return
@@ -957,6 +961,8 @@ class ViewerViewModel @Inject constructor(
                         resultUri = null,
                         resultPhotoId = null,
                         isResultForCurrentPhoto = false,
+                        previewBitmap = null,
+                        previewPhotoId = null,
                     )
                 }
             }
@@ -975,6 +981,8 @@ class ViewerViewModel @Inject constructor(
                 resultUri = null,
                 resultPhotoId = null,
                 isResultForCurrentPhoto = false,
+                previewBitmap = null,
+                previewPhotoId = null,
             )
         }
     }
@@ -1210,6 +1218,8 @@ class ViewerViewModel @Inject constructor(
                             resultUri = null,
                             resultPhotoId = null,
                             isResultForCurrentPhoto = false,
+                            previewBitmap = null,
+                            previewPhotoId = null,
                         )
                     }
                 }
@@ -2470,6 +2480,8 @@ class ViewerViewModel @Inject constructor(
                     resultUri = null,
                     resultPhotoId = null,
                     isResultForCurrentPhoto = false,
+                    previewBitmap = null,
+                    previewPhotoId = null,
                 )
             }
             val workspace = try {
@@ -2485,6 +2497,8 @@ class ViewerViewModel @Inject constructor(
                         resultUri = null,
                         resultPhotoId = null,
                         isResultForCurrentPhoto = false,
+                        previewBitmap = null,
+                        previewPhotoId = null,
                     )
                 }
                 return@launch
@@ -2676,9 +2690,28 @@ class ViewerViewModel @Inject constructor(
                         fallbackReason = "adapter_unavailable"
                         return null
                     }
+                    // Цветовая стадия профиля применяется нативно при записи результата.
+                    val colorGains = NativeEnhanceController.ColorGains(
+                        vibranceGain = predictedProfile.vibranceGain,
+                        saturationGain = predictedProfile.saturationGain,
+                    )
                     val previewOk = nativeEnhanceAdapter.computePreview(
                         sourceFile = workspace.source,
                         strength = normalized,
+                        onPreviewLevel = { level ->
+                            viewModelScope.launch {
+                                _enhancementState.update { state ->
+                                    if (!state.inProgress) {
+                                        return@update state
+                                    }
+                                    state.copy(
+                                        previewBitmap = level.bitmap,
+                                        previewPhotoId = photo.id,
+                                    )
+                                }
+                            }
+                        },
+                        colorGains = colorGains,
                     ) { value -> updateNativeProgress(value) }
                     if (!previewOk) {
                         fallbackReason = "preview_failed"
@@ -2689,6 +2722,7 @@ class ViewerViewModel @Inject constructor(
                         strength = normalized,
                         outputFile = workspace.output,
                         exif = workspace.exif,
+                        colorGains = colorGains,
                     ) { value -> updateNativeProgress(value) } ?: run {
                         if (fallbackReason == null) {
                             fallbackReason = "full_failed"
@@ -2835,6 +2869,8 @@ class ViewerViewModel @Inject constructor(
                         resultUri = result.uri,
                         resultPhotoId = photo.id,
                         isResultForCurrentPhoto = matchesCurrentPhoto,
+                        previewBitmap = null,
+                        previewPhotoId = null,
                     )
                 }
                 logEnhancementDecision(photo, delegatePlan, analysis, result)
@@ -2896,6 +2932,8 @@ class ViewerViewModel @Inject constructor(
                 resultUri = null,
                 resultPhotoId = null,
                 isResultForCurrentPhoto = false,
+                previewBitmap = null,
+                previewPhotoId = null,
             )
         }
     }
@@ -3102,12 +3140,21 @@ class ViewerViewModel @Inject constructor(
             EnhancementWorkspace(source = source, output = output, exif = exif)
         }
 
-    private suspend fun analyzeWorkspace(workspace: EnhancementWorkspace): WorkspaceAnalysis =
-        withContext(Dispatchers.IO) {
+    /**
+     * Метрики входа для профиля и делегата. JPEG считает натив по уменьшенному
+     * кадру без полноразмерного декодирования; полный проход Kotlin остаётся для
+     * файлов, которые нативный декодер не читает, и когда натив не готов.
+     */
+    private suspend fun analyzeWorkspace(workspace: EnhancementWorkspace): WorkspaceAnalysis {
+        nativeEnhanceAdapter?.computeInputMetrics(workspace.source)?.let { analysis ->
+            return WorkspaceAnalysis(metrics = analysis.metrics, width = analysis.width, height = analysis.height)
+        }
+        return withContext(Dispatchers.IO) {
             val buffer = EnhanceEngine.BitmapImageDecoder().decode(workspace.source)
             val metrics = EnhanceEngine.MetricsCalculator.calculate(buffer)
             WorkspaceAnalysis(metrics = metrics, width = buffer.width, height = buffer.height)
         }
+    }
 
     private fun selectEnhancementDelegate(
         metrics: EnhanceEngine.Metrics,
@@ -3772,6 +3819,8 @@ class ViewerViewModel @Inject constructor(
         val resultUri: Uri? = null,
         val resultPhotoId: String? = null,
         val isResultForCurrentPhoto: Boolean = false,
+        val previewBitmap: Bitmap? = null,
+        val previewPhotoId: String? = null,
     )
 
     enum class EnhancementResultDisposition { DISCARD, ENQUEUED, UPLOADED }
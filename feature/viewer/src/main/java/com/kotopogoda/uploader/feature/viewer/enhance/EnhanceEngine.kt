@@ -4,6 +4,7 @@ import android.graphics.Bitmap
 import android.graphics.BitmapFactory
 import android.graphics.Color
 import android.media.ExifInterface
+import androidx.annotation.VisibleForTesting
 import java.io.File
 import java.io.FileOutputStream
 import java.io.IOException
@@ -29,6 +30,13 @@ import timber.log.Timber
  * Центральный класс, отвечающий за вычисление метрик изображения и применение цепочки улучшений.
  * Алгоритм держится в JVM-памяти (через [ImageBuffer]) и поэтому пригоден как для unit-тестов,
  * так и для боевого использования через стандартные [Bitmap]-ы.
+ *
+ * В приложении движок не создаётся: просмотрщик улучшает фото через [NativeEnhanceAdapter] и
+ * берёт отсюда лишь [ProfileCalculator]; цветовую стадию профиля натив применяет при записи
+ * результата ([NativeEnhanceController.ColorGains]). Конвейер целиком служит эталоном для тестов. Резкость и цветовая стадия в нём считаются
+ * нативно ([NativeEdgeAwareSharpener], [NativeColorLutGrader]), если библиотека загружена;
+ * без неё (unit-тесты на JVM) работает реализация на Kotlin. `sharpener = null` и
+ * `colorGrader = null` принудительно оставляют Kotlin-путь.
  */
 class EnhanceEngine(
     private val decoder: ImageDecoder = BitmapImageDecoder(),
@@ -37,6 +45,8 @@ class EnhanceEngine(
     private val restormer: RestormerModel? = null,
     private val dispatcher: CoroutineDispatcher = Dispatchers.IO,
     private val expectedChecksums: ExpectedChecksums = ExpectedChecksums(),
+    private val sharpener: Sharpener? = NativeEdgeAwareSharpener,
+    private val colorGrader: ColorGrader? = NativeColorLutGrader(),
 ) {
 
     enum class Delegate {
@@ -864,7 +874,8 @@ class EnhanceEngine(
         return tilesX * tilesY
     }
 
-    private fun applyEdgeAwareUnsharp(
+    @VisibleForTesting
+    internal fun applyEdgeAwareUnsharp(
         buffer: ImageBuffer,
         amount: Float,
         radius: Float,
@@ -877,6 +888,7 @@ class EnhanceEngine(
         val height = buffer.height
         val total = width * height
         if (total == 0) return buffer
+        sharpener?.applyEdgeAwareUnsharp(buffer, amount, radius, threshold)?.let { return it }
 
         val srcR = FloatArray(total)
         val srcG = FloatArray(total)
@@ -995,7 +1007,8 @@ class EnhanceEngine(
         return kernel
     }
 
-    private fun applyVibranceAndSaturation(
+    @VisibleForTesting
+    internal fun applyVibranceAndSaturation(
         buffer: ImageBuffer,
         vibranceGain: Float,
         saturationGain: Float,
@@ -1003,6 +1016,7 @@ class EnhanceEngine(
         if (abs(vibranceGain) <= 1e-3f && abs(saturationGain - 1f) <= 1e-3f) {
             return buffer
         }
+        colorGrader?.applyVibranceAndSaturation(buffer, vibranceGain, saturationGain)?.let { return it }
         val pixels = buffer.pixels.copyOf()
         for (index in pixels.indices) {
             val color = pixels[index]
@@ -1128,6 +1142,22 @@ class EnhanceEngine(
         fun encode(buffer: ImageBuffer, target: File)
     }
 
+    /**
+     * Ускоренная реализация [applyEdgeAwareUnsharp] с тем же результатом (±1 LSB).
+     * `null` — не справилась, тогда работает реализация на Kotlin.
+     */
+    interface Sharpener {
+        fun applyEdgeAwareUnsharp(buffer: ImageBuffer, amount: Float, radius: Float, threshold: Float): ImageBuffer?
+    }
+
+    /**
+     * Ускоренная реализация [applyVibranceAndSaturation] (например, через 3D LUT).
+     * `null` — не справилась, тогда работает реализация на Kotlin.
+     */
+    interface ColorGrader {
+        fun applyVibranceAndSaturation(buffer: ImageBuffer, vibranceGain: Float, saturationGain: Float): ImageBuffer?
+    }
+
     interface ZeroDceModel {
         val backend: ModelBackend
         val checksum: String
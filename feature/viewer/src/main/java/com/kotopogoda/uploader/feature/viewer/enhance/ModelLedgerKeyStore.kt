@@ -0,0 +1,51 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+import android.content.Context
+import timber.log.Timber
+import java.io.File
+import java.io.IOException
+import java.security.SecureRandom
+
+/**
+ * Хранит ключ HMAC для нативного журнала проверок моделей.
+ * Ключ генерируется один раз на установку и лежит в noBackupFilesDir,
+ * поэтому журнал, восстановленный из бэкапа или скопированный с другого
+ * устройства, не пройдёт проверку подписи и модели будут перехешированы.
+ */
+class ModelLedgerKeyStore(
+    private val keyFile: File,
+) {
+
+    constructor(context: Context) : this(File(context.noBackupFilesDir, KEY_FILE_NAME))
+
+    @Synchronized
+    fun getOrCreateKey(): ByteArray? {
+        return try {
+            if (keyFile.exists()) {
+                val stored = keyFile.readBytes()
+                if (stored.size == KEY_SIZE_BYTES) {
+                    return stored
+                }
+                Timber.tag(TAG).w("Ключ журнала проверок повреждён (size=%d), создаём новый", stored.size)
+            }
+            val key = ByteArray(KEY_SIZE_BYTES).also(SecureRandom()::nextBytes)
+            keyFile.parentFile?.mkdirs()
+            val tmpFile = File(keyFile.parentFile, "${keyFile.name}.tmp")
+            tmpFile.writeBytes(key)
+            if (!tmpFile.renameTo(keyFile)) {
+                tmpFile.delete()
+                throw IOException("Не удалось сохранить ключ журнала проверок")
+            }
+            key
+        } catch (error: IOException) {
+            Timber.tag(TAG).w(error, "Журнал проверок моделей отключён: ключ недоступен")
+            null
+        }
+    }
+
+    companion object {
+        private const val TAG = "ModelLedgerKeyStore"
+        private const val KEY_FILE_NAME = "model_ledger.key"
+        private const val KEY_SIZE_BYTES = 32
+    }
+}
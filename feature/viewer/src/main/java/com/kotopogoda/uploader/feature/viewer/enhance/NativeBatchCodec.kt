@@ -0,0 +1,18 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+import android.graphics.Bitmap
+
+/**
+ * Декодирование и кодирование для пакетного пайплайна там, где натив не
+ * справляется сам: JPEG он декодирует и кодирует без Bitmap. Натив вызывает [decode]
+ * из потока декодирования, а [encode] — из потока кодирования (оба
+ * `kotopogoda-batch`), поэтому реализация должна допускать одновременные вызовы
+ * для разных элементов пакета.
+ */
+interface NativeBatchCodec {
+    /** Декодирует источник в ARGB_8888 Bitmap; `null` — элемент завершится ошибкой декодирования. */
+    fun decode(inputPath: String): Bitmap?
+
+    /** Записывает результат (натив уже перенёс его в [bitmap]) в [outputPath]. */
+    fun encode(bitmap: Bitmap, inputPath: String, outputPath: String): Boolean
+}
@@ -0,0 +1,46 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Прямой буфер с записями элементов пакета, зеркально `batch_item_layout` в
+ * `telemetry_buffer.h`. Натив пишет запись элемента при его завершении;
+ * состояние пишется последним, поэтому PENDING означает, что элемент не
+ * завершился (например, пакет отменён до запуска).
+ */
+internal class NativeBatchItemsBuffer(val itemCount: Int) {
+
+    val buffer: ByteBuffer = ByteBuffer.allocateDirect(itemCount * RECORD_SIZE_BYTES)
+        .order(ByteOrder.nativeOrder())
+
+    fun decode(index: Int): NativeEnhanceController.BatchItemResult {
+        require(index in 0 until itemCount) { "Индекс элемента вне пакета: $index" }
+        val base = index * RECORD_SIZE_BYTES
+        return NativeEnhanceController.BatchItemResult(
+            index = index,
+            state = NativeEnhanceController.BatchItemState.fromCode(buffer.getInt(base + OFFSET_STATE)),
+            stoppedAt = NativeEnhanceController.BatchStage.fromCode(buffer.getInt(base + OFFSET_STOPPED_AT)),
+            decodeMs = buffer.getLong(base + OFFSET_DECODE_MS),
+            inferMs = buffer.getLong(base + OFFSET_INFER_MS),
+            encodeMs = buffer.getLong(base + OFFSET_ENCODE_MS),
+            width = buffer.getInt(base + OFFSET_WIDTH),
+            height = buffer.getInt(base + OFFSET_HEIGHT),
+            telemetry = NativeTelemetryBuffer.decodeAt(buffer, base + OFFSET_TELEMETRY),
+        )
+    }
+
+    fun decodeAll(): List<NativeEnhanceController.BatchItemResult> = (0 until itemCount).map(::decode)
+
+    internal companion object {
+        const val OFFSET_STATE = 0
+        const val OFFSET_STOPPED_AT = 4
+        const val OFFSET_DECODE_MS = 8
+        const val OFFSET_INFER_MS = 16
+        const val OFFSET_ENCODE_MS = 24
+        const val OFFSET_WIDTH = 32
+        const val OFFSET_HEIGHT = 36
+        const val OFFSET_TELEMETRY = 40
+        const val RECORD_SIZE_BYTES = OFFSET_TELEMETRY + NativeTelemetryBuffer.SIZE_BYTES
+    }
+}
@@ -0,0 +1,10 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+/**
+ * Завершение элемента пакета с кодом [NativeEnhanceController.BatchItemState].
+ * Вызывается из потока пайплайна, завершившего элемент; запись элемента в
+ * [NativeBatchItemsBuffer] к этому моменту уже заполнена.
+ */
+fun interface NativeBatchListener {
+    fun onItemFinished(index: Int, state: Int)
+}
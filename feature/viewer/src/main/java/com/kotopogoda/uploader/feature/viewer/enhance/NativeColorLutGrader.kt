@@ -0,0 +1,45 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+import timber.log.Timber
+
+/**
+ * [EnhanceEngine.ColorGrader] на нативной 3D LUT ([NativeEnhanceController.applyColorLut]).
+ * Требует загруженной библиотеки ([NativeEnhanceController.loadLibrary]); если её нет,
+ * один раз пишет предупреждение и дальше возвращает `null`, оставляя Kotlin-путь.
+ */
+class NativeColorLutGrader(
+    private val lutSize: Int = NativeEnhanceController.COLOR_LUT_SIZE_65,
+) : EnhanceEngine.ColorGrader {
+
+    @Volatile
+    private var unavailable = false
+
+    override fun applyVibranceAndSaturation(
+        buffer: EnhanceEngine.ImageBuffer,
+        vibranceGain: Float,
+        saturationGain: Float,
+    ): EnhanceEngine.ImageBuffer? {
+        if (unavailable) {
+            return null
+        }
+        val pixels = try {
+            NativeEnhanceController.applyColorLut(
+                buffer.pixels,
+                buffer.width,
+                buffer.height,
+                vibranceGain,
+                saturationGain,
+                lutSize,
+            )
+        } catch (error: UnsatisfiedLinkError) {
+            unavailable = true
+            Timber.tag(LOG_TAG).w(error, "Нативная цветовая LUT недоступна, используется Kotlin")
+            return null
+        } ?: return null
+        return EnhanceEngine.ImageBuffer(buffer.width, buffer.height, pixels)
+    }
+
+    companion object {
+        private const val LOG_TAG = "NativeColorLutGrader"
+    }
+}
@@ -0,0 +1,42 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+import timber.log.Timber
+
+/**
+ * [EnhanceEngine.Sharpener] на нативном ядре ([NativeEnhanceController.applyEdgeAwareUnsharp]).
+ * Требует загруженной библиотеки ([NativeEnhanceController.loadLibrary]); если её нет,
+ * один раз пишет предупреждение и дальше возвращает `null`, оставляя Kotlin-путь.
+ * Используется только [EnhanceEngine]; рабочий путь просмотрщика резкость не применяет.
+ */
+object NativeEdgeAwareSharpener : EnhanceEngine.Sharpener {
+    private const val LOG_TAG = "NativeEdgeAwareSharpener"
+
+    @Volatile
+    private var unavailable = false
+
+    override fun applyEdgeAwareUnsharp(
+        buffer: EnhanceEngine.ImageBuffer,
+        amount: Float,
+        radius: Float,
+        threshold: Float,
+    ): EnhanceEngine.ImageBuffer? {
+        if (unavailable) {
+            return null
+        }
+        val pixels = try {
+            NativeEnhanceController.applyEdgeAwareUnsharp(
+                buffer.pixels,
+                buffer.width,
+                buffer.height,
+                amount,
+                radius,
+                threshold,
+            )
+        } catch (error: UnsatisfiedLinkError) {
+            unavailable = true
+            Timber.tag(LOG_TAG).w(error, "Нативное ядро резкости недоступно, используется Kotlin")
+            return null
+        } ?: return null
+        return EnhanceEngine.ImageBuffer(buffer.width, buffer.height, pixels)
+    }
+}
@@ -3,6 +3,7 @@ package com.kotopogoda.uploader.feature.viewer.enhance
 import android.content.Context
 import android.graphics.Bitmap
 import android.graphics.BitmapFactory
+import android.graphics.Matrix
 import android.media.ExifInterface
 import com.kotopogoda.uploader.core.data.ml.ModelDefinition
 import com.kotopogoda.uploader.core.data.ml.ModelsLock
@@ -14,12 +15,14 @@ import com.kotopogoda.uploader.feature.viewer.enhance.EnhanceEngine.ModelBackend
 import com.kotopogoda.uploader.feature.viewer.enhance.EnhanceEngine.ModelUsage
 import com.kotopogoda.uploader.feature.viewer.enhance.EnhanceLogging
 import dagger.hilt.android.qualifiers.ApplicationContext
+import kotlinx.coroutines.CancellationException
 import kotlinx.coroutines.CoroutineDispatcher
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.withContext
 import timber.log.Timber
 import java.io.File
 import java.io.FileOutputStream
+import java.util.concurrent.ConcurrentHashMap
 import java.util.concurrent.atomic.AtomicBoolean
 import javax.inject.Inject
 import javax.inject.Named
@@ -38,10 +41,13 @@ class NativeEnhanceAdapter @Inject constructor(
     private var isInitialized = false
     private var cachedPreviewBitmap: Bitmap? = null
     private var cachedFullBitmap: Bitmap? = null
+    private var cachedFullImageStats: NativeImageStats? = null
     private var currentPhotoPath: String? = null
     private var currentStrength: Float = 0f
     private var previewResult: NativeEnhanceController.PreviewResult? = null
+    private var previewDelivered = false
     private val crashLoopDetector = NativeEnhanceCrashLoopDetector(context)
+    private val ledgerKeyStore = ModelLedgerKeyStore(context)
     private val zeroDceModelFiles = modelsLock.require(ZERO_DCE_MODEL_NAME).toModelFiles()
 
     fun isReady(): Boolean = isInitialized && controller.isInitialized()
@@ -89,6 +95,7 @@ class NativeEnhanceAdapter @Inject constructor(
             previewProfile = profile,
             forceCpu = true,
             forceCpuReason = DeviceGpuPolicy.forceCpuReason,
+            verificationKey = ledgerKeyStore.getOrCreateKey(),
         )
 
         controller.initialize(params)
@@ -102,9 +109,19 @@ class NativeEnhanceAdapter @Inject constructor(
         )
     }
 
+    /**
+     * Превью для [sourceFile]. Если задан [onPreviewLevel], превью строится
+     * прогрессивно (1/8 → 1/2 → экран), и каждый уровень, повёрнутый по EXIF,
+     * передаётся туда сразу по готовности; Bitmap уровня принадлежит
+     * получателю. [colorGains] — цветовая стадия профиля, натив применяет её
+     * при записи результата; профиль зависит только от фото и силы, поэтому
+     * в ключ кеша не входит.
+     */
     suspend fun computePreview(
         sourceFile: File,
         strength: Float,
+        onPreviewLevel: ((NativeEnhanceController.PreviewLevel) -> Unit)? = null,
+        colorGains: NativeEnhanceController.ColorGains = NativeEnhanceController.ColorGains.IDENTITY,
         onProgress: (Float) -> Unit = {},
     ): Boolean = withContext(dispatcher) {
         if (!isInitialized) {
@@ -115,7 +132,7 @@ class NativeEnhanceAdapter @Inject constructor(
         val isSamePhoto = currentPhotoPath == sourceFile.absolutePath
         val isSameStrength = kotlin.math.abs(currentStrength - strength) < 0.01f
 
-        if (isSamePhoto && cachedPreviewBitmap != null && isSameStrength) {
+        if (isSamePhoto && (cachedPreviewBitmap != null || previewDelivered) && isSameStrength) {
             Timber.tag(TAG).d("Используем закешированный preview")
             return@withContext true
         }
@@ -127,6 +144,16 @@ class NativeEnhanceAdapter @Inject constructor(
 
         currentStrength = strength
 
+        if (onPreviewLevel != null) {
+            computeProgressivePreview(sourceFile, strength, colorGains, onPreviewLevel, onProgress)?.let { success ->
+                return@withContext success
+            }
+        }
+
+        computePreviewFromJpeg(sourceFile, strength, colorGains, onProgress)?.let { success ->
+            return@withContext success
+        }
+
         val sourceBitmap = BitmapFactory.decodeFile(sourceFile.absolutePath)
             ?: return@withContext false
 
@@ -136,6 +163,8 @@ class NativeEnhanceAdapter @Inject constructor(
             val result = controller.runPreview(
                 sourceBitmap = sourceBitmap,
                 strength = strength,
+                photoKey = sourceFile.absolutePath,
+                colorGains = colorGains,
                 onProgress = { info ->
                     logNativeProgress(
                         event = "native_preview_progress",
@@ -146,6 +175,11 @@ class NativeEnhanceAdapter @Inject constructor(
                 },
             )
 
+            if (result.superseded) {
+                Timber.tag(TAG).d("Превью вытеснено более новым запросом для того же фото")
+                return@withContext false
+            }
+
             previewResult = result
 
             if (result.success) {
@@ -165,11 +199,170 @@ class NativeEnhanceAdapter @Inject constructor(
         }
     }
 
+    /**
+     * Превью через нативный JPEG-декодер: файл декодируется сразу в уменьшенном
+     * до размера экрана виде, без полноразмерного Bitmap. `null` — файл не
+     * читается нативно (не JPEG, CMYK), нужен путь через [BitmapFactory].
+     */
+    private suspend fun computePreviewFromJpeg(
+        sourceFile: File,
+        strength: Float,
+        colorGains: NativeEnhanceController.ColorGains,
+        onProgress: (Float) -> Unit,
+    ): Boolean? {
+        crashLoopDetector.markEnhanceRunning()
+        try {
+            val previewProgressState = NativeProgressLogState()
+            val preview = controller.runPreviewFromJpeg(
+                sourceFile = sourceFile,
+                maxSide = previewMaxSide(),
+                strength = strength,
+                photoKey = sourceFile.absolutePath,
+                colorGains = colorGains,
+                onProgress = { info ->
+                    logNativeProgress(
+                        event = "native_preview_progress",
+                        info = info,
+                        state = previewProgressState,
+                    )
+                    onProgress(info.progress)
+                },
+            ) ?: return null
+
+            val result = preview.result
+            if (result.superseded) {
+                Timber.tag(TAG).d("Превью вытеснено более новым запросом для того же фото")
+                preview.bitmap.recycle()
+                return false
+            }
+
+            previewResult = result
+
+            if (result.success) {
+                cachedPreviewBitmap = preview.bitmap
+                return true
+            }
+
+            preview.bitmap.recycle()
+            return false
+        } catch (error: Exception) {
+            Timber.tag(TAG).e(error, "Ошибка вычисления превью из JPEG")
+            return false
+        } finally {
+            crashLoopDetector.clearEnhanceRunningFlag()
+        }
+    }
+
+    /**
+     * Прогрессивное превью через нативный JPEG-декодер. Уровни отдаются в
+     * [onPreviewLevel] и в кеше адаптера не остаются. `null` — файл не
+     * читается нативно, нужен обычный путь.
+     */
+    private suspend fun computeProgressivePreview(
+        sourceFile: File,
+        strength: Float,
+        colorGains: NativeEnhanceController.ColorGains,
+        onPreviewLevel: (NativeEnhanceController.PreviewLevel) -> Unit,
+        onProgress: (Float) -> Unit,
+    ): Boolean? {
+        val orientation = runCatching {
+            ExifInterface(sourceFile.absolutePath).getAttributeInt(
+                ExifInterface.TAG_ORIENTATION,
+                ExifInterface.ORIENTATION_NORMAL,
+            )
+        }.getOrDefault(ExifInterface.ORIENTATION_NORMAL)
+        val deliveredAny = AtomicBoolean(false)
+        crashLoopDetector.markEnhanceRunning()
+        try {
+            val previewProgressState = NativeProgressLogState()
+            val preview = controller.runProgressivePreviewFromJpeg(
+                sourceFile = sourceFile,
+                maxSide = previewMaxSide(),
+                strength = strength,
+                photoKey = sourceFile.absolutePath,
+                colorGains = colorGains,
+                onLevel = { level ->
+                    deliveredAny.set(true)
+                    Timber.tag(TAG).d(
+                        "Уровень превью %d (1/%d) готов: %dx%d",
+                        level.index,
+                        level.scaleDenom,
+                        level.bitmap.width,
+                        level.bitmap.height,
+                    )
+                    onPreviewLevel(level.copy(bitmap = applyExifOrientation(level.bitmap, orientation)))
+                },
+                onProgress = { info ->
+                    logNativeProgress(
+                        event = "native_preview_progress",
+                        info = info,
+                        state = previewProgressState,
+                    )
+                    onProgress(info.progress)
+                },
+            ) ?: return null
+
+            if (!deliveredAny.get()) {
+                preview.bitmap.recycle()
+            }
+            val result = preview.result
+            if (result.superseded) {
+                Timber.tag(TAG).d("Прогрессивное превью вытеснено более новым запросом для того же фото")
+                return false
+            }
+
+            previewResult = result
+            previewDelivered = result.success
+            return result.success
+        } catch (error: Exception) {
+            Timber.tag(TAG).e(error, "Ошибка прогрессивного превью из JPEG")
+            return false
+        } finally {
+            crashLoopDetector.clearEnhanceRunningFlag()
+        }
+    }
+
+    /**
+     * Нативный декодер не учитывает EXIF: поворот и отражение применяются
+     * так же, как при загрузке исходника в просмотрщик. Исходный Bitmap
+     * освобождается, если создана копия.
+     */
+    private fun applyExifOrientation(bitmap: Bitmap, orientation: Int): Bitmap {
+        val matrix = Matrix()
+        when (orientation) {
+            ExifInterface.ORIENTATION_FLIP_HORIZONTAL -> matrix.postScale(-1f, 1f)
+            ExifInterface.ORIENTATION_ROTATE_180 -> matrix.postRotate(180f)
+            ExifInterface.ORIENTATION_FLIP_VERTICAL -> matrix.postScale(1f, -1f)
+            ExifInterface.ORIENTATION_TRANSPOSE -> {
+                matrix.postScale(-1f, 1f)
+                matrix.postRotate(90f)
+            }
+            ExifInterface.ORIENTATION_ROTATE_90 -> matrix.postRotate(90f)
+            ExifInterface.ORIENTATION_TRANSVERSE -> {
+                matrix.postScale(-1f, 1f)
+                matrix.postRotate(270f)
+            }
+            ExifInterface.ORIENTATION_ROTATE_270 -> matrix.postRotate(270f)
+            else -> return bitmap
+        }
+        val oriented = Bitmap.createBitmap(bitmap, 0, 0, bitmap.width, bitmap.height, matrix, true)
+        if (oriented !== bitmap) {
+            bitmap.recycle()
+        }
+        return oriented
+    }
+
+    private fun previewMaxSide(): Int {
+        val metrics = context.resources.displayMetrics
+        return maxOf(metrics.widthPixels, metrics.heightPixels)
+    }
+
     suspend fun computeFull(
         sourceFile: File,
         strength: Float,
         outputFile: File,
         exif: ExifInterface? = null,
+        colorGains: NativeEnhanceController.ColorGains = NativeEnhanceController.ColorGains.IDENTITY,
         onProgress: (Float) -> Unit = {},
     ): UploadEnhancementInfo? = withContext(dispatcher) {
         if (!isInitialized) {
@@ -191,6 +384,28 @@ class NativeEnhanceAdapter @Inject constructor(
 
         clearFullCache()
 
+        val jpegResult = try {
+            computeFullToJpeg(sourceFile, strength, outputFile, colorGains, onProgress)
+        } catch (error: Exception) {
+            Timber.tag(TAG).e(error, "Ошибка полного вычисления из JPEG")
+            return@withContext null
+        }
+        if (jpegResult != null) {
+            if (jpegResult.cancelled) {
+                Timber.tag(TAG).w("Полное вычисление отменено")
+                return@withContext null
+            }
+            if (!jpegResult.success) {
+                return@withContext null
+            }
+            // EXIF источника уже перенесён нативно; явно переданный exif может
+            // содержать правки и применяется поверх.
+            if (exif != null) {
+                copyExif(exif, sourceFile, outputFile)
+            }
+            return@withContext buildEnhancementInfo(strength, outputFile, jpegResult)
+        }
+
         val sourceBitmap = BitmapFactory.decodeFile(sourceFile.absolutePath)
             ?: return@withContext null
 
@@ -202,6 +417,7 @@ class NativeEnhanceAdapter @Inject constructor(
                 strength = strength,
                 outputFile = outputFile,
                 quality = 95,
+                colorGains = colorGains,
                 onProgress = { info ->
                     logNativeProgress(
                         event = "native_full_progress",
@@ -217,10 +433,12 @@ class NativeEnhanceAdapter @Inject constructor(
                 return@withContext null
             }
 
-            cachedFullBitmap = result.bitmap
+            val resultBitmap = checkNotNull(result.bitmap)
+            cachedFullBitmap = resultBitmap
+            cachedFullImageStats = result.imageStats
             
             val outputStream = FileOutputStream(outputFile)
-            result.bitmap.compress(Bitmap.CompressFormat.JPEG, 95, outputStream)
+            resultBitmap.compress(Bitmap.CompressFormat.JPEG, 95, outputStream)
             outputStream.close()
 
             copyExif(exif, sourceFile, outputFile)
@@ -237,6 +455,164 @@ class NativeEnhanceAdapter @Inject constructor(
         }
     }
 
+    /**
+     * Полная обработка через нативные JPEG-декодер и кодировщик: результат
+     * пишется в [outputFile] полосами, без полноразмерных Bitmap. `null` —
+     * файл не читается нативно (не JPEG, CMYK), нужен путь через [BitmapFactory].
+     */
+    private suspend fun computeFullToJpeg(
+        sourceFile: File,
+        strength: Float,
+        outputFile: File,
+        colorGains: NativeEnhanceController.ColorGains,
+        onProgress: (Float) -> Unit,
+    ): NativeEnhanceController.FullResult? {
+        crashLoopDetector.markEnhanceRunning()
+        try {
+            val fullProgressState = NativeProgressLogState()
+            return controller.runFullToJpeg(
+                sourceFile = sourceFile,
+                strength = strength,
+                outputFile = outputFile,
+                quality = 95,
+                colorGains = colorGains,
+                onProgress = { info ->
+                    logNativeProgress(
+                        event = "native_full_progress",
+                        info = info,
+                        state = fullProgressState,
+                    )
+                    onProgress(info.progress)
+                },
+            )
+        } finally {
+            crashLoopDetector.clearEnhanceRunningFlag()
+        }
+    }
+
+    /** Размер файла и метрики входа для выбора профиля ([computeInputMetrics]). */
+    data class InputAnalysis(
+        val width: Int,
+        val height: Int,
+        val metrics: EnhanceEngine.Metrics,
+    )
+
+    /**
+     * Метрики входа до обработки: натив декодирует JPEG уменьшенным в DCT-домене
+     * (длинная сторона не меньше [INPUT_STATS_MAX_SIDE]) и считает метрики
+     * [EnhanceEngine.MetricsCalculator] по полосам, без полноразмерного Bitmap.
+     * Резкость и шум относятся к уменьшенному кадру. `null` — адаптер не готов
+     * или файл не читается нативно (не JPEG, CMYK).
+     */
+    suspend fun computeInputMetrics(sourceFile: File): InputAnalysis? = withContext(dispatcher) {
+        if (!isReady()) {
+            return@withContext null
+        }
+        val stats = try {
+            controller.readJpegStats(sourceFile, INPUT_STATS_MAX_SIDE)
+        } catch (cancellation: CancellationException) {
+            throw cancellation
+        } catch (error: Exception) {
+            Timber.tag(TAG).w(error, "Не удалось посчитать метрики входа нативно")
+            null
+        } ?: return@withContext null
+        InputAnalysis(
+            width = stats.width,
+            height = stats.height,
+            metrics = EnhanceEngine.Metrics(
+                lMean = stats.lumaMean.toDouble(),
+                pDark = stats.darkShare.toDouble(),
+                bSharpness = stats.sharpness.toDouble(),
+                nNoise = stats.noise.toDouble(),
+            ),
+        )
+    }
+
+    data class BatchRequest(
+        val sourceFile: File,
+        val outputFile: File,
+        val exif: ExifInterface? = null,
+    )
+
+    /**
+     * Улучшает очередь загрузки одним нативным пакетом. Результат по индексу
+     * совпадает с [requests]; `null` — элемент не обработан. [onItemFinished]
+     * вызывается из нативного потока по мере готовности элементов.
+     *
+     * Вызывающих в приложении пока нет: просмотрщик улучшает одно фото через
+     * [computeFull], а воркеры загрузки улучшение не запускают.
+     */
+    suspend fun computeFullBatch(
+        requests: List<BatchRequest>,
+        strength: Float,
+        onItemFinished: (Int, UploadEnhancementInfo?) -> Unit = { _, _ -> },
+    ): List<UploadEnhancementInfo?> = withContext(dispatcher) {
+        if (!isInitialized) {
+            Timber.tag(TAG).w("Попытка пакетного вычисления до инициализации")
+            return@withContext requests.map { null }
+        }
+        if (requests.isEmpty()) {
+            return@withContext emptyList()
+        }
+
+        // Метрики натив считает попутно с записью результата (telemetry.imageStats);
+        // здесь запоминается только, какие файлы закодировал Kotlin.
+        val encodedByCodec = ConcurrentHashMap.newKeySet<String>()
+        val exifBySource = requests.mapNotNull { request ->
+            request.exif?.let { request.sourceFile.absolutePath to it }
+        }.toMap()
+        val codec = object : NativeBatchCodec {
+            override fun decode(inputPath: String): Bitmap? = BitmapFactory.decodeFile(inputPath)
+
+            override fun encode(bitmap: Bitmap, inputPath: String, outputPath: String): Boolean {
+                val outputFile = File(outputPath)
+                val written = FileOutputStream(outputFile).use { stream ->
+                    bitmap.compress(Bitmap.CompressFormat.JPEG, 95, stream)
+                }
+                if (!written) {
+                    return false
+                }
+                copyExif(exifBySource[inputPath], File(inputPath), outputFile)
+                encodedByCodec.add(outputPath)
+                return true
+            }
+        }
+
+        fun toInfo(result: NativeEnhanceController.BatchItemResult): UploadEnhancementInfo? {
+            if (result.state != NativeEnhanceController.BatchItemState.SUCCEEDED) {
+                return null
+            }
+            val request = requests[result.index]
+            val outputFile = request.outputFile
+            val telemetry = result.telemetry ?: return null
+            // Файл, закодированный нативно, уже несёт EXIF источника; явно
+            // переданный exif применяется поверх.
+            if (!encodedByCodec.remove(outputFile.absolutePath)) {
+                request.exif?.let { copyExif(it, request.sourceFile, outputFile) }
+            }
+            val metrics = telemetry.imageStats?.let(::toUploadMetrics) ?: computeMetricsFromFile(outputFile)
+            return buildBatchEnhancementInfo(strength, outputFile, metrics, telemetry)
+        }
+
+        crashLoopDetector.markEnhanceRunning()
+        try {
+            val results = controller.runBatch(
+                items = requests.map { NativeEnhanceController.BatchItem(it.sourceFile, it.outputFile) },
+                strength = strength,
+                codec = codec,
+                onItemFinished = { result -> onItemFinished(result.index, toInfo(result)) },
+            )
+            results.map(::toInfo)
+        } catch (cancellation: CancellationException) {
+            throw cancellation
+        } catch (error: Exception) {
+            Timber.tag(TAG).e(error, "Ошибка пакетного вычисления")
+            requests.map { null }
+        } finally {
+            crashLoopDetector.clearEnhanceRunningFlag()
+        }
+    }
+
     suspend fun cancel() = withContext(dispatcher) {
         controller.cancel()
     }
@@ -250,6 +626,7 @@ class NativeEnhanceAdapter @Inject constructor(
     fun clearCache() {
         cachedPreviewBitmap?.recycle()
         cachedPreviewBitmap = null
+        previewDelivered = false
         clearFullCache()
         currentPhotoPath = null
         currentStrength = 0f
@@ -259,6 +636,7 @@ class NativeEnhanceAdapter @Inject constructor(
     private fun clearFullCache() {
         cachedFullBitmap?.recycle()
         cachedFullBitmap = null
+        cachedFullImageStats = null
     }
 
     private data class NativeProgressLogState(
@@ -295,7 +673,8 @@ class NativeEnhanceAdapter @Inject constructor(
         outputFile: File,
         fullResult: NativeEnhanceController.FullResult? = null,
     ): UploadEnhancementInfo {
-        val metrics = fullResult?.bitmap?.let(::computeMetricsForBitmap)
+        val metrics = (fullResult?.imageStats ?: cachedFullImageStats)?.let(::toUploadMetrics)
+            ?: fullResult?.bitmap?.let(::computeMetricsForBitmap)
             ?: cachedFullBitmap?.let(::computeMetricsForBitmap)
             ?: computeMetricsFromFile(outputFile)
 
@@ -346,6 +725,48 @@ class NativeEnhanceAdapter @Inject constructor(
         )
     }
 
+    private fun buildBatchEnhancementInfo(
+        strength: Float,
+        outputFile: File,
+        metrics: UploadEnhancementMetrics,
+        telemetry: NativeRunTelemetry,
+    ): UploadEnhancementInfo {
+        val fallbackCause = NativeEnhanceController.FallbackCause.fromCode(telemetry.fallbackCauseCode.toLong())
+        return UploadEnhancementInfo(
+            strength = strength,
+            delegate = telemetry.delegateUsed,
+            metrics = metrics,
+            fileSize = outputFile.length(),
+            previewTimingMs = null,
+            fullTimingMs = telemetry.timingMs,
+            usedVulkan = telemetry.usedVulkan,
+            peakMemoryMb = telemetry.peakMemoryKb.toFloat() / 1024f,
+            cancelled = telemetry.cancelled,
+            fallbackUsed = telemetry.fallbackUsed,
+            fallbackCause = fallbackCause?.name?.lowercase(),
+            durationMsVulkan = telemetry.durationMsVulkan.takeIf { it > 0 },
+            durationMsCpu = telemetry.durationMsCpu.takeIf { it > 0 },
+            delegateUsed = telemetry.delegateUsed,
+            forceCpuReason = null,
+            tileUsed = telemetry.tileUsed,
+            tileSize = telemetry.tileSize,
+            tileOverlap = telemetry.tileOverlap,
+            tilesTotal = telemetry.tilesTotal,
+            tilesCompleted = telemetry.tilesCompleted,
+            seamMaxDelta = telemetry.seamMaxDelta,
+            seamMeanDelta = telemetry.seamMeanDelta,
+            gpuAllocRetryCount = telemetry.gpuAllocRetryCount,
+        )
+    }
+
+    private fun toUploadMetrics(stats: NativeImageStats): UploadEnhancementMetrics = UploadEnhancementMetrics(
+        lMean = stats.lumaMean,
+        pDark = stats.darkShare,
+        bSharpness = stats.sharpness,
+        nNoise = stats.noise,
+    )
+
+    /** Запасной путь, когда натив результат не записывал: метрики по файлу в Kotlin. */
     private fun computeMetricsFromFile(file: File): UploadEnhancementMetrics {
         val bitmap = BitmapFactory.decodeFile(file.absolutePath) ?: return emptyMetrics()
         return computeMetricsForBitmap(bitmap).also { bitmap.recycle() }
@@ -430,6 +851,8 @@ class NativeEnhanceAdapter @Inject constructor(
         private const val TAG = "NativeEnhanceAdapter"
         private const val ZERO_DCE_MODEL_NAME = "zerodcepp_fp16"
         private const val PROGRESS_LOG_DELTA = 0.005f
+        /** Длинная сторона кадра для метрик входа: их хватает для выбора профиля. */
+        private const val INPUT_STATS_MAX_SIDE = 1024
         private val cpuOnlyLogGuard = AtomicBoolean(false)
     }
 }
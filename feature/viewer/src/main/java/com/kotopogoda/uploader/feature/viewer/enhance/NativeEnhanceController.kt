@@ -3,12 +3,17 @@ package com.kotopogoda.uploader.feature.viewer.enhance
 import android.content.res.AssetManager
 import android.graphics.Bitmap
 import com.kotopogoda.uploader.core.data.upload.UploadLog
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CompletableDeferred
 import kotlinx.coroutines.CoroutineDispatcher
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.NonCancellable
 import kotlinx.coroutines.withContext
 import timber.log.Timber
 import java.io.File
+import java.nio.ByteBuffer
 import java.util.LinkedHashMap
+import java.util.concurrent.TimeUnit
 import java.util.concurrent.atomic.AtomicInteger
 import java.util.concurrent.atomic.AtomicLong
 
@@ -18,6 +23,7 @@ import java.util.concurrent.atomic.AtomicLong
  */
 class NativeEnhanceController(
     private val dispatcher: CoroutineDispatcher = Dispatchers.Default,
+    private val progressMaxRateHz: Int = DEFAULT_PROGRESS_MAX_RATE_HZ,
 ) {
 
     private var nativeHandle: Long = 0L
@@ -46,6 +52,47 @@ class NativeEnhanceController(
         ERROR,
     }
 
+    /** Состояние задачи нативной очереди; коды совпадают с EnhanceJobState. */
+    enum class JobState(val code: Int) {
+        UNKNOWN(-1),
+        QUEUED(0),
+        RUNNING(1),
+        SUCCEEDED(2),
+        FAILED(3),
+        CANCELLED(4),
+        SUPERSEDED(5);
+
+        val isTerminal: Boolean
+            get() = this == SUCCEEDED || this == FAILED || this == CANCELLED || this == SUPERSEDED
+
+        companion object {
+            fun fromCode(code: Int): JobState = values().firstOrNull { it.code == code } ?: UNKNOWN
+        }
+    }
+
+    /** Состояние элемента пакета; коды совпадают с BatchItemState в batch_pipeline.h. */
+    enum class BatchItemState(val code: Int) {
+        PENDING(0),
+        SUCCEEDED(1),
+        FAILED(2),
+        CANCELLED(3);
+
+        companion object {
+            fun fromCode(code: Int): BatchItemState = values().firstOrNull { it.code == code } ?: PENDING
+        }
+    }
+
+    /** Стадия пакетного пайплайна; коды совпадают с BatchStage в batch_pipeline.h. */
+    enum class BatchStage(val code: Int) {
+        DECODE(0),
+        INFER(1),
+        ENCODE(2);
+
+        companion object {
+            fun fromCode(code: Int): BatchStage? = values().firstOrNull { it.code == code }
+        }
+    }
+
     enum class FallbackCause(val code: Int) {
         NONE(0),
         LOAD_FAILED(1),
@@ -79,6 +126,8 @@ class NativeEnhanceController(
         val previewProfile: PreviewProfile,
         val forceCpu: Boolean = true,
         val forceCpuReason: String = DeviceGpuPolicy.forceCpuReason,
+        val verificationKey: ByteArray? = null,
+        val modelReverifyIntervalHours: Long = DEFAULT_MODEL_REVERIFY_INTERVAL_HOURS,
     )
 
     data class IntegrityFailure(
@@ -112,10 +161,13 @@ class NativeEnhanceController(
         val seamMaxDelta: Float,
         val seamMeanDelta: Float,
         val gpuAllocRetryCount: Int,
+        val superseded: Boolean = false,
     )
 
+    /** [bitmap] — `null`, если результат записан в файл нативно ([runFullToJpeg]). */
     data class FullResult(
-        val bitmap: Bitmap,
+        val bitmap: Bitmap?,
+        val success: Boolean,
         val timingMs: Long,
         val usedVulkan: Boolean,
         val peakMemoryMb: Float,
@@ -134,8 +186,88 @@ class NativeEnhanceController(
         val seamMaxDelta: Float,
         val seamMeanDelta: Float,
         val gpuAllocRetryCount: Int,
+        /** Статистика результата; `null`, если результат не был записан. */
+        val imageStats: NativeImageStats? = null,
+    )
+
+    /** Превью из JPEG: [bitmap] уменьшен в [scaleDenom] раз относительно файла. */
+    data class JpegPreview(
+        val bitmap: Bitmap,
+        val scaleDenom: Int,
+        val result: PreviewResult,
+    )
+
+    /**
+     * Метрики входа по JPEG-файлу ([readJpegStats]): [width]/[height] — размер
+     * файла, метрики посчитаны на кадре, уменьшенном в [scaleDenom] раз, так же,
+     * как [EnhanceEngine.MetricsCalculator].
+     */
+    data class JpegStats(
+        val width: Int,
+        val height: Int,
+        val scaleDenom: Int,
+        val lumaMean: Float,
+        val darkShare: Float,
+        val sharpness: Float,
+        val noise: Float,
     )
 
+    /**
+     * Цветовая стадия профиля (`EnhanceEngine.applyVibranceAndSaturation`),
+     * которую натив применяет через 3D LUT при записи результата превью и
+     * полной обработки, в том же проходе, что и квантование в 8 бит.
+     * [IDENTITY] — без цветовой стадии.
+     */
+    data class ColorGains(
+        val vibranceGain: Float,
+        val saturationGain: Float,
+    ) {
+        fun toLogPayload(): Map<String, Any?> = mapOf(
+            "vibrance_gain" to vibranceGain,
+            "saturation_gain" to saturationGain,
+        )
+
+        companion object {
+            val IDENTITY = ColorGains(vibranceGain = 0f, saturationGain = 1f)
+        }
+    }
+
+    /**
+     * Уровень прогрессивного превью: [bitmap] уменьшен в [scaleDenom] раз
+     * относительно файла; [isFinal] — уровень разрешения экрана.
+     */
+    data class PreviewLevel(
+        val index: Int,
+        val scaleDenom: Int,
+        val bitmap: Bitmap,
+        val isFinal: Boolean,
+    )
+
+    data class BatchItem(
+        val inputFile: File,
+        val outputFile: File,
+    )
+
+    data class BatchItemResult(
+        val index: Int,
+        val state: BatchItemState,
+        /** Стадия, на которой элемент завершился ошибкой или был отменён. */
+        val stoppedAt: BatchStage?,
+        val decodeMs: Long,
+        val inferMs: Long,
+        val encodeMs: Long,
+        val width: Int,
+        val height: Int,
+        /** Телеметрия вывода; `null`, если элемент до вывода не дошёл. */
+        val telemetry: NativeRunTelemetry?,
+    )
+
+    /** Управление поставленным пакетом: отмена отдельных элементов. */
+    inner class BatchControl internal constructor(private val jobId: Long) {
+        /** Не начатый элемент пропускается, текущий прерывается; false — пакет уже завершён. */
+        fun cancelItem(index: Int): Boolean = nativeCancelBatchItem(nativeHandle, jobId, index)
+    }
+
     data class ProgressInfo(
         val progress: Float,
         val currentStage: String,
@@ -161,6 +293,8 @@ class NativeEnhanceController(
                 params.restormerChecksums.bin,
                 params.previewProfile.ordinal,
                 params.forceCpu,
+                params.verificationKey,
+                TimeUnit.HOURS.toSeconds(params.modelReverifyIntervalHours),
             )
 
             if (handle == 0L) {
@@ -212,6 +346,8 @@ class NativeEnhanceController(
                     "zero_dce_bin_checksum" to params.zeroDceChecksums.bin.take(8),
                     "restormer_param_checksum" to params.restormerChecksums.param.take(8),
                     "restormer_bin_checksum" to params.restormerChecksums.bin.take(8),
+                    "verification_ledger" to (params.verificationKey != null),
+                    "model_reverify_interval_h" to params.modelReverifyIntervalHours,
                 ) + modelPayload + commonDelegatePayload,
             )
 
@@ -226,12 +362,227 @@ class NativeEnhanceController(
         }
     }
 
+    /**
+     * Ставит превью в нативную очередь и ждёт его завершения. Новое превью с тем
+     * же [photoKey] вытесняет ещё не выполненные и текущее превью этого фото —
+     * их вызовы вернут результат с `superseded = true`.
+     */
     suspend fun runPreview(
         sourceBitmap: Bitmap,
         strength: Float,
+        photoKey: String? = null,
+        colorGains: ColorGains = ColorGains.IDENTITY,
         onProgress: (ProgressInfo) -> Unit = {},
     ): PreviewResult = withContext(dispatcher) {
         checkInitialized()
+        runPreviewJob(
+            width = sourceBitmap.width,
+            height = sourceBitmap.height,
+            strength = strength,
+            startPayload = colorGains.toLogPayload(),
+            onProgress = onProgress,
+        ) { progressCallback, completion ->
+            nativeSubmitPreview(
+                nativeHandle,
+                sourceBitmap,
+                strength,
+                colorGains.vibranceGain,
+                colorGains.saturationGain,
+                photoKey,
+                PRIORITY_PREVIEW,
+                progressCallback,
+                progressMaxRateHz,
+                completion,
+            )
+        }
+    }
+
+    /**
+     * Превью прямо из JPEG-файла: натив декодирует его полосами сразу в
+     * планарный вход движка, уменьшая в DCT-домене (1/2, 1/4, 1/8) до
+     * наименьшего размера, у которого длинная сторона не меньше [maxSide].
+     * Полноразмерный ARGB Bitmap не создаётся. Возвращает `null`, если файл не
+     * читается нативным декодером (не JPEG, CMYK) — тогда нужен [runPreview].
+     */
+    suspend fun runPreviewFromJpeg(
+        sourceFile: File,
+        maxSide: Int,
+        strength: Float,
+        photoKey: String? = null,
+        colorGains: ColorGains = ColorGains.IDENTITY,
+        onProgress: (ProgressInfo) -> Unit = {},
+    ): JpegPreview? = withContext(dispatcher) {
+        checkInitialized()
+        val info = IntArray(JPEG_INFO_SIZE)
+        if (!nativeReadJpegInfo(sourceFile.absolutePath, maxSide, info)) {
+            return@withContext null
+        }
+        val scaleDenom = info[JPEG_INFO_SCALE_DENOM]
+        val bitmap = Bitmap.createBitmap(
+            info[JPEG_INFO_SCALED_WIDTH],
+            info[JPEG_INFO_SCALED_HEIGHT],
+            Bitmap.Config.ARGB_8888,
+        )
+        val result = try {
+            runPreviewJob(
+                width = bitmap.width,
+                height = bitmap.height,
+                strength = strength,
+                startPayload = mapOf(
+                    "source" to "jpeg",
+                    "source_width" to info[JPEG_INFO_WIDTH],
+                    "source_height" to info[JPEG_INFO_HEIGHT],
+                    "scale_denom" to scaleDenom,
+                ) + colorGains.toLogPayload(),
+                onProgress = onProgress,
+            ) { progressCallback, completion ->
+                nativeSubmitPreviewJpeg(
+                    nativeHandle,
+                    sourceFile.absolutePath,
+                    scaleDenom,
+                    bitmap,
+                    strength,
+                    colorGains.vibranceGain,
+                    colorGains.saturationGain,
+                    photoKey,
+                    PRIORITY_PREVIEW,
+                    progressCallback,
+                    progressMaxRateHz,
+                    completion,
+                )
+            }
+        } catch (error: Throwable) {
+            bitmap.recycle()
+            throw error
+        }
+        JpegPreview(bitmap = bitmap, scaleDenom = scaleDenom, result = result)
+    }
+
+    /**
+     * Метрики входа без полноразмерного декодирования: натив уменьшает JPEG в
+     * DCT-домене до наименьшего размера с длинной стороной не меньше [maxSide]
+     * и считает яркость, долю тёмного, резкость и шум по полосам декодера, не
+     * создавая Bitmap. Возвращает `null`, если файл не читается нативным
+     * декодером (не JPEG, CMYK).
+     */
+    suspend fun readJpegStats(sourceFile: File, maxSide: Int): JpegStats? = withContext(dispatcher) {
+        checkInitialized()
+        val info = IntArray(JPEG_INFO_SIZE)
+        val stats = FloatArray(JPEG_STATS_SIZE)
+        if (!nativeComputeJpegStats(sourceFile.absolutePath, maxSide, info, stats)) {
+            return@withContext null
+        }
+        JpegStats(
+            width = info[JPEG_INFO_WIDTH],
+            height = info[JPEG_INFO_HEIGHT],
+            scaleDenom = info[JPEG_INFO_SCALE_DENOM],
+            lumaMean = stats[JPEG_STATS_LUMA_MEAN],
+            darkShare = stats[JPEG_STATS_DARK_SHARE],
+            sharpness = stats[JPEG_STATS_SHARPNESS],
+            noise = stats[JPEG_STATS_NOISE],
+        )
+    }
+
+    /**
+     * Прогрессивное превью из JPEG: одна нативная задача выводит превью
+     * последовательно на уровнях [progressiveScaleDenoms] — сначала 1/8 (первый
+     * результат за десятки миллисекунд почти независимо от размера фото), затем
+     * 1/2 и разрешение экрана, как в [runPreviewFromJpeg]. Каждый готовый
+     * уровень передаётся в [onLevel] из рабочего потока очереди; с этого
+     * момента его Bitmap принадлежит получателю. Новое превью того же
+     * [photoKey] вытесняет задачу, и оставшиеся уровни не выполняются — их
+     * Bitmap освобождаются здесь. Возвращает `null`, если файл не читается
+     * нативным декодером; иначе [JpegPreview] последнего готового уровня (его
+     * Bitmap уже передан в [onLevel]).
+     */
+    suspend fun runProgressivePreviewFromJpeg(
+        sourceFile: File,
+        maxSide: Int,
+        strength: Float,
+        photoKey: String? = null,
+        colorGains: ColorGains = ColorGains.IDENTITY,
+        onLevel: (PreviewLevel) -> Unit,
+        onProgress: (ProgressInfo) -> Unit = {},
+    ): JpegPreview? = withContext(dispatcher) {
+        checkInitialized()
+        val info = IntArray(JPEG_INFO_SIZE)
+        if (!nativeReadJpegInfo(sourceFile.absolutePath, maxSide, info)) {
+            return@withContext null
+        }
+        val width = info[JPEG_INFO_WIDTH]
+        val height = info[JPEG_INFO_HEIGHT]
+        val scaleDenoms = progressiveScaleDenoms(info[JPEG_INFO_SCALE_DENOM])
+        val bitmaps = scaleDenoms.map { scaleDenom ->
+            Bitmap.createBitmap(
+                scaledJpegSize(width, scaleDenom),
+                scaledJpegSize(height, scaleDenom),
+                Bitmap.Config.ARGB_8888,
+            )
+        }
+        val delivered = AtomicInteger(0)
+        val levelListener = NativePreviewLevelListener { level ->
+            delivered.set(level + 1)
+            onLevel(
+                PreviewLevel(
+                    index = level,
+                    scaleDenom = scaleDenoms[level],
+                    bitmap = bitmaps[level],
+                    isFinal = level == scaleDenoms.lastIndex,
+                )
+            )
+        }
+        val result = try {
+            runPreviewJob(
+                width = bitmaps.last().width,
+                height = bitmaps.last().height,
+                strength = strength,
+                startPayload = mapOf(
+                    "source" to "jpeg_progressive",
+                    "source_width" to width,
+                    "source_height" to height,
+                    "scale_denoms" to scaleDenoms.joinToString(","),
+                ) + colorGains.toLogPayload(),
+                onProgress = onProgress,
+            ) { progressCallback, completion ->
+                nativeSubmitProgressivePreviewJpeg(
+                    nativeHandle,
+                    sourceFile.absolutePath,
+                    scaleDenoms.toIntArray(),
+                    bitmaps.toTypedArray(),
+                    strength,
+                    colorGains.vibranceGain,
+                    colorGains.saturationGain,
+                    photoKey,
+                    PRIORITY_PREVIEW,
+                    progressCallback,
+                    progressMaxRateHz,
+                    levelListener,
+                    completion,
+                )
+            }
+        } catch (error: Throwable) {
+            bitmaps.drop(delivered.get()).forEach { it.recycle() }
+            throw error
+        }
+        // Если ни один уровень не готов, Bitmap первого уровня возвращается
+        // вызывающему, как в runPreviewFromJpeg.
+        val lastLevel = (delivered.get() - 1).coerceAtLeast(0)
+        bitmaps.drop(lastLevel + 1).forEach { it.recycle() }
+        JpegPreview(
+            bitmap = bitmaps[lastLevel],
+            scaleDenom = scaleDenoms[lastLevel],
+            result = result,
+        )
+    }
+
+    private suspend fun runPreviewJob(
+        width: Int,
+        height: Int,
+        strength: Float,
+        startPayload: Map<String, Any?>,
+        onProgress: (ProgressInfo) -> Unit,
+        submit: (NativeTileProgressCallback, NativeJobCompletion) -> Long,
+    ): PreviewResult {
         activeOperations.incrementAndGet()
 
         try {
@@ -240,11 +591,11 @@ class NativeEnhanceController(
                 "native_preview_start",
                 mapOf(
                     "strength" to strength,
-                    "width" to sourceBitmap.width,
-                    "height" to sourceBitmap.height,
+                    "width" to width,
+                    "height" to height,
                     "tile_size" to NATIVE_TILE_SIZE,
                     "tile_overlap" to NATIVE_TILE_OVERLAP,
-                ) + previewStartMetadata,
+                ) + startPayload + previewStartMetadata,
             )
 
             val startTime = System.currentTimeMillis()
@@ -261,7 +612,9 @@ class NativeEnhanceController(
                 onProgress(info)
             }
 
-            val telemetry = nativeRunPreview(nativeHandle, sourceBitmap, strength, progressCallback)
+            val (jobState, telemetry) = awaitJob("превью") { completion ->
+                submit(progressCallback, completion)
+            }
             val elapsed = System.currentTimeMillis() - startTime
 
             lastRestPrecision = telemetry.restPrecision
@@ -285,6 +638,7 @@ class NativeEnhanceController(
                     "used_vulkan" to usedVulkan,
                     "peak_memory_mb" to peakMemory,
                     "cancelled" to telemetry.cancelled,
+                    "job_state" to jobState.name.lowercase(),
                     "fallback_used" to fallbackUsed,
                     "fallback_cause" to fallbackCause?.name?.lowercase(),
                     "duration_ms_vulkan" to durationVulkan,
@@ -299,10 +653,12 @@ class NativeEnhanceController(
                     "gpu_alloc_retry_count" to telemetry.gpuAllocRetryCount,
                     "rest_precision" to telemetry.restPrecision,
                     "restormer_precision" to telemetry.restPrecision,
-                ) + previewCompleteMetadata,
+                ) + telemetry.memory.toLogPayload() + telemetry.profile?.toLogPayload().orEmpty() +
+                    telemetry.cpu.toLogPayload() +
+                    previewCompleteMetadata,
             )
 
-            PreviewResult(
+            return PreviewResult(
                 success = success,
                 timingMs = timing,
                 usedVulkan = usedVulkan,
@@ -321,6 +677,7 @@ class NativeEnhanceController(
                 seamMaxDelta = telemetry.seamMaxDelta,
                 seamMeanDelta = telemetry.seamMeanDelta,
                 gpuAllocRetryCount = telemetry.gpuAllocRetryCount,
+                superseded = jobState == JobState.SUPERSEDED,
             )
         } finally {
             activeOperations.decrementAndGet()
@@ -332,9 +689,99 @@ class NativeEnhanceController(
         strength: Float,
         outputFile: File,
         quality: Int = 95,
+        colorGains: ColorGains = ColorGains.IDENTITY,
         onProgress: (ProgressInfo) -> Unit = {},
     ): FullResult = withContext(dispatcher) {
         checkInitialized()
+        val resultBitmap = Bitmap.createBitmap(
+            sourceBitmap.width,
+            sourceBitmap.height,
+            Bitmap.Config.ARGB_8888,
+        )
+        runFullJob(
+            width = sourceBitmap.width,
+            height = sourceBitmap.height,
+            resultBitmap = resultBitmap,
+            strength = strength,
+            startPayload = mapOf(
+                "output_file" to outputFile.absolutePath,
+                "quality" to quality,
+            ) + colorGains.toLogPayload(),
+            onProgress = onProgress,
+        ) { progressCallback, completion ->
+            nativeSubmitFull(
+                nativeHandle,
+                sourceBitmap,
+                strength,
+                colorGains.vibranceGain,
+                colorGains.saturationGain,
+                resultBitmap,
+                PRIORITY_FULL,
+                progressCallback,
+                progressMaxRateHz,
+                completion,
+            )
+        }
+    }
+
+    /**
+     * Полная обработка JPEG-файла без Bitmap: натив декодирует источник сразу
+     * в рабочем разрешении сети, а результат увеличивает до исходного размера
+     * полосами по 32 строки и тут же кодирует в [outputFile] с EXIF источника.
+     * В памяти одновременно лишь несколько полос полного размера.
+     * [FullResult.bitmap] — `null`. Возвращает `null`, если файл не читается
+     * нативным декодером (не JPEG, CMYK) — тогда нужен [runFull].
+     */
+    suspend fun runFullToJpeg(
+        sourceFile: File,
+        strength: Float,
+        outputFile: File,
+        quality: Int = 95,
+        colorGains: ColorGains = ColorGains.IDENTITY,
+        onProgress: (ProgressInfo) -> Unit = {},
+    ): FullResult? = withContext(dispatcher) {
+        checkInitialized()
+        val info = IntArray(JPEG_INFO_SIZE)
+        if (!nativeReadJpegInfo(sourceFile.absolutePath, 0, info)) {
+            return@withContext null
+        }
+        runFullJob(
+            width = info[JPEG_INFO_WIDTH],
+            height = info[JPEG_INFO_HEIGHT],
+            resultBitmap = null,
+            strength = strength,
+            startPayload = mapOf(
+                "source" to "jpeg",
+                "output_file" to outputFile.absolutePath,
+                "quality" to quality,
+            ) + colorGains.toLogPayload(),
+            onProgress = onProgress,
+        ) { progressCallback, completion ->
+            nativeSubmitFullJpeg(
+                nativeHandle,
+                sourceFile.absolutePath,
+                outputFile.absolutePath,
+                quality,
+                strength,
+                colorGains.vibranceGain,
+                colorGains.saturationGain,
+                PRIORITY_FULL,
+                progressCallback,
+                progressMaxRateHz,
+                completion,
+            )
+        }
+    }
+
+    private suspend fun runFullJob(
+        width: Int,
+        height: Int,
+        resultBitmap: Bitmap?,
+        strength: Float,
+        startPayload: Map<String, Any?>,
+        onProgress: (ProgressInfo) -> Unit,
+        submit: (NativeTileProgressCallback, NativeJobCompletion) -> Long,
+    ): FullResult {
         activeOperations.incrementAndGet()
 
         try {
@@ -343,21 +790,14 @@ class NativeEnhanceController(
                 "native_full_start",
                 mapOf(
                     "strength" to strength,
-                    "width" to sourceBitmap.width,
-                    "height" to sourceBitmap.height,
-                    "output_file" to outputFile.absolutePath,
-                    "quality" to quality,
+                    "width" to width,
+                    "height" to height,
                     "tile_size" to NATIVE_TILE_SIZE,
                     "tile_overlap" to NATIVE_TILE_OVERLAP,
-                ) + fullStartMetadata,
+                ) + startPayload + fullStartMetadata,
             )
 
             val startTime = System.currentTimeMillis()
-            val resultBitmap = Bitmap.createBitmap(
-                sourceBitmap.width,
-                sourceBitmap.height,
-                Bitmap.Config.ARGB_8888,
-            )
 
             val fullStages = fullStagePlan()
             val progressAggregator = NativeProgressAggregator(fullStages)
@@ -372,7 +812,9 @@ class NativeEnhanceController(
                 onProgress(info)
             }
 
-            val telemetry = nativeRunFull(nativeHandle, sourceBitmap, strength, resultBitmap, progressCallback)
+            val (jobState, telemetry) = awaitJob("полной обработки") { completion ->
+                submit(progressCallback, completion)
+            }
             val elapsed = System.currentTimeMillis() - startTime
 
             lastRestPrecision = telemetry.restPrecision
@@ -380,7 +822,9 @@ class NativeEnhanceController(
             val timing = telemetry.timingMs
             val usedVulkan = telemetry.usedVulkan
             val peakMemory = telemetry.peakMemoryKb.toFloat() / 1024f
-            val cancelled = telemetry.cancelled
+            val cancelled = telemetry.cancelled ||
+                jobState == JobState.CANCELLED ||
+                jobState == JobState.SUPERSEDED
             val fallbackUsed = telemetry.fallbackUsed
             val fallbackCause = FallbackCause.fromCode(telemetry.fallbackCauseCode.toLong())
             val durationVulkan = telemetry.durationMsVulkan.takeIf { it > 0 }
@@ -397,6 +841,7 @@ class NativeEnhanceController(
                     "used_vulkan" to usedVulkan,
                     "peak_memory_mb" to peakMemory,
                     "cancelled" to cancelled,
+                    "job_state" to jobState.name.lowercase(),
                     "fallback_used" to fallbackUsed,
                     "fallback_cause" to fallbackCause?.name?.lowercase(),
                     "duration_ms_vulkan" to durationVulkan,
@@ -411,11 +856,15 @@ class NativeEnhanceController(
                     "gpu_alloc_retry_count" to telemetry.gpuAllocRetryCount,
                     "rest_precision" to telemetry.restPrecision,
                     "restormer_precision" to telemetry.restPrecision,
-                ) + fullCompleteMetadata,
+                ) + telemetry.memory.toLogPayload() + telemetry.profile?.toLogPayload().orEmpty() +
+                    telemetry.cpu.toLogPayload() + telemetry.sustained?.toLogPayload().orEmpty() +
+                    telemetry.imageStats?.toLogPayload().orEmpty() +
+                    fullCompleteMetadata,
             )
 
             FullResult(
                 bitmap = resultBitmap,
+                success = success,
                 timingMs = timing,
                 usedVulkan = usedVulkan,
                 peakMemoryMb = peakMemory,
@@ -434,7 +883,84 @@ class NativeEnhanceController(
                 seamMaxDelta = telemetry.seamMaxDelta,
                 seamMeanDelta = telemetry.seamMeanDelta,
                 gpuAllocRetryCount = telemetry.gpuAllocRetryCount,
+                imageStats = telemetry.imageStats,
+            )
+        } finally {
+            activeOperations.decrementAndGet()
+        }
+    }
+
+    /**
+     * Улучшает пакет файлов в нативном трёхстадийном пайплайне: декодирование
+     * элемента N+1 и кодирование N-1 идут параллельно с выводом N. JPEG натив
+     * декодирует и кодирует сам (полосами, с EXIF источника); остальные форматы
+     * декодирует и кодирует [codec]. [onItemFinished] вызывается из нативного
+     * потока по мере завершения элементов; [onSubmitted] получает
+     * [BatchControl] для отмены отдельных элементов. Отмена корутины отменяет
+     * оставшиеся элементы.
+     */
+    suspend fun runBatch(
+        items: List<BatchItem>,
+        strength: Float,
+        codec: NativeBatchCodec,
+        onSubmitted: (BatchControl) -> Unit = {},
+        onItemFinished: (BatchItemResult) -> Unit = {},
+    ): List<BatchItemResult> = withContext(dispatcher) {
+        require(items.isNotEmpty()) { "Пакет пуст" }
+        checkInitialized()
+        activeOperations.incrementAndGet()
+
+        try {
+            EnhanceLogging.logEvent(
+                "native_batch_start",
+                mapOf(
+                    "strength" to strength,
+                    "items" to items.size,
+                ) + delegateSnapshotPayload(),
             )
+
+            val startTime = System.currentTimeMillis()
+            val itemsBuffer = NativeBatchItemsBuffer(items.size)
+            val listener = NativeBatchListener { index, _ ->
+                onItemFinished(itemsBuffer.decode(index))
+            }
+            val (jobState, _) = awaitJob("пакета") { completion ->
+                val jobId = nativeSubmitBatch(
+                    nativeHandle,
+                    items.map { it.inputFile.absolutePath }.toTypedArray(),
+                    items.map { it.outputFile.absolutePath }.toTypedArray(),
+                    strength,
+                    PRIORITY_FULL,
+                    codec,
+                    listener,
+                    itemsBuffer.buffer,
+                    completion,
+                )
+                if (jobId > 0L) {
+                    onSubmitted(BatchControl(jobId))
+                }
+                jobId
+            }
+            val results = itemsBuffer.decodeAll()
+            val elapsed = System.currentTimeMillis() - startTime
+
+            EnhanceLogging.logEvent(
+                "native_batch_complete",
+                mapOf(
+                    "job_state" to jobState.name.lowercase(),
+                    "items" to results.size,
+                    "succeeded" to results.count { it.state == BatchItemState.SUCCEEDED },
+                    "failed" to results.count { it.state == BatchItemState.FAILED },
+                    "cancelled" to results.count { it.state != BatchItemState.SUCCEEDED && it.state != BatchItemState.FAILED },
+                    "elapsed_ms" to elapsed,
+                    "decode_ms_total" to results.sumOf { it.decodeMs },
+                    "infer_ms_total" to results.sumOf { it.inferMs },
+                    "encode_ms_total" to results.sumOf { it.encodeMs },
+                ) + results.lastOrNull { it.telemetry?.sustained != null }
+                    ?.telemetry?.sustained?.toLogPayload().orEmpty() +
+                    delegateSnapshotPayload(),
+            )
+            results
         } finally {
             activeOperations.decrementAndGet()
         }
@@ -479,6 +1005,42 @@ class NativeEnhanceController(
         }
     }
 
+    /**
+     * Ставит задачу в нативную очередь и приостанавливается до её завершения.
+     * Отмена корутины отменяет только эту задачу; результат всё равно
+     * забирается из очереди, чтобы не копился в ней.
+     */
+    private suspend fun awaitJob(
+        label: String,
+        submit: (NativeJobCompletion) -> Long,
+    ): Pair<JobState, NativeRunTelemetry> {
+        val finished = CompletableDeferred<JobState>()
+        val completion = NativeJobCompletion { _, state ->
+            finished.complete(JobState.fromCode(state))
+        }
+        val jobId = submit(completion)
+        check(jobId > 0L) { "Нативная очередь не приняла задачу $label (handle=$nativeHandle)" }
+
+        val completedState = try {
+            finished.await()
+        } catch (cancellation: CancellationException) {
+            nativeCancelJob(nativeHandle, jobId)
+            withContext(NonCancellable) {
+                finished.await()
+                nativePollJob(nativeHandle, jobId, telemetryBuffers.get().buffer)
+            }
+            throw cancellation
+        }
+
+        val telemetryBuffer = telemetryBuffers.get()
+        telemetryBuffer.reset()
+        val polledState = JobState.fromCode(nativePollJob(nativeHandle, jobId, telemetryBuffer.buffer))
+        val jobState = if (polledState.isTerminal) polledState else completedState
+        val telemetry = telemetryBuffer.decode()
+            ?: throw IllegalStateException("Нативная задача $label job=$jobId не записала телеметрию (state=$jobState)")
+        return jobState to telemetry
+    }
+
     private external fun nativeInit(
         assetManager: AssetManager,
         modelsDir: String,
@@ -488,22 +1050,121 @@ class NativeEnhanceController(
         restormerBinChecksum: String,
         previewProfile: Int,
         forceCpu: Boolean,
+        ledgerKey: ByteArray?,
+        reverifyIntervalSec: Long,
     ): Long
 
-    private external fun nativeRunPreview(
+    private external fun nativeSubmitPreview(
         handle: Long,
         bitmap: Bitmap,
         strength: Float,
+        vibranceGain: Float,
+        saturationGain: Float,
+        photoKey: String?,
+        priority: Int,
         progressCallback: NativeTileProgressCallback?,
-    ): NativeRunTelemetry
+        progressMaxRateHz: Int,
+        completion: NativeJobCompletion,
+    ): Long
 
-    private external fun nativeRunFull(
+    private external fun nativeSubmitFull(
         handle: Long,
         sourceBitmap: Bitmap,
         strength: Float,
+        vibranceGain: Float,
+        saturationGain: Float,
+        outputBitmap: Bitmap,
+        priority: Int,
+        progressCallback: NativeTileProgressCallback?,
+        progressMaxRateHz: Int,
+        completion: NativeJobCompletion,
+    ): Long
+
+    private external fun nativeSubmitFullJpeg(
+        handle: Long,
+        inputPath: String,
+        outputPath: String,
+        quality: Int,
+        strength: Float,
+        vibranceGain: Float,
+        saturationGain: Float,
+        priority: Int,
+        progressCallback: NativeTileProgressCallback?,
+        progressMaxRateHz: Int,
+        completion: NativeJobCompletion,
+    ): Long
+
+    /** Неблокирующий опрос; для конечного состояния записывает телеметрию и забирает результат. */
+    private external fun nativePollJob(handle: Long, jobId: Long, telemetryBuffer: ByteBuffer): Int
+
+    /** Ждёт конечного состояния не дольше [timeoutMs] (< 0 — без ограничения). */
+    private external fun nativeAwaitJob(
+        handle: Long,
+        jobId: Long,
+        timeoutMs: Long,
+        telemetryBuffer: ByteBuffer,
+    ): Int
+
+    private external fun nativeCancelJob(handle: Long, jobId: Long): Boolean
+
+    /** Заполняет [outInfo]: ширина, высота, знаменатель масштаба, ширина и высота результата. */
+    private external fun nativeReadJpegInfo(path: String, maxSide: Int, outInfo: IntArray): Boolean
+
+    /**
+     * [outInfo] — как у [nativeReadJpegInfo]; [outStats]: средняя яркость, доля
+     * тёмного, резкость и шум уменьшенного кадра.
+     */
+    private external fun nativeComputeJpegStats(
+        path: String,
+        maxSide: Int,
+        outInfo: IntArray,
+        outStats: FloatArray,
+    ): Boolean
+
+    private external fun nativeSubmitPreviewJpeg(
+        handle: Long,
+        path: String,
+        scaleDenom: Int,
         outputBitmap: Bitmap,
+        strength: Float,
+        vibranceGain: Float,
+        saturationGain: Float,
+        photoKey: String?,
+        priority: Int,
+        progressCallback: NativeTileProgressCallback?,
+        progressMaxRateHz: Int,
+        completion: NativeJobCompletion,
+    ): Long
+
+    private external fun nativeSubmitProgressivePreviewJpeg(
+        handle: Long,
+        path: String,
+        scaleDenoms: IntArray,
+        outputBitmaps: Array<Bitmap>,
+        strength: Float,
+        vibranceGain: Float,
+        saturationGain: Float,
+        photoKey: String?,
+        priority: Int,
         progressCallback: NativeTileProgressCallback?,
-    ): NativeRunTelemetry
+        progressMaxRateHz: Int,
+        levelListener: NativePreviewLevelListener,
+        completion: NativeJobCompletion,
+    ): Long
+
+    private external fun nativeSubmitBatch(
+        handle: Long,
+        inputPaths: Array<String>,
+        outputPaths: Array<String>,
+        strength: Float,
+        priority: Int,
+        codec: NativeBatchCodec,
+        listener: NativeBatchListener?,
+        itemsBuffer: ByteBuffer,
+        completion: NativeJobCompletion,
+    ): Long
+
+    private external fun nativeCancelBatchItem(handle: Long, jobId: Long, index: Int): Boolean
 
     private external fun nativeCancel(handle: Long)
 
@@ -564,9 +1225,149 @@ class NativeEnhanceController(
         private const val STAGE_ZERODCE_FULL = "zerodce_full"
         private const val STAGE_GENERIC = "native"
 
+        /** Буфер телеметрии на поток: натив пишет в него, не создавая Java-объектов. */
+        private val telemetryBuffers: ThreadLocal<NativeTelemetryBuffer> =
+            ThreadLocal.withInitial { NativeTelemetryBuffer() }
+
+        /** Превью интерактивно и обгоняет в очереди полную обработку. */
+        private const val PRIORITY_PREVIEW = 10
+        private const val PRIORITY_FULL = 0
+
+        // Раскладка массива nativeReadJpegInfo.
+        private const val JPEG_INFO_WIDTH = 0
+        private const val JPEG_INFO_HEIGHT = 1
+        private const val JPEG_INFO_SCALE_DENOM = 2
+        private const val JPEG_INFO_SCALED_WIDTH = 3
+        private const val JPEG_INFO_SCALED_HEIGHT = 4
+        private const val JPEG_INFO_SIZE = 5
+
+        // Раскладка массива статистики nativeComputeJpegStats.
+        private const val JPEG_STATS_LUMA_MEAN = 0
+        private const val JPEG_STATS_DARK_SHARE = 1
+        private const val JPEG_STATS_SHARPNESS = 2
+        private const val JPEG_STATS_NOISE = 3
+        private const val JPEG_STATS_SIZE = 4
+
+        /** Промежуточные уровни прогрессивного превью, от грубого к точному. */
+        private val PROGRESSIVE_SCALE_DENOMS = listOf(8, 2)
+
+        /**
+         * Знаменатели уровней прогрессивного превью: промежуточные уровни грубее
+         * [finalScaleDenom], затем он сам. Уровни точнее экрана не выводятся.
+         */
+        internal fun progressiveScaleDenoms(finalScaleDenom: Int): List<Int> =
+            PROGRESSIVE_SCALE_DENOMS.filter { it > finalScaleDenom } + finalScaleDenom
+
+        /** Сторона JPEG после DCT-масштабирования 1/[scaleDenom] (округление вверх, как в libjpeg). */
+        internal fun scaledJpegSize(size: Int, scaleDenom: Int): Int = (size + scaleDenom - 1) / scaleDenom
+
+        /** Предельная частота onTileProgress на стадию; события чаще объединяются нативно. */
+        const val DEFAULT_PROGRESS_MAX_RATE_HZ = 30
+
+        /** Как часто полностью перехешировать модели, даже если файлы не менялись. */
+        const val DEFAULT_MODEL_REVERIFY_INTERVAL_HOURS = 24L * 7
+
         @JvmStatic
         private external fun nativeConsumeIntegrityFailure(): Array<String>?
 
+        @JvmStatic
+        private external fun nativeSetProfilingEnabled(enabled: Boolean)
+
+        /**
+         * Включает профилирование нативных запусков: время стадий, перцентили
+         * тайлов и время слоёв ncnn попадают в [NativeRunTelemetry.profile] и в
+         * события `native_*_complete`, а в [NativeCpuUsage] — CPU по классам ядер и маска
+         * CPU. Действует на запуски, начатые после вызова;
+         * послойный замер держит все промежуточные блобы, поэтому не для релиза.
+         */
+        fun setProfilingEnabled(enabled: Boolean) {
+            nativeSetProfilingEnabled(enabled)
+        }
+
+        @JvmStatic
+        private external fun nativeSetSustainedModeEnabled(enabled: Boolean)
+
+        /**
+         * Включает устойчивый режим пакетной обработки ([runBatch], по умолчанию
+         * включён): под троттлингом движок добавляет паузы между изображениями и
+         * снимает потоки, а после остывания возвращает полный бюджет. Одиночные
+         * запуски просмотрщика (превью и полная обработка одного фото) не
+         * ограничиваются. Решения попадают в [NativeRunTelemetry.sustained].
+         */
+        fun setSustainedModeEnabled(enabled: Boolean) {
+            nativeSetSustainedModeEnabled(enabled)
+        }
+
+        @JvmStatic
+        private external fun nativeApplyEdgeAwareUnsharp(
+            pixels: IntArray,
+            output: IntArray,
+            width: Int,
+            height: Int,
+            amount: Float,
+            radius: Float,
+            threshold: Float,
+        ): Boolean
+
+        /**
+         * Нативное нерезкое маскирование с порогом по яркости — то же, что
+         * `EnhanceEngine.applyEdgeAwareUnsharp`, но раздельным размытием на NEON
+         * в нескольких потоках. [pixels] — ARGB построчно; возвращает новый массив
+         * или `null`, если размеры не сходятся.
+         */
+        fun applyEdgeAwareUnsharp(
+            pixels: IntArray,
+            width: Int,
+            height: Int,
+            amount: Float,
+            radius: Float,
+            threshold: Float,
+        ): IntArray? {
+            val output = IntArray(pixels.size)
+            return if (nativeApplyEdgeAwareUnsharp(pixels, output, width, height, amount, radius, threshold)) {
+                output
+            } else {
+                null
+            }
+        }
+
+        @JvmStatic
+        private external fun nativeApplyColorLut(
+            pixels: IntArray,
+            output: IntArray,
+            width: Int,
+            height: Int,
+            vibranceGain: Float,
+            saturationGain: Float,
+            lutSize: Int,
+        ): Boolean
+
+        /** Стороны 3D LUT цветовой стадии: 65 — точнее (±1 LSB), 33 — в восемь раз меньше (±2 LSB). */
+        const val COLOR_LUT_SIZE_33 = 33
+        const val COLOR_LUT_SIZE_65 = 65
+
+        /**
+         * Цветовая стадия профиля (`EnhanceEngine.applyVibranceAndSaturation`) через
+         * 3D LUT [lutSize]^3 с тетраэдрической интерполяцией, в несколько потоков.
+         * Таблица собирается один раз на пару коэффициентов; почти серые пиксели
+         * считаются точно. Возвращает новый массив или `null`, если размеры не сходятся.
+         */
+        fun applyColorLut(
+            pixels: IntArray,
+            width: Int,
+            height: Int,
+            vibranceGain: Float,
+            saturationGain: Float,
+            lutSize: Int = COLOR_LUT_SIZE_65,
+        ): IntArray? {
+            val output = IntArray(pixels.size)
+            return if (nativeApplyColorLut(pixels, output, width, height, vibranceGain, saturationGain, lutSize)) {
+                output
+            } else {
+                null
+            }
+        }
+
         fun loadLibrary() {
             try {
                 System.loadLibrary(LIBRARY_NAME)
@@ -0,0 +1,11 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+/**
+ * Завершение задачи нативной очереди. Вызывается один раз на задачу с кодом
+ * конечного состояния [NativeEnhanceController.JobState] — из рабочего потока
+ * `kotopogoda-enhance` либо из потока, который отменил или вытеснил задачу до
+ * её запуска.
+ */
+fun interface NativeJobCompletion {
+    fun onJobFinished(jobId: Long, state: Int)
+}
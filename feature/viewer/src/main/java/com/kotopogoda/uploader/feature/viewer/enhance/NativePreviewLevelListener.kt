@@ -0,0 +1,9 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+/**
+ * Готовность уровня прогрессивного превью: результат уровня [level] уже
+ * записан в его Bitmap. Вызывается из рабочего потока нативной очереди.
+ */
+fun interface NativePreviewLevelListener {
+    fun onLevelReady(level: Int)
+}
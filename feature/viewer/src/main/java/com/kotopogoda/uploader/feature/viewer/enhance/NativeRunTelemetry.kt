@@ -1,7 +1,7 @@
 package com.kotopogoda.uploader.feature.viewer.enhance
 
 /**
- * Пакет телеметрии, который JNI возвращает после выполнения native-пайплайна.
+ * Телеметрия native-пайплайна, декодированная из [NativeTelemetryBuffer].
  */
 data class NativeRunTelemetry(
     val success: Boolean,
@@ -23,4 +23,165 @@ data class NativeRunTelemetry(
     val gpuAllocRetryCount: Int,
     val delegateUsed: String,
     val restPrecision: String,
+    val memory: NativeMemoryTelemetry = NativeMemoryTelemetry(),
+    val profile: NativeProfile? = null,
+    val cpu: NativeCpuUsage = NativeCpuUsage(),
+    val sustained: NativeSustainedTelemetry? = null,
+    val imageStats: NativeImageStats? = null,
+)
+
+/**
+ * Память запуска по стадиям (КиБ). [stagePeakKb] — пик учтённых аллокаций
+ * (ncnn-аллокаторы и Mat движка), [stageRssKb] — VmRSS на границе стадии,
+ * [processPeakRssKb] — VmHWM процесса. 0 — стадия в запуске не выполнялась.
+ */
+data class NativeMemoryTelemetry(
+    val stagePeakKb: Map<String, Long> = emptyMap(),
+    val stageRssKb: Map<String, Long> = emptyMap(),
+    val processPeakRssKb: Long = 0,
+) {
+    /** Поля для журнала: `peak_kb_<стадия>`, `rss_kb_<стадия>` и `process_peak_rss_kb`. */
+    fun toLogPayload(): Map<String, Any?> = buildMap {
+        stagePeakKb.forEach { (stage, value) -> put("peak_kb_$stage", value) }
+        stageRssKb.forEach { (stage, value) -> put("rss_kb_$stage", value) }
+        put("process_peak_rss_kb", processPeakRssKb)
+    }
+}
+
+/**
+ * Профиль запуска (только при [NativeEnhanceController.setProfilingEnabled]).
+ * Время стадий в мкс по монотонным часам; [tileP50Micros]/[tileP95Micros] —
+ * перцентили по ближайшему рангу; [topLayers] — самые медленные слои ncnn по
+ * убыванию, [layersTotalMicros] — сумма по всем [layerCount] слоям.
+ */
+data class NativeProfile(
+    val stageMicros: Map<String, Long>,
+    val tileCount: Int,
+    val tileP50Micros: Long,
+    val tileP95Micros: Long,
+    val tileMaxMicros: Long,
+    val layerCount: Int,
+    val layersTotalMicros: Long,
+    val topLayers: List<NativeLayerTiming>,
+) {
+    /** Поля для журнала: `profile_us_<стадия>`, тайлы, слои и `profile_top_layers` строкой. */
+    fun toLogPayload(): Map<String, Any?> = buildMap {
+        stageMicros.forEach { (stage, value) -> put("profile_us_$stage", value) }
+        put("profile_tiles", tileCount)
+        put("profile_tile_p50_us", tileP50Micros)
+        put("profile_tile_p95_us", tileP95Micros)
+        put("profile_tile_max_us", tileMaxMicros)
+        put("profile_layers", layerCount)
+        put("profile_layers_us", layersTotalMicros)
+        put("profile_top_layers", topLayers.joinToString(",") { "${it.name}/${it.type}:${it.micros}" })
+    }
+}
+
+/**
+ * CPU запуска (мкс). [threadCpuMicros] — поток, выполнявший запуск;
+ * [processCpuMicros] — user + sys всего процесса за время запуска, то есть
+ * верхняя оценка при параллельных задачах. [coreClassMicros] — доля
+ * процессного времени по классам ядер (`little`/`mid`/`big`) по последнему
+ * CPU потоков с точностью тика планировщика; [cpuMask] — замеченные CPU. Оба
+ * считаются только при [NativeEnhanceController.setProfilingEnabled], иначе нулевые.
+ * [cpuMsPerMegapixel] — энергетический прокси: мс CPU на мегапиксель входа.
+ */
+data class NativeCpuUsage(
+    val threadCpuMicros: Long = 0,
+    val processCpuMicros: Long = 0,
+    val voluntarySwitches: Long = 0,
+    val involuntarySwitches: Long = 0,
+    val coreClassMicros: Map<String, Long> = emptyMap(),
+    val cpuMask: Long = 0,
+    val pixels: Long = 0,
+    val cpuMsPerMegapixel: Float = 0f,
+) {
+    /** Поля для журнала: `cpu_*_ms`, переключения контекста, `cpu_ms_<класс>` и маска CPU в hex. */
+    fun toLogPayload(): Map<String, Any?> = buildMap {
+        put("cpu_thread_ms", threadCpuMicros / 1000)
+        put("cpu_process_ms", processCpuMicros / 1000)
+        put("cpu_ms_per_mp", cpuMsPerMegapixel)
+        put("cpu_csw_voluntary", voluntarySwitches)
+        put("cpu_csw_involuntary", involuntarySwitches)
+        coreClassMicros.forEach { (coreClass, value) -> put("cpu_ms_$coreClass", value / 1000) }
+        put("cpu_mask", "0x" + java.lang.Long.toHexString(cpuMask))
+    }
+}
+
+/**
+ * Устойчивый режим полноразмерного запуска (только при
+ * [NativeEnhanceController.setSustainedModeEnabled]): бюджет уровня [level]
+ * с выдержанной перед запуском паузой [pauseMicros] и решение контроллера
+ * после запуска (`hold`/`throttle`/`recover`) с уровнем [nextLevel].
+ * [windowMpps] — медиана скользящего окна, [baselineMpps] — эталон для
+ * [threads] потоков; [tileSize] 0 — путь без тайлов.
+ */
+data class NativeSustainedTelemetry(
+    val level: Int,
+    val threads: Int,
+    val tileSize: Int,
+    val pauseMicros: Long,
+    val decision: String,
+    val nextLevel: Int,
+    val levelChanges: Int,
+    val windowMpps: Float,
+    val baselineMpps: Float,
+) {
+    /** Поля для журнала с префиксом `sustained_`; пауза в мс. */
+    fun toLogPayload(): Map<String, Any?> = mapOf(
+        "sustained_level" to level,
+        "sustained_threads" to threads,
+        "sustained_tile_size" to tileSize,
+        "sustained_pause_ms" to pauseMicros / 1000,
+        "sustained_decision" to decision,
+        "sustained_next_level" to nextLevel,
+        "sustained_level_changes" to levelChanges,
+        "sustained_window_mpps" to windowMpps,
+        "sustained_baseline_mpps" to baselineMpps,
+    )
+}
+
+/**
+ * Статистика 8-битного результата, собранная нативно при его записи в Bitmap
+ * или JPEG. [lumaMean], [darkShare], [sharpness] и [noise] считаются как в
+ * [EnhanceEngine.MetricsCalculator]; перцентили яркости в [0, 1]; клиппинг —
+ * доля пикселей с каналом 0 (тени) или 255 (света); насыщенность — S из HSV,
+ * [saturatedShare] — доля пикселей с S ≥ 0.9. [histogram] — число пикселей
+ * в каждой из [NativeTelemetryBuffer.IMAGE_STATS_BINS] корзин яркости.
+ */
+data class NativeImageStats(
+    val pixels: Long,
+    val lumaMean: Float,
+    val darkShare: Float,
+    val sharpness: Float,
+    val noise: Float,
+    val lumaP05: Float,
+    val lumaP50: Float,
+    val lumaP95: Float,
+    val clippedShadowShare: Float,
+    val clippedHighlightShare: Float,
+    val saturationMean: Float,
+    val saturatedShare: Float,
+    val histogram: List<Int>,
+) {
+    /** Поля для журнала с префиксом `image_`, без гистограммы. */
+    fun toLogPayload(): Map<String, Any?> = mapOf(
+        "image_luma_mean" to lumaMean,
+        "image_luma_p05" to lumaP05,
+        "image_luma_p50" to lumaP50,
+        "image_luma_p95" to lumaP95,
+        "image_dark_share" to darkShare,
+        "image_clipped_shadows" to clippedShadowShare,
+        "image_clipped_highlights" to clippedHighlightShare,
+        "image_saturation_mean" to saturationMean,
+        "image_saturated_share" to saturatedShare,
+    )
+}
+
+/** Время слоя ncnn; [index] — позиция в `ncnn::Net::layers()`. */
+data class NativeLayerTiming(
+    val index: Int,
+    val name: String,
+    val type: String,
+    val micros: Long,
 )
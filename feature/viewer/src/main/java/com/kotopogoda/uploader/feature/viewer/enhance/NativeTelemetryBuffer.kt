@@ -0,0 +1,281 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Прямой буфер, в который нативный пайплайн пишет телеметрию запуска вместо
+ * создания Java-объектов. Раскладка фиксирована и версионирована, зеркально
+ * `telemetry_buffer.h`; буфер переиспользуется между запусками в одном потоке.
+ */
+internal class NativeTelemetryBuffer {
+
+    val buffer: ByteBuffer = ByteBuffer.allocateDirect(SIZE_BYTES).order(ByteOrder.nativeOrder())
+
+    /** Обнуляет буфер перед вызовом: версия 0 означает, что натив ничего не записал. */
+    fun reset() {
+        for (offset in 0 until SIZE_BYTES step Int.SIZE_BYTES) {
+            buffer.putInt(offset, 0)
+        }
+    }
+
+    /**
+     * Читает телеметрию. `null` — натив буфер не заполнил (например, недействительный handle).
+     * Несовпадение версии или размера означает рассинхронизацию Kotlin и натива.
+     */
+    fun decode(): NativeRunTelemetry? = decodeAt(buffer, 0)
+
+    internal companion object {
+        const val LAYOUT_VERSION = 7
+        const val SIZE_BYTES = 1208
+
+        const val OFFSET_VERSION = 0
+        const val OFFSET_SIZE = 4
+        const val OFFSET_FLAGS = 8
+        const val OFFSET_FALLBACK_CAUSE = 12
+        const val OFFSET_TIMING_MS = 16
+        const val OFFSET_PEAK_MEMORY_KB = 24
+        const val OFFSET_DURATION_MS_VULKAN = 32
+        const val OFFSET_DURATION_MS_CPU = 40
+        const val OFFSET_TILE_SIZE = 48
+        const val OFFSET_TILE_OVERLAP = 52
+        const val OFFSET_TILES_TOTAL = 56
+        const val OFFSET_TILES_COMPLETED = 60
+        const val OFFSET_SEAM_MAX_DELTA = 64
+        const val OFFSET_SEAM_MEAN_DELTA = 68
+        const val OFFSET_GPU_ALLOC_RETRIES = 72
+        const val OFFSET_DELEGATE = 76
+        const val OFFSET_REST_PRECISION = 80
+        const val OFFSET_STAGE_PEAK_KB = 88
+        const val OFFSET_STAGE_RSS_KB = 128
+        const val OFFSET_PROCESS_PEAK_RSS_KB = 168
+        const val OFFSET_STAGE_MICROS = 176
+        const val OFFSET_TILE_COUNT = 216
+        const val OFFSET_LAYER_COUNT = 220
+        const val OFFSET_TILE_P50_MICROS = 224
+        const val OFFSET_TILE_P95_MICROS = 232
+        const val OFFSET_TILE_MAX_MICROS = 240
+        const val OFFSET_LAYERS_MICROS = 248
+        const val OFFSET_TOP_LAYER_COUNT = 256
+        const val OFFSET_TOP_LAYERS = 264
+        const val OFFSET_THREAD_CPU_MICROS = 776
+        const val OFFSET_PROCESS_CPU_MICROS = 784
+        const val OFFSET_VOLUNTARY_SWITCHES = 792
+        const val OFFSET_INVOLUNTARY_SWITCHES = 800
+        const val OFFSET_CORE_CLASS_MICROS = 808
+        const val OFFSET_CPU_MASK = 832
+        const val OFFSET_PIXELS = 840
+        const val OFFSET_CPU_MS_PER_MEGAPIXEL = 848
+        const val OFFSET_SUSTAINED_LEVEL = 856
+        const val OFFSET_SUSTAINED_THREADS = 860
+        const val OFFSET_SUSTAINED_TILE_SIZE = 864
+        const val OFFSET_SUSTAINED_DECISION = 868
+        const val OFFSET_SUSTAINED_PAUSE_MICROS = 872
+        const val OFFSET_SUSTAINED_NEXT_LEVEL = 880
+        const val OFFSET_SUSTAINED_CHANGES = 884
+        const val OFFSET_SUSTAINED_WINDOW_MPPS = 888
+        const val OFFSET_SUSTAINED_BASELINE_MPPS = 892
+        const val OFFSET_STATS_PIXELS = 896
+        const val OFFSET_STATS_LUMA_MEAN = 904
+        const val OFFSET_STATS_DARK_SHARE = 908
+        const val OFFSET_STATS_SHARPNESS = 912
+        const val OFFSET_STATS_NOISE = 916
+        const val OFFSET_STATS_LUMA_P05 = 920
+        const val OFFSET_STATS_LUMA_P50 = 924
+        const val OFFSET_STATS_LUMA_P95 = 928
+        const val OFFSET_STATS_CLIPPED_SHADOWS = 932
+        const val OFFSET_STATS_CLIPPED_HIGHLIGHTS = 936
+        const val OFFSET_STATS_SATURATION_MEAN = 940
+        const val OFFSET_STATS_SATURATED_SHARE = 944
+        const val OFFSET_STATS_HISTOGRAM = 952
+
+        /** Корзин гистограммы яркости, `kImageStatsBins` (image_stats.h). */
+        const val IMAGE_STATS_BINS = 64
+
+        // Запись слоя внутри OFFSET_TOP_LAYERS.
+        const val TOP_LAYER_MICROS = 0
+        const val TOP_LAYER_INDEX = 8
+        const val TOP_LAYER_TYPE = 16
+        const val TOP_LAYER_TYPE_LENGTH = 16
+        const val TOP_LAYER_NAME = 32
+        const val TOP_LAYER_NAME_LENGTH = 32
+        const val TOP_LAYER_SIZE = 64
+        const val MAX_TOP_LAYERS = 8
+
+        /** Стадии запуска в порядке `PipelineStage` (pipeline_stage.h). */
+        val PIPELINE_STAGES = listOf("convert_in", "zerodce", "blend", "upscale", "convert_out")
+
+        /** Классы ядер в порядке `CoreClass` (cpu_accounting.h). */
+        val CORE_CLASSES = listOf("little", "mid", "big")
+
+        const val FLAG_SUCCESS = 1 shl 0
+        const val FLAG_USED_VULKAN = 1 shl 1
+        const val FLAG_CANCELLED = 1 shl 2
+        const val FLAG_FALLBACK_USED = 1 shl 3
+        const val FLAG_TILE_USED = 1 shl 4
+        const val FLAG_PROFILED = 1 shl 5
+        const val FLAG_SUSTAINED = 1 shl 6
+        const val FLAG_IMAGE_STATS = 1 shl 7
+
+        /** Решения контроллера в порядке `SustainedDecision` (sustained_performance.h). */
+        val SUSTAINED_DECISIONS = listOf("hold", "throttle", "recover")
+
+        const val DELEGATE_CODE_VULKAN = 1
+        const val PRECISION_CODE_FP16 = 0
+        const val PRECISION_CODE_FP32 = 1
+
+        /**
+         * Читает телеметрию, записанную с байта [base] (например, внутри записи элемента пакета).
+         * `null` — натив буфер не заполнил (например, недействительный handle).
+         * Несовпадение версии или размера означает рассинхронизацию Kotlin и натива.
+         */
+        fun decodeAt(buffer: ByteBuffer, base: Int): NativeRunTelemetry? {
+            val version = buffer.getInt(base + OFFSET_VERSION)
+            if (version == 0) {
+                return null
+            }
+            check(version == LAYOUT_VERSION) {
+                "Неподдерживаемая версия телеметрии: $version (ожидалась $LAYOUT_VERSION)"
+            }
+            val size = buffer.getInt(base + OFFSET_SIZE)
+            check(size == SIZE_BYTES) { "Неожиданный размер телеметрии: $size (ожидался $SIZE_BYTES)" }
+
+            val flags = buffer.getInt(base + OFFSET_FLAGS)
+            return NativeRunTelemetry(
+                success = (flags and FLAG_SUCCESS) != 0,
+                timingMs = buffer.getLong(base + OFFSET_TIMING_MS),
+                usedVulkan = (flags and FLAG_USED_VULKAN) != 0,
+                peakMemoryKb = buffer.getLong(base + OFFSET_PEAK_MEMORY_KB),
+                cancelled = (flags and FLAG_CANCELLED) != 0,
+                fallbackUsed = (flags and FLAG_FALLBACK_USED) != 0,
+                fallbackCauseCode = buffer.getInt(base + OFFSET_FALLBACK_CAUSE),
+                durationMsVulkan = buffer.getLong(base + OFFSET_DURATION_MS_VULKAN),
+                durationMsCpu = buffer.getLong(base + OFFSET_DURATION_MS_CPU),
+                tileUsed = (flags and FLAG_TILE_USED) != 0,
+                tileSize = buffer.getInt(base + OFFSET_TILE_SIZE),
+                tileOverlap = buffer.getInt(base + OFFSET_TILE_OVERLAP),
+                tilesTotal = buffer.getInt(base + OFFSET_TILES_TOTAL),
+                tilesCompleted = buffer.getInt(base + OFFSET_TILES_COMPLETED),
+                seamMaxDelta = buffer.getFloat(base + OFFSET_SEAM_MAX_DELTA),
+                seamMeanDelta = buffer.getFloat(base + OFFSET_SEAM_MEAN_DELTA),
+                gpuAllocRetryCount = buffer.getInt(base + OFFSET_GPU_ALLOC_RETRIES),
+                delegateUsed = delegateName(buffer.getInt(base + OFFSET_DELEGATE)),
+                restPrecision = precisionName(buffer.getInt(base + OFFSET_REST_PRECISION)),
+                memory = decodeMemory(buffer, base),
+                profile = if ((flags and FLAG_PROFILED) != 0) decodeProfile(buffer, base) else null,
+                cpu = decodeCpu(buffer, base),
+                sustained = if ((flags and FLAG_SUSTAINED) != 0) decodeSustained(buffer, base) else null,
+                imageStats = if ((flags and FLAG_IMAGE_STATS) != 0) decodeImageStats(buffer, base) else null,
+            )
+        }
+
+        private fun decodeCpu(buffer: ByteBuffer, base: Int): NativeCpuUsage {
+            val coreClassMicros = LinkedHashMap<String, Long>()
+            CORE_CLASSES.forEachIndexed { index, coreClass ->
+                coreClassMicros[coreClass] = buffer.getLong(base + OFFSET_CORE_CLASS_MICROS + index * Long.SIZE_BYTES)
+            }
+            return NativeCpuUsage(
+                threadCpuMicros = buffer.getLong(base + OFFSET_THREAD_CPU_MICROS),
+                processCpuMicros = buffer.getLong(base + OFFSET_PROCESS_CPU_MICROS),
+                voluntarySwitches = buffer.getLong(base + OFFSET_VOLUNTARY_SWITCHES),
+                involuntarySwitches = buffer.getLong(base + OFFSET_INVOLUNTARY_SWITCHES),
+                coreClassMicros = coreClassMicros,
+                cpuMask = buffer.getLong(base + OFFSET_CPU_MASK),
+                pixels = buffer.getLong(base + OFFSET_PIXELS),
+                cpuMsPerMegapixel = buffer.getFloat(base + OFFSET_CPU_MS_PER_MEGAPIXEL),
+            )
+        }
+
+        private fun decodeSustained(buffer: ByteBuffer, base: Int): NativeSustainedTelemetry =
+            NativeSustainedTelemetry(
+                level = buffer.getInt(base + OFFSET_SUSTAINED_LEVEL),
+                threads = buffer.getInt(base + OFFSET_SUSTAINED_THREADS),
+                tileSize = buffer.getInt(base + OFFSET_SUSTAINED_TILE_SIZE),
+                pauseMicros = buffer.getLong(base + OFFSET_SUSTAINED_PAUSE_MICROS),
+                decision = SUSTAINED_DECISIONS.getOrElse(buffer.getInt(base + OFFSET_SUSTAINED_DECISION)) { "unknown" },
+                nextLevel = buffer.getInt(base + OFFSET_SUSTAINED_NEXT_LEVEL),
+                levelChanges = buffer.getInt(base + OFFSET_SUSTAINED_CHANGES),
+                windowMpps = buffer.getFloat(base + OFFSET_SUSTAINED_WINDOW_MPPS),
+                baselineMpps = buffer.getFloat(base + OFFSET_SUSTAINED_BASELINE_MPPS),
+            )
+
+        private fun decodeImageStats(buffer: ByteBuffer, base: Int): NativeImageStats =
+            NativeImageStats(
+                pixels = buffer.getLong(base + OFFSET_STATS_PIXELS),
+                lumaMean = buffer.getFloat(base + OFFSET_STATS_LUMA_MEAN),
+                darkShare = buffer.getFloat(base + OFFSET_STATS_DARK_SHARE),
+                sharpness = buffer.getFloat(base + OFFSET_STATS_SHARPNESS),
+                noise = buffer.getFloat(base + OFFSET_STATS_NOISE),
+                lumaP05 = buffer.getFloat(base + OFFSET_STATS_LUMA_P05),
+                lumaP50 = buffer.getFloat(base + OFFSET_STATS_LUMA_P50),
+                lumaP95 = buffer.getFloat(base + OFFSET_STATS_LUMA_P95),
+                clippedShadowShare = buffer.getFloat(base + OFFSET_STATS_CLIPPED_SHADOWS),
+                clippedHighlightShare = buffer.getFloat(base + OFFSET_STATS_CLIPPED_HIGHLIGHTS),
+                saturationMean = buffer.getFloat(base + OFFSET_STATS_SATURATION_MEAN),
+                saturatedShare = buffer.getFloat(base + OFFSET_STATS_SATURATED_SHARE),
+                histogram = List(IMAGE_STATS_BINS) { bin ->
+                    buffer.getInt(base + OFFSET_STATS_HISTOGRAM + bin * Int.SIZE_BYTES)
+                },
+            )
+
+        private fun decodeMemory(buffer: ByteBuffer, base: Int): NativeMemoryTelemetry {
+            val stagePeakKb = LinkedHashMap<String, Long>()
+            val stageRssKb = LinkedHashMap<String, Long>()
+            PIPELINE_STAGES.forEachIndexed { index, stage ->
+                stagePeakKb[stage] = buffer.getLong(base + OFFSET_STAGE_PEAK_KB + index * Long.SIZE_BYTES)
+                stageRssKb[stage] = buffer.getLong(base + OFFSET_STAGE_RSS_KB + index * Long.SIZE_BYTES)
+            }
+            return NativeMemoryTelemetry(
+                stagePeakKb = stagePeakKb,
+                stageRssKb = stageRssKb,
+                processPeakRssKb = buffer.getLong(base + OFFSET_PROCESS_PEAK_RSS_KB),
+            )
+        }
+
+        private fun decodeProfile(buffer: ByteBuffer, base: Int): NativeProfile {
+            val stageMicros = LinkedHashMap<String, Long>()
+            PIPELINE_STAGES.forEachIndexed { index, stage ->
+                stageMicros[stage] = buffer.getLong(base + OFFSET_STAGE_MICROS + index * Long.SIZE_BYTES)
+            }
+            val topLayerCount = buffer.getInt(base + OFFSET_TOP_LAYER_COUNT).coerceIn(0, MAX_TOP_LAYERS)
+            val topLayers = List(topLayerCount) { position ->
+                val record = base + OFFSET_TOP_LAYERS + position * TOP_LAYER_SIZE
+                NativeLayerTiming(
+                    index = buffer.getInt(record + TOP_LAYER_INDEX),
+                    name = readText(buffer, record + TOP_LAYER_NAME, TOP_LAYER_NAME_LENGTH),
+                    type = readText(buffer, record + TOP_LAYER_TYPE, TOP_LAYER_TYPE_LENGTH),
+                    micros = buffer.getLong(record + TOP_LAYER_MICROS),
+                )
+            }
+            return NativeProfile(
+                stageMicros = stageMicros,
+                tileCount = buffer.getInt(base + OFFSET_TILE_COUNT),
+                tileP50Micros = buffer.getLong(base + OFFSET_TILE_P50_MICROS),
+                tileP95Micros = buffer.getLong(base + OFFSET_TILE_P95_MICROS),
+                tileMaxMicros = buffer.getLong(base + OFFSET_TILE_MAX_MICROS),
+                layerCount = buffer.getInt(base + OFFSET_LAYER_COUNT),
+                layersTotalMicros = buffer.getLong(base + OFFSET_LAYERS_MICROS),
+                topLayers = topLayers,
+            )
+        }
+
+        /** ASCII-поле фиксированной длины, дополненное нулями. */
+        private fun readText(buffer: ByteBuffer, offset: Int, length: Int): String {
+            val builder = StringBuilder(length)
+            for (i in 0 until length) {
+                val byte = buffer.get(offset + i).toInt()
+                if (byte == 0) break
+                builder.append((byte and 0xFF).toChar())
+            }
+            return builder.toString()
+        }
+
+        private fun delegateName(code: Int): String = if (code == DELEGATE_CODE_VULKAN) "vulkan" else "cpu"
+
+        private fun precisionName(code: Int): String = when (code) {
+            PRECISION_CODE_FP16 -> "fp16"
+            PRECISION_CODE_FP32 -> "fp32"
+            else -> "unknown"
+        }
+    }
+}
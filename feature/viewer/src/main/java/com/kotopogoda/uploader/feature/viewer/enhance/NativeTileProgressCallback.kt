@@ -1,5 +1,10 @@
 package com.kotopogoda.uploader.feature.viewer.enhance
 
+/**
+ * Прогресс нативных стадий. Вызывается из отдельного нативного потока
+ * `kotopogoda-progress`, не чаще заданной частоты на стадию; последнее значение
+ * каждой стадии доставляется до завершения задачи ([NativeJobCompletion]).
+ */
 fun interface NativeTileProgressCallback {
     fun onTileProgress(stage: String, tilesCompleted: Int, tileCount: Int)
 }
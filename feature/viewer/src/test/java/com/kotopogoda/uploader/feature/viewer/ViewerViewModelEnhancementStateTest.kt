@@ -206,13 +206,13 @@ class ViewerViewModelEnhancementStateTest {
         viewModel.onEnhancementStrengthChangeFinished()
         advanceUntilIdle()
 
-        coVerify(exactly = 1) { nativeEnhanceAdapter.computeFull(any(), any(), any(), any(), any()) }
+        coVerify(exactly = 1) { nativeEnhanceAdapter.computeFull(any(), any(), any(), any(), any(), any()) }
 
         viewModel.onEnhancementStrengthChange(0.85f)
         viewModel.onEnhancementStrengthChangeFinished()
         advanceUntilIdle()
 
-        coVerify(exactly = 2) { nativeEnhanceAdapter.computeFull(any(), any(), any(), any(), any()) }
+        coVerify(exactly = 2) { nativeEnhanceAdapter.computeFull(any(), any(), any(), any(), any(), any()) }
     }
 
     @Test
@@ -515,17 +515,19 @@ class ViewerViewModelEnhancementStateTest {
         every { nativeEnhanceAdapter.isReady() } returns true
         every { nativeEnhanceAdapter.modelsTelemetry() } returns modelsTelemetry
         coEvery { nativeEnhanceAdapter.initialize(any()) } returns Unit
-        coEvery { nativeEnhanceAdapter.computePreview(any(), any(), any()) } coAnswers {
-            val progress = thirdArg<(Float) -> Unit>()
+        coEvery { nativeEnhanceAdapter.computeInputMetrics(any()) } returns null
+        coEvery { nativeEnhanceAdapter.computePreview(any(), any(), any(), any(), any()) } coAnswers {
+            @Suppress("UNCHECKED_CAST")
+            val progress = args[4] as (Float) -> Unit
             progress(0.25f)
             true
         }
         coEvery {
-            nativeEnhanceAdapter.computeFull(any(), any(), any(), any(), any())
+            nativeEnhanceAdapter.computeFull(any(), any(), any(), any(), any(), any())
         } coAnswers {
             val output = thirdArg<File>()
             @Suppress("UNCHECKED_CAST")
-            val onProgress = args[4] as (Float) -> Unit
+            val onProgress = args[5] as (Float) -> Unit
             output.writeBytes(ByteArray(128) { 0x11 })
             onProgress(0.6f)
             com.kotopogoda.uploader.core.data.upload.UploadEnhancementInfo(
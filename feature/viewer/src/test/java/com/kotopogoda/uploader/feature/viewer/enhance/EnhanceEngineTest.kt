@@ -637,6 +637,79 @@ class EnhanceEngineTest {
         outputHigh.delete()
     }
 
+    @Test
+    fun `sharpener replaces kotlin unsharp when provided`() = runTest {
+        val pixels = IntArray(64) { index ->
+            if ((index / 8 + index % 8) % 2 == 0) argb(210, 210, 210) else argb(160, 160, 160)
+        }
+        val decoder = QueueDecoder(listOf(EnhanceEngine.ImageBuffer(8, 8, pixels)))
+        val encoder = RecordingEncoder()
+        val sharpener = TrackingSharpener()
+        val engine = EnhanceEngine(
+            decoder = decoder,
+            encoder = encoder,
+            zeroDce = null,
+            restormer = null,
+            dispatcher = StandardTestDispatcher(testScheduler),
+            sharpener = sharpener,
+        )
+        val input = File.createTempFile("input", ".jpg")
+        val output = File.createTempFile("output", ".jpg")
+
+        val result = engine.enhance(
+            EnhanceEngine.Request(
+                source = input,
+                strength = 1f,
+                outputFile = output,
+            ),
+        )
+
+        val call = sharpener.calls.single()
+        assertEquals(result.profile.sharpenAmount, call.amount, 1e-6f)
+        assertEquals(result.profile.sharpenRadius, call.radius, 1e-6f)
+        assertEquals(result.profile.sharpenThreshold, call.threshold, 1e-6f)
+        val encoded = encoder.lastBuffer ?: error("результат должен быть записан")
+        assertEquals("результат должен прийти из sharpener", 1, encoded.pixels.distinct().size)
+
+        input.delete()
+        output.delete()
+    }
+
+    @Test
+    fun `color grader replaces kotlin vibrance when provided`() = runTest {
+        val pixels = IntArray(64) { index -> if (index % 2 == 0) argb(200, 120, 80) else argb(90, 140, 200) }
+        val decoder = QueueDecoder(listOf(EnhanceEngine.ImageBuffer(8, 8, pixels)))
+        val encoder = RecordingEncoder()
+        val grader = TrackingColorGrader()
+        val engine = EnhanceEngine(
+            decoder = decoder,
+            encoder = encoder,
+            zeroDce = null,
+            restormer = null,
+            dispatcher = StandardTestDispatcher(testScheduler),
+            colorGrader = grader,
+        )
+        val input = File.createTempFile("input", ".jpg")
+        val output = File.createTempFile("output", ".jpg")
+
+        val result = engine.enhance(
+            EnhanceEngine.Request(
+                source = input,
+                strength = 1f,
+                outputFile = output,
+            ),
+        )
+
+        val call = grader.calls.single()
+        assertEquals(result.profile.vibranceGain, call.first, 1e-6f)
+        assertEquals(result.profile.saturationGain, call.second, 1e-6f)
+        val encoded = encoder.lastBuffer ?: error("результат должен быть записан")
+        assertTrue("результат должен прийти из color grader", encoded.pixels.all { it == argb(12, 34, 56) })
+
+        input.delete()
+        output.delete()
+    }
+
     private fun assertClose(expected: Float, actual: Float, epsilon: Float) {
         assertTrue(
             "expected=$expected actual=$actual",
@@ -669,6 +742,34 @@ class EnhanceEngineTest {
         }
     }
 
+    private class TrackingSharpener : EnhanceEngine.Sharpener {
+        data class Call(val amount: Float, val radius: Float, val threshold: Float)
+        val calls = mutableListOf<Call>()
+        override fun applyEdgeAwareUnsharp(
+            buffer: EnhanceEngine.ImageBuffer,
+            amount: Float,
+            radius: Float,
+            threshold: Float,
+        ): EnhanceEngine.ImageBuffer {
+            calls += Call(amount, radius, threshold)
+            val pixels = IntArray(buffer.pixels.size) { argb(90, 90, 90) }
+            return EnhanceEngine.ImageBuffer(buffer.width, buffer.height, pixels)
+        }
+    }
+
+    private class TrackingColorGrader : EnhanceEngine.ColorGrader {
+        val calls = mutableListOf<Pair<Float, Float>>()
+        override fun applyVibranceAndSaturation(
+            buffer: EnhanceEngine.ImageBuffer,
+            vibranceGain: Float,
+            saturationGain: Float,
+        ): EnhanceEngine.ImageBuffer {
+            calls += vibranceGain to saturationGain
+            val pixels = IntArray(buffer.pixels.size) { argb(12, 34, 56) }
+            return EnhanceEngine.ImageBuffer(buffer.width, buffer.height, pixels)
+        }
+    }
+
     private class TrackingZeroDce : EnhanceEngine.ZeroDceModel {
         data class Call(val delegate: EnhanceEngine.Delegate, val iterations: Int)
         val calls = mutableListOf<Call>()
@@ -0,0 +1,45 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+import java.io.File
+import java.nio.file.Files
+import kotlin.test.AfterTest
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNotNull
+
+class ModelLedgerKeyStoreTest {
+
+    private val tempDir: File = Files.createTempDirectory("ledger-key").toFile()
+
+    @AfterTest
+    fun tearDown() {
+        tempDir.deleteRecursively()
+    }
+
+    @Test
+    fun `key is generated once and reused`() {
+        val keyFile = File(tempDir, "model_ledger.key")
+
+        val first = ModelLedgerKeyStore(keyFile).getOrCreateKey()
+        val second = ModelLedgerKeyStore(keyFile).getOrCreateKey()
+
+        assertNotNull(first)
+        assertEquals(32, first.size)
+        assertContentEquals(first, second)
+    }
+
+    @Test
+    fun `corrupted key is replaced`() {
+        val keyFile = File(tempDir, "model_ledger.key")
+        keyFile.writeBytes(byteArrayOf(1, 2, 3))
+
+        val key = ModelLedgerKeyStore(keyFile).getOrCreateKey()
+
+        assertNotNull(key)
+        assertEquals(32, key.size)
+        assertContentEquals(key, keyFile.readBytes())
+        assertFalse(File(tempDir, "model_ledger.key.tmp").exists())
+    }
+}
@@ -0,0 +1,66 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertNotNull
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class NativeBatchItemsBufferTest {
+
+    @Test
+    fun `unfinished items decode as pending without telemetry`() {
+        val items = NativeBatchItemsBuffer(itemCount = 3)
+
+        val decoded = items.decodeAll()
+
+        assertEquals(3, decoded.size)
+        decoded.forEach { result ->
+            assertEquals(NativeEnhanceController.BatchItemState.PENDING, result.state)
+            assertNull(result.telemetry)
+        }
+    }
+
+    @Test
+    fun `records are read relative to item index`() {
+        val items = NativeBatchItemsBuffer(itemCount = 2)
+        val base = NativeBatchItemsBuffer.RECORD_SIZE_BYTES
+        val telemetryBase = base + NativeBatchItemsBuffer.OFFSET_TELEMETRY
+        items.buffer.apply {
+            putInt(base + NativeBatchItemsBuffer.OFFSET_STOPPED_AT, NativeEnhanceController.BatchStage.INFER.code)
+            putLong(base + NativeBatchItemsBuffer.OFFSET_DECODE_MS, 40L)
+            putLong(base + NativeBatchItemsBuffer.OFFSET_INFER_MS, 900L)
+            putLong(base + NativeBatchItemsBuffer.OFFSET_ENCODE_MS, 0L)
+            putInt(base + NativeBatchItemsBuffer.OFFSET_WIDTH, 4000)
+            putInt(base + NativeBatchItemsBuffer.OFFSET_HEIGHT, 3000)
+            putInt(telemetryBase + NativeTelemetryBuffer.OFFSET_SIZE, NativeTelemetryBuffer.SIZE_BYTES)
+            putInt(telemetryBase + NativeTelemetryBuffer.OFFSET_FLAGS, NativeTelemetryBuffer.FLAG_CANCELLED)
+            putInt(telemetryBase + NativeTelemetryBuffer.OFFSET_TILES_TOTAL, 24)
+            putInt(telemetryBase + NativeTelemetryBuffer.OFFSET_TILES_COMPLETED, 7)
+            putInt(telemetryBase + NativeTelemetryBuffer.OFFSET_VERSION, NativeTelemetryBuffer.LAYOUT_VERSION)
+            putInt(base + NativeBatchItemsBuffer.OFFSET_STATE, NativeEnhanceController.BatchItemState.CANCELLED.code)
+        }
+
+        assertEquals(NativeEnhanceController.BatchItemState.PENDING, items.decode(0).state)
+        val decoded = items.decode(1)
+        assertEquals(1, decoded.index)
+        assertEquals(NativeEnhanceController.BatchItemState.CANCELLED, decoded.state)
+        assertEquals(NativeEnhanceController.BatchStage.INFER, decoded.stoppedAt)
+        assertEquals(40L, decoded.decodeMs)
+        assertEquals(900L, decoded.inferMs)
+        assertEquals(4000, decoded.width)
+        assertEquals(3000, decoded.height)
+        val telemetry = assertNotNull(decoded.telemetry)
+        assertTrue(telemetry.cancelled)
+        assertEquals(24, telemetry.tilesTotal)
+        assertEquals(7, telemetry.tilesCompleted)
+    }
+
+    @Test
+    fun `index outside the batch is rejected`() {
+        val items = NativeBatchItemsBuffer(itemCount = 1)
+
+        assertFailsWith<IllegalArgumentException> { items.decode(1) }
+    }
+}
@@ -0,0 +1,31 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+class NativeProgressivePreviewLevelsTest {
+
+    @Test
+    fun `full resolution preview refines through eighth and half scale`() {
+        assertEquals(listOf(8, 2, 1), NativeEnhanceController.progressiveScaleDenoms(1))
+    }
+
+    @Test
+    fun `levels finer than the display scale are skipped`() {
+        assertEquals(listOf(8, 4), NativeEnhanceController.progressiveScaleDenoms(4))
+        assertEquals(listOf(8, 2), NativeEnhanceController.progressiveScaleDenoms(2))
+    }
+
+    @Test
+    fun `eighth scale display preview is a single level`() {
+        assertEquals(listOf(8), NativeEnhanceController.progressiveScaleDenoms(8))
+    }
+
+    @Test
+    fun `scaled size rounds up like libjpeg`() {
+        assertEquals(4000, NativeEnhanceController.scaledJpegSize(4000, 1))
+        assertEquals(500, NativeEnhanceController.scaledJpegSize(4000, 8))
+        assertEquals(126, NativeEnhanceController.scaledJpegSize(1003, 8))
+        assertEquals(502, NativeEnhanceController.scaledJpegSize(1003, 2))
+    }
+}
@@ -0,0 +1,252 @@
+package com.kotopogoda.uploader.feature.viewer.enhance
+
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertFalse
+import kotlin.test.assertNotNull
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class NativeTelemetryBufferTest {
+
+    @Test
+    fun `reset buffer decodes to null`() {
+        val telemetry = NativeTelemetryBuffer()
+        telemetry.buffer.putInt(NativeTelemetryBuffer.OFFSET_VERSION, NativeTelemetryBuffer.LAYOUT_VERSION)
+
+        telemetry.reset()
+
+        assertNull(telemetry.decode())
+    }
+
+    @Test
+    fun `fields are read from fixed offsets`() {
+        val telemetry = NativeTelemetryBuffer()
+        telemetry.reset()
+        telemetry.buffer.apply {
+            putInt(NativeTelemetryBuffer.OFFSET_SIZE, NativeTelemetryBuffer.SIZE_BYTES)
+            putInt(
+                NativeTelemetryBuffer.OFFSET_FLAGS,
+                NativeTelemetryBuffer.FLAG_SUCCESS or NativeTelemetryBuffer.FLAG_TILE_USED,
+            )
+            putInt(NativeTelemetryBuffer.OFFSET_FALLBACK_CAUSE, 2)
+            putLong(NativeTelemetryBuffer.OFFSET_TIMING_MS, 1234L)
+            putLong(NativeTelemetryBuffer.OFFSET_PEAK_MEMORY_KB, 98_765L)
+            putLong(NativeTelemetryBuffer.OFFSET_DURATION_MS_VULKAN, 0L)
+            putLong(NativeTelemetryBuffer.OFFSET_DURATION_MS_CPU, 1200L)
+            putInt(NativeTelemetryBuffer.OFFSET_TILE_SIZE, 384)
+            putInt(NativeTelemetryBuffer.OFFSET_TILE_OVERLAP, 64)
+            putInt(NativeTelemetryBuffer.OFFSET_TILES_TOTAL, 12)
+            putInt(NativeTelemetryBuffer.OFFSET_TILES_COMPLETED, 12)
+            putFloat(NativeTelemetryBuffer.OFFSET_SEAM_MAX_DELTA, 0.25f)
+            putFloat(NativeTelemetryBuffer.OFFSET_SEAM_MEAN_DELTA, 0.125f)
+            putInt(NativeTelemetryBuffer.OFFSET_GPU_ALLOC_RETRIES, 1)
+            putInt(NativeTelemetryBuffer.OFFSET_DELEGATE, 0)
+            putInt(NativeTelemetryBuffer.OFFSET_REST_PRECISION, NativeTelemetryBuffer.PRECISION_CODE_FP32)
+            putLong(NativeTelemetryBuffer.OFFSET_STAGE_PEAK_KB, 12_288L)
+            putLong(NativeTelemetryBuffer.OFFSET_STAGE_PEAK_KB + Long.SIZE_BYTES, 98_765L)
+            putLong(NativeTelemetryBuffer.OFFSET_STAGE_RSS_KB + 4 * Long.SIZE_BYTES, 250_000L)
+            putLong(NativeTelemetryBuffer.OFFSET_PROCESS_PEAK_RSS_KB, 312_000L)
+            putInt(NativeTelemetryBuffer.OFFSET_VERSION, NativeTelemetryBuffer.LAYOUT_VERSION)
+        }
+
+        val decoded = assertNotNull(telemetry.decode())
+
+        assertTrue(decoded.success)
+        assertTrue(decoded.tileUsed)
+        assertFalse(decoded.usedVulkan)
+        assertFalse(decoded.cancelled)
+        assertFalse(decoded.fallbackUsed)
+        assertEquals(2, decoded.fallbackCauseCode)
+        assertEquals(1234L, decoded.timingMs)
+        assertEquals(98_765L, decoded.peakMemoryKb)
+        assertEquals(1200L, decoded.durationMsCpu)
+        assertEquals(384, decoded.tileSize)
+        assertEquals(64, decoded.tileOverlap)
+        assertEquals(12, decoded.tilesTotal)
+        assertEquals(12, decoded.tilesCompleted)
+        assertEquals(0.25f, decoded.seamMaxDelta)
+        assertEquals(0.125f, decoded.seamMeanDelta)
+        assertEquals(1, decoded.gpuAllocRetryCount)
+        assertEquals("cpu", decoded.delegateUsed)
+        assertEquals("fp32", decoded.restPrecision)
+        assertEquals(
+            mapOf("convert_in" to 12_288L, "zerodce" to 98_765L, "blend" to 0L, "upscale" to 0L, "convert_out" to 0L),
+            decoded.memory.stagePeakKb,
+        )
+        assertEquals(250_000L, decoded.memory.stageRssKb["convert_out"])
+        assertEquals(312_000L, decoded.memory.processPeakRssKb)
+        assertNull(decoded.profile)
+    }
+
+    @Test
+    fun `profile is decoded when flagged`() {
+        val telemetry = NativeTelemetryBuffer()
+        telemetry.reset()
+        telemetry.buffer.apply {
+            putInt(NativeTelemetryBuffer.OFFSET_SIZE, NativeTelemetryBuffer.SIZE_BYTES)
+            putInt(
+                NativeTelemetryBuffer.OFFSET_FLAGS,
+                NativeTelemetryBuffer.FLAG_SUCCESS or NativeTelemetryBuffer.FLAG_PROFILED,
+            )
+            putLong(NativeTelemetryBuffer.OFFSET_STAGE_MICROS, 4_100L)
+            putLong(NativeTelemetryBuffer.OFFSET_STAGE_MICROS + Long.SIZE_BYTES, 52_000L)
+            putInt(NativeTelemetryBuffer.OFFSET_TILE_COUNT, 3)
+            putInt(NativeTelemetryBuffer.OFFSET_LAYER_COUNT, 9)
+            putLong(NativeTelemetryBuffer.OFFSET_TILE_P50_MICROS, 17_000L)
+            putLong(NativeTelemetryBuffer.OFFSET_TILE_P95_MICROS, 21_000L)
+            putLong(NativeTelemetryBuffer.OFFSET_TILE_MAX_MICROS, 21_000L)
+            putLong(NativeTelemetryBuffer.OFFSET_LAYERS_MICROS, 48_000L)
+            putInt(NativeTelemetryBuffer.OFFSET_TOP_LAYER_COUNT, 1)
+            val record = NativeTelemetryBuffer.OFFSET_TOP_LAYERS
+            putLong(record + NativeTelemetryBuffer.TOP_LAYER_MICROS, 15_000L)
+            putInt(record + NativeTelemetryBuffer.TOP_LAYER_INDEX, 4)
+            "Convolution".forEachIndexed { i, ch -> put(record + NativeTelemetryBuffer.TOP_LAYER_TYPE + i, ch.code.toByte()) }
+            "conv3".forEachIndexed { i, ch -> put(record + NativeTelemetryBuffer.TOP_LAYER_NAME + i, ch.code.toByte()) }
+            putInt(NativeTelemetryBuffer.OFFSET_VERSION, NativeTelemetryBuffer.LAYOUT_VERSION)
+        }
+
+        val profile = assertNotNull(assertNotNull(telemetry.decode()).profile)
+
+        assertEquals(
+            mapOf("convert_in" to 4_100L, "zerodce" to 52_000L, "blend" to 0L, "upscale" to 0L, "convert_out" to 0L),
+            profile.stageMicros,
+        )
+        assertEquals(3, profile.tileCount)
+        assertEquals(17_000L, profile.tileP50Micros)
+        assertEquals(21_000L, profile.tileP95Micros)
+        assertEquals(9, profile.layerCount)
+        assertEquals(48_000L, profile.layersTotalMicros)
+        assertEquals(listOf(NativeLayerTiming(4, "conv3", "Convolution", 15_000L)), profile.topLayers)
+        assertEquals("conv3/Convolution:15000", profile.toLogPayload()["profile_top_layers"])
+    }
+
+    @Test
+    fun `cpu usage is decoded`() {
+        val telemetry = NativeTelemetryBuffer()
+        telemetry.reset()
+        telemetry.buffer.apply {
+            putInt(NativeTelemetryBuffer.OFFSET_SIZE, NativeTelemetryBuffer.SIZE_BYTES)
+            putInt(NativeTelemetryBuffer.OFFSET_FLAGS, NativeTelemetryBuffer.FLAG_SUCCESS)
+            putLong(NativeTelemetryBuffer.OFFSET_THREAD_CPU_MICROS, 180_000L)
+            putLong(NativeTelemetryBuffer.OFFSET_PROCESS_CPU_MICROS, 640_000L)
+            putLong(NativeTelemetryBuffer.OFFSET_VOLUNTARY_SWITCHES, 42L)
+            putLong(NativeTelemetryBuffer.OFFSET_INVOLUNTARY_SWITCHES, 7L)
+            putLong(NativeTelemetryBuffer.OFFSET_CORE_CLASS_MICROS, 40_000L)
+            putLong(NativeTelemetryBuffer.OFFSET_CORE_CLASS_MICROS + 2 * Long.SIZE_BYTES, 600_000L)
+            putLong(NativeTelemetryBuffer.OFFSET_CPU_MASK, 0xF1L)
+            putLong(NativeTelemetryBuffer.OFFSET_PIXELS, 12_000_000L)
+            putFloat(NativeTelemetryBuffer.OFFSET_CPU_MS_PER_MEGAPIXEL, 53.5f)
+            putInt(NativeTelemetryBuffer.OFFSET_VERSION, NativeTelemetryBuffer.LAYOUT_VERSION)
+        }
+
+        val cpu = assertNotNull(telemetry.decode()).cpu
+
+        assertEquals(180_000L, cpu.threadCpuMicros)
+        assertEquals(640_000L, cpu.processCpuMicros)
+        assertEquals(42L, cpu.voluntarySwitches)
+        assertEquals(7L, cpu.involuntarySwitches)
+        assertEquals(mapOf("little" to 40_000L, "mid" to 0L, "big" to 600_000L), cpu.coreClassMicros)
+        assertEquals(12_000_000L, cpu.pixels)
+        assertEquals(53.5f, cpu.cpuMsPerMegapixel)
+        val payload = cpu.toLogPayload()
+        assertEquals(640L, payload["cpu_process_ms"])
+        assertEquals(600L, payload["cpu_ms_big"])
+        assertEquals("0xf1", payload["cpu_mask"])
+        assertNull(assertNotNull(telemetry.decode()).sustained)
+    }
+
+    @Test
+    fun `sustained mode is decoded when flagged`() {
+        val telemetry = NativeTelemetryBuffer()
+        telemetry.reset()
+        telemetry.buffer.apply {
+            putInt(NativeTelemetryBuffer.OFFSET_SIZE, NativeTelemetryBuffer.SIZE_BYTES)
+            putInt(
+                NativeTelemetryBuffer.OFFSET_FLAGS,
+                NativeTelemetryBuffer.FLAG_SUCCESS or NativeTelemetryBuffer.FLAG_SUSTAINED,
+            )
+            putInt(NativeTelemetryBuffer.OFFSET_SUSTAINED_LEVEL, 2)
+            putInt(NativeTelemetryBuffer.OFFSET_SUSTAINED_THREADS, 3)
+            putInt(NativeTelemetryBuffer.OFFSET_SUSTAINED_DECISION, 1)
+            putLong(NativeTelemetryBuffer.OFFSET_SUSTAINED_PAUSE_MICROS, 180_000L)
+            putInt(NativeTelemetryBuffer.OFFSET_SUSTAINED_NEXT_LEVEL, 3)
+            putInt(NativeTelemetryBuffer.OFFSET_SUSTAINED_CHANGES, 5)
+            putFloat(NativeTelemetryBuffer.OFFSET_SUSTAINED_WINDOW_MPPS, 0.75f)
+            putFloat(NativeTelemetryBuffer.OFFSET_SUSTAINED_BASELINE_MPPS, 1.5f)
+            putInt(NativeTelemetryBuffer.OFFSET_VERSION, NativeTelemetryBuffer.LAYOUT_VERSION)
+        }
+
+        val sustained = assertNotNull(assertNotNull(telemetry.decode()).sustained)
+
+        assertEquals(2, sustained.level)
+        assertEquals(3, sustained.threads)
+        assertEquals(0, sustained.tileSize)
+        assertEquals(180_000L, sustained.pauseMicros)
+        assertEquals("throttle", sustained.decision)
+        assertEquals(3, sustained.nextLevel)
+        assertEquals(5, sustained.levelChanges)
+        assertEquals(0.75f, sustained.windowMpps)
+        assertEquals(1.5f, sustained.baselineMpps)
+        val payload = sustained.toLogPayload()
+        assertEquals(180L, payload["sustained_pause_ms"])
+        assertEquals("throttle", payload["sustained_decision"])
+    }
+
+    @Test
+    fun `image stats are decoded when flagged`() {
+        val telemetry = NativeTelemetryBuffer()
+        telemetry.reset()
+        telemetry.buffer.apply {
+            putInt(NativeTelemetryBuffer.OFFSET_SIZE, NativeTelemetryBuffer.SIZE_BYTES)
+            putInt(
+                NativeTelemetryBuffer.OFFSET_FLAGS,
+                NativeTelemetryBuffer.FLAG_SUCCESS or NativeTelemetryBuffer.FLAG_IMAGE_STATS,
+            )
+            putLong(NativeTelemetryBuffer.OFFSET_STATS_PIXELS, 12_000_000L)
+            putFloat(NativeTelemetryBuffer.OFFSET_STATS_LUMA_MEAN, 0.42f)
+            putFloat(NativeTelemetryBuffer.OFFSET_STATS_DARK_SHARE, 0.25f)
+            putFloat(NativeTelemetryBuffer.OFFSET_STATS_SHARPNESS, 0.875f)
+            putFloat(NativeTelemetryBuffer.OFFSET_STATS_NOISE, 0.125f)
+            putFloat(NativeTelemetryBuffer.OFFSET_STATS_LUMA_P05, 0.05f)
+            putFloat(NativeTelemetryBuffer.OFFSET_STATS_LUMA_P50, 0.4f)
+            putFloat(NativeTelemetryBuffer.OFFSET_STATS_LUMA_P95, 0.9f)
+            putFloat(NativeTelemetryBuffer.OFFSET_STATS_CLIPPED_SHADOWS, 0.01f)
+            putFloat(NativeTelemetryBuffer.OFFSET_STATS_CLIPPED_HIGHLIGHTS, 0.02f)
+            putFloat(NativeTelemetryBuffer.OFFSET_STATS_SATURATION_MEAN, 0.3f)
+            putFloat(NativeTelemetryBuffer.OFFSET_STATS_SATURATED_SHARE, 0.04f)
+            putInt(NativeTelemetryBuffer.OFFSET_STATS_HISTOGRAM, 7)
+            putInt(
+                NativeTelemetryBuffer.OFFSET_STATS_HISTOGRAM + (NativeTelemetryBuffer.IMAGE_STATS_BINS - 1) * Int.SIZE_BYTES,
+                11,
+            )
+            putInt(NativeTelemetryBuffer.OFFSET_VERSION, NativeTelemetryBuffer.LAYOUT_VERSION)
+        }
+
+        val stats = assertNotNull(assertNotNull(telemetry.decode()).imageStats)
+
+        assertEquals(12_000_000L, stats.pixels)
+        assertEquals(0.42f, stats.lumaMean)
+        assertEquals(0.25f, stats.darkShare)
+        assertEquals(0.875f, stats.sharpness)
+        assertEquals(0.125f, stats.noise)
+        assertEquals(0.4f, stats.lumaP50)
+        assertEquals(0.02f, stats.clippedHighlightShare)
+        assertEquals(0.04f, stats.saturatedShare)
+        assertEquals(NativeTelemetryBuffer.IMAGE_STATS_BINS, stats.histogram.size)
+        assertEquals(7, stats.histogram.first())
+        assertEquals(11, stats.histogram.last())
+        assertEquals(0.9f, stats.toLogPayload()["image_luma_p95"])
+    }
+
+    @Test
+    fun `unknown layout version is rejected`() {
+        val telemetry = NativeTelemetryBuffer()
+        telemetry.reset()
+        telemetry.buffer.putInt(NativeTelemetryBuffer.OFFSET_SIZE, NativeTelemetryBuffer.SIZE_BYTES)
+        telemetry.buffer.putInt(NativeTelemetryBuffer.OFFSET_VERSION, NativeTelemetryBuffer.LAYOUT_VERSION + 1)
+
+        assertFailsWith<IllegalStateException> { telemetry.decode() }
+    }
+}
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+"""Сравнение двух JSON-отчётов kotopogoda_bench (цель bench_report)."""
+from __future__ import annotations
+
+import argparse
+import json
+import pathlib
+import sys
+from typing import Dict, Tuple
+
+_UNIT_TO_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load_times(path: pathlib.Path) -> Tuple[Dict[str, float], Dict[str, str]]:
+    """Возвращает время (нс) по имени бенчмарка и контекст отчёта.
+
+    Из агрегатов берётся медиана; если отчёт без повторов, берётся минимум
+    по итерационным записям с тем же именем.
+    """
+    report = json.loads(path.read_text(encoding="utf-8"))
+    medians: Dict[str, float] = {}
+    singles: Dict[str, float] = {}
+    for entry in report.get("benchmarks", []):
+        if entry.get("error_occurred"):
+            continue
+        name = entry.get("run_name", entry["name"])
+        time_ns = entry["real_time"] * _UNIT_TO_NS[entry.get("time_unit", "ns")]
+        if entry.get("run_type") == "aggregate":
+            if entry.get("aggregate_name") == "median":
+                medians[name] = time_ns
+        else:
+            singles[name] = min(time_ns, singles.get(name, time_ns))
+    times = dict(singles)
+    times.update(medians)
+    return times, report.get("context", {})
+
+
+def format_ns(value: float) -> str:
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if value >= scale:
+            return f"{value / scale:.2f} {unit}"
+    return f"{value:.0f} ns"
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("baseline", type=pathlib.Path, help="отчёт базового коммита")
+    parser.add_argument("candidate", type=pathlib.Path, help="отчёт проверяемого коммита")
+    parser.add_argument(
+        "--threshold",
+        type=float,
+        default=5.0,
+        help="рост времени в процентах, начиная с которого бенчмарк считается регрессией",
+    )
+    parser.add_argument(
+        "--fail-on-regression",
+        action="store_true",
+        help="код выхода 1, если есть хотя бы одна регрессия",
+    )
+    args = parser.parse_args()
+
+    base_times, base_context = load_times(args.baseline)
+    new_times, new_context = load_times(args.candidate)
+    print(
+        f"{base_context.get('source_revision', '?')} -> {new_context.get('source_revision', '?')}"
+        f" ({new_context.get('host_name', '?')})"
+    )
+
+    regressions = 0
+    width = max((len(name) for name in base_times.keys() | new_times.keys()), default=10)
+    for name in sorted(base_times.keys() | new_times.keys()):
+        base = base_times.get(name)
+        new = new_times.get(name)
+        if base is None or new is None:
+            status = "только в базе" if new is None else "новый"
+            value = format_ns(base if new is None else new)
+            print(f"{name:<{width}}  {value:>12}  {status}")
+            continue
+        change = (new - base) / base * 100.0 if base > 0 else 0.0
+        marker = ""
+        if change >= args.threshold:
+            marker = "  РЕГРЕССИЯ"
+            regressions += 1
+        elif change <= -args.threshold:
+            marker = "  ускорение"
+        print(f"{name:<{width}}  {format_ns(base):>12}  {format_ns(new):>12}  {change:+7.1f}%{marker}")
+
+    if regressions:
+        print(f"Регрессий больше {args.threshold:.1f}%: {regressions}")
+    return 1 if regressions and args.fail_on_regression else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())